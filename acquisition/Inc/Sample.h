@@ -0,0 +1,23 @@
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+#include "../../sensors/Inc/SensorBase.h"
+
+namespace Acquisition
+{
+    /**
+     * @brief One open/read/close cycle of a sensor.
+     */
+    struct SampleRecord
+    {
+        int sensorId;
+        unsigned long long scheduledNs; ///< CLOCK_MONOTONIC time the cycle was due
+        unsigned long long startNs;     ///< time the worker actually started it
+        unsigned long long endNs;       ///< time the cycle finished
+        bool ok;                        ///< read() result
+        Sensors::SensorData data;
+    };
+
+} // namespace Acquisition
+
+#endif // SAMPLE_H
@@ -0,0 +1,69 @@
+#ifndef SAMPLE_BATCH_H
+#define SAMPLE_BATCH_H
+
+#include "../../define.h"
+#include "../../sensors/Inc/SensorBase.h"
+#include "Sample.h"
+#include <cstddef>
+
+#define SAMPLE_BATCH_CAPACITY 1024
+// Column alignment: a cache line, and enough for any vector width
+#define SAMPLE_BATCH_ALIGN 64
+
+namespace Acquisition
+{
+    /**
+     * @class SampleBatch
+     * @brief Successful readings of one sensor, stored column by column.
+     *
+     * A timestamp column and one float column per schema channel, each
+     * contiguous and SAMPLE_BATCH_ALIGN-aligned, so consumers can run plain
+     * loops over a channel instead of walking SampleRecords. Failed reads
+     * only keep their timestamp, in a separate column. Memory is allocated
+     * once at construction; a full batch refuses further appends until
+     * clear().
+     */
+    class SampleBatch
+    {
+    public:
+        // schema is copied; timestamps are CLOCK_MONOTONIC like SampleRecord::endNs
+        SampleBatch(int sensorId, const Sensors::SensorSchema &schema, size_t capacity = SAMPLE_BATCH_CAPACITY);
+        ~SampleBatch();
+        SampleBatch(const SampleBatch &) = delete;
+        SampleBatch &operator=(const SampleBatch &) = delete;
+
+        // One value per schema channel; false if the batch is full
+        bool append(unsigned long long timestampNs, const float *values);
+        // A failed read; false if the failure column is full
+        bool appendFailure(unsigned long long timestampNs);
+        // A scheduler record of this sensor, mapped through fromSensorData()
+        bool append(const SampleRecord &record);
+        void clear();
+
+        int getSensorId() const { return sensorId; }
+        const Sensors::SensorSchema &getSchema() const { return schema; }
+        size_t size() const { return count; }
+        size_t capacity() const { return rows; }
+        bool full() const { return count == rows; }
+
+        const unsigned long long *timestamps() const { return timestampColumn; }
+        const float *column(size_t channel) const { return valueColumns + channel * stride; }
+        size_t getFailureCount() const { return failures; }
+        const unsigned long long *failureTimestamps() const { return failureColumn; }
+
+    private:
+        int sensorId;
+        Sensors::SensorSchema schema;
+        size_t rows;
+        size_t stride; ///< floats from one channel column to the next, padded to the alignment
+        size_t count;
+        size_t failures;
+        void *storage;
+        unsigned long long *timestampColumn;
+        unsigned long long *failureColumn;
+        float *valueColumns;
+    };
+
+} // namespace Acquisition
+
+#endif // SAMPLE_BATCH_H
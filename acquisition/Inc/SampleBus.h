@@ -0,0 +1,73 @@
+#ifndef SAMPLE_BUS_H
+#define SAMPLE_BUS_H
+
+#include "../../define.h"
+#include "../../common/Inc/RingBuffer.h"
+#include "Sample.h"
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <atomic>
+
+#define SAMPLE_BUS_QUEUE 1024
+// Consumer sleep when its queue is empty and no eventfd could be created
+#define SAMPLE_BUS_IDLE_US 1000
+
+namespace Acquisition
+{
+    /**
+     * @class SampleBus
+     * @brief Fan-out of samples from acquisition threads to consumer threads.
+     *
+     * Every subscriber (logger, exporter, aggregator, ...) owns an MPSC ring
+     * and a thread that drains it into its handler. publish() only pushes
+     * into the rings: it never locks, allocates or waits, and a full ring
+     * drops the sample for that subscriber and counts it, so a slow
+     * consumer cannot stall a timing-critical read. An idle consumer
+     * blocks on its eventfd, written by the publish that makes its ring
+     * non-empty.
+     */
+    class SampleBus
+    {
+    public:
+        using Handler = std::function<void(const SampleRecord &)>;
+
+        SampleBus();
+        ~SampleBus();
+
+        // Register a consumer before start(); returns its id or ERROR
+        int subscribe(const char *name, Handler handler);
+        bool start();
+        // Stop consumer threads after they drain what is queued
+        void stop();
+
+        // Lock-free; safe from any number of acquisition threads. false if a subscriber dropped it
+        bool publish(const SampleRecord &record);
+
+        unsigned long getDelivered(int subscriberId) const;
+        unsigned long getDropped(int subscriberId) const;
+
+    private:
+        struct Subscriber
+        {
+            const char *name;
+            Handler handler;
+            Common::MpscRing<SampleRecord, SAMPLE_BUS_QUEUE> queue;
+            std::thread thread;
+            std::atomic<unsigned long> queued;
+            std::atomic<unsigned long> delivered;
+            std::atomic<unsigned long> dropped;
+            int wakeFd; ///< eventfd the consumer blocks on while its queue is empty
+        };
+
+        void consume(Subscriber *subscriber);
+        static void wake(Subscriber *subscriber);
+
+        std::vector<std::unique_ptr<Subscriber>> subscribers;
+        std::atomic<bool> running;
+    };
+
+} // namespace Acquisition
+
+#endif // SAMPLE_BUS_H
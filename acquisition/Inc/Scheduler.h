@@ -0,0 +1,118 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "../../define.h"
+#include "../../sensors/Inc/SensorBase.h"
+#include "Sample.h"
+#include "SampleBus.h"
+#include "../../common/Inc/Realtime.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+#define SCHEDULER_SHARED_WORKERS 2
+#define SCHEDULER_RT_PRIORITY REALTIME_PRIORITY
+#define SCHEDULER_HISTORY 1024
+
+namespace Acquisition
+{
+    /**
+     * @brief Per-sensor counters, updated by the worker running the sensor.
+     */
+    struct SensorStats
+    {
+        unsigned long runs = 0;
+        unsigned long failures = 0;
+        unsigned long deadlineMisses = 0;  ///< cycles that ended after scheduledNs + deadline
+        unsigned long skippedPeriods = 0;  ///< periods dropped because the worker fell behind
+        unsigned long long jitterNsTotal = 0;
+        unsigned long long jitterNsMax = 0;
+        unsigned long long busyNsTotal = 0; ///< time spent inside open/read/close
+    };
+
+    /**
+     * @brief Thread pool and real-time options of the scheduler.
+     */
+    struct SchedulerConfig
+    {
+        int sharedWorkers = SCHEDULER_SHARED_WORKERS; ///< threads shared by sensors that are not timing-critical
+        int realtimePriority = SCHEDULER_RT_PRIORITY; ///< SCHED_FIFO priority of dedicated workers, 0 to keep SCHED_OTHER
+        int firstRealtimeCpu = -1;                    ///< CPU of the first dedicated worker (next ones follow), -1 to not pin
+        bool lockMemory = true;                       ///< mlockall() when the first dedicated worker starts
+        size_t historyCapacity = SCHEDULER_HISTORY;   ///< records kept per sensor
+    };
+
+    /**
+     * @class Scheduler
+     * @brief Runs periodic open/read/close cycles of many sensors on a small thread pool.
+     *
+     * Timing-critical sensors (SensorBase::isTimingCritical()) get a dedicated
+     * worker that sleeps on an absolute deadline and is moved to SCHED_FIFO
+     * and pinned when privileges allow. The others share a pool that always
+     * runs the earliest due sensor. Every cycle is recorded with its scheduled
+     * and actual start time so jitter and throughput can be measured.
+     */
+    class Scheduler
+    {
+    public:
+        explicit Scheduler(const SchedulerConfig &config = SchedulerConfig());
+        ~Scheduler();
+
+        // Register a sensor before start(); deadlineMs 0 means one period. Returns its id or ERROR.
+        int addSensor(Sensors::SensorBase *sensor, unsigned int periodMs, unsigned int deadlineMs = 0);
+        bool start();
+        void stop();
+
+        // Publish every cycle record to a bus (lock-free); set before start()
+        void setSampleBus(SampleBus *sampleBus) { bus = sampleBus; }
+
+        int getSensorCount() const { return (int)tasks.size(); }
+        SensorStats getStats(int sensorId) const;
+        // Channels the sensor declared when it was added (SensorBase::schema())
+        const Sensors::SensorSchema &getSchema(int sensorId) const;
+        // Copy up to maxRecords of the most recent records, oldest first; returns the count
+        size_t getRecords(int sensorId, SampleRecord *records, size_t maxRecords) const;
+        // Number of dedicated workers that obtained SCHED_FIFO
+        int getRealtimeWorkers() const { return realtimeWorkers.load(); }
+
+    private:
+        struct Task
+        {
+            Sensors::SensorBase *sensor;
+            int id;
+            Sensors::SensorSchema schema;
+            unsigned long long periodNs;
+            unsigned long long deadlineNs;
+            unsigned long long nextRunNs;
+            bool dedicated;
+            bool busy;               ///< a shared worker is running it (guarded by poolLock)
+            mutable std::mutex lock; ///< guards stats and history
+            SensorStats stats;
+            std::vector<SampleRecord> history;
+            size_t historyHead;
+            size_t historyCount;
+        };
+
+        void runCycle(Task &task);
+        void dedicatedWorker(Task *task, int cpu);
+        void sharedWorker();
+        void advance(Task &task, unsigned long long now);
+        bool sleepUntil(unsigned long long deadlineNs);
+        void applyRealtime(int cpu);
+
+        SchedulerConfig config;
+        SampleBus *bus; ///< Optional consumer fan-out, not owned
+        std::vector<std::unique_ptr<Task>> tasks;
+        std::vector<std::thread> workers;
+        std::atomic<bool> running;
+        std::atomic<int> realtimeWorkers;
+        std::mutex poolLock;               ///< guards nextRunNs of shared tasks
+        std::condition_variable poolWake;  ///< wakes shared workers on stop() and when a sensor is released
+    };
+
+} // namespace Acquisition
+
+#endif // SCHEDULER_H
@@ -0,0 +1,149 @@
+#ifndef SHARED_READINGS_H
+#define SHARED_READINGS_H
+
+/*
+ * Latest readings in POSIX shared memory for other processes on the node.
+ *
+ * The acquisition side (one writer process) owns a segment holding, per
+ * sensor, its channel names and a ring of the last SHM_HISTORY readings.
+ * Every ring slot is a seqlock: the writer makes the sequence odd, stores
+ * the reading and makes it even again, and a reader retries a copy during
+ * which the sequence changed. Readers map the segment read-only and never
+ * write to it, so any number of them (display, control loop, telemetry
+ * agent) get consistent values with no syscalls or locks and no effect on
+ * the writer or the sensor bus. All shared fields are 32-bit atomics,
+ * which stay lock-free plain loads and stores on 32-bit ARM as well.
+ */
+
+#include "../../define.h"
+#include "../../sensors/Inc/SensorBase.h"
+#include "Sample.h"
+#include <atomic>
+#include <cstdint>
+
+#define SHM_READINGS_NAME "/enviromonitor"
+#define SHM_MAGIC 0x4D564E45u // "ENVM"
+#define SHM_VERSION 1
+#define SHM_MAX_SENSORS 16
+// Readings kept per sensor; a power of two
+#define SHM_HISTORY 64
+#define SHM_NAME_SIZE 32
+#define SHM_CHANNEL_NAME_SIZE 16
+#define SHM_UNIT_SIZE 8
+// Copies a reader attempts while the writer keeps rewriting a slot
+#define SHM_READ_RETRIES 1000
+
+namespace Acquisition
+{
+    // One reading as seen by readers
+    struct SharedReading
+    {
+        uint64_t timestampNs;                 ///< CLOCK_MONOTONIC end of the read, same clock in every process
+        uint32_t serial;                      ///< readings of this sensor published before this one
+        uint32_t ok;                          ///< read() result; values are NaN when 0
+        float values[SENSOR_MAX_CHANNELS];    ///< one per channel, in the sensor's schema order
+    };
+
+    // A seqlock-protected reading
+    struct alignas(64) SharedSlot
+    {
+        static constexpr size_t WORDS = sizeof(SharedReading) / sizeof(uint32_t);
+
+        std::atomic<uint32_t> sequence; ///< odd while the writer is storing
+        std::atomic<uint32_t> words[WORDS];
+    };
+
+    struct SharedSensor
+    {
+        char name[SHM_NAME_SIZE];
+        uint32_t channelCount;
+        char channels[SENSOR_MAX_CHANNELS][SHM_CHANNEL_NAME_SIZE];
+        char units[SENSOR_MAX_CHANNELS][SHM_UNIT_SIZE];
+        std::atomic<uint32_t> published; ///< readings written; the newest is in slot (published - 1) % SHM_HISTORY
+        SharedSlot history[SHM_HISTORY];
+    };
+
+    // Layout of the segment
+    struct SharedSegment
+    {
+        std::atomic<uint32_t> magic;       ///< SHM_MAGIC once the header is complete
+        uint32_t version;
+        uint32_t segmentSize;
+        std::atomic<uint32_t> writerPid;   ///< 0 after the writer closed the segment
+        std::atomic<uint32_t> sensorCount; ///< sensors whose entry is complete
+        SharedSensor sensors[SHM_MAX_SENSORS];
+    };
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared memory needs lock-free 32-bit atomics");
+
+    /**
+     * @class SharedPublisher
+     * @brief Writer side: creates the segment and publishes readings into it.
+     *
+     * One writer process; each sensor must be published from one thread at
+     * a time (the Scheduler and the Daemon both guarantee that).
+     */
+    class SharedPublisher
+    {
+    public:
+        explicit SharedPublisher(const char *name = SHM_READINGS_NAME);
+        ~SharedPublisher();
+
+        // Create (or replace) the segment; false if it cannot be created or mapped
+        bool open();
+        // Register a sensor; returns its index in the segment or ERROR
+        int addSensor(const char *name, const Sensors::SensorSchema &schema);
+        // Publish one reading of values in the schema order
+        void publish(int sensorIndex, unsigned long long timestampNs, bool ok, const float *values);
+        // Publish a cycle record; sensorId must be the index returned by addSensor()
+        void publish(const SampleRecord &record);
+        // Mark the segment closed for readers, unmap it and remove its name
+        void close();
+
+        bool isOpen() const { return segment != nullptr; }
+
+    private:
+        const char *name;
+        SharedSegment *segment;
+        Sensors::SensorSchema schemas[SHM_MAX_SENSORS]; ///< for mapping SampleRecord data onto channels
+    };
+
+    /**
+     * @class SharedReader
+     * @brief Reader side: maps the segment read-only and copies consistent readings.
+     */
+    class SharedReader
+    {
+    public:
+        explicit SharedReader(const char *name = SHM_READINGS_NAME);
+        ~SharedReader();
+
+        // Map the segment; false if no writer has created it
+        bool open();
+        void close();
+
+        int getSensorCount() const;
+        // Index of the sensor with this name, or -1
+        int findSensor(const char *sensorName) const;
+        // Sensor entry: name, channel names and units
+        const SharedSensor &getSensor(int sensorIndex) const { return segment->sensors[sensorIndex]; }
+        // Newest reading; false if there is none yet or it could not be copied consistently
+        bool latest(int sensorIndex, SharedReading &reading) const;
+        // Up to maxReadings of the newest readings, oldest first; returns the count
+        size_t history(int sensorIndex, SharedReading *readings, size_t maxReadings) const;
+        // Newest reading mapped onto SensorData by channel name
+        bool latestData(int sensorIndex, Sensors::SensorData &data) const;
+        // True once the writer closed the segment; reopen to follow a restarted writer
+        bool isClosed() const;
+
+    private:
+        bool readSlot(const SharedSlot &slot, SharedReading &reading) const;
+
+        const char *name;
+        const SharedSegment *segment;
+        size_t mappedSize;
+    };
+
+} // namespace Acquisition
+
+#endif // SHARED_READINGS_H
@@ -0,0 +1,103 @@
+#include "../Inc/SampleBatch.h"
+#include "../../common/Inc/Log.h"
+#include <cstdlib>
+
+namespace Acquisition
+{
+    /**
+     * @brief Rounds a byte count up to the column alignment.
+     */
+    static size_t alignUp(size_t bytes)
+    {
+        return (bytes + SAMPLE_BATCH_ALIGN - 1) / SAMPLE_BATCH_ALIGN * SAMPLE_BATCH_ALIGN;
+    }
+
+    /**
+     * @brief Allocates the columns of an empty batch.
+     * @param sensorId Sensor the readings belong to.
+     * @param schema Channels of the sensor; one value column each.
+     * @param capacity Rows the batch holds.
+     */
+    SampleBatch::SampleBatch(int sensorId, const Sensors::SensorSchema &schema, size_t capacity)
+        : sensorId(sensorId), schema(schema), rows(capacity), count(0), failures(0), storage(nullptr)
+    {
+        size_t timestampBytes = alignUp(rows * sizeof(unsigned long long));
+        size_t columnBytes = alignUp(rows * sizeof(float));
+        stride = columnBytes / sizeof(float);
+        size_t total = 2 * timestampBytes + schema.count * columnBytes;
+        if (posix_memalign(&storage, SAMPLE_BATCH_ALIGN, total > 0 ? total : SAMPLE_BATCH_ALIGN) != 0)
+        {
+            LOG_ERROR("Sample batch: cannot allocate %zu bytes.\n", total);
+            storage = nullptr;
+            rows = 0;
+        }
+        char *base = (char *)storage;
+        timestampColumn = (unsigned long long *)base;
+        failureColumn = (unsigned long long *)(base + timestampBytes);
+        valueColumns = (float *)(base + 2 * timestampBytes);
+    }
+
+    SampleBatch::~SampleBatch()
+    {
+        free(storage);
+    }
+
+    /**
+     * @brief Appends a successful reading.
+     * @param timestampNs When the reading was taken.
+     * @param values schema.count values, in schema order.
+     * @return false if the batch is full.
+     */
+    bool SampleBatch::append(unsigned long long timestampNs, const float *values)
+    {
+        if (count == rows)
+        {
+            return false;
+        }
+        timestampColumn[count] = timestampNs;
+        for (size_t c = 0; c < schema.count; ++c)
+        {
+            valueColumns[c * stride + count] = values[c];
+        }
+        count++;
+        return true;
+    }
+
+    /**
+     * @brief Records a failed read.
+     * @return false if the failure column is full.
+     */
+    bool SampleBatch::appendFailure(unsigned long long timestampNs)
+    {
+        if (failures == rows)
+        {
+            return false;
+        }
+        failureColumn[failures++] = timestampNs;
+        return true;
+    }
+
+    /**
+     * @brief Appends a scheduler record, successful or not, stamped with its endNs.
+     * @return false if the column it goes to is full.
+     */
+    bool SampleBatch::append(const SampleRecord &record)
+    {
+        if (!record.ok)
+        {
+            return appendFailure(record.endNs);
+        }
+        float values[SENSOR_MAX_CHANNELS];
+        Sensors::fromSensorData(schema, record.data, values);
+        return append(record.endNs, values);
+    }
+
+    /**
+     * @brief Empties the batch, keeping its memory.
+     */
+    void SampleBatch::clear()
+    {
+        count = 0;
+        failures = 0;
+    }
+} // namespace Acquisition
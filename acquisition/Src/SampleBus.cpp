@@ -0,0 +1,201 @@
+#include "../Inc/SampleBus.h"
+#include "../../common/Inc/Log.h"
+#include "../../common/Inc/AllocTracker.h"
+#include <chrono>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace Acquisition
+{
+    /**
+     * @brief Constructs a bus without subscribers.
+     */
+    SampleBus::SampleBus() : running(false)
+    {
+    }
+
+    /**
+     * @brief Stops and joins the consumer threads.
+     */
+    SampleBus::~SampleBus()
+    {
+        stop();
+        for (std::unique_ptr<Subscriber> &subscriber : subscribers)
+        {
+            if (subscriber->wakeFd != -1)
+            {
+                close(subscriber->wakeFd);
+            }
+        }
+    }
+
+    /**
+     * @brief Adds a consumer. Its queue is allocated here, never on the publish path.
+     * @param name Consumer name used in diagnostics.
+     * @param handler Called on the consumer thread for every sample.
+     * @return Subscriber id, or ERROR if the bus is running.
+     */
+    int SampleBus::subscribe(const char *name, Handler handler)
+    {
+        if (running.load())
+        {
+            LOG_ERROR("Cannot subscribe %s to a running sample bus.\n", name);
+            return ERROR;
+        }
+        std::unique_ptr<Subscriber> subscriber(new Subscriber());
+        subscriber->name = name;
+        subscriber->handler = std::move(handler);
+        subscriber->queued = 0;
+        subscriber->delivered = 0;
+        subscriber->dropped = 0;
+        subscriber->wakeFd = eventfd(0, EFD_CLOEXEC);
+        subscribers.push_back(std::move(subscriber));
+        return (int)subscribers.size() - 1;
+    }
+
+    /**
+     * @brief Starts one thread per subscriber.
+     * @return true if started, false if already running.
+     */
+    bool SampleBus::start()
+    {
+        if (running.exchange(true))
+        {
+            return false;
+        }
+        for (std::unique_ptr<Subscriber> &subscriber : subscribers)
+        {
+            subscriber->thread = std::thread(&SampleBus::consume, this, subscriber.get());
+        }
+        return true;
+    }
+
+    /**
+     * @brief Stops the consumers; each drains its queue before exiting.
+     */
+    void SampleBus::stop()
+    {
+        running = false;
+        for (std::unique_ptr<Subscriber> &subscriber : subscribers)
+        {
+            wake(subscriber.get());
+        }
+        for (std::unique_ptr<Subscriber> &subscriber : subscribers)
+        {
+            if (subscriber->thread.joinable())
+            {
+                subscriber->thread.join();
+            }
+        }
+    }
+
+    /**
+     * @brief Hands a sample to every subscriber.
+     *
+     * A subscriber is woken only when everything queued before this
+     * sample was delivered, so a burst costs it one eventfd write.
+     *
+     * @param record Sample to copy into each subscriber queue.
+     * @return true if every subscriber accepted it, false if at least one queue was full.
+     */
+    bool SampleBus::publish(const SampleRecord &record)
+    {
+        Common::NoAllocScope noAlloc("SampleBus::publish");
+        bool accepted = true;
+        for (std::unique_ptr<Subscriber> &subscriber : subscribers)
+        {
+            if (!subscriber->queue.tryPush(record))
+            {
+                subscriber->dropped.fetch_add(1, std::memory_order_relaxed);
+                accepted = false;
+            }
+            else if (subscriber->queued.fetch_add(1) == subscriber->delivered.load())
+            {
+                wake(subscriber.get());
+            }
+        }
+        return accepted;
+    }
+
+    /**
+     * @brief Number of samples handed to the subscriber's handler.
+     */
+    unsigned long SampleBus::getDelivered(int subscriberId) const
+    {
+        if (subscriberId < 0 || subscriberId >= (int)subscribers.size())
+        {
+            return 0;
+        }
+        return subscribers[subscriberId]->delivered.load();
+    }
+
+    /**
+     * @brief Number of samples lost because the subscriber's queue was full.
+     */
+    unsigned long SampleBus::getDropped(int subscriberId) const
+    {
+        if (subscriberId < 0 || subscriberId >= (int)subscribers.size())
+        {
+            return 0;
+        }
+        return subscribers[subscriberId]->dropped.load();
+    }
+
+    /**
+     * @brief Wakes a consumer blocked on its eventfd.
+     */
+    void SampleBus::wake(Subscriber *subscriber)
+    {
+        uint64_t one = 1;
+        if (subscriber->wakeFd != -1 && write(subscriber->wakeFd, &one, sizeof(one)) < 0)
+        {
+            // The counter only saturates if the consumer stopped reading; it is awake anyway
+        }
+    }
+
+    /**
+     * @brief Consumer thread: drains the queue, blocking on the eventfd when it is empty.
+     */
+    void SampleBus::consume(Subscriber *subscriber)
+    {
+        SampleRecord record;
+        for (;;)
+        {
+            bool stopping = !running.load();
+            bool drained = true;
+            while (subscriber->queue.tryPop(record))
+            {
+                subscriber->handler(record);
+                subscriber->delivered.fetch_add(1);
+                drained = false;
+            }
+            if (stopping)
+            {
+                break;
+            }
+            if (!drained)
+            {
+                continue;
+            }
+            if (subscriber->delivered.load() != subscriber->queued.load())
+            {
+                // A publisher holding an earlier ring slot has not published it yet
+                std::this_thread::yield();
+            }
+            else if (subscriber->wakeFd == -1)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(SAMPLE_BUS_IDLE_US));
+            }
+            else
+            {
+                // Seq-cst counters: either this load saw the new sample or its publisher sees
+                // delivered == queued and writes the eventfd, so no wake-up is lost
+                uint64_t wakeups;
+                if (read(subscriber->wakeFd, &wakeups, sizeof(wakeups)) < 0)
+                {
+                    // EINTR: re-check the queue
+                }
+            }
+        }
+    }
+} // namespace Acquisition
@@ -0,0 +1,348 @@
+#include "../Inc/Scheduler.h"
+#include "../../common/Inc/Log.h"
+#include "../../periferia/Inc/gpio_backend.h"
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <climits>
+#include <chrono>
+
+// Dedicated workers re-check stop() at least this often while sleeping
+#define SLEEP_SLICE_NS 50000000ULL
+
+namespace Acquisition
+{
+    /**
+     * @brief Constructs an idle scheduler.
+     * @param config Worker counts, real-time priority and history size.
+     */
+    Scheduler::Scheduler(const SchedulerConfig &config)
+        : config(config), bus(nullptr), running(false), realtimeWorkers(0)
+    {
+    }
+
+    /**
+     * @brief Stops and joins all workers.
+     */
+    Scheduler::~Scheduler()
+    {
+        stop();
+    }
+
+    /**
+     * @brief Registers a sensor to be read periodically.
+     *
+     * Sensors can only be added while the scheduler is stopped. The sensor is
+     * not owned and must outlive the scheduler.
+     *
+     * @param sensor Sensor driver.
+     * @param periodMs Time between cycle starts.
+     * @param deadlineMs Time after the scheduled start by which the cycle must end, 0 for one period.
+     * @return Sensor id used by getStats()/getRecords(), or ERROR.
+     */
+    int Scheduler::addSensor(Sensors::SensorBase *sensor, unsigned int periodMs, unsigned int deadlineMs)
+    {
+        if (running.load() || sensor == nullptr || periodMs == 0)
+        {
+            LOG_ERROR("Cannot add sensor to the scheduler.\n");
+            return ERROR;
+        }
+
+        std::unique_ptr<Task> task(new Task());
+        task->sensor = sensor;
+        task->id = (int)tasks.size();
+        task->schema = sensor->schema();
+        task->periodNs = periodMs * 1000000ULL;
+        task->deadlineNs = (deadlineMs == 0 ? periodMs : deadlineMs) * 1000000ULL;
+        task->nextRunNs = 0;
+        task->dedicated = sensor->isTimingCritical();
+        task->busy = false;
+        task->history.resize(config.historyCapacity);
+        task->historyHead = 0;
+        task->historyCount = 0;
+        tasks.push_back(std::move(task));
+        return tasks.back()->id;
+    }
+
+    /**
+     * @brief Starts one dedicated worker per timing-critical sensor and the shared pool.
+     * @return true if workers were started, false if already running or empty.
+     */
+    bool Scheduler::start()
+    {
+        if (running.load() || tasks.empty())
+        {
+            return false;
+        }
+        Log::start();
+        running = true;
+
+        unsigned long long now = Periferia::monotonicNs();
+        int sharedTasks = 0;
+        int cpu = config.firstRealtimeCpu;
+        for (std::unique_ptr<Task> &task : tasks)
+        {
+            task->nextRunNs = now;
+            if (task->dedicated)
+            {
+                workers.emplace_back(&Scheduler::dedicatedWorker, this, task.get(), cpu);
+                if (cpu >= 0)
+                {
+                    cpu++;
+                }
+            }
+            else
+            {
+                sharedTasks++;
+            }
+        }
+
+        int poolSize = (sharedTasks < config.sharedWorkers) ? sharedTasks : config.sharedWorkers;
+        for (int i = 0; i < poolSize; ++i)
+        {
+            workers.emplace_back(&Scheduler::sharedWorker, this);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Stops all workers after their current cycle and joins them.
+     */
+    void Scheduler::stop()
+    {
+        {
+            std::lock_guard<std::mutex> guard(poolLock);
+            running = false;
+        }
+        poolWake.notify_all();
+        for (std::thread &worker : workers)
+        {
+            if (worker.joinable())
+            {
+                worker.join();
+            }
+        }
+        workers.clear();
+    }
+
+    /**
+     * @brief Returns a copy of the counters of a sensor.
+     */
+    SensorStats Scheduler::getStats(int sensorId) const
+    {
+        if (sensorId < 0 || sensorId >= (int)tasks.size())
+        {
+            return SensorStats();
+        }
+        std::lock_guard<std::mutex> guard(tasks[sensorId]->lock);
+        return tasks[sensorId]->stats;
+    }
+
+    /**
+     * @brief Channels a sensor declared at registration.
+     * @param sensorId Id returned by addSensor().
+     * @return Its schema, or the SensorData schema for an unknown id.
+     */
+    const Sensors::SensorSchema &Scheduler::getSchema(int sensorId) const
+    {
+        if (sensorId < 0 || sensorId >= (int)tasks.size())
+        {
+            return Sensors::legacySchema();
+        }
+        return tasks[sensorId]->schema;
+    }
+
+    /**
+     * @brief Copies the most recent cycle records of a sensor, oldest first.
+     * @param sensorId Id returned by addSensor().
+     * @param records Destination array.
+     * @param maxRecords Capacity of records.
+     * @return Number of records copied.
+     */
+    size_t Scheduler::getRecords(int sensorId, SampleRecord *records, size_t maxRecords) const
+    {
+        if (sensorId < 0 || sensorId >= (int)tasks.size())
+        {
+            return 0;
+        }
+        const Task &task = *tasks[sensorId];
+        std::lock_guard<std::mutex> guard(task.lock);
+
+        size_t count = (task.historyCount < maxRecords) ? task.historyCount : maxRecords;
+        size_t capacity = task.history.size();
+        size_t first = (task.historyHead + capacity - count) % capacity;
+        for (size_t i = 0; i < count; ++i)
+        {
+            records[i] = task.history[(first + i) % capacity];
+        }
+        return count;
+    }
+
+    /**
+     * @brief Runs one open/read/close cycle, publishes it and records it.
+     */
+    void Scheduler::runCycle(Task &task)
+    {
+        SampleRecord record;
+        memset(&record, 0, sizeof(record));
+        record.sensorId = task.id;
+        record.scheduledNs = task.nextRunNs;
+        record.startNs = Periferia::monotonicNs();
+
+        record.ok = task.sensor->open();
+        if (record.ok)
+        {
+            record.ok = task.sensor->read(record.data);
+        }
+        task.sensor->close();
+        record.endNs = Periferia::monotonicNs();
+
+        if (bus != nullptr)
+        {
+            bus->publish(record);
+        }
+
+        unsigned long long jitter = record.startNs - record.scheduledNs;
+        std::lock_guard<std::mutex> guard(task.lock);
+        task.stats.runs++;
+        if (!record.ok)
+        {
+            task.stats.failures++;
+        }
+        if (record.endNs > record.scheduledNs + task.deadlineNs)
+        {
+            task.stats.deadlineMisses++;
+        }
+        task.stats.jitterNsTotal += jitter;
+        if (jitter > task.stats.jitterNsMax)
+        {
+            task.stats.jitterNsMax = jitter;
+        }
+        task.stats.busyNsTotal += record.endNs - record.startNs;
+
+        if (!task.history.empty())
+        {
+            task.history[task.historyHead] = record;
+            task.historyHead = (task.historyHead + 1) % task.history.size();
+            if (task.historyCount < task.history.size())
+            {
+                task.historyCount++;
+            }
+        }
+    }
+
+    /**
+     * @brief Moves the next run one period ahead, skipping periods that already passed.
+     */
+    void Scheduler::advance(Task &task, unsigned long long now)
+    {
+        task.nextRunNs += task.periodNs;
+        if (task.nextRunNs <= now)
+        {
+            unsigned long long missed = (now - task.nextRunNs) / task.periodNs + 1;
+            task.nextRunNs += missed * task.periodNs;
+            std::lock_guard<std::mutex> guard(task.lock);
+            task.stats.skippedPeriods += missed;
+        }
+    }
+
+    /**
+     * @brief Sleeps on CLOCK_MONOTONIC until an absolute time, in slices so stop() is noticed.
+     * @return true when the time was reached, false if the scheduler was stopped.
+     */
+    bool Scheduler::sleepUntil(unsigned long long deadlineNs)
+    {
+        while (running.load())
+        {
+            unsigned long long now = Periferia::monotonicNs();
+            if (now >= deadlineNs)
+            {
+                return true;
+            }
+            unsigned long long wake = (deadlineNs - now > SLEEP_SLICE_NS) ? now + SLEEP_SLICE_NS : deadlineNs;
+            struct timespec ts;
+            ts.tv_sec = wake / 1000000000ULL;
+            ts.tv_nsec = wake % 1000000000ULL;
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+        }
+        return false;
+    }
+
+    /**
+     * @brief Puts the calling worker in real-time mode as far as privileges allow.
+     *
+     * SCHED_FIFO, pinning, mlockall() and stack prefaulting each degrade on
+     * their own; the worker keeps running with whatever was achieved.
+     *
+     * @param cpu CPU to pin to, or -1.
+     */
+    void Scheduler::applyRealtime(int cpu)
+    {
+        Common::RealtimeConfig realtime;
+        realtime.priority = config.realtimePriority;
+        realtime.cpu = cpu;
+        realtime.lockMemory = config.lockMemory;
+        Common::RealtimeStatus status = Common::enterRealtime(realtime);
+        if (status.policy == SCHED_FIFO)
+        {
+            realtimeWorkers++;
+        }
+        LOG_DEBUG("Acquisition worker runs %s priority %d on CPU %d, memory %s\n", Common::policyName(status.policy),
+                  status.priority, status.cpu, status.memoryLocked ? "locked" : "pageable");
+    }
+
+    /**
+     * @brief Worker owning a single timing-critical sensor.
+     */
+    void Scheduler::dedicatedWorker(Task *task, int cpu)
+    {
+        applyRealtime(cpu);
+        while (sleepUntil(task->nextRunNs))
+        {
+            runCycle(*task);
+            advance(*task, Periferia::monotonicNs());
+        }
+    }
+
+    /**
+     * @brief Pool worker: repeatedly runs the earliest due shared sensor.
+     *
+     * The due sensor is found by a linear scan under poolLock, which stays
+     * cheap next to a sensor cycle even with hundreds of sensors.
+     */
+    void Scheduler::sharedWorker()
+    {
+        std::unique_lock<std::mutex> guard(poolLock);
+        while (running.load())
+        {
+            Task *due = nullptr;
+            for (std::unique_ptr<Task> &task : tasks)
+            {
+                if (!task->dedicated && !task->busy && (due == nullptr || task->nextRunNs < due->nextRunNs))
+                {
+                    due = task.get();
+                }
+            }
+            if (due == nullptr)
+            {
+                poolWake.wait(guard); // every shared sensor is being read by another worker
+                continue;
+            }
+
+            unsigned long long now = Periferia::monotonicNs();
+            if (due->nextRunNs > now)
+            {
+                poolWake.wait_for(guard, std::chrono::nanoseconds(due->nextRunNs - now));
+                continue;
+            }
+
+            due->busy = true;
+            guard.unlock();
+            runCycle(*due);
+            guard.lock();
+            advance(*due, Periferia::monotonicNs());
+            due->busy = false;
+            poolWake.notify_all();
+        }
+    }
+} // namespace Acquisition
@@ -0,0 +1,445 @@
+#include "../Inc/SharedReadings.h"
+#include "../../common/Inc/Log.h"
+#include "../../common/Inc/AllocTracker.h"
+#include <cmath>
+#include <cstring>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace Acquisition
+{
+    /**
+     * @brief Constructs a publisher; the segment is created by open().
+     * @param name POSIX shared memory name, starting with '/'.
+     */
+    SharedPublisher::SharedPublisher(const char *name) : name(name), segment(nullptr)
+    {
+    }
+
+    /**
+     * @brief Closes the segment if it is still open.
+     */
+    SharedPublisher::~SharedPublisher()
+    {
+        close();
+    }
+
+    /**
+     * @brief Creates a fresh segment under the name.
+     *
+     * A segment left by an earlier writer is unlinked first: readers that
+     * still map it keep their copy, see it as closed (or its writer gone)
+     * and reopen, instead of watching the counters jump back to zero.
+     *
+     * @return true if the segment is mapped and its header published.
+     */
+    bool SharedPublisher::open()
+    {
+        if (segment != nullptr)
+        {
+            return true;
+        }
+        shm_unlink(name);
+        int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            LOG_ERROR("Cannot create shared memory %s: %s\n", name, strerror(errno));
+            return false;
+        }
+        if (ftruncate(fd, sizeof(SharedSegment)) < 0)
+        {
+            LOG_ERROR("Cannot size shared memory %s: %s\n", name, strerror(errno));
+            ::close(fd);
+            shm_unlink(name);
+            return false;
+        }
+        void *memory = mmap(nullptr, sizeof(SharedSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (memory == MAP_FAILED)
+        {
+            LOG_ERROR("Cannot map shared memory %s: %s\n", name, strerror(errno));
+            shm_unlink(name);
+            return false;
+        }
+
+        // ftruncate() zero-filled the segment: no sensors, no readings
+        segment = static_cast<SharedSegment *>(memory);
+        segment->version = SHM_VERSION;
+        segment->segmentSize = sizeof(SharedSegment);
+        segment->writerPid.store((uint32_t)getpid(), std::memory_order_relaxed);
+        segment->magic.store(SHM_MAGIC, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Registers a sensor and its channels in the segment.
+     *
+     * Readers see the sensor once its entry is complete. A sensor already
+     * registered with the same name and channels (the daemon reloading its
+     * configuration) keeps its entry and history instead of taking a new one.
+     *
+     * @param sensorName Label readers look the sensor up by, truncated to SHM_NAME_SIZE - 1.
+     * @param schema Channels of the sensor, in the order of the published values.
+     * @return Index to publish under, or ERROR if the segment is closed or full.
+     */
+    int SharedPublisher::addSensor(const char *sensorName, const Sensors::SensorSchema &schema)
+    {
+        if (segment == nullptr)
+        {
+            return ERROR;
+        }
+        uint32_t index = segment->sensorCount.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < index; ++i)
+        {
+            const SharedSensor &existing = segment->sensors[i];
+            bool same = strncmp(existing.name, sensorName, sizeof(existing.name) - 1) == 0 &&
+                        existing.channelCount == (uint32_t)schema.count;
+            for (size_t c = 0; same && c < schema.count; ++c)
+            {
+                same = strncmp(existing.channels[c], schema.channels[c].name, sizeof(existing.channels[c]) - 1) == 0;
+            }
+            if (same)
+            {
+                return (int)i;
+            }
+        }
+        if (index >= SHM_MAX_SENSORS)
+        {
+            LOG_ERROR("Shared memory %s is full, %s not published.\n", name, sensorName);
+            return ERROR;
+        }
+        SharedSensor &sensor = segment->sensors[index];
+        snprintf(sensor.name, sizeof(sensor.name), "%s", sensorName);
+        sensor.channelCount = (uint32_t)schema.count;
+        for (size_t i = 0; i < schema.count; ++i)
+        {
+            snprintf(sensor.channels[i], sizeof(sensor.channels[i]), "%s", schema.channels[i].name);
+            snprintf(sensor.units[i], sizeof(sensor.units[i]), "%s", schema.channels[i].unit);
+        }
+        schemas[index] = schema;
+        segment->sensorCount.store(index + 1, std::memory_order_release);
+        return (int)index;
+    }
+
+    /**
+     * @brief Stores a reading in the sensor's ring and makes it the newest.
+     *
+     * Seqlock write: the slot's sequence goes odd, the words are stored,
+     * the sequence goes even, and only then is the published count moved
+     * on. A failed read is published with NaN values so readers see its age.
+     *
+     * @param sensorIndex Index returned by addSensor().
+     * @param timestampNs CLOCK_MONOTONIC time of the reading.
+     * @param ok read() result.
+     * @param values One value per channel of the sensor.
+     */
+    void SharedPublisher::publish(int sensorIndex, unsigned long long timestampNs, bool ok, const float *values)
+    {
+        Common::NoAllocScope noAlloc("SharedPublisher::publish");
+        if (segment == nullptr || sensorIndex < 0 ||
+            sensorIndex >= (int)segment->sensorCount.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        SharedSensor &sensor = segment->sensors[sensorIndex];
+        uint32_t serial = sensor.published.load(std::memory_order_relaxed);
+
+        SharedReading reading;
+        reading.timestampNs = timestampNs;
+        reading.serial = serial;
+        reading.ok = ok ? 1 : 0;
+        for (size_t i = 0; i < SENSOR_MAX_CHANNELS; ++i)
+        {
+            reading.values[i] = (ok && i < sensor.channelCount) ? values[i] : NAN;
+        }
+        uint32_t words[SharedSlot::WORDS];
+        memcpy(words, &reading, sizeof(words));
+
+        SharedSlot &slot = sensor.history[serial % SHM_HISTORY];
+        uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < SharedSlot::WORDS; ++i)
+        {
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+        sensor.published.store(serial + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Publishes a Scheduler cycle, e.g. from a SampleBus subscriber.
+     *
+     * SensorData fields are mapped onto the channels registered for the
+     * sensor by name.
+     *
+     * @param record Cycle record whose sensorId is the index returned by addSensor().
+     */
+    void SharedPublisher::publish(const SampleRecord &record)
+    {
+        if (segment == nullptr || record.sensorId < 0 ||
+            record.sensorId >= (int)segment->sensorCount.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        float values[SENSOR_MAX_CHANNELS];
+        Sensors::fromSensorData(schemas[record.sensorId], record.data, values);
+        publish(record.sensorId, record.endNs, record.ok, values);
+    }
+
+    /**
+     * @brief Marks the segment closed, unmaps it and removes its name.
+     *
+     * Readers that have it mapped keep the last readings.
+     */
+    void SharedPublisher::close()
+    {
+        if (segment == nullptr)
+        {
+            return;
+        }
+        segment->writerPid.store(0, std::memory_order_release);
+        munmap(segment, sizeof(SharedSegment));
+        shm_unlink(name);
+        segment = nullptr;
+    }
+
+    /**
+     * @brief Constructs a reader; the segment is mapped by open().
+     * @param name POSIX shared memory name used by the writer.
+     */
+    SharedReader::SharedReader(const char *name) : name(name), segment(nullptr), mappedSize(0)
+    {
+    }
+
+    /**
+     * @brief Unmaps the segment.
+     */
+    SharedReader::~SharedReader()
+    {
+        close();
+    }
+
+    /**
+     * @brief Maps the writer's segment read-only.
+     * @return false if there is no segment, it is still being created, or its layout differs.
+     */
+    bool SharedReader::open()
+    {
+        close();
+        int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat status;
+        if (fstat(fd, &status) < 0 || (size_t)status.st_size < sizeof(SharedSegment))
+        {
+            ::close(fd);
+            return false;
+        }
+        void *memory = mmap(nullptr, sizeof(SharedSegment), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (memory == MAP_FAILED)
+        {
+            LOG_ERROR("Cannot map shared memory %s: %s\n", name, strerror(errno));
+            return false;
+        }
+        segment = static_cast<const SharedSegment *>(memory);
+        mappedSize = sizeof(SharedSegment);
+        if (segment->magic.load(std::memory_order_acquire) != SHM_MAGIC || segment->version != SHM_VERSION ||
+            segment->segmentSize != sizeof(SharedSegment))
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Unmaps the segment.
+     */
+    void SharedReader::close()
+    {
+        if (segment != nullptr)
+        {
+            munmap(const_cast<SharedSegment *>(segment), mappedSize);
+            segment = nullptr;
+        }
+    }
+
+    /**
+     * @brief Number of sensors registered by the writer so far.
+     */
+    int SharedReader::getSensorCount() const
+    {
+        return (segment == nullptr) ? 0 : (int)segment->sensorCount.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Looks a sensor up by the name it was registered with.
+     * @return Its index, or -1.
+     */
+    int SharedReader::findSensor(const char *sensorName) const
+    {
+        int count = getSensorCount();
+        for (int i = 0; i < count; ++i)
+        {
+            if (strncmp(segment->sensors[i].name, sensorName, SHM_NAME_SIZE) == 0)
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Seqlock read of one slot.
+     *
+     * The copy is kept only if the sequence was even before it and
+     * unchanged after it; otherwise the writer was storing and the copy is
+     * retried, up to SHM_READ_RETRIES times.
+     */
+    bool SharedReader::readSlot(const SharedSlot &slot, SharedReading &reading) const
+    {
+        uint32_t words[SharedSlot::WORDS];
+        for (int attempt = 0; attempt < SHM_READ_RETRIES; ++attempt)
+        {
+            uint32_t before = slot.sequence.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                continue;
+            }
+            for (size_t i = 0; i < SharedSlot::WORDS; ++i)
+            {
+                words[i] = slot.words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == before)
+            {
+                memcpy(&reading, words, sizeof(reading));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Copies the newest reading of a sensor.
+     *
+     * If the writer moves on to the same slot while it is being copied (a
+     * full ring lap), the new newest reading is taken instead.
+     *
+     * @param sensorIndex Index from findSensor().
+     * @param reading Receives the reading.
+     * @return false if the sensor has no reading yet or no consistent copy was possible.
+     */
+    bool SharedReader::latest(int sensorIndex, SharedReading &reading) const
+    {
+        if (sensorIndex < 0 || sensorIndex >= getSensorCount())
+        {
+            return false;
+        }
+        const SharedSensor &sensor = segment->sensors[sensorIndex];
+        for (int attempt = 0; attempt < SHM_READ_RETRIES; ++attempt)
+        {
+            uint32_t published = sensor.published.load(std::memory_order_acquire);
+            if (published == 0)
+            {
+                return false;
+            }
+            uint32_t serial = published - 1;
+            if (readSlot(sensor.history[serial % SHM_HISTORY], reading) && reading.serial == serial)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Copies the newest readings of a sensor, oldest first.
+     *
+     * Readings overwritten by the writer while the ring is copied are left
+     * out, so fewer than requested may be returned.
+     *
+     * @param sensorIndex Index from findSensor().
+     * @param readings Destination array.
+     * @param maxReadings Capacity of readings; at most SHM_HISTORY are returned.
+     * @return Number of readings copied.
+     */
+    size_t SharedReader::history(int sensorIndex, SharedReading *readings, size_t maxReadings) const
+    {
+        if (sensorIndex < 0 || sensorIndex >= getSensorCount())
+        {
+            return 0;
+        }
+        const SharedSensor &sensor = segment->sensors[sensorIndex];
+        uint32_t published = sensor.published.load(std::memory_order_acquire);
+        size_t wanted = std::min<size_t>(std::min<size_t>(maxReadings, SHM_HISTORY), published);
+        size_t copied = 0;
+        for (uint32_t serial = published - (uint32_t)wanted; serial != published; ++serial)
+        {
+            SharedReading &reading = readings[copied];
+            if (readSlot(sensor.history[serial % SHM_HISTORY], reading) && reading.serial == serial)
+            {
+                copied++;
+            }
+        }
+        return copied;
+    }
+
+    /**
+     * @brief Newest reading as SensorData.
+     *
+     * Channels are matched by name; SensorData fields the sensor has no
+     * channel for are NaN.
+     *
+     * @return true if there is a reading and it was a successful read.
+     */
+    bool SharedReader::latestData(int sensorIndex, Sensors::SensorData &data) const
+    {
+        SharedReading reading;
+        if (!latest(sensorIndex, reading))
+        {
+            return false;
+        }
+        const SharedSensor &sensor = segment->sensors[sensorIndex];
+        data.temperature = NAN;
+        data.humidity = NAN;
+        data.light = NAN;
+        for (uint32_t i = 0; i < sensor.channelCount && i < SENSOR_MAX_CHANNELS; ++i)
+        {
+            if (strcmp(sensor.channels[i], "temperature") == 0)
+            {
+                data.temperature = reading.values[i];
+            }
+            else if (strcmp(sensor.channels[i], "humidity") == 0)
+            {
+                data.humidity = reading.values[i];
+            }
+            else if (strcmp(sensor.channels[i], "light") == 0)
+            {
+                data.light = reading.values[i];
+            }
+        }
+        return reading.ok != 0;
+    }
+
+    /**
+     * @brief True once the writer closed the segment or exited without closing it.
+     *
+     * The exit check is a kill(pid, 0) syscall; call this when readings
+     * stop getting newer, not on every read.
+     */
+    bool SharedReader::isClosed() const
+    {
+        if (segment == nullptr)
+        {
+            return true;
+        }
+        uint32_t pid = segment->writerPid.load(std::memory_order_acquire);
+        return pid == 0 || (kill((pid_t)pid, 0) < 0 && errno == ESRCH);
+    }
+} // namespace Acquisition
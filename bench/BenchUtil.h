@@ -0,0 +1,172 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+
+namespace Bench
+{
+    /**
+     * @brief Returns CLOCK_MONOTONIC in nanoseconds.
+     */
+    inline unsigned long long nowNs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    /**
+     * @brief Latency samples of one benchmark case.
+     */
+    struct Samples
+    {
+        std::vector<unsigned long long> ns;
+
+        explicit Samples(size_t capacity) { ns.reserve(capacity); }
+        void add(unsigned long long value) { ns.push_back(value); }
+
+        // Sorts in place; call before percentile()
+        void finish() { std::sort(ns.begin(), ns.end()); }
+        unsigned long long percentile(double p) const
+        {
+            if (ns.empty())
+            {
+                return 0;
+            }
+            size_t index = (size_t)(p / 100.0 * (ns.size() - 1) + 0.5);
+            return ns[index];
+        }
+        double mean() const
+        {
+            unsigned long long total = 0;
+            for (unsigned long long value : ns)
+            {
+                total += value;
+            }
+            return ns.empty() ? 0.0 : (double)total / ns.size();
+        }
+    };
+
+    /**
+     * @brief Prints one result row: name, count, mean, p50, p99, max and an extra column.
+     */
+    inline void report(FILE *out, const char *name, Samples &samples, const char *extraLabel, double extra)
+    {
+        samples.finish();
+        fprintf(out, "%-28s n=%-8zu mean=%9.1fns p50=%8lluns p99=%8lluns max=%9lluns %s=%.2f\n",
+                name, samples.ns.size(), samples.mean(), samples.percentile(50), samples.percentile(99),
+                samples.percentile(100), extraLabel, extra);
+    }
+
+    /**
+     * @brief Prints a log2 histogram of the samples in microseconds: <1us, <2us, <4us, ...
+     */
+    inline void histogram(FILE *out, const Samples &samples)
+    {
+        const int buckets = 16;
+        size_t counts[buckets] = {0};
+        for (unsigned long long value : samples.ns)
+        {
+            int bucket = 0;
+            for (unsigned long long us = value / 1000; us > 0 && bucket < buckets - 1; us >>= 1)
+            {
+                bucket++;
+            }
+            counts[bucket]++;
+        }
+        for (int bucket = 0; bucket < buckets; ++bucket)
+        {
+            if (counts[bucket] > 0)
+            {
+                fprintf(out, "    %s%6lluus %8zu  %5.2f%%\n", bucket == buckets - 1 ? ">=" : " <",
+                        1ULL << (bucket == buckets - 1 ? bucket - 1 : bucket),
+                        counts[bucket], 100.0 * counts[bucket] / samples.ns.size());
+            }
+        }
+    }
+
+    /**
+     * @brief Sends stdout (driver chatter) to /dev/null and returns a stream on the original stdout.
+     */
+    inline FILE *quietStdout()
+    {
+        FILE *out = fdopen(dup(STDOUT_FILENO), "w");
+        if (freopen("/dev/null", "w", stdout) == nullptr)
+        {
+            perror("freopen");
+        }
+        return out;
+    }
+
+    /**
+     * @brief Throw-away /sys/class/gpio look-alike in /tmp: export plus gpioN/{value,direction,edge}.
+     */
+    class FakeSysfs
+    {
+    public:
+        FakeSysfs() : created(false) { snprintf(path, sizeof(path), "/tmp/enviromonitor-sysfs-XXXXXX"); }
+        ~FakeSysfs()
+        {
+            if (created)
+            {
+                char command[sizeof(path) + 16];
+                snprintf(command, sizeof(command), "rm -rf %s", path);
+                if (system(command) != 0)
+                {
+                    fprintf(stderr, "Could not remove %s\n", path);
+                }
+            }
+        }
+
+        // Creates the tree with every pin reading 1; false if the directory cannot be made
+        bool create(const int *pins, int count)
+        {
+            if (mkdtemp(path) == nullptr)
+            {
+                perror("mkdtemp");
+                return false;
+            }
+            created = true;
+            char file[sizeof(path) + 64];
+            for (int i = 0; i < count; ++i)
+            {
+                snprintf(file, sizeof(file), "%s/gpio%d", path, pins[i]);
+                mkdir(file, 0755);
+                const char *names[] = {"value", "direction", "edge"};
+                for (const char *name : names)
+                {
+                    snprintf(file, sizeof(file), "%s/gpio%d/%s", path, pins[i], name);
+                    writeFile(file, "1\n");
+                }
+            }
+            snprintf(file, sizeof(file), "%s/export", path);
+            writeFile(file, "");
+            return true;
+        }
+
+        const char *root() const { return path; }
+
+    private:
+        static void writeFile(const char *file, const char *content)
+        {
+            FILE *stream = fopen(file, "w");
+            if (stream != nullptr)
+            {
+                fputs(content, stream);
+                fclose(stream);
+            }
+        }
+
+        char path[64];
+        bool created;
+    };
+
+} // namespace Bench
+
+#endif // BENCH_UTIL_H
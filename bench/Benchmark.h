@@ -0,0 +1,308 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+/*
+ * Minimal Google-Benchmark-style harness: register functions with
+ * BENCHMARK(fn), loop on state.keepRunning(), and the runner picks the
+ * iteration count, reports ns/iteration and writes the same JSON schema as
+ * --benchmark_format=json of Google Benchmark, so existing comparison
+ * tooling (compare.py) can diff two runs.
+ *
+ *   static void BM_Read(Bench::State &state)
+ *   {
+ *       while (state.keepRunning())
+ *       {
+ *           gpio.read();
+ *       }
+ *       state.counter("syscalls_per_iter", ...);
+ *   }
+ *   BENCHMARK(BM_Read);
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+// Keep growing the iteration count until a run takes this long
+#define BENCH_MIN_TIME_NS 200000000ULL
+#define BENCH_MAX_ITERATIONS 1000000000LL
+
+#ifndef BENCH_VARIANT
+#define BENCH_VARIANT "unknown"
+#endif
+
+namespace Bench
+{
+    inline unsigned long long clockNs(clockid_t clock)
+    {
+        struct timespec ts;
+        clock_gettime(clock, &ts);
+        return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    /**
+     * @brief Iteration control and counters of one benchmark run.
+     */
+    class State
+    {
+    public:
+        explicit State(long long iterations)
+            : target(iterations), done(0), realNs(0), cpuNs(0), running(false), realStart(0), cpuStart(0)
+        {
+        }
+
+        // True while more iterations are needed; the timer runs between the first and last call
+        bool keepRunning()
+        {
+            if (done == 0 && !running)
+            {
+                resumeTiming();
+            }
+            if (done < target)
+            {
+                done++;
+                return true;
+            }
+            pauseTiming();
+            return false;
+        }
+
+        // Exclude setup inside the loop from the measurement
+        void pauseTiming()
+        {
+            if (running)
+            {
+                realNs += clockNs(CLOCK_MONOTONIC) - realStart;
+                cpuNs += clockNs(CLOCK_THREAD_CPUTIME_ID) - cpuStart;
+                running = false;
+            }
+        }
+        void resumeTiming()
+        {
+            if (!running)
+            {
+                realStart = clockNs(CLOCK_MONOTONIC);
+                cpuStart = clockNs(CLOCK_THREAD_CPUTIME_ID);
+                running = true;
+            }
+        }
+
+        // Extra value reported with the result (JSON field and console column)
+        void counter(const char *name, double value) { counters.push_back(std::make_pair(std::string(name), value)); }
+
+        long long iterations() const { return target; }
+        unsigned long long getRealNs() const { return realNs; }
+        unsigned long long getCpuNs() const { return cpuNs; }
+        const std::vector<std::pair<std::string, double>> &getCounters() const { return counters; }
+
+    private:
+        long long target;
+        long long done;
+        unsigned long long realNs;
+        unsigned long long cpuNs;
+        bool running;
+        unsigned long long realStart;
+        unsigned long long cpuStart;
+        std::vector<std::pair<std::string, double>> counters;
+    };
+
+    typedef void (*BenchmarkFunction)(State &);
+
+    struct Registration
+    {
+        const char *name;
+        BenchmarkFunction function;
+    };
+
+    inline std::vector<Registration> &registry()
+    {
+        static std::vector<Registration> benchmarks;
+        return benchmarks;
+    }
+
+    inline int registerBenchmark(const char *name, BenchmarkFunction function)
+    {
+        registry().push_back(Registration{name, function});
+        return 0;
+    }
+
+    struct Result
+    {
+        std::string name;
+        long long iterations;
+        double realNsPerIteration;
+        double cpuNsPerIteration;
+        std::vector<std::pair<std::string, double>> counters;
+    };
+
+    /**
+     * @brief Runs one benchmark with a growing iteration count until it takes BENCH_MIN_TIME_NS.
+     */
+    inline Result runOne(const Registration &benchmark)
+    {
+        long long iterations = 1;
+        for (;;)
+        {
+            State state(iterations);
+            benchmark.function(state);
+            unsigned long long elapsed = state.getRealNs();
+            if (elapsed >= BENCH_MIN_TIME_NS || iterations >= BENCH_MAX_ITERATIONS)
+            {
+                Result result;
+                result.name = benchmark.name;
+                result.iterations = iterations;
+                result.realNsPerIteration = (double)elapsed / iterations;
+                result.cpuNsPerIteration = (double)state.getCpuNs() / iterations;
+                result.counters = state.getCounters();
+                return result;
+            }
+            // Aim 40% past the minimum, growing at most 10x per step
+            double scale = (elapsed == 0) ? 10.0 : 1.4 * BENCH_MIN_TIME_NS / elapsed;
+            scale = (scale > 10.0) ? 10.0 : (scale < 2.0 ? 2.0 : scale);
+            iterations = (long long)(iterations * scale);
+            if (iterations > BENCH_MAX_ITERATIONS)
+            {
+                iterations = BENCH_MAX_ITERATIONS;
+            }
+        }
+    }
+
+    /**
+     * @brief Writes results in the Google Benchmark JSON schema.
+     */
+    inline void writeJson(FILE *out, const char *executable, const std::vector<Result> &results)
+    {
+        char date[64];
+        time_t now = time(nullptr);
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+        char host[128] = "unknown";
+        gethostname(host, sizeof(host) - 1);
+
+        fprintf(out, "{\n  \"context\": {\n");
+        fprintf(out, "    \"date\": \"%s\",\n", date);
+        fprintf(out, "    \"host_name\": \"%s\",\n", host);
+        fprintf(out, "    \"executable\": \"%s\",\n", executable);
+        fprintf(out, "    \"num_cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+        fprintf(out, "    \"build_variant\": \"%s\",\n", BENCH_VARIANT);
+#ifdef __OPTIMIZE__
+        fprintf(out, "    \"library_build_type\": \"release\"\n");
+#else
+        fprintf(out, "    \"library_build_type\": \"debug\"\n");
+#endif
+        fprintf(out, "  },\n  \"benchmarks\": [\n");
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result &result = results[i];
+            fprintf(out, "    {\n");
+            fprintf(out, "      \"name\": \"%s\",\n", result.name.c_str());
+            fprintf(out, "      \"run_name\": \"%s\",\n", result.name.c_str());
+            fprintf(out, "      \"run_type\": \"iteration\",\n");
+            fprintf(out, "      \"iterations\": %lld,\n", result.iterations);
+            fprintf(out, "      \"real_time\": %.4f,\n", result.realNsPerIteration);
+            fprintf(out, "      \"cpu_time\": %.4f,\n", result.cpuNsPerIteration);
+            for (const std::pair<std::string, double> &counter : result.counters)
+            {
+                fprintf(out, "      \"%s\": %.6g,\n", counter.first.c_str(), counter.second);
+            }
+            fprintf(out, "      \"time_unit\": \"ns\"\n");
+            fprintf(out, "    }%s\n", (i + 1 < results.size()) ? "," : "");
+        }
+        fprintf(out, "  ]\n}\n");
+    }
+
+    /**
+     * @brief Prints one console row per result.
+     */
+    inline void writeConsole(FILE *out, const std::vector<Result> &results)
+    {
+        fprintf(out, "%-36s %14s %14s %12s\n", "Benchmark", "Time", "CPU", "Iterations");
+        for (const Result &result : results)
+        {
+            fprintf(out, "%-36s %11.1f ns %11.1f ns %12lld", result.name.c_str(), result.realNsPerIteration,
+                    result.cpuNsPerIteration, result.iterations);
+            for (const std::pair<std::string, double> &counter : result.counters)
+            {
+                fprintf(out, " %s=%.4g", counter.first.c_str(), counter.second);
+            }
+            fprintf(out, "\n");
+        }
+    }
+
+    /**
+     * @brief Runs the registered benchmarks.
+     *
+     * Options (Google Benchmark names): --benchmark_filter=<substring>,
+     * --benchmark_format=console|json, --benchmark_out=<file> (JSON).
+     *
+     * @return 0 on success, 1 on bad options or an unwritable output file.
+     */
+    inline int runBenchmarks(int argc, char *argv[], FILE *console)
+    {
+        const char *filter = "";
+        const char *outPath = nullptr;
+        bool json = false;
+        for (int i = 1; i < argc; ++i)
+        {
+            if (strncmp(argv[i], "--benchmark_filter=", 19) == 0)
+            {
+                filter = argv[i] + 19;
+            }
+            else if (strcmp(argv[i], "--benchmark_format=json") == 0)
+            {
+                json = true;
+            }
+            else if (strcmp(argv[i], "--benchmark_format=console") == 0)
+            {
+                json = false;
+            }
+            else if (strncmp(argv[i], "--benchmark_out=", 16) == 0)
+            {
+                outPath = argv[i] + 16;
+            }
+            else
+            {
+                fprintf(stderr, "Unknown option %s\n", argv[i]);
+                return 1;
+            }
+        }
+
+        std::vector<Result> results;
+        for (const Registration &benchmark : registry())
+        {
+            if (strstr(benchmark.name, filter) != nullptr)
+            {
+                results.push_back(runOne(benchmark));
+            }
+        }
+
+        if (json)
+        {
+            writeJson(console, argv[0], results);
+        }
+        else
+        {
+            writeConsole(console, results);
+        }
+        if (outPath != nullptr)
+        {
+            FILE *file = fopen(outPath, "w");
+            if (file == nullptr)
+            {
+                perror(outPath);
+                return 1;
+            }
+            writeJson(file, argv[0], results);
+            fclose(file);
+        }
+        return 0;
+    }
+
+} // namespace Bench
+
+#define BENCHMARK(function) static int benchmark_##function = Bench::registerBenchmark(#function, function)
+
+#endif // BENCHMARK_H
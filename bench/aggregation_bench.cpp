@@ -0,0 +1,168 @@
+/*
+ * Windowed aggregation: cost per sample and correctness of the summaries.
+ *
+ * SENSORS sensors produce a reading every PERIOD_MS of simulated time
+ * (a slow random walk at the DHT22's 0.1 resolution, with FAILURE_PERCENT
+ * failed reads), for RECORDS records in total. The records are fed to a
+ * tumbling and a sliding aggregator; add() is timed per record, which
+ * includes publishing. Every published window is recomputed by brute
+ * force over the records and compared. The input/output ratio is the
+ * reduction in what has to be shipped downstream.
+ */
+#include "BenchUtil.h"
+#include "../processing/Inc/Aggregator.h"
+#include "../common/Inc/Log.h"
+#include <cmath>
+
+#define RECORDS 2000000
+#define SENSORS 4
+#define PERIOD_MS 10
+#define FAILURE_PERCENT 1
+#define TUMBLING_MS 60000
+#define SLIDING_MS 10000
+#define SLIDING_CADENCE_MS 1000
+
+static unsigned long long rngState = 88172645463325252ULL;
+
+static unsigned long long randomNext()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
+/**
+ * @brief Nearest-rank quantile of sorted values.
+ */
+static float quantileOf(const std::vector<float> &sorted, double q)
+{
+    size_t rank = std::max<size_t>(1, (size_t)std::ceil(q * sorted.size()));
+    return sorted[rank - 1];
+}
+
+/**
+ * @brief Recomputes a window from the records and compares it with the aggregator's result.
+ * @return true if they agree (quantiles to within one resolution step).
+ */
+static bool check(const std::vector<Acquisition::SampleRecord> &records, const Processing::WindowResult &result)
+{
+    std::vector<float> values[AGG_CHANNELS];
+    // Records are in endNs order: start at the window instead of scanning them all
+    auto first = std::lower_bound(records.begin(), records.end(), result.startNs,
+                                  [](const Acquisition::SampleRecord &record, unsigned long long timeNs) {
+                                      return record.endNs < timeNs;
+                                  });
+    for (auto it = first; it != records.end() && it->endNs < result.endNs; ++it)
+    {
+        const Acquisition::SampleRecord &record = *it;
+        if (record.sensorId == result.sensorId && record.ok)
+        {
+            values[0].push_back(record.data.temperature);
+            values[1].push_back(record.data.humidity);
+        }
+    }
+    const Processing::ChannelSummary *summaries[2] = {&result.temperature, &result.humidity};
+    for (int c = 0; c < 2; ++c)
+    {
+        std::vector<float> &sorted = values[c];
+        if (sorted.size() != result.samples || sorted.size() != summaries[c]->count)
+        {
+            return false;
+        }
+        if (sorted.empty())
+        {
+            continue;
+        }
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for (float value : sorted)
+        {
+            total += value;
+        }
+        const Processing::ChannelSummary &summary = *summaries[c];
+        if (summary.min != sorted.front() || summary.max != sorted.back() ||
+            std::fabs(summary.mean - total / sorted.size()) > 1e-3 ||
+            std::fabs(summary.p50 - quantileOf(sorted, 0.50)) > 0.051 ||
+            std::fabs(summary.p90 - quantileOf(sorted, 0.90)) > 0.051 ||
+            std::fabs(summary.p99 - quantileOf(sorted, 0.99)) > 0.051)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int run(FILE *out, const char *name, const Processing::WindowConfig &config,
+               const std::vector<Acquisition::SampleRecord> &records)
+{
+    std::vector<Processing::WindowResult> results;
+    Processing::Aggregator aggregator(config, [&results](const Processing::WindowResult &result) {
+        results.push_back(result);
+    });
+    for (int sensor = 0; sensor < SENSORS; ++sensor)
+    {
+        aggregator.setChannels(sensor, AGG_TEMPERATURE | AGG_HUMIDITY); // DHT22: no light
+    }
+
+    Bench::Samples addNs(records.size());
+    for (const Acquisition::SampleRecord &record : records)
+    {
+        unsigned long long before = Bench::nowNs();
+        aggregator.add(record);
+        addNs.add(Bench::nowNs() - before);
+    }
+    aggregator.flush();
+
+    int mismatches = 0;
+    for (const Processing::WindowResult &result : results)
+    {
+        mismatches += !check(records, result);
+    }
+    Bench::report(out, name, addNs, "records/window", (double)records.size() / results.size());
+    fprintf(out, "%-28s windows=%zu mismatches=%d\n", "", results.size(), mismatches);
+    return mismatches;
+}
+
+int main()
+{
+    const unsigned long long periodNs = PERIOD_MS * 1000000ULL;
+    std::vector<Acquisition::SampleRecord> records(RECORDS);
+    float temperature[SENSORS];
+    float humidity[SENSORS];
+    for (int sensor = 0; sensor < SENSORS; ++sensor)
+    {
+        temperature[sensor] = 20.0f + sensor;
+        humidity[sensor] = 40.0f + sensor;
+    }
+    for (int i = 0; i < RECORDS; ++i)
+    {
+        int sensor = i % SENSORS;
+        Acquisition::SampleRecord &record = records[i];
+        record.sensorId = sensor;
+        record.scheduledNs = 1000000000ULL + (unsigned long long)(i / SENSORS) * periodNs;
+        record.startNs = record.scheduledNs;
+        record.endNs = record.scheduledNs + 5000000ULL; // a DHT22 read takes about 5 ms
+        record.ok = (int)(randomNext() % 100) >= FAILURE_PERCENT;
+        temperature[sensor] = std::min(80.0f, std::max(-40.0f, temperature[sensor] + ((int)(randomNext() % 3) - 1) * 0.1f));
+        humidity[sensor] = std::min(100.0f, std::max(0.0f, humidity[sensor] + ((int)(randomNext() % 3) - 1) * 0.1f));
+        // Quantized the way the DHT22 decoder produces them
+        record.data.temperature = std::round(temperature[sensor] * 10.0f) / 10.0f;
+        record.data.humidity = std::round(humidity[sensor] * 10.0f) / 10.0f;
+        record.data.light = NAN; // not filled in by a DHT22
+    }
+
+    Processing::WindowConfig tumbling;
+    tumbling.kind = Processing::WindowKind::Tumbling;
+    tumbling.length = std::chrono::milliseconds(TUMBLING_MS);
+
+    Processing::WindowConfig sliding;
+    sliding.kind = Processing::WindowKind::Sliding;
+    sliding.length = std::chrono::milliseconds(SLIDING_MS);
+    sliding.cadence = std::chrono::milliseconds(SLIDING_CADENCE_MS);
+
+    int mismatches = run(stdout, "tumbling 60s", tumbling, records);
+    mismatches += run(stdout, "sliding 10s every 1s", sliding, records);
+    Log::flush();
+    return mismatches == 0 ? 0 : 1;
+}
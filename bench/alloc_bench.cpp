@@ -0,0 +1,245 @@
+/*
+ * Heap allocations on the acquisition path after warm-up; all must be zero.
+ *
+ * Each case calls one operation WARMUP times, then CALLS times inside a
+ * NoAllocScope, and reports the per-call latency and the allocations the
+ * scope saw: DHT22Sensor::read() on the simulated sensor (polling, with
+ * and without real-time mode, and edge capture), GPIO::read()/write() on every backend (fake sysfs tree,
+ * MockGPIOChip, anonymous page for mmap), SharedPublisher::publish(),
+ * SampleBus::publish() and LOG_WARN. Violations counted by the scopes
+ * inside the library itself, warm-up included, must be zero as well.
+ * Built with VARIANT=debug the first violation aborts instead. The
+ * counting hooks sit on malloc(), so allocations made by libc itself are
+ * included; a first check makes sure an fopen() is counted.
+ *
+ * Last, POOL_THREADS threads take and return Pool slots for POOL_MS,
+ * marking each slot while they own it; a slot handed out twice is counted.
+ */
+#include "BenchUtil.h"
+#include "../common/Inc/AllocTracker.h"
+#include "../common/Inc/Log.h"
+#include "../common/Inc/Pool.h"
+#include "../periferia/Inc/gpio.h"
+#include "../periferia/Inc/gpio_mock_chip.h"
+#include "../sensors/Inc/DHT22.h"
+#include "../sensors/Inc/DHT22Model.h"
+#include "../acquisition/Inc/SampleBus.h"
+#include "../acquisition/Inc/SharedReadings.h"
+#include <atomic>
+#include <sys/mman.h>
+#include <thread>
+
+#define WARMUP 3
+#define CALLS 20000
+#define SENSOR_CALLS 10
+#define WARNINGS 200
+#define POOL_SLOTS 64
+#define POOL_THREADS 4
+#define POOL_MS 500
+
+/**
+ * @brief Runs call() WARMUP times, then calls times in a NoAllocScope; returns 1 if any allocated.
+ */
+template <typename Call>
+static int check(FILE *out, const char *name, int calls, Call call)
+{
+    for (int i = 0; i < WARMUP; ++i)
+    {
+        call(i);
+    }
+    Bench::Samples samples(calls);
+    unsigned long allocations;
+    {
+        Common::NoAllocScope scope(name);
+        for (int i = 0; i < calls; ++i)
+        {
+            unsigned long long start = Bench::nowNs();
+            call(i);
+            samples.add(Bench::nowNs() - start);
+        }
+        allocations = scope.getAllocations();
+    }
+    Bench::report(out, name, samples, "allocations", (double)allocations);
+    return allocations == 0 ? 0 : 1;
+}
+
+static int checkGPIO(FILE *out, const char *name, const Periferia::GPIOConfig &config)
+{
+    Periferia::GPIO gpio(GPIO_DHT22, OUTPUT, config);
+    char label[48];
+    snprintf(label, sizeof(label), "GPIO::write %s", name);
+    int errors = check(out, label, CALLS, [&](int i) { gpio.write(i & 1); });
+    gpio.setDirection(INPUT);
+    snprintf(label, sizeof(label), "GPIO::read %s", name);
+    volatile int sink = 0;
+    errors += check(out, label, CALLS, [&](int) { sink += gpio.read(); });
+    (void)sink;
+    return errors;
+}
+
+static int checkDHT22(FILE *out, const char *name, Sensors::CaptureMode mode, bool realtime)
+{
+    Sensors::DHT22Model model;
+    Periferia::SimBackend simulator(&model, mode == Sensors::CaptureMode::EdgeTriggered);
+    Periferia::GPIOConfig config = Sensors::DHT22Sensor::persistentGPIOConfig();
+    config.customBackend = &simulator;
+    Sensors::DHT22Sensor sensor(GPIO_DHT22, config);
+    sensor.setCaptureMode(mode);
+    sensor.setStartPulse(std::chrono::microseconds(1000));
+    sensor.setRealtime(realtime);
+    if (!sensor.open())
+    {
+        return 1;
+    }
+    Sensors::SensorData data;
+    int ok = 0;
+    int errors = check(out, name, SENSOR_CALLS, [&](int) { ok += sensor.read(data); });
+    printf("%-28s ok=%d of %d\n", "", ok, WARMUP + SENSOR_CALLS);
+    sensor.close();
+    return errors;
+}
+
+/**
+ * @brief Hammers a Pool from several threads; returns the slots seen owned twice.
+ */
+static unsigned long checkPool()
+{
+    static Common::Pool<std::atomic<int>, POOL_SLOTS> pool;
+    std::atomic<unsigned long> duplicates(0);
+    std::atomic<unsigned long> rounds(0);
+    unsigned long long deadline = Bench::nowNs() + POOL_MS * 1000000ULL;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < POOL_THREADS; ++t)
+    {
+        threads.emplace_back([&]() {
+            uint32_t held[POOL_SLOTS / POOL_THREADS];
+            unsigned long local = 0;
+            while (Bench::nowNs() < deadline)
+            {
+                int count = 0;
+                for (; count < POOL_SLOTS / POOL_THREADS; ++count)
+                {
+                    held[count] = pool.acquire();
+                    if (held[count] == POOL_NONE)
+                    {
+                        break;
+                    }
+                    if (pool[held[count]].exchange(1) != 0)
+                    {
+                        duplicates.fetch_add(1);
+                    }
+                }
+                for (int i = 0; i < count; ++i)
+                {
+                    pool[held[i]].store(0);
+                    pool.release(held[i]);
+                }
+                local++;
+            }
+            rounds.fetch_add(local);
+        });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    printf("%-28s threads=%d rounds=%lu duplicates=%lu\n", "Pool contention", POOL_THREADS, rounds.load(),
+           duplicates.load());
+    return duplicates.load();
+}
+
+/**
+ * @brief Checks that an allocation made inside libc is counted; returns 1 if it was not.
+ */
+static int checkLibcCounted()
+{
+    unsigned long before = Common::threadAllocationCount();
+    FILE *file = fopen("/proc/self/stat", "r");
+    if (file != nullptr)
+    {
+        fclose(file);
+    }
+    unsigned long counted = Common::threadAllocationCount() - before;
+    printf("%-28s allocations=%lu\n", "fopen (libc)", counted);
+    return counted > 0 ? 0 : 1;
+}
+
+int main()
+{
+    int errors = checkLibcCounted();
+    errors += checkDHT22(stdout, "DHT22 read, polling (sim)", Sensors::CaptureMode::Polling, false);
+    errors += checkDHT22(stdout, "DHT22 read, polling+rt (sim)", Sensors::CaptureMode::Polling, true);
+    errors += checkDHT22(stdout, "DHT22 read, edges (sim)", Sensors::CaptureMode::EdgeTriggered, false);
+
+    Bench::FakeSysfs sysfs;
+    const int pin = GPIO_DHT22;
+    if (!sysfs.create(&pin, 1))
+    {
+        return 1;
+    }
+    Periferia::GPIOConfig reopen;
+    reopen.sysfsRoot = sysfs.root();
+    errors += checkGPIO(stdout, "sysfs reopen", reopen);
+    Periferia::GPIOConfig persistent = reopen;
+    persistent.mode = Periferia::AccessMode::Persistent;
+    errors += checkGPIO(stdout, "sysfs persistent", persistent);
+
+    static Periferia::MockGPIOChip chip;
+    Periferia::GPIOConfig cdev;
+    cdev.backend = Periferia::Backend::Chardev;
+    cdev.chip = &chip;
+    cdev.chipLine = GPIO_DHT22 % MOCK_CHIP_LINES;
+    errors += checkGPIO(stdout, "chardev", cdev);
+
+    void *page = mmap(nullptr, Periferia::AM335X_GPIO_LAYOUT.mapSize, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED)
+    {
+        perror("mmap");
+        return 1;
+    }
+    Periferia::GPIOConfig mmapConfig;
+    mmapConfig.backend = Periferia::Backend::Mmap;
+    mmapConfig.registers = (volatile uint32_t *)page;
+    errors += checkGPIO(stdout, "mmap", mmapConfig);
+
+    char name[64];
+    snprintf(name, sizeof(name), "/enviromonitor-alloc-%d", (int)getpid());
+    Acquisition::SharedPublisher publisher(name);
+    if (!publisher.open())
+    {
+        return 1;
+    }
+    int shared = publisher.addSensor("bench", Sensors::legacySchema());
+    float values[3] = {21.5f, 45.0f, 300.0f};
+    errors += check(stdout, "SharedPublisher::publish", CALLS,
+                    [&](int i) { publisher.publish(shared, (unsigned long long)i, true, values); });
+    publisher.close();
+
+    Acquisition::SampleBus bus;
+    bus.subscribe("sink", [](const Acquisition::SampleRecord &) {});
+    bus.start();
+    Acquisition::SampleRecord record = {};
+    errors += check(stdout, "SampleBus::publish", CALLS, [&](int i) {
+        record.endNs = (unsigned long long)i;
+        bus.publish(record);
+    });
+    bus.stop();
+
+    // Warnings go to the async sink; keep them off the terminal
+    fflush(stderr);
+    int savedStderr = dup(STDERR_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    dup2(devNull, STDERR_FILENO);
+    errors += check(stdout, "LOG_WARN", WARNINGS, [](int i) { LOG_WARN("Allocation check warning %d\n", i); });
+    Log::flush();
+    dup2(savedStderr, STDERR_FILENO);
+    close(devNull);
+    close(savedStderr);
+
+    unsigned long violations = Common::allocationViolations();
+    printf("%-28s %lu\n", "violations in library scopes", violations);
+    errors += (int)checkPool();
+    Log::flush();
+    return (errors == 0 && violations == 0) ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+/*
+ * Row-wise records against column batches.
+ *
+ * The same RECORDS readings of SENSORS DHT22-like sensors are aggregated
+ * into tumbling windows twice: record by record through
+ * Aggregator::add(), walking SampleRecord structs, and through
+ * SampleBatch columns of BATCH_ROWS rows with Aggregator::addBatch().
+ * The windows must agree (mean to rounding). A second case compares the
+ * bare statistics kernels: Welford over the temperature field of an
+ * array of records against summarizeColumn() over a float column.
+ */
+#include "BenchUtil.h"
+#include "../processing/Inc/Aggregator.h"
+#include "../acquisition/Inc/SampleBatch.h"
+#include "../common/Inc/Log.h"
+#include <cmath>
+#include <memory>
+
+#define RECORDS 2000000
+#define SENSORS 4
+#define PERIOD_MS 10
+#define FAILURE_PERCENT 1
+#define WINDOW_MS 60000
+#define BATCH_ROWS 1024
+#define KERNEL_ROUNDS 20
+
+static unsigned long long rngState = 88172645463325252ULL;
+
+static unsigned long long randomNext()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
+static bool sameSummary(const Processing::ChannelSummary &a, const Processing::ChannelSummary &b)
+{
+    return a.count == b.count && a.min == b.min && a.max == b.max && std::fabs(a.mean - b.mean) < 1e-9 &&
+           std::fabs(a.stddev - b.stddev) < 1e-9 && a.p50 == b.p50 && a.p90 == b.p90 && a.p99 == b.p99;
+}
+
+static bool byWindow(const Processing::WindowResult &a, const Processing::WindowResult &b)
+{
+    return a.sensorId != b.sensorId ? a.sensorId < b.sensorId : a.startNs < b.startNs;
+}
+
+int main()
+{
+    const Sensors::SensorSchema schema = {2, {{"temperature", "C"}, {"humidity", "%RH"}}};
+    const unsigned long long periodNs = PERIOD_MS * 1000000ULL;
+    std::vector<Acquisition::SampleRecord> records(RECORDS);
+    float temperature[SENSORS];
+    for (int sensor = 0; sensor < SENSORS; ++sensor)
+    {
+        temperature[sensor] = 20.0f + sensor;
+    }
+    for (int i = 0; i < RECORDS; ++i)
+    {
+        int sensor = i % SENSORS;
+        Acquisition::SampleRecord &record = records[i];
+        record.sensorId = sensor;
+        record.scheduledNs = 1000000000ULL + (unsigned long long)(i / SENSORS) * periodNs;
+        record.startNs = record.scheduledNs;
+        record.endNs = record.scheduledNs + 5000000ULL;
+        record.ok = (int)(randomNext() % 100) >= FAILURE_PERCENT;
+        temperature[sensor] += ((int)(randomNext() % 3) - 1) * 0.1f;
+        record.data.temperature = std::round(temperature[sensor] * 10.0f) / 10.0f;
+        record.data.humidity = 40.0f + (float)(randomNext() % 200) * 0.1f;
+        record.data.light = NAN;
+    }
+
+    Processing::WindowConfig config;
+    config.length = std::chrono::milliseconds(WINDOW_MS);
+
+    // Row-wise: one SampleRecord at a time
+    std::vector<Processing::WindowResult> rowResults;
+    Processing::Aggregator rowAggregator(config, [&rowResults](const Processing::WindowResult &result) {
+        rowResults.push_back(result);
+    });
+    for (int sensor = 0; sensor < SENSORS; ++sensor)
+    {
+        rowAggregator.setChannels(sensor, AGG_TEMPERATURE | AGG_HUMIDITY);
+    }
+    unsigned long long start = Bench::nowNs();
+    for (const Acquisition::SampleRecord &record : records)
+    {
+        rowAggregator.add(record);
+    }
+    rowAggregator.flush();
+    double rowNs = (double)(Bench::nowNs() - start) / RECORDS;
+
+    // Column-wise: the acquisition side fills one batch per sensor, the aggregator takes full batches
+    std::vector<std::unique_ptr<Acquisition::SampleBatch>> batches;
+    for (int sensor = 0; sensor < SENSORS; ++sensor)
+    {
+        batches.emplace_back(new Acquisition::SampleBatch(sensor, schema, BATCH_ROWS));
+    }
+    std::vector<Processing::WindowResult> columnResults;
+    Processing::Aggregator columnAggregator(config, [&columnResults](const Processing::WindowResult &result) {
+        columnResults.push_back(result);
+    });
+    unsigned long long aggregateNs = 0;
+    start = Bench::nowNs();
+    for (const Acquisition::SampleRecord &record : records)
+    {
+        Acquisition::SampleBatch &batch = *batches[record.sensorId];
+        if (batch.full() || batch.getFailureCount() == batch.capacity())
+        {
+            unsigned long long before = Bench::nowNs();
+            columnAggregator.addBatch(batch);
+            aggregateNs += Bench::nowNs() - before;
+            batch.clear();
+        }
+        batch.append(record);
+    }
+    unsigned long long before = Bench::nowNs();
+    for (std::unique_ptr<Acquisition::SampleBatch> &batch : batches)
+    {
+        columnAggregator.addBatch(*batch);
+    }
+    columnAggregator.flush();
+    aggregateNs += Bench::nowNs() - before;
+    double columnNs = (double)(Bench::nowNs() - start) / RECORDS;
+
+    std::sort(rowResults.begin(), rowResults.end(), byWindow);
+    std::sort(columnResults.begin(), columnResults.end(), byWindow);
+    int mismatches = (rowResults.size() != columnResults.size());
+    for (size_t i = 0; i < rowResults.size() && i < columnResults.size(); ++i)
+    {
+        const Processing::WindowResult &a = rowResults[i];
+        const Processing::WindowResult &b = columnResults[i];
+        mismatches += !(a.sensorId == b.sensorId && a.startNs == b.startNs && a.samples == b.samples &&
+                        a.failures == b.failures && a.channels == b.channels &&
+                        sameSummary(a.temperature, b.temperature) && sameSummary(a.humidity, b.humidity));
+    }
+    printf("%-28s %6.1f ns/record windows=%zu\n", "aggregate add() rows", rowNs, rowResults.size());
+    printf("%-28s %6.1f ns/record (%.1f in addBatch) windows=%zu mismatches=%d\n", "aggregate addBatch() cols",
+           columnNs, (double)aggregateNs / RECORDS, columnResults.size(), mismatches);
+
+    // Bare kernels over one channel: struct walk against a contiguous column
+    std::vector<float> column(RECORDS);
+    for (int i = 0; i < RECORDS; ++i)
+    {
+        column[i] = records[i].data.temperature;
+    }
+    double rowMean = 0.0;
+    start = Bench::nowNs();
+    for (int round = 0; round < KERNEL_ROUNDS; ++round)
+    {
+        Processing::RunningStats stats;
+        for (const Acquisition::SampleRecord &record : records)
+        {
+            stats.add(record.data.temperature);
+        }
+        rowMean += stats.getMean();
+    }
+    double welfordNs = (double)(Bench::nowNs() - start) / ((double)KERNEL_ROUNDS * RECORDS);
+    double columnMean = 0.0;
+    start = Bench::nowNs();
+    for (int round = 0; round < KERNEL_ROUNDS; ++round)
+    {
+        columnMean += Processing::summarizeColumn(column.data(), column.size()).mean;
+    }
+    double kernelNs = (double)(Bench::nowNs() - start) / ((double)KERNEL_ROUNDS * RECORDS);
+    printf("%-28s %6.2f ns/value\n", "welford over records", welfordNs);
+    printf("%-28s %6.2f ns/value speedup=%.1fx mean_diff=%.2e\n", "summarizeColumn over column", kernelNs,
+           welfordNs / kernelNs, std::fabs(rowMean - columnMean) / KERNEL_ROUNDS);
+    Log::flush();
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+/*
+ * Many consumers reading one DHT22 through CachedSensor.
+ *
+ * CONSUMERS threads call read() in a tight loop for RUN_MS against the
+ * simulated sensor (edge capture, instant edges). The minimum interval is
+ * scaled down from the DHT22's 2 s to MIN_INTERVAL_MS so the run is short;
+ * what matters is that bus transactions stay at one per interval however
+ * many calls arrive. Each case reports the latency of read() as seen by
+ * the consumers, the call/transaction ratio, and the retry and fallback
+ * counters under fault injection. The direct cases read the DHT22Sensor
+ * from a single thread, since it is not safe to share. A cached case that
+ * ran more transactions than the interval allows (retries included) makes
+ * the program exit non-zero.
+ */
+#include "BenchUtil.h"
+#include "../sensors/Inc/CachedSensor.h"
+#include "../sensors/Inc/DHT22.h"
+#include "../sensors/Inc/DHT22Model.h"
+#include "../common/Inc/Log.h"
+#include <atomic>
+#include <thread>
+
+#define CONSUMERS 4
+#define RUN_MS 1000
+#define MIN_INTERVAL_MS 50
+#define SAMPLES_PER_THREAD 200000
+
+/**
+ * @brief Runs the consumers for RUN_MS; returns 1 if a cached case broke the rate limit.
+ */
+static int run(FILE *out, const char *name, const Sensors::DHT22ModelConfig &modelConfig, bool cached)
+{
+    Sensors::DHT22Model model(modelConfig);
+    Periferia::SimBackend simulator(&model, true);
+    Periferia::GPIOConfig config;
+    config.customBackend = &simulator;
+    Sensors::DHT22Sensor sensor(GPIO_DHT22, config);
+    sensor.setCaptureMode(Sensors::CaptureMode::EdgeTriggered);
+    sensor.setStartPulse(std::chrono::microseconds(1000));
+
+    Sensors::CachePolicy policy;
+    policy.minInterval = std::chrono::milliseconds(MIN_INTERVAL_MS);
+    policy.backoff = std::chrono::milliseconds(MIN_INTERVAL_MS);
+    policy.maxBackoff = std::chrono::milliseconds(4 * MIN_INTERVAL_MS);
+    Sensors::CachedSensor cache(sensor, name, policy);
+    Sensors::SensorBase &target = cached ? (Sensors::SensorBase &)cache : (Sensors::SensorBase &)sensor;
+
+    std::atomic<bool> running(true);
+    std::atomic<unsigned long> calls(0);
+    std::atomic<unsigned long> failed(0);
+    int threads = cached ? CONSUMERS : 1;
+    std::vector<Bench::Samples> samples(threads, Bench::Samples(SAMPLES_PER_THREAD));
+    std::vector<std::thread> consumers;
+    for (int i = 0; i < threads; ++i)
+    {
+        consumers.emplace_back([&, i]() {
+            while (running.load(std::memory_order_relaxed))
+            {
+                Sensors::SensorData data;
+                unsigned long long start = Bench::nowNs();
+                bool ok = target.read(data);
+                if (samples[i].ns.size() < SAMPLES_PER_THREAD)
+                {
+                    samples[i].add(Bench::nowNs() - start);
+                }
+                calls.fetch_add(1, std::memory_order_relaxed);
+                if (!ok)
+                {
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(RUN_MS));
+    running = false;
+    for (std::thread &consumer : consumers)
+    {
+        consumer.join();
+    }
+
+    Bench::Samples all(threads * SAMPLES_PER_THREAD);
+    for (const Bench::Samples &thread : samples)
+    {
+        all.ns.insert(all.ns.end(), thread.ns.begin(), thread.ns.end());
+    }
+    unsigned long transactions = cached ? cache.getTransactions() : simulator.getTransactions();
+    Bench::report(out, name, all, "calls/transaction", (double)calls / (transactions ? transactions : 1));
+    fprintf(out, "%-28s calls=%lu transactions=%lu retries=%llu fallbacks=%llu failed=%lu\n", "", calls.load(),
+            transactions, cached ? cache.getRetries() : 0ULL, cached ? cache.getFallbacks() : 0ULL, failed.load());
+    // One transaction at the start, then at most one per interval
+    return (cached && transactions > RUN_MS / MIN_INTERVAL_MS + 1) ? 1 : 0;
+}
+
+int main()
+{
+    FILE *out = Bench::quietStdout();
+    if (freopen("/dev/null", "w", stderr) == nullptr) // expected checksum warnings
+    {
+        perror("freopen");
+    }
+
+    int errors = 0;
+    Sensors::DHT22ModelConfig clean;
+    errors += run(out, "direct clean", clean, false);
+    errors += run(out, "cached clean", clean, true);
+
+    Sensors::DHT22ModelConfig faulty = clean;
+    faulty.badChecksumRate = 0.3;
+    faulty.missingAckRate = 0.1;
+    errors += run(out, "direct 30% checksum+10% ACK", faulty, false);
+    errors += run(out, "cached 30% checksum+10% ACK", faulty, true);
+
+    Log::flush();
+    fclose(out);
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,330 @@
+/*
+ * Daemon mode against the one-shot binary.
+ *
+ * In-process: LOOP_SENSORS fake sensors on LOOP_PERIOD_MS timers drive the
+ * event loop for LOOP_MS while a socket client asks for the status every
+ * CLIENT_EVERY wakeups. Reports the loop overhead per wakeup (time awake
+ * outside sensor reads), checks that the sensors were opened once, and
+ * counts heap allocations after the warm-up, which must be zero.
+ *
+ * Processes (when EnviroMonitor sits next to this binary): ONESHOT_RUNS
+ * runs of the one-shot binary on the simulated DHT22, then one daemon on
+ * the same sensor for DAEMON_MS. Compares wall time to the first reading,
+ * CPU time per reading and peak RSS; the daemon's per-cycle read time
+ * comes from the metrics file it writes on SIGTERM.
+ */
+#include "BenchUtil.h"
+#include "../service/Inc/Daemon.h"
+#include "../common/Inc/Log.h"
+#include "../common/Inc/AllocTracker.h"
+#include <spawn.h>
+#include <signal.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#define LOOP_SENSORS 4
+#define LOOP_PERIOD_MS 1
+#define LOOP_MS 2000
+#define WARMUP_WAKEUPS 200
+#define CLIENT_EVERY 50
+#define ONESHOT_RUNS 10
+#define DAEMON_PERIOD_MS 100
+#define DAEMON_MS 3000
+
+extern char **environ;
+
+class FakeSensor : public Sensors::SensorBase
+{
+public:
+    bool open() override
+    {
+        opens++;
+        return true;
+    }
+    bool read(Sensors::SensorData &data) override
+    {
+        data.temperature = 21.5f;
+        data.humidity = 45.0f;
+        data.light = 300.0f;
+        return true;
+    }
+    void close() override {}
+
+    int opens = 0;
+};
+
+/**
+ * @brief Connects to a UNIX socket; -1 if nothing listens there.
+ */
+static int connectTo(const char *path)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&address, sizeof(address)) < 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Reads a reply until the peer closes; returns its length.
+ */
+static size_t receiveAll(int fd, char *buffer, size_t size)
+{
+    size_t used = 0;
+    ssize_t length;
+    while (used < size - 1 && (length = recv(fd, buffer + used, size - 1 - used, 0)) > 0)
+    {
+        used += length;
+    }
+    buffer[used] = '\0';
+    close(fd);
+    return used;
+}
+
+static int loopCase(const std::string &socketPath)
+{
+    Service::DaemonConfig config;
+    config.socketPath = socketPath.c_str();
+    config.handleSignals = false;
+    Service::Daemon daemon(config);
+    FakeSensor sensors[LOOP_SENSORS];
+    for (int i = 0; i < LOOP_SENSORS; ++i)
+    {
+        char name[16];
+        snprintf(name, sizeof(name), "fake%d", i);
+        daemon.addSensor(name, &sensors[i], LOOP_PERIOD_MS);
+    }
+    if (!daemon.start())
+    {
+        printf("%-28s start failed\n", "event loop");
+        return 1;
+    }
+
+    char reply[DAEMON_REPLY_SIZE];
+    int badReplies = 0;
+    unsigned long allocationsBefore = 0;
+    unsigned long long end = Bench::nowNs() + LOOP_MS * 1000000ULL;
+    for (unsigned long wakeup = 0; Bench::nowNs() < end; ++wakeup)
+    {
+        if (wakeup == WARMUP_WAKEUPS)
+        {
+            allocationsBefore = Common::allocationCount();
+            Metrics::histogram("daemon_overhead_duration_seconds").reset();
+        }
+        if (wakeup % CLIENT_EVERY == 0)
+        {
+            int client = connectTo(socketPath.c_str());
+            unsigned long served = daemon.getStats().clients;
+            while (client >= 0 && daemon.getStats().clients == served)
+            {
+                daemon.runOnce(-1);
+            }
+            receiveAll(client, reply, sizeof(reply));
+            if (strstr(reply, "fake3 humidity 45.00 %RH") == nullptr)
+            {
+                badReplies++;
+            }
+            continue;
+        }
+        daemon.runOnce(-1);
+    }
+    unsigned long steadyAllocations = Common::allocationCount() - allocationsBefore;
+
+    const Service::DaemonStats &stats = daemon.getStats();
+    unsigned long cycles = 0;
+    unsigned long overruns = 0;
+    for (int i = 0; i < LOOP_SENSORS; ++i)
+    {
+        cycles += daemon.getSensorStats(i).cycles;
+        overruns += daemon.getSensorStats(i).overruns;
+    }
+    int opens = 0;
+    for (const FakeSensor &sensor : sensors)
+    {
+        opens += sensor.opens;
+    }
+    daemon.stop();
+
+    Metrics::Snapshot snapshot = Metrics::snapshot();
+    const Metrics::HistogramValue *overhead = snapshot.findHistogram("daemon_overhead_duration_seconds");
+    printf("%-28s n=%-8lu mean=%9.1fns p50=%8lluns p99=%8lluns max=%9lluns reads/wakeup=%.2f\n", "event loop overhead",
+           (unsigned long)overhead->count, overhead->meanNs(), (unsigned long long)overhead->percentileNs(50),
+           (unsigned long long)overhead->percentileNs(99), (unsigned long long)overhead->maxNs,
+           (double)cycles / stats.wakeups);
+    printf("%-28s reads=%lu overruns=%lu clients=%lu bad_replies=%d opens=%d steady_allocations=%lu\n", "", cycles,
+           overruns, stats.clients, badReplies, opens, steadyAllocations);
+    return (badReplies == 0 && opens == LOOP_SENSORS && steadyAllocations == 0) ? 0 : 1;
+}
+
+/**
+ * @brief Starts the EnviroMonitor binary with its output discarded.
+ */
+static pid_t spawn(const std::string &program, std::vector<const char *> args)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    args.insert(args.begin(), program.c_str());
+    args.push_back(nullptr);
+    pid_t pid = -1;
+    if (posix_spawn(&pid, program.c_str(), &actions, nullptr, (char *const *)args.data(), environ) != 0)
+    {
+        pid = -1;
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    return pid;
+}
+
+/**
+ * @brief Seconds of user plus system time used by waited-for children so far.
+ */
+static double childCpuSeconds(long *maxRssKb)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_CHILDREN, &usage);
+    *maxRssKb = usage.ru_maxrss;
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/**
+ * @brief Value of one line of a Prometheus text file, or -1.
+ */
+static double promValue(const std::string &path, const char *series)
+{
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == nullptr)
+    {
+        return -1.0;
+    }
+    char line[256];
+    double value = -1.0;
+    size_t length = strlen(series);
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        if (strncmp(line, series, length) == 0 && line[length] == ' ')
+        {
+            value = atof(line + length + 1);
+        }
+    }
+    fclose(file);
+    return value;
+}
+
+static int processCase(const std::string &program, const std::string &directory)
+{
+    long rssKb = 0;
+    double cpuBefore = childCpuSeconds(&rssKb);
+    Bench::Samples oneShot(ONESHOT_RUNS);
+    int oneShotFailures = 0;
+    for (int i = 0; i < ONESHOT_RUNS; ++i)
+    {
+        unsigned long long start = Bench::nowNs();
+        pid_t pid = spawn(program, {"--backend", "sim", "--edges"});
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            oneShotFailures++;
+        }
+        oneShot.add(Bench::nowNs() - start);
+    }
+    long oneShotRssKb = 0;
+    double oneShotCpu = (childCpuSeconds(&oneShotRssKb) - cpuBefore) / ONESHOT_RUNS;
+    Bench::report(stdout, "one-shot process", oneShot, "cpu_us/reading", oneShotCpu * 1e6);
+    printf("%-28s failures=%d peak_rss_kb=%ld\n", "", oneShotFailures, oneShotRssKb);
+
+    std::string socketPath = directory + "/daemon.sock";
+    std::string metricsPath = directory + "/daemon.prom";
+    char period[16];
+    snprintf(period, sizeof(period), "%d", DAEMON_PERIOD_MS);
+    cpuBefore = childCpuSeconds(&rssKb);
+    unsigned long long start = Bench::nowNs();
+    pid_t pid = spawn(program, {"--backend", "sim", "--edges", "--daemon", "--socket", socketPath.c_str(), "--period",
+                                period, "--metrics", metricsPath.c_str()});
+    if (pid < 0)
+    {
+        printf("%-28s spawn failed\n", "daemon");
+        return 1;
+    }
+    // First reading: the status shows a temperature instead of nan
+    char reply[DAEMON_REPLY_SIZE] = {0};
+    unsigned long long firstReadingNs = 0;
+    while (Bench::nowNs() - start < DAEMON_MS * 1000000ULL)
+    {
+        int client = connectTo(socketPath.c_str());
+        if (client >= 0 && receiveAll(client, reply, sizeof(reply)) > 0 &&
+            strstr(reply, "dht22 temperature nan") == nullptr && strstr(reply, "dht22 temperature") != nullptr)
+        {
+            firstReadingNs = Bench::nowNs() - start;
+            break;
+        }
+        usleep(1000);
+    }
+    usleep(DAEMON_MS * 1000 - (useconds_t)((Bench::nowNs() - start) / 1000));
+    int client = connectTo(socketPath.c_str());
+    if (client >= 0)
+    {
+        receiveAll(client, reply, sizeof(reply));
+    }
+    long daemonRssKb = -1;
+    const char *rss = strstr(reply, "rss_kb=");
+    if (rss != nullptr)
+    {
+        daemonRssKb = atol(rss + strlen("rss_kb="));
+    }
+    kill(pid, SIGTERM);
+    int status = 0;
+    bool clean = waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    long peakRssKb = 0;
+    double daemonCpu = childCpuSeconds(&peakRssKb) - cpuBefore;
+
+    double reads = promValue(metricsPath, "daemon_reads_total{sensor=\"dht22\"}");
+    double readSeconds = promValue(metricsPath, "daemon_read_duration_seconds_sum{sensor=\"dht22\"}");
+    double overheadSeconds = promValue(metricsPath, "daemon_overhead_duration_seconds_sum");
+    double wakeups = promValue(metricsPath, "daemon_overhead_duration_seconds_count");
+    printf("%-28s first_reading=%.1fms reads=%.0f cpu_us/reading=%.1f rss_kb=%ld clean_exit=%s\n", "daemon process",
+           firstReadingNs / 1e6, reads, reads > 0 ? daemonCpu * 1e6 / reads : 0.0, daemonRssKb, clean ? "yes" : "NO");
+    printf("%-28s read=%.1fus/cycle loop_overhead=%.2fus/wakeup\n", "", reads > 0 ? readSeconds * 1e6 / reads : 0.0,
+           wakeups > 0 ? overheadSeconds * 1e6 / wakeups : 0.0);
+    unlink(metricsPath.c_str());
+    return (clean && firstReadingNs > 0 && reads > 0) ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    char directory[] = "/tmp/enviromonitor-daemon-XXXXXX";
+    if (mkdtemp(directory) == nullptr)
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    int errors = loopCase(std::string(directory) + "/loop.sock");
+
+    std::string program = argv[0];
+    size_t slash = program.rfind('/');
+    program = (slash == std::string::npos ? std::string(".") : program.substr(0, slash)) + "/EnviroMonitor";
+    if (argc > 1)
+    {
+        program = argv[1];
+    }
+    if (access(program.c_str(), X_OK) == 0)
+    {
+        errors += processCase(program, directory);
+    }
+    else
+    {
+        printf("%-28s skipped, no %s\n", "process comparison", program.c_str());
+    }
+    rmdir(directory);
+    Log::flush();
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,51 @@
+/*
+ * Achieved vs requested delay: std::this_thread::sleep_for against the
+ * hybrid Common::delay (absolute sleep plus calibrated spin tail).
+ *
+ * Samples are the overshoot past the requested duration; neither method
+ * returns early. The requested values are the ones the DHT22 start signal
+ * and bit timing use.
+ */
+#include "BenchUtil.h"
+#include "../common/Inc/Timing.h"
+#include <thread>
+
+#define ROUNDS 500
+
+template <typename Wait>
+static void run(const char *name, long long requestedNs, Wait wait)
+{
+    int rounds = (requestedNs >= 1000000LL) ? ROUNDS / 10 : ROUNDS;
+    Bench::Samples overshoot(rounds);
+    for (int i = 0; i < rounds; ++i)
+    {
+        unsigned long long start = Bench::nowNs();
+        wait();
+        overshoot.add(Bench::nowNs() - start - requestedNs);
+    }
+    Bench::report(stdout, name, overshoot, "requested_us", requestedNs / 1000.0);
+}
+
+static void compare(long long requestedUs)
+{
+    std::chrono::microseconds duration(requestedUs);
+    char name[64];
+    snprintf(name, sizeof(name), "sleep_for %lldus", requestedUs);
+    run(name, requestedUs * 1000, [&]() { std::this_thread::sleep_for(duration); });
+    snprintf(name, sizeof(name), "Common::delay %lldus", requestedUs);
+    run(name, requestedUs * 1000, [&]() { Common::delay(duration); });
+}
+
+int main()
+{
+    const Common::TimingCalibration &calibration = Common::calibrateTiming();
+    printf("calibration: sleep overshoot p90 %lld ns, spin tail %lld ns\n", calibration.sleepOvershootNs,
+           calibration.spinNs);
+
+    const long long requestedUs[] = {10, 30, 80, 500, 18000};
+    for (long long us : requestedUs)
+    {
+        compare(us);
+    }
+    return 0;
+}
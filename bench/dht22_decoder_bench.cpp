@@ -0,0 +1,198 @@
+/*
+ * DHT22Decoder on synthetic frames, no hardware involved.
+ *
+ * Each case generates edge streams for random readings with a given pulse
+ * jitter and a constant latency added to every high pulse (what a slow
+ * capture path adds). The decode time is measured, and the success rate is
+ * shown for the adaptive threshold and for the fixed nominal BIT_SPLIT_US.
+ *
+ * Last, frames recorded by polling the simulated sensor from a thread that
+ * got descheduled mid-frame: edges were lost or moved, yet the pulses
+ * still add up to a valid checksum for a reading the model never sent.
+ * Each must be rejected as Timing; the program exits non-zero otherwise.
+ */
+#include "BenchUtil.h"
+#include "../sensors/Inc/DHT22Decoder.h"
+
+#define FRAMES 20000
+#define STALLED_TRACES 3
+#define STALLED_SEGMENTS 84
+
+using Sensors::DHT22Decoder;
+using Sensors::DHT22Frame;
+using Sensors::DHT22Status;
+
+static unsigned int rngState = 12345;
+
+static int randomInt(int range)
+{
+    rngState = rngState * 1103515245u + 12345u;
+    return (int)((rngState >> 8) % (unsigned int)range);
+}
+
+/**
+ * @brief Appends one level change, jittered by up to +-jitterUs.
+ */
+static void addEdge(Periferia::EdgeEvent *edges, int &count, unsigned long long &timeNs, int widthUs, int jitterUs, int value)
+{
+    int jitter = (jitterUs > 0) ? randomInt(2 * jitterUs + 1) - jitterUs : 0;
+    timeNs += (unsigned long long)(widthUs + jitter) * 1000ULL;
+    edges[count].timestampNs = timeNs;
+    edges[count].value = value;
+    count++;
+}
+
+/**
+ * @brief Builds the edge stream of a frame: idle high, ACK, 40 bits, release.
+ */
+static int synthesize(const uint8_t *bytes, int jitterUs, int latencyUs, Periferia::EdgeEvent *edges)
+{
+    int count = 0;
+    unsigned long long timeNs = 1000000;
+    edges[count].timestampNs = timeNs;
+    edges[count++].value = HIGH;
+    addEdge(edges, count, timeNs, 30, jitterUs, LOW);
+    addEdge(edges, count, timeNs, 80, jitterUs, HIGH);
+    addEdge(edges, count, timeNs, 80 + latencyUs, jitterUs, LOW);
+    for (int i = 0; i < DHT22_DATA_BIT_COUNT; ++i)
+    {
+        bool one = bytes[i / 8] & (0x80 >> (i % 8));
+        addEdge(edges, count, timeNs, 50 - latencyUs, jitterUs, HIGH);
+        addEdge(edges, count, timeNs, (one ? 70 : 27) + latencyUs, jitterUs, LOW);
+    }
+    addEdge(edges, count, timeNs, 50, jitterUs, HIGH);
+    return count;
+}
+
+static bool sameBytes(const uint8_t *a, const uint8_t *b)
+{
+    for (int i = 0; i < DHT22_DATA_BYTE_COUNT; ++i)
+    {
+        if (a[i] != b[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Classifies the captured pulses against the fixed nominal threshold.
+ */
+static bool fixedDecode(const DHT22Frame &frame, const uint8_t *expected)
+{
+    uint8_t bytes[DHT22_DATA_BYTE_COUNT] = {0};
+    for (int i = 0; i < DHT22_DATA_BIT_COUNT; ++i)
+    {
+        bytes[i / 8] <<= 1;
+        if (frame.pulseNs[i] >= BIT_SPLIT_US * 1000ULL)
+        {
+            bytes[i / 8] |= 1;
+        }
+    }
+    return sameBytes(bytes, expected);
+}
+
+static void run(const char *name, int jitterUs, int latencyUs)
+{
+    Periferia::EdgeEvent edges[2 * DHT22_DATA_BIT_COUNT + 8];
+    Bench::Samples samples(FRAMES);
+    int adaptiveOk = 0;
+    int fixedOk = 0;
+
+    for (int n = 0; n < FRAMES; ++n)
+    {
+        uint8_t bytes[DHT22_DATA_BYTE_COUNT];
+        int humidity = 200 + randomInt(700);
+        int temperature = randomInt(800) - 200;
+        bytes[0] = humidity >> 8;
+        bytes[1] = humidity & 0xFF;
+        bytes[2] = ((temperature < 0 ? -temperature : temperature) >> 8) | (temperature < 0 ? 0x80 : 0);
+        bytes[3] = (temperature < 0 ? -temperature : temperature) & 0xFF;
+        bytes[4] = (bytes[0] + bytes[1] + bytes[2] + bytes[3]) & 0xFF;
+        int edgeCount = synthesize(bytes, jitterUs, latencyUs, edges);
+
+        DHT22Frame frame;
+        unsigned long long start = Bench::nowNs();
+        DHT22Status status = DHT22Decoder::decode(edges, edgeCount, frame);
+        samples.add(Bench::nowNs() - start);
+
+        if (status == DHT22Status::Ok && sameBytes(frame.bytes, bytes))
+        {
+            adaptiveOk++;
+        }
+        if (status != DHT22Status::NoResponse && status != DHT22Status::Truncated && fixedDecode(frame, bytes))
+        {
+            fixedOk++;
+        }
+    }
+    Bench::report(stdout, name, samples, "adaptive_ok%", 100.0 * adaptiveOk / FRAMES);
+    printf("%-28s fixed_ok%%=%.2f\n", "", 100.0 * fixedOk / FRAMES);
+}
+
+/**
+ * @brief Polled captures, as microseconds between level changes starting from the idle high.
+ *
+ * Sent: 45.0 %RH, -7.3 C. Read with a checksum that matches: 1649.6 %RH and
+ * -821.0 C (a pulse pair hidden by a stall near the end), 3276.8 %RH and
+ * 12.8 C (a 133us low), 45.0 %RH and -8.9 C (two bits shifted by 25us).
+ */
+static const int STALLED[STALLED_TRACES][STALLED_SEGMENTS] = {
+    {28, 80, 80, 50, 26, 50, 26, 50, 26, 50, 26, 50, 26, 50, 26, 50, 26, 50, 70, 50,
+     70, 50, 70, 50, 26, 50, 26, 50, 26, 50, 26, 50, 70, 50, 26, 50, 70, 50, 26, 50,
+     26, 50, 26, 50, 26, 50, 26, 50, 26, 50, 26, 50, 26, 50, 70, 50, 26, 50, 26, 50,
+     70, 50, 26, 50, 26, 50, 70, 50, 70, 50, 26, 50, 26, 50, 26, 50, 70, 81, 38, 50},
+    {28, 80, 80, 50, 26, 50, 26, 50, 26, 50, 26, 50, 26, 50, 26, 50, 26, 50, 70, 50,
+     70, 50, 70, 50, 26, 50, 26, 50, 26, 50, 26, 50, 70, 50, 26, 50, 70, 50, 26, 50,
+     26, 50, 26, 50, 26, 50, 26, 50, 26, 50, 133, 19, 70, 50, 26, 50, 26, 50, 70, 50,
+     26, 50, 26, 50, 70, 50, 70, 50, 26, 50, 26, 50, 26, 50, 70, 50, 70, 50, 26, 50,
+     26, 50},
+    {28, 80, 80, 50, 26, 50, 26, 50, 26, 50, 26, 50, 26, 50, 26, 50, 26, 50, 70, 50,
+     70, 50, 70, 50, 26, 50, 26, 50, 26, 50, 26, 50, 70, 50, 26, 50, 70, 50, 26, 50,
+     26, 50, 26, 50, 26, 50, 26, 50, 26, 51, 26, 50, 26, 50, 70, 50, 26, 50, 53, 23,
+     70, 50, 26, 50, 26, 50, 70, 50, 70, 50, 26, 50, 26, 50, 54, 22, 70, 50, 70, 50,
+     26, 50, 26, 50},
+};
+
+/**
+ * @brief Decodes the recorded stalled captures; returns how many were not rejected as Timing.
+ */
+static int runStalled()
+{
+    static const char *const statusNames[] = {"ok", "no_response", "truncated", "timing", "checksum"};
+    int accepted = 0;
+    for (int t = 0; t < STALLED_TRACES; ++t)
+    {
+        Periferia::EdgeEvent edges[STALLED_SEGMENTS + 1];
+        unsigned long long timeNs = 1000000;
+        int level = HIGH;
+        int count = 0;
+        edges[count].timestampNs = timeNs;
+        edges[count++].value = level;
+        for (int i = 0; i < STALLED_SEGMENTS && STALLED[t][i] != 0; ++i)
+        {
+            timeNs += STALLED[t][i] * 1000ULL;
+            level = (level == HIGH) ? LOW : HIGH;
+            edges[count].timestampNs = timeNs;
+            edges[count++].value = level;
+        }
+        DHT22Frame frame;
+        DHT22Status status = DHT22Decoder::decode(edges, count, frame);
+        char name[32];
+        snprintf(name, sizeof(name), "stalled capture %d", t + 1);
+        printf("%-28s edges=%d checksum_ok=%d status=%s\n", name, count, DHT22Decoder::checksumValid(frame.bytes),
+               statusNames[static_cast<int>(status)]);
+        accepted += (status != DHT22Status::Timing);
+    }
+    return accepted;
+}
+
+int main()
+{
+    run("nominal", 0, 0);
+    run("jitter 5us", 5, 0);
+    run("jitter 10us", 10, 0);
+    run("latency 25us", 0, 25);
+    run("latency 25us + jitter 5us", 5, 25);
+    return runStalled() == 0 ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+/*
+ * DHT22Sensor::read() end to end against the simulated sensor.
+ *
+ * The sensor runs on a SimBackend with a DHT22Model, with a 1 ms start
+ * pulse (the datasheet minimum). Edge-triggered reads get the answer with
+ * model timestamps at once; polling reads busy-sample the waveform in real
+ * time, so they also measure how well the capture loop keeps up, with and
+ * without real-time mode (which needs CAP_SYS_NICE to matter). Each case
+ * reports read() latency and the success rate next to the rate the fault
+ * injection allows, plus the protocol phase percentiles and failure causes
+ * taken from a Metrics snapshot.
+ *
+ * A polled read can only be judged when the thread kept sampling: on a
+ * loaded or virtual CPU it is descheduled for longer than a data pulse,
+ * edges are lost and the frame fails (or, 1 in 256, passes the checksum
+ * with the wrong bits) through no fault of the capture loop. Polled reads
+ * whose longest sampling gap exceeds STALL_US are counted apart and left
+ * out of the success rate the check uses. The program exits non-zero when
+ * any read returns wrong values, or when a success rate falls more than
+ * OK_TOLERANCE_PCT below the expected one.
+ */
+#include "BenchUtil.h"
+#include "../sensors/Inc/DHT22.h"
+#include "../sensors/Inc/DHT22Model.h"
+#include "../common/Inc/Log.h"
+#include "../common/Inc/Metrics.h"
+#include <cmath>
+
+#define EDGE_READS 2000
+#define POLL_READS 200
+// Sampling gap above which a polled read may lose edges (a "0" bit is high for 26us)
+#define STALL_US 20
+#define OK_TOLERANCE_PCT 5.0
+// Fewer unstalled polled reads than this are reported but not judged
+#define MIN_JUDGED_READS 50
+
+static void reportMetrics(FILE *out)
+{
+    Metrics::Snapshot snapshot = Metrics::snapshot();
+    char labels[METRICS_LABELS_SIZE];
+    const char *phases[] = {"start", "ack", "capture", "decode"};
+    fprintf(out, "%-28s", "");
+    for (const char *phase : phases)
+    {
+        snprintf(labels, sizeof(labels), "pin=\"%d\",phase=\"%s\"", GPIO_DHT22, phase);
+        const Metrics::HistogramValue *histogram = snapshot.findHistogram("dht22_phase_duration_seconds", labels);
+        if (histogram != nullptr && histogram->count > 0)
+        {
+            fprintf(out, " %s p50=%lluus p99=%lluus", phase, (unsigned long long)histogram->percentileNs(50) / 1000,
+                    (unsigned long long)histogram->percentileNs(99) / 1000);
+        }
+    }
+    fprintf(out, "\n%-28s", "");
+    const char *causes[] = {"gpio", "no_response", "truncated", "timing", "checksum"};
+    for (const char *cause : causes)
+    {
+        snprintf(labels, sizeof(labels), "pin=\"%d\",cause=\"%s\"", GPIO_DHT22, cause);
+        const Metrics::CounterValue *failures = snapshot.findCounter("dht22_read_failures_total", labels);
+        fprintf(out, " %s=%llu", cause, failures != nullptr ? (unsigned long long)failures->value : 0ULL);
+    }
+    fprintf(out, "\n");
+}
+
+/**
+ * @brief Runs reads against the model and reports them; returns 1 if the check failed.
+ */
+static int run(FILE *out, const char *name, Sensors::CaptureMode mode, bool realtime, int reads,
+                const Sensors::DHT22ModelConfig &modelConfig)
+{
+    Sensors::DHT22Model model(modelConfig);
+    Periferia::SimBackend simulator(&model, mode == Sensors::CaptureMode::EdgeTriggered);
+    Periferia::GPIOConfig config;
+    config.customBackend = &simulator;
+
+    Sensors::DHT22Sensor sensor(GPIO_DHT22, config);
+    sensor.setCaptureMode(mode);
+    sensor.setStartPulse(std::chrono::microseconds(1000));
+    sensor.setRealtime(realtime);
+
+    Metrics::reset();
+    Bench::Samples latency(reads);
+    int ok = 0;
+    int wrong = 0;
+    int stalled = 0;
+    int judgedOk = 0;
+    for (int i = 0; i < reads; ++i)
+    {
+        Sensors::SensorData data;
+        unsigned long long start = Bench::nowNs();
+        bool success = sensor.read(data);
+        latency.add(Bench::nowNs() - start);
+        bool isStalled = mode == Sensors::CaptureMode::Polling && sensor.getPollGapNs() > STALL_US * 1000ULL;
+        stalled += isStalled;
+        if (success)
+        {
+            ok++;
+            judgedOk += !isStalled;
+            if (fabsf(data.temperature - modelConfig.temperature) > 0.05f ||
+                fabsf(data.humidity - modelConfig.humidity) > 0.05f)
+            {
+                wrong++;
+            }
+        }
+    }
+    double expected = 100.0 * (1.0 - modelConfig.missingAckRate) * (1.0 - modelConfig.badChecksumRate);
+    int judged = reads - stalled;
+    double judgedRate = judged > 0 ? 100.0 * judgedOk / judged : 0.0;
+    bool rateChecked = judged >= MIN_JUDGED_READS;
+    bool failed = wrong > 0 || (rateChecked && judgedRate < expected - OK_TOLERANCE_PCT);
+    Bench::report(out, name, latency, "ok%", 100.0 * ok / reads);
+    fprintf(out, "%-28s expected_ok%%=%.2f wrong_values=%d reads/s=%.0f\n", "", expected, wrong, 1e9 / latency.mean());
+    fprintf(out, "%-28s stalled=%d unstalled_ok%%=%.2f %s\n", "", stalled, judgedRate,
+            failed ? "FAIL" : (rateChecked ? "pass" : "not judged"));
+    reportMetrics(out);
+    return failed ? 1 : 0;
+}
+
+static int runBoth(FILE *out, const char *name, const Sensors::DHT22ModelConfig &modelConfig)
+{
+    char label[64];
+    int errors = 0;
+    snprintf(label, sizeof(label), "edges %s", name);
+    errors += run(out, label, Sensors::CaptureMode::EdgeTriggered, false, EDGE_READS, modelConfig);
+    snprintf(label, sizeof(label), "polling %s", name);
+    errors += run(out, label, Sensors::CaptureMode::Polling, false, POLL_READS, modelConfig);
+    snprintf(label, sizeof(label), "polling+rt %s", name);
+    errors += run(out, label, Sensors::CaptureMode::Polling, true, POLL_READS, modelConfig);
+    return errors;
+}
+
+int main()
+{
+    FILE *out = Bench::quietStdout();
+    if (freopen("/dev/null", "w", stderr) == nullptr) // expected checksum/ACK warnings
+    {
+        perror("freopen");
+    }
+
+    int errors = 0;
+    Sensors::DHT22ModelConfig clean;
+    clean.temperature = -7.3f;
+    errors += runBoth(out, "clean", clean);
+
+    Sensors::DHT22ModelConfig jitter = clean;
+    jitter.jitterUs = 8;
+    errors += runBoth(out, "jitter 8us", jitter);
+
+    Sensors::DHT22ModelConfig noAck = clean;
+    noAck.missingAckRate = 0.05;
+    errors += runBoth(out, "5% missing ACK", noAck);
+
+    Sensors::DHT22ModelConfig checksum = clean;
+    checksum.badChecksumRate = 0.05;
+    errors += runBoth(out, "5% bad checksum", checksum);
+
+    Log::flush();
+    fclose(out);
+    return errors == 0 ? 0 : 1;
+}
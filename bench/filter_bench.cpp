@@ -0,0 +1,154 @@
+/*
+ * Filter pipeline: outlier rejection quality and cost per value.
+ *
+ * A temperature trace of RECORDS readings is generated as a slow drift
+ * plus noise, quantized to the DHT22's 0.1 C, with OUTLIER_PERCENT of the
+ * readings corrupted the way a multi-bit error with a still-valid
+ * checksum would: a jump of 2^k * 0.1 C. The trace goes through range
+ * check -> Hampel -> Kalman, once value by value through a FilterPipeline
+ * (the acquisition path) and once column-wise through processBatch()
+ * (offline replay); both must give bit-identical output. Reported are the
+ * outliers caught, good readings wrongly rejected, the error against the
+ * true signal, and the time per value of each stage.
+ */
+#include "BenchUtil.h"
+#include "../processing/Inc/Filters.h"
+#include "../common/Inc/Log.h"
+#include <cmath>
+#include <cstring>
+
+#define RECORDS 1000000
+#define OUTLIER_PERCENT 1
+#define HAMPEL_WINDOW 7
+#define HAMPEL_K 3.0f
+#define MEDIAN_WINDOW 5
+
+static unsigned long long rngState = 88172645463325252ULL;
+
+static unsigned long long randomNext()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
+static float quantize(float value)
+{
+    return std::round(value * 10.0f) / 10.0f;
+}
+
+/**
+ * @brief Largest and RMS difference between a filtered trace and the true signal.
+ */
+static void printError(const char *name, const std::vector<float> &values, const std::vector<float> &truth)
+{
+    double sumSquares = 0.0;
+    double largest = 0.0;
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        double error = std::fabs((double)values[i] - truth[i]);
+        sumSquares += error * error;
+        largest = std::max(largest, error);
+    }
+    printf("%-28s rms_error=%.3fC max_error=%.2fC\n", name, std::sqrt(sumSquares / values.size()), largest);
+}
+
+/**
+ * @brief Times one filter over a copy of the trace, column-wise.
+ */
+static void timeStage(const char *name, Processing::Filter &filter, const std::vector<float> &input)
+{
+    std::vector<float> column(input);
+    unsigned long long start = Bench::nowNs();
+    size_t rejections = filter.processBatch(column.data(), column.size());
+    double ns = (double)(Bench::nowNs() - start) / column.size();
+    printf("%-28s %6.1f ns/value rejected=%zu\n", name, ns, rejections);
+}
+
+int main()
+{
+    std::vector<float> truth(RECORDS);
+    std::vector<float> raw(RECORDS);
+    std::vector<bool> corrupted(RECORDS);
+    float drift = 21.0f;
+    size_t outliers = 0;
+    for (int i = 0; i < RECORDS; ++i)
+    {
+        drift += ((int)(randomNext() % 2001) - 1000) * 0.00002f; // about 0.01 C per reading
+        truth[i] = drift + 2.0f * std::sin(i * 2.0f * (float)M_PI / 86400.0f);
+        float noise = ((int)(randomNext() % 3) - 1) * 0.05f;
+        raw[i] = quantize(truth[i] + noise);
+        if ((int)(randomNext() % 100) < OUTLIER_PERCENT)
+        {
+            int bit = 6 + (int)(randomNext() % 7); // 6.4 C .. 409.6 C
+            raw[i] = quantize(raw[i] + ((randomNext() & 1) ? 1.0f : -1.0f) * (float)(1 << bit) * 0.1f);
+            corrupted[i] = true;
+            outliers++;
+        }
+    }
+
+    // Acquisition path: one reading at a time through the pipeline
+    Processing::RangeFilter range(-40.0f, 80.0f);
+    Processing::HampelFilter hampel(HAMPEL_WINDOW, HAMPEL_K, 0.1f);
+    Processing::KalmanFilter kalman(0.0004f, 0.01f);
+    Processing::FilterPipeline pipeline("bench");
+    pipeline.add(Processing::Channel::Temperature, &range);
+    pipeline.add(Processing::Channel::Temperature, &hampel);
+    pipeline.add(Processing::Channel::Temperature, &kalman);
+
+    std::vector<float> streamed(RECORDS);
+    std::vector<float> rejectedOnly(RECORDS);
+    Processing::RangeFilter rangeOnly(-40.0f, 80.0f);
+    Processing::HampelFilter hampelOnly(HAMPEL_WINDOW, HAMPEL_K, 0.1f);
+    size_t caught = 0;
+    size_t falseRejections = 0;
+    Bench::Samples processNs(RECORDS);
+    for (int i = 0; i < RECORDS; ++i)
+    {
+        Sensors::SensorData data = {};
+        data.temperature = raw[i];
+        unsigned long long before = Bench::nowNs();
+        pipeline.process(data);
+        processNs.add(Bench::nowNs() - before);
+        streamed[i] = data.temperature;
+
+        // Same rejection stages without smoothing, to count what they caught
+        float value = raw[i];
+        bool accepted = rangeOnly.process(value);
+        accepted &= hampelOnly.process(value);
+        rejectedOnly[i] = value;
+        caught += (corrupted[i] && !accepted);
+        falseRejections += (!corrupted[i] && !accepted);
+    }
+    Bench::report(stdout, "pipeline process()", processNs, "values/s", 1e9 / processNs.mean());
+    printf("%-28s outliers=%zu caught=%zu (%.2f%%) false_rejections=%zu (%.3f%%)\n", "", outliers, caught,
+           100.0 * caught / outliers, falseRejections, 100.0 * falseRejections / (RECORDS - outliers));
+
+    // Offline replay: the same chain column-wise
+    range.reset();
+    hampel.reset();
+    kalman.reset();
+    std::vector<float> replayed(raw);
+    unsigned long long start = Bench::nowNs();
+    pipeline.processBatch(Processing::Channel::Temperature, replayed.data(), replayed.size());
+    double batchNs = (double)(Bench::nowNs() - start) / RECORDS;
+    bool identical = memcmp(replayed.data(), streamed.data(), RECORDS * sizeof(float)) == 0;
+    printf("%-28s %6.1f ns/value identical_to_streaming=%s\n", "pipeline processBatch()", batchNs,
+           identical ? "yes" : "NO");
+
+    range.reset();
+    hampel.reset();
+    kalman.reset();
+    Processing::MedianFilter median(MEDIAN_WINDOW);
+    timeStage("range", range, raw);
+    timeStage("hampel 7", hampel, raw);
+    timeStage("median 5", median, raw);
+    timeStage("kalman", kalman, raw);
+
+    printError("raw", raw, truth);
+    printError("range+hampel", rejectedOnly, truth);
+    printError("range+hampel+kalman", streamed, truth);
+    Log::flush();
+    return identical ? 0 : 1;
+}
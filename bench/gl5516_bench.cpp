@@ -0,0 +1,205 @@
+/*
+ * GL5516 over IIO: buffered block reads against one-shot sysfs reads.
+ *
+ * A fake IIO tree is built in a temporary directory (sysfs attributes,
+ * scan_elements, buffer/) with a regular file standing in for
+ * /dev/iio:device0, filled with READS * OVERSAMPLE scans of noisy 12-bit
+ * samples. Two scan layouts are used: the channel alone (2-byte scans)
+ * and the channel next to a second one and a timestamp (16-byte scans).
+ * Every reading's lux is compared with the divider and photoresistor
+ * formula applied to the exact average of the samples it covered. The
+ * one-shot case reads in_voltage0_raw OVERSAMPLE times per reading; on a
+ * regular file that only measures the syscall cost, not a conversion.
+ */
+#include "BenchUtil.h"
+#include "../sensors/Inc/GL5516.h"
+#include "../common/Inc/Log.h"
+#include <cmath>
+#include <string>
+
+#define READS 2000
+#define OVERSAMPLE 64
+#define BASE_CODE 1800
+#define NOISE_CODES 16
+#define KERNEL_SAMPLES 1000000
+
+static unsigned long long rngState = 88172645463325252ULL;
+
+static unsigned long long randomNext()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
+static void writeFile(const std::string &path, const void *data, size_t size)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr || fwrite(data, 1, size, file) != size)
+    {
+        perror(path.c_str());
+        exit(1);
+    }
+    fclose(file);
+}
+
+static void writeText(const std::string &path, const char *text)
+{
+    writeFile(path, text, strlen(text));
+}
+
+static std::string readText(const std::string &path)
+{
+    char buffer[64] = {0};
+    FILE *file = fopen(path.c_str(), "r");
+    if (file != nullptr)
+    {
+        size_t length = fread(buffer, 1, sizeof(buffer) - 1, file);
+        buffer[length] = '\0';
+        fclose(file);
+    }
+    return buffer;
+}
+
+/**
+ * @brief Lux for an exact raw average, straight from the formula used to build the table.
+ */
+static double expectedLux(double raw, const Sensors::GL5516Config &config, double mvPerCode)
+{
+    double volts = raw * mvPerCode;
+    double resistance = config.fixedOhms * volts / (config.supplyMv - volts);
+    return 10.0 * std::pow(config.r10Ohms / resistance, 1.0 / config.gamma);
+}
+
+/**
+ * @brief Builds a fake iio:device0 whose scans hold `scanBytes` bytes, the channel first.
+ * @return Exact average of each reading's samples.
+ */
+static std::vector<double> buildDevice(const std::string &root, size_t scanBytes)
+{
+    std::string device = root + "/sys/iio:device0";
+    if (system(("rm -rf " + root + "/sys " + root + "/dev && mkdir -p " + device + "/scan_elements " + device +
+                "/buffer " + device + "/trigger " + root + "/dev")
+                   .c_str()) != 0)
+    {
+        exit(1);
+    }
+    writeText(device + "/in_voltage0_raw", "1800\n");
+    writeText(device + "/in_voltage_scale", "0.805664062\n"); // 3300 mV / 4096
+    writeText(device + "/buffer/enable", "0\n");
+    writeText(device + "/buffer/length", "0\n");
+    writeText(device + "/trigger/current_trigger", "\n");
+    writeText(device + "/scan_elements/in_voltage0_en", "0\n");
+    writeText(device + "/scan_elements/in_voltage0_index", "0\n");
+    writeText(device + "/scan_elements/in_voltage0_type", "le:u12/16>>0\n");
+    bool wide = scanBytes > 2;
+    writeText(device + "/scan_elements/in_voltage1_en", wide ? "1\n" : "0\n");
+    writeText(device + "/scan_elements/in_voltage1_index", "1\n");
+    writeText(device + "/scan_elements/in_voltage1_type", "le:u12/16>>0\n");
+    writeText(device + "/scan_elements/in_timestamp_en", wide ? "1\n" : "0\n");
+    writeText(device + "/scan_elements/in_timestamp_index", "2\n");
+    writeText(device + "/scan_elements/in_timestamp_type", "le:s64/64>>0\n");
+
+    std::vector<uint8_t> scans((size_t)READS * OVERSAMPLE * scanBytes, 0);
+    std::vector<double> averages(READS);
+    for (int r = 0; r < READS; ++r)
+    {
+        long total = 0;
+        for (int s = 0; s < OVERSAMPLE; ++s)
+        {
+            uint16_t code = (uint16_t)(BASE_CODE + r % 200 + (int)(randomNext() % (2 * NOISE_CODES + 1)) - NOISE_CODES);
+            total += code;
+            uint8_t *scan = &scans[((size_t)r * OVERSAMPLE + s) * scanBytes];
+            memcpy(scan, &code, sizeof(code));
+            if (wide)
+            {
+                uint16_t other = 4095;
+                int64_t timestamp = (int64_t)r * OVERSAMPLE + s;
+                memcpy(scan + 2, &other, sizeof(other));
+                memcpy(scan + 8, &timestamp, sizeof(timestamp));
+            }
+        }
+        averages[r] = (double)total / OVERSAMPLE;
+    }
+    writeFile(root + "/dev/iio:device0", scans.data(), scans.size());
+    return averages;
+}
+
+static int run(const char *name, const std::string &root, size_t scanBytes, bool buffered)
+{
+    std::vector<double> averages = buildDevice(root, scanBytes);
+    std::string sysfs = root + "/sys";
+    std::string dev = root + "/dev";
+    Sensors::GL5516Config config;
+    config.adc.sysfsRoot = sysfs.c_str();
+    config.adc.devRoot = dev.c_str();
+    config.adc.buffered = buffered;
+    config.oversample = OVERSAMPLE;
+    config.timeoutMs = 0;
+    Sensors::GL5516Sensor sensor(config);
+    if (!sensor.open())
+    {
+        printf("%-28s open failed\n", name);
+        return 1;
+    }
+    bool enabled = !buffered || readText(sysfs + "/iio:device0/buffer/enable") == "1";
+
+    Bench::Samples readNs(READS);
+    double worstError = 0.0;
+    int failures = 0;
+    for (int r = 0; r < READS; ++r)
+    {
+        Sensors::SensorData data = {};
+        unsigned long long before = Bench::nowNs();
+        bool ok = sensor.read(data);
+        readNs.add(Bench::nowNs() - before);
+        if (!ok)
+        {
+            failures++;
+            continue;
+        }
+        double raw = buffered ? averages[r] : 1800.0;
+        double expected = expectedLux(raw, config, 0.805664062);
+        worstError = std::max(worstError, std::fabs(data.light - expected) / expected);
+    }
+    sensor.close();
+    bool disabled = !buffered || readText(sysfs + "/iio:device0/buffer/enable") == "0";
+    Bench::report(stdout, name, readNs, "samples/read", (double)OVERSAMPLE);
+    printf("%-28s failures=%d worst_lux_error=%.4f%% buffer_on_off=%s\n", "", failures, 100.0 * worstError,
+           enabled && disabled ? "ok" : "WRONG");
+    return (failures == 0 && worstError < 0.005 && enabled && disabled) ? 0 : 1;
+}
+
+int main()
+{
+    char root[] = "/tmp/enviromonitor-iio-XXXXXX";
+    if (mkdtemp(root) == nullptr)
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    int errors = run("buffered 2-byte scans", root, 2, true);
+    errors += run("buffered 16-byte scans", root, 16, true);
+    errors += run("one-shot sysfs", root, 2, false);
+
+    std::vector<uint16_t> samples(KERNEL_SAMPLES);
+    for (uint16_t &sample : samples)
+    {
+        sample = (uint16_t)(randomNext() % 4096);
+    }
+    unsigned long long start = Bench::nowNs();
+    volatile float sink = 0.0f;
+    for (int round = 0; round < 20; ++round)
+    {
+        sink = sink + Sensors::averageSamples(samples.data(), samples.size());
+    }
+    printf("%-28s %6.3f ns/sample\n", "averageSamples", (double)(Bench::nowNs() - start) / (20.0 * KERNEL_SAMPLES));
+
+    if (system((std::string("rm -rf ") + root).c_str()) != 0)
+    {
+        fprintf(stderr, "Could not remove %s\n", root);
+    }
+    Log::flush();
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,331 @@
+/*
+ * Edge wake-up of the sysfs backend, with a FIFO standing in for the value file.
+ *
+ * The value file of a fake gpio tree is replaced by a FIFO and the pin is
+ * opened persistent with edgeWakeEvents = POLLIN, so poll() wakes when a
+ * writer thread puts a level character in, the way POLLPRI wakes on a
+ * real edge. pread() on the FIFO fails with ESPIPE and the backend falls
+ * back to read(). Reports the latency from the write to the wake-up
+ * timestamp over EDGES alternating levels, and checks that:
+ * - the edge file holds the selected edge while the pin is an input and
+ *   "none" while it drives, including an edge selected on the output;
+ * - waitEdge() on an empty FIFO returns 0 after the timeout;
+ * - every level arrives in order and a non-level character is an ERROR;
+ * - reading an empty value file is an ERROR rather than a stale level.
+ *
+ * Then the chardev backend on MockGPIOChip: a whole DHT22 frame (84
+ * edges from DHT22Model) is queued with pushEdge() and read back through
+ * GPIO::readEdges(). The first read must stop at the CDEV_EVENT_BATCH
+ * boundary, the next return the rest and an empty queue must report a
+ * timeout; the events must decode to the reading the model sent, for a
+ * positive and a negative temperature. Last, DHT22Sensor::read() runs
+ * READS times against a chip that queues the frame when the sensor
+ * releases the line with edges armed, and every read must return the
+ * model's reading.
+ * Exits non-zero on any mismatch.
+ */
+#include "BenchUtil.h"
+#include "../periferia/Inc/gpio.h"
+#include "../periferia/Inc/gpio_cdev.h"
+#include "../periferia/Inc/gpio_mock_chip.h"
+#include "../sensors/Inc/DHT22.h"
+#include "../sensors/Inc/DHT22Model.h"
+#include "../common/Inc/Log.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#define EDGES 2000
+#define TIMEOUT_MS 20
+#define EMPTY_PIN (GPIO_DHT22 + 1)
+#define CHIP_LINE (GPIO_DHT22 % MOCK_CHIP_LINES)
+#define READS 200
+
+static int errors = 0;
+
+/**
+ * @brief Counts and prints a failed check.
+ */
+static void expect(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        printf("%-28s %s\n", "MISMATCH", what);
+        errors++;
+    }
+}
+
+/**
+ * @brief True if the file starts with word (pwrite at offset 0 leaves longer old contents behind).
+ */
+static bool fileStartsWith(const std::string &path, const char *word)
+{
+    char buffer[16] = {0};
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    size_t length = fread(buffer, 1, sizeof(buffer) - 1, file);
+    fclose(file);
+    return length >= strlen(word) && strncmp(buffer, word, strlen(word)) == 0;
+}
+
+static void checkEdgeFile(Periferia::GPIO &gpio, const std::string &edgePath)
+{
+    expect(gpio.setEdge(Periferia::Edge::Both) == SUCCESS && fileStartsWith(edgePath, "both"),
+           "setEdge(Both) on an input writes both");
+    expect(gpio.setDirection(OUTPUT) == SUCCESS && fileStartsWith(edgePath, "none"),
+           "switching to output disarms the edge");
+    expect(gpio.setEdge(Periferia::Edge::Falling) == SUCCESS && fileStartsWith(edgePath, "none"),
+           "an edge selected on an output is deferred");
+    expect(gpio.setDirection(INPUT) == SUCCESS && fileStartsWith(edgePath, "falling"),
+           "switching to input arms the selected edge");
+    expect(gpio.setEdge(Periferia::Edge::Both) == SUCCESS && fileStartsWith(edgePath, "both"),
+           "setEdge(Both) re-arms on an input");
+}
+
+static void checkTimeout(Periferia::GPIO &gpio)
+{
+    Periferia::EdgeEvent event;
+    unsigned long long start = Bench::nowNs();
+    int result = gpio.waitEdge(event, TIMEOUT_MS);
+    unsigned long long elapsedNs = Bench::nowNs() - start;
+    printf("%-28s result=%d waited=%.2fms\n", "waitEdge, empty FIFO", result, elapsedNs / 1e6);
+    expect(result == 0, "waitEdge() on an empty FIFO times out");
+    expect(elapsedNs >= (TIMEOUT_MS - 1) * 1000000ULL, "the timeout is honoured");
+}
+
+/**
+ * @brief Feeds EDGES alternating levels from a second thread, one per wake-up.
+ */
+static void checkLevels(Periferia::GPIO &gpio, int writer)
+{
+    std::atomic<int> consumed(0);
+    std::atomic<unsigned long long> sentNs(0);
+    std::thread feeder([&]() {
+        for (int i = 0; i < EDGES; ++i)
+        {
+            while (consumed.load() != i)
+            {
+                std::this_thread::yield();
+            }
+            char level = (i & 1) ? '1' : '0';
+            sentNs.store(Bench::nowNs());
+            if (write(writer, &level, 1) != 1)
+            {
+                perror("write");
+            }
+        }
+    });
+
+    gpio.resetStats();
+    Bench::Samples samples(EDGES);
+    int outOfOrder = 0;
+    int timeouts = 0;
+    for (int i = 0; i < EDGES; ++i)
+    {
+        Periferia::EdgeEvent event;
+        int result = gpio.waitEdge(event, 1000);
+        if (result != OK)
+        {
+            timeouts++;
+        }
+        else
+        {
+            samples.add(event.timestampNs - sentNs.load());
+            outOfOrder += (event.value != (i & 1));
+        }
+        consumed.store(i + 1);
+    }
+    feeder.join();
+    Bench::report(stdout, "waitEdge, FIFO wake-up", samples, "syscalls/edge",
+                  (double)gpio.getStats().syscalls / EDGES);
+    printf("%-28s out_of_order=%d missed=%d\n", "", outOfOrder, timeouts);
+    expect(outOfOrder == 0 && timeouts == 0, "every level arrives in order");
+
+    const char garbage = 'x';
+    Periferia::EdgeEvent event;
+    expect(write(writer, &garbage, 1) == 1 && gpio.waitEdge(event, TIMEOUT_MS) == ERROR,
+           "a non-level character is an ERROR");
+}
+
+/**
+ * @brief MockGPIOChip on which a DHT22 answers when the host releases the line with edges armed.
+ */
+class AnsweringChip : public Periferia::MockGPIOChip
+{
+public:
+    explicit AnsweringChip(Sensors::DHT22Model &model) : model(model) {}
+
+    Status_t setConfig(int request, uint64_t flags) override
+    {
+        Status_t result = MockGPIOChip::setConfig(request, flags);
+        if (result == SUCCESS && (flags & GPIO_V2_LINE_FLAG_INPUT) && (flags & GPIO_V2_LINE_FLAG_EDGE_FALLING))
+        {
+            Periferia::EdgeEvent answer[DHT22_MAX_EDGES];
+            int count = model.respond(0, Periferia::monotonicNs(), answer, DHT22_MAX_EDGES);
+            for (int i = 0; i < count; ++i)
+            {
+                pushEdge(CHIP_LINE, answer[i].timestampNs, answer[i].value);
+            }
+        }
+        return result;
+    }
+
+private:
+    Sensors::DHT22Model &model;
+};
+
+static bool sameReading(const Sensors::SensorData &data, float humidity, float temperature)
+{
+    return std::fabs(data.humidity - humidity) < 0.05f && std::fabs(data.temperature - temperature) < 0.05f;
+}
+
+/**
+ * @brief Queues one frame with pushEdge() and reads it back in kernel-sized batches.
+ */
+static void checkChardevFrame(Periferia::MockGPIOChip &chip, float humidity, float temperature)
+{
+    Sensors::DHT22ModelConfig modelConfig;
+    modelConfig.humidity = humidity;
+    modelConfig.temperature = temperature;
+    Sensors::DHT22Model model(modelConfig);
+    Periferia::EdgeEvent sent[DHT22_MAX_EDGES];
+    int sentCount = model.respond(0, Periferia::monotonicNs(), sent, DHT22_MAX_EDGES);
+
+    Periferia::GPIOConfig config;
+    config.backend = Periferia::Backend::Chardev;
+    config.chip = &chip;
+    config.chipLine = CHIP_LINE;
+    Periferia::GPIO gpio(GPIO_DHT22, INPUT, config);
+    // The idle bus is pulled up; no edge is reported before detection is armed
+    chip.pushEdge(CHIP_LINE, 0, HIGH);
+    expect(gpio.setEdge(Periferia::Edge::Both) == SUCCESS, "setEdge(Both) on the chardev");
+
+    Periferia::EdgeEvent events[DHT22_MAX_EDGES];
+    expect(gpio.readEdges(events, DHT22_MAX_EDGES, TIMEOUT_MS) == 0, "an empty queue reads as a timeout");
+    expect(gpio.waitEdge(events[0], TIMEOUT_MS) == 0, "waitEdge() on an empty queue times out");
+
+    for (int i = 0; i < sentCount; ++i)
+    {
+        chip.pushEdge(CHIP_LINE, sent[i].timestampNs, sent[i].value);
+    }
+    int batches[3];
+    int count = 0;
+    for (int &batch : batches)
+    {
+        batch = gpio.readEdges(&events[count], DHT22_MAX_EDGES - count, TIMEOUT_MS);
+        count += (batch > 0) ? batch : 0;
+    }
+    printf("%-28s edges=%d batches=%d+%d+%d\n", "chardev frame, pushEdge", sentCount, batches[0], batches[1],
+           batches[2]);
+    expect(sentCount > CDEV_EVENT_BATCH && batches[0] == CDEV_EVENT_BATCH, "the first read stops at the batch size");
+    expect(batches[1] == sentCount - CDEV_EVENT_BATCH, "the second read returns the rest of the frame");
+    expect(batches[2] == 0, "the drained queue reads as a timeout");
+
+    int mismatched = 0;
+    for (int i = 0; i < count && i < sentCount; ++i)
+    {
+        mismatched += (events[i].timestampNs != sent[i].timestampNs || events[i].value != sent[i].value);
+    }
+    expect(count == sentCount && mismatched == 0, "events keep their order, timestamps and levels");
+
+    Sensors::DHT22Frame frame;
+    Sensors::SensorData data = {};
+    bool decoded = Sensors::DHT22Decoder::decode(events, count, frame) == Sensors::DHT22Status::Ok;
+    if (decoded)
+    {
+        Sensors::DHT22Decoder::toSensorData(frame.bytes, data);
+    }
+    printf("%-28s decoded=%d humidity=%.1f temperature=%.1f\n", "", decoded, data.humidity, data.temperature);
+    expect(decoded && sameReading(data, humidity, temperature), "the frame decodes to the model's reading");
+}
+
+/**
+ * @brief Full DHT22Sensor::read() over the chardev backend, the frame queued on release.
+ */
+static void checkChardevSensor()
+{
+    Sensors::DHT22ModelConfig modelConfig;
+    Sensors::DHT22Model model(modelConfig);
+    static AnsweringChip chip(model);
+    Periferia::GPIOConfig config;
+    config.backend = Periferia::Backend::Chardev;
+    config.chip = &chip;
+    config.chipLine = CHIP_LINE;
+    Sensors::DHT22Sensor sensor(GPIO_DHT22, config);
+    sensor.setCaptureMode(Sensors::CaptureMode::EdgeTriggered);
+    sensor.setStartPulse(std::chrono::microseconds(1000));
+
+    Bench::Samples samples(READS);
+    int good = 0;
+    for (int i = 0; i < READS; ++i)
+    {
+        Sensors::SensorData data = {};
+        unsigned long long start = Bench::nowNs();
+        bool ok = sensor.read(data);
+        samples.add(Bench::nowNs() - start);
+        good += (ok && sameReading(data, modelConfig.humidity, modelConfig.temperature));
+    }
+    Bench::report(stdout, "DHT22 read, chardev (mock)", samples, "ok%", 100.0 * good / READS);
+    expect(good == READS, "every chardev DHT22 read returns the model's reading");
+}
+
+int main()
+{
+    Bench::FakeSysfs sysfs;
+    const int pins[] = {GPIO_DHT22, EMPTY_PIN};
+    if (!sysfs.create(pins, 2))
+    {
+        return 1;
+    }
+    std::string pinDir = std::string(sysfs.root()) + "/gpio" + std::to_string(GPIO_DHT22);
+    std::string valuePath = pinDir + "/value";
+    if (unlink(valuePath.c_str()) != 0 || mkfifo(valuePath.c_str(), 0644) != 0)
+    {
+        perror("mkfifo");
+        return 1;
+    }
+
+    Periferia::GPIOConfig config;
+    config.sysfsRoot = sysfs.root();
+    config.mode = Periferia::AccessMode::Persistent;
+    config.edgeWakeEvents = POLLIN;
+    Periferia::GPIO gpio(GPIO_DHT22, INPUT, config);
+    // The pin holds the FIFO open O_RDWR, so a non-blocking writer finds a reader
+    int writer = open(valuePath.c_str(), O_WRONLY | O_NONBLOCK);
+    if (writer == ERROR)
+    {
+        perror("open FIFO");
+        return 1;
+    }
+
+    checkEdgeFile(gpio, pinDir + "/edge");
+    checkTimeout(gpio);
+    checkLevels(gpio, writer);
+    close(writer);
+
+    // An empty value file reads 0 bytes
+    std::string emptyPath = std::string(sysfs.root()) + "/gpio" + std::to_string(EMPTY_PIN) + "/value";
+    if (truncate(emptyPath.c_str(), 0) != 0)
+    {
+        perror("truncate");
+        return 1;
+    }
+    Periferia::GPIOConfig reopen;
+    reopen.sysfsRoot = sysfs.root();
+    Periferia::GPIO empty(EMPTY_PIN, INPUT, reopen);
+    expect(empty.read() == ERROR, "an empty value file reads as ERROR");
+
+    static Periferia::MockGPIOChip chip;
+    checkChardevFrame(chip, 45.0f, 21.5f);
+    checkChardevFrame(chip, 87.6f, -12.3f);
+    checkChardevSensor();
+
+    printf("%-28s %d\n", "mismatches", errors);
+    Log::flush();
+    return errors == 0 ? 0 : 1;
+}
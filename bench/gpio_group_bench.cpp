@@ -0,0 +1,115 @@
+/*
+ * Pass time of sampling N pins: N GPIO::read() calls against one
+ * GPIOGroup::read(), per backend, for N = 1..32.
+ *
+ * Same stand-ins as gpio_poll_bench: a fake sysfs tree in /tmp (persistent
+ * fds in both cases), MockGPIOChip for chardev and an anonymous page for
+ * one mmap bank. Pins 32..63 are bank 1 on the AM335x layout.
+ */
+#include "BenchUtil.h"
+#include "../periferia/Inc/gpio_group.h"
+#include "../periferia/Inc/gpio_mock_chip.h"
+#include <sys/mman.h>
+
+#define PASSES 20000
+#define FIRST_PIN 32
+#define MAX_PINS 32
+
+static void runSingle(FILE *out, const char *backend, const int *pins, int count, const Periferia::GPIOConfig &config)
+{
+    std::vector<std::unique_ptr<Periferia::GPIO>> gpios;
+    for (int i = 0; i < count; ++i)
+    {
+        gpios.emplace_back(new Periferia::GPIO(pins[i], INPUT, config));
+    }
+
+    Bench::Samples samples(PASSES);
+    volatile uint64_t sink = 0;
+    for (int pass = 0; pass < PASSES; ++pass)
+    {
+        unsigned long long start = Bench::nowNs();
+        uint64_t bits = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            bits |= (uint64_t)(gpios[i]->read() == HIGH) << i;
+        }
+        samples.add(Bench::nowNs() - start);
+        sink += bits;
+    }
+    (void)sink;
+    char name[64];
+    snprintf(name, sizeof(name), "%s %2d x GPIO", backend, count);
+    Bench::report(out, name, samples, "ns/pin", samples.mean() / count);
+}
+
+static void runGroup(FILE *out, const char *backend, const int *pins, int count, const Periferia::GPIOConfig &config)
+{
+    Periferia::GPIOGroup group(pins, count, INPUT, config);
+
+    Bench::Samples samples(PASSES);
+    volatile uint64_t sink = 0;
+    for (int pass = 0; pass < PASSES; ++pass)
+    {
+        unsigned long long start = Bench::nowNs();
+        uint64_t bits = 0;
+        group.read(bits);
+        samples.add(Bench::nowNs() - start);
+        sink += bits;
+    }
+    (void)sink;
+    char name[64];
+    snprintf(name, sizeof(name), "%s %2d x group", backend, count);
+    Bench::report(out, name, samples, "ns/pin", samples.mean() / count);
+}
+
+int main()
+{
+    FILE *out = Bench::quietStdout();
+    int pins[MAX_PINS];
+    for (int i = 0; i < MAX_PINS; ++i)
+    {
+        pins[i] = FIRST_PIN + i;
+    }
+
+    Bench::FakeSysfs sysfs;
+    if (!sysfs.create(pins, MAX_PINS))
+    {
+        return 1;
+    }
+    void *page = mmap(nullptr, Periferia::AM335X_GPIO_LAYOUT.mapSize, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED)
+    {
+        perror("mmap");
+        return 1;
+    }
+
+    for (int count = 1; count <= MAX_PINS; count *= 2)
+    {
+        Periferia::GPIOConfig sysfsConfig;
+        sysfsConfig.sysfsRoot = sysfs.root();
+        sysfsConfig.mode = Periferia::AccessMode::Persistent;
+        runSingle(out, "sysfs", pins, count, sysfsConfig);
+        runGroup(out, "sysfs", pins, count, sysfsConfig);
+
+        Periferia::MockGPIOChip chip;
+        Periferia::GPIOConfig cdevConfig;
+        cdevConfig.backend = Periferia::Backend::Chardev;
+        cdevConfig.chip = &chip;
+        if (count <= MOCK_CHIP_REQUESTS) // one line request per GPIO
+        {
+            runSingle(out, "cdev ", pins, count, cdevConfig);
+        }
+        runGroup(out, "cdev ", pins, count, cdevConfig);
+
+        Periferia::GPIOConfig mmapConfig;
+        mmapConfig.backend = Periferia::Backend::Mmap;
+        mmapConfig.registers = (volatile uint32_t *)page;
+        runSingle(out, "mmap ", pins, count, mmapConfig);
+        runGroup(out, "mmap ", pins, count, mmapConfig);
+    }
+
+    munmap(page, Periferia::AM335X_GPIO_LAYOUT.mapSize);
+    fclose(out);
+    return 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * Poll latency of GPIO::read() on every backend.
+ *
+ * sysfs runs against a fake /sys/class/gpio tree in /tmp, chardev against
+ * MockGPIOChip and mmap against an anonymous page standing in for the
+ * AM335x GPIO1 bank, so the numbers show the userspace/syscall cost of
+ * each access method rather than the bus itself.
+ */
+#include "BenchUtil.h"
+#include "../periferia/Inc/gpio.h"
+#include "../periferia/Inc/gpio_mock_chip.h"
+#include <sys/mman.h>
+
+#define POLLS 200000
+
+static void run(FILE *out, const char *name, const Periferia::GPIOConfig &config)
+{
+    Periferia::GPIO gpio(GPIO_DHT22, INPUT, config);
+    gpio.resetStats();
+
+    Bench::Samples samples(POLLS);
+    volatile int sink = 0;
+    for (int i = 0; i < POLLS; ++i)
+    {
+        unsigned long long start = Bench::nowNs();
+        sink += gpio.read();
+        samples.add(Bench::nowNs() - start);
+    }
+    (void)sink;
+    Bench::report(out, name, samples, "syscalls/poll", (double)gpio.getStats().syscalls / POLLS);
+}
+
+int main()
+{
+    FILE *out = Bench::quietStdout();
+    Bench::FakeSysfs sysfs;
+    const int pin = GPIO_DHT22;
+    if (!sysfs.create(&pin, 1))
+    {
+        return 1;
+    }
+
+    Periferia::GPIOConfig reopen;
+    reopen.sysfsRoot = sysfs.root();
+    run(out, "sysfs reopen", reopen);
+
+    Periferia::GPIOConfig persistent = reopen;
+    persistent.mode = Periferia::AccessMode::Persistent;
+    run(out, "sysfs persistent (pread)", persistent);
+
+    static Periferia::MockGPIOChip chip;
+    Periferia::GPIOConfig cdev;
+    cdev.backend = Periferia::Backend::Chardev;
+    cdev.chip = &chip;
+    cdev.chipLine = GPIO_DHT22 % MOCK_CHIP_LINES;
+    run(out, "chardev (mock chip)", cdev);
+
+    void *page = mmap(nullptr, Periferia::AM335X_GPIO_LAYOUT.mapSize, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED)
+    {
+        perror("mmap");
+        return 1;
+    }
+    Periferia::GPIOConfig mmapConfig;
+    mmapConfig.backend = Periferia::Backend::Mmap;
+    mmapConfig.registers = (volatile uint32_t *)page;
+    run(out, "mmap (anonymous page)", mmapConfig);
+    munmap(page, Periferia::AM335X_GPIO_LAYOUT.mapSize);
+
+    fclose(out);
+    return 0;
+}
@@ -0,0 +1,229 @@
+/*
+ * Startup cost of PINS sysfs GPIOs: one at a time against setupPins().
+ *
+ * A fake gpio class tree stands in for the kernel and udev: export is a
+ * FIFO read by a thread that creates gpioN/ (value, direction, edge)
+ * SETTLE_MS after each request, the way udev makes a freshly exported
+ * pin usable only after its rules have run. Requests settle
+ * independently, as udev handles events in parallel.
+ *
+ * Cold start: no pin exported. Warm start: every pin already exported,
+ * e.g. a daemon restart. Each case constructs one GPIO per pin (sysfs,
+ * persistent value fd, output), with or without a setupPins() pass first,
+ * and checks that every pin ends up writable. Then the direction change a
+ * DHT22 transaction makes twice is timed on the kept-open direction fd,
+ * next to the open/write/close it replaced.
+ */
+#include "BenchUtil.h"
+#include "../periferia/Inc/gpio_setup.h"
+#include "../common/Inc/Log.h"
+#include <atomic>
+#include <memory>
+#include <poll.h>
+#include <string>
+#include <thread>
+
+#define PINS 32
+#define FIRST_PIN 20
+#define SETTLE_MS 15
+#define TOGGLES 20000
+
+/**
+ * @class FakeKernel
+ * @brief Serves export requests on a fake tree, each pin appearing SETTLE_MS after its request.
+ */
+class FakeKernel
+{
+public:
+    explicit FakeKernel(const std::string &root) : root(root), running(true), readFd(-1), keepFd(-1)
+    {
+        std::string exportPath = root + "/export";
+        mkfifo(exportPath.c_str(), 0600);
+        readFd = open(exportPath.c_str(), O_RDONLY | O_NONBLOCK);
+        keepFd = open(exportPath.c_str(), O_WRONLY); // no EOF between writers
+        worker = std::thread(&FakeKernel::serve, this);
+    }
+
+    ~FakeKernel()
+    {
+        running = false;
+        worker.join();
+        close(readFd);
+        close(keepFd);
+    }
+
+    // Unexport every pin
+    void reset()
+    {
+        if (system(("rm -rf " + root + "/gpio*").c_str()) != 0)
+        {
+            fprintf(stderr, "Could not reset %s\n", root.c_str());
+        }
+    }
+
+private:
+    struct Request
+    {
+        int pin;
+        unsigned long long dueNs;
+    };
+
+    void serve()
+    {
+        std::vector<Request> requests;
+        std::string partial;
+        while (running.load())
+        {
+            struct pollfd pfd = {readFd, POLLIN, 0};
+            poll(&pfd, 1, 1);
+            char buffer[256];
+            ssize_t length;
+            while ((length = read(readFd, buffer, sizeof(buffer))) > 0)
+            {
+                partial.append(buffer, length);
+            }
+            size_t newline;
+            while ((newline = partial.find('\n')) != std::string::npos)
+            {
+                requests.push_back(Request{atoi(partial.substr(0, newline).c_str()),
+                                           Bench::nowNs() + SETTLE_MS * 1000000ULL});
+                partial.erase(0, newline + 1);
+            }
+            unsigned long long now = Bench::nowNs();
+            for (size_t i = 0; i < requests.size();)
+            {
+                if (requests[i].dueNs > now)
+                {
+                    ++i;
+                    continue;
+                }
+                createPin(requests[i].pin);
+                requests[i] = requests.back();
+                requests.pop_back();
+            }
+        }
+    }
+
+    // Built aside and renamed, so the pin appears complete
+    void createPin(int pin)
+    {
+        std::string staging = root + "/.staging" + std::to_string(pin);
+        mkdir(staging.c_str(), 0755);
+        const char *names[] = {"value", "direction", "edge"};
+        for (const char *name : names)
+        {
+            FILE *file = fopen((staging + "/" + name).c_str(), "w");
+            if (file != nullptr)
+            {
+                fputs(strcmp(name, "direction") == 0 ? "in" : "0", file);
+                fclose(file);
+            }
+        }
+        rename(staging.c_str(), (root + "/gpio" + std::to_string(pin)).c_str());
+    }
+
+    std::string root;
+    std::atomic<bool> running;
+    int readFd;
+    int keepFd;
+    std::thread worker;
+};
+
+/**
+ * @brief Constructs one output GPIO per pin, after a bulk pass if asked; returns the failures.
+ */
+static int startup(const char *name, const std::string &root, bool bulk, Bench::Samples &samples)
+{
+    Periferia::GPIOConfig config;
+    config.sysfsRoot = root.c_str();
+    config.mode = Periferia::AccessMode::Persistent;
+    Periferia::GPIOPinSetup setups[PINS];
+    for (int i = 0; i < PINS; ++i)
+    {
+        setups[i] = Periferia::GPIOPinSetup{FIRST_PIN + i, OUTPUT};
+    }
+
+    unsigned long long start = Bench::nowNs();
+    Periferia::GPIOSetupReport report;
+    if (bulk)
+    {
+        Periferia::setupPins(setups, PINS, root.c_str(), &report);
+    }
+    std::vector<std::unique_ptr<Periferia::GPIO>> pins;
+    for (int i = 0; i < PINS; ++i)
+    {
+        pins.emplace_back(new Periferia::GPIO(FIRST_PIN + i, OUTPUT, config));
+    }
+    unsigned long long elapsed = Bench::nowNs() - start;
+
+    int failures = 0;
+    for (std::unique_ptr<Periferia::GPIO> &pin : pins)
+    {
+        if (pin->write(HIGH) == ERROR)
+        {
+            failures++;
+        }
+    }
+    samples.add(elapsed);
+    printf("%-28s %8.2f ms exported=%d already=%d failed=%d unwritable=%d\n", name, elapsed / 1e6,
+           report.exported, report.alreadyExported, report.failed, failures);
+    return failures + report.failed;
+}
+
+int main()
+{
+    char directory[] = "/tmp/enviromonitor-gpio-setup-XXXXXX";
+    if (mkdtemp(directory) == nullptr)
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    std::string root = directory;
+    int errors = 0;
+    {
+        FakeKernel kernel(root);
+        Bench::Samples coldSerial(1), coldBulk(1), warmSerial(1), warmBulk(1);
+        kernel.reset();
+        errors += startup("cold, one by one", root, false, coldSerial);
+        errors += startup("warm, one by one", root, false, warmSerial);
+        kernel.reset();
+        errors += startup("cold, setupPins", root, true, coldBulk);
+        errors += startup("warm, setupPins", root, true, warmBulk);
+        printf("%-28s cold %.1fx warm %.1fx\n", "setupPins speedup", (double)coldSerial.ns[0] / coldBulk.ns[0],
+               (double)warmSerial.ns[0] / warmBulk.ns[0]);
+
+        // Direction changes of a DHT22 transaction: out before the start pulse, in after it
+        Periferia::GPIOConfig config;
+        config.sysfsRoot = root.c_str();
+        config.mode = Periferia::AccessMode::Persistent;
+        Periferia::GPIO pin(FIRST_PIN, OUTPUT, config);
+        Bench::Samples kept(TOGGLES);
+        for (int i = 0; i < TOGGLES; ++i)
+        {
+            unsigned long long start = Bench::nowNs();
+            pin.setDirection((i % 2 == 0) ? INPUT : OUTPUT);
+            kept.add(Bench::nowNs() - start);
+        }
+        Bench::report(stdout, "setDirection, kept fd", kept, "syscalls", 1.0);
+
+        std::string directionPath = root + "/gpio" + std::to_string(FIRST_PIN) + "/direction";
+        Bench::Samples reopened(TOGGLES);
+        for (int i = 0; i < TOGGLES; ++i)
+        {
+            const char *direction = (i % 2 == 0) ? "in" : "out";
+            unsigned long long start = Bench::nowNs();
+            int fd = open(directionPath.c_str(), O_WRONLY);
+            ssize_t written = write(fd, direction, strlen(direction));
+            close(fd);
+            reopened.add(Bench::nowNs() - start);
+            (void)written;
+        }
+        Bench::report(stdout, "open/write/close (before)", reopened, "syscalls", 3.0);
+    }
+    if (system(("rm -rf " + root).c_str()) != 0)
+    {
+        fprintf(stderr, "Could not remove %s\n", root.c_str());
+    }
+    Log::flush();
+    return errors == 0 ? 0 : 1;
+}
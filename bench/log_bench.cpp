@@ -0,0 +1,77 @@
+/*
+ * Cost of logging on the GPIO poll path.
+ *
+ * The same mmap poll loop runs with the per-read trace line compiled in
+ * (printed to stdout, which is redirected to /dev/null) and compiled out,
+ * as a build with LOG_LEVEL above trace would have it. The last case times
+ * a LOG_WARN call, which only formats and enqueues for the async sink.
+ */
+#include "BenchUtil.h"
+#include "../common/Inc/Log.h"
+#include "../periferia/Inc/gpio.h"
+#include <sys/mman.h>
+
+#define POLLS 200000
+#define WARNINGS 200
+
+/**
+ * @brief Polls the line, tracing each value only if Threshold lets trace through.
+ */
+template <Log::Level Threshold>
+static void run(FILE *out, const char *name, Periferia::GPIO &gpio)
+{
+    Bench::Samples samples(POLLS);
+    volatile int sink = 0;
+    for (int i = 0; i < POLLS; ++i)
+    {
+        unsigned long long start = Bench::nowNs();
+        int value = gpio.read();
+        if constexpr (Log::enabled<Log::Level::Trace, Threshold>())
+        {
+            Log::emit(Log::Level::Trace, "Read [%d]\n", value);
+        }
+        sink += value;
+        samples.add(Bench::nowNs() - start);
+    }
+    (void)sink;
+    Bench::report(out, name, samples, "compiled_in", Log::enabled<Log::Level::Trace, Threshold>() ? 1 : 0);
+}
+
+int main()
+{
+    FILE *out = Bench::quietStdout();
+
+    void *page = mmap(nullptr, Periferia::AM335X_GPIO_LAYOUT.mapSize, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED)
+    {
+        perror("mmap");
+        return 1;
+    }
+    Periferia::GPIOConfig config;
+    config.backend = Periferia::Backend::Mmap;
+    config.registers = (volatile uint32_t *)page;
+    Periferia::GPIO gpio(GPIO_DHT22, INPUT, config);
+
+    run<Log::Level::Trace>(out, "poll + trace (stdout)", gpio);
+    run<Log::Level::Off>(out, "poll, trace compiled out", gpio);
+
+    // Stay below LOG_QUEUE so nothing is dropped; the sink writes to /dev/null
+    if (freopen("/dev/null", "w", stderr) == nullptr)
+    {
+        perror("freopen");
+    }
+    Bench::Samples warn(WARNINGS);
+    for (int i = 0; i < WARNINGS; ++i)
+    {
+        unsigned long long start = Bench::nowNs();
+        LOG_WARN("bench warning %d\n", i);
+        warn.add(Bench::nowNs() - start);
+    }
+    Log::flush();
+    Bench::report(out, "LOG_WARN enqueue", warn, "dropped", (double)Log::dropped());
+
+    munmap(page, Periferia::AM335X_GPIO_LAYOUT.mapSize);
+    fclose(out);
+    return 0;
+}
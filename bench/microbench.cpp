@@ -0,0 +1,221 @@
+/*
+ * Microbenchmarks of the hot paths, in the Google Benchmark format.
+ *
+ * Each BM_ function times one operation per iteration: GPIO access on a
+ * fake sysfs tree and an anonymous mmap page, DHT22 frame decoding and
+ * checksum, a full DHT22Sensor::read() on the simulated sensor, the hybrid
+ * delay, SampleBus::publish() and metric recording. Run with
+ * --benchmark_out=<file> to keep a JSON baseline and compare builds
+ * (make bench VARIANT=native|lto).
+ */
+#include "Benchmark.h"
+#include "BenchUtil.h"
+#include "../periferia/Inc/gpio.h"
+#include "../sensors/Inc/DHT22.h"
+#include "../sensors/Inc/DHT22Decoder.h"
+#include "../sensors/Inc/DHT22Model.h"
+#include "../common/Inc/Timing.h"
+#include "../acquisition/Inc/SampleBus.h"
+#include "../common/Inc/Metrics.h"
+#include <sys/mman.h>
+
+static Bench::FakeSysfs sysfs;
+
+static void sysfsRead(Bench::State &state, Periferia::AccessMode mode)
+{
+    Periferia::GPIOConfig config;
+    config.sysfsRoot = sysfs.root();
+    config.mode = mode;
+    Periferia::GPIO gpio(GPIO_DHT22, INPUT, config);
+    gpio.resetStats();
+
+    volatile int sink = 0;
+    while (state.keepRunning())
+    {
+        sink += gpio.read();
+    }
+    (void)sink;
+    state.counter("syscalls_per_iter", (double)gpio.getStats().syscalls / state.iterations());
+}
+
+static void BM_SysfsReadReopen(Bench::State &state)
+{
+    sysfsRead(state, Periferia::AccessMode::Reopen);
+}
+BENCHMARK(BM_SysfsReadReopen);
+
+static void BM_SysfsReadPersistent(Bench::State &state)
+{
+    sysfsRead(state, Periferia::AccessMode::Persistent);
+}
+BENCHMARK(BM_SysfsReadPersistent);
+
+static void BM_SysfsWritePersistent(Bench::State &state)
+{
+    Periferia::GPIOConfig config;
+    config.sysfsRoot = sysfs.root();
+    config.mode = Periferia::AccessMode::Persistent;
+    Periferia::GPIO gpio(GPIO_DHT22, OUTPUT, config);
+
+    int value = LOW;
+    while (state.keepRunning())
+    {
+        gpio.write(value);
+        value ^= 1;
+    }
+}
+BENCHMARK(BM_SysfsWritePersistent);
+
+static void BM_MmapRead(Bench::State &state)
+{
+    void *page = mmap(nullptr, Periferia::AM335X_GPIO_LAYOUT.mapSize, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED)
+    {
+        return;
+    }
+    Periferia::GPIOConfig config;
+    config.backend = Periferia::Backend::Mmap;
+    config.registers = (volatile uint32_t *)page;
+    {
+        Periferia::GPIO gpio(GPIO_DHT22, INPUT, config);
+        volatile int sink = 0;
+        while (state.keepRunning())
+        {
+            sink += gpio.read();
+        }
+        (void)sink;
+    }
+    munmap(page, Periferia::AM335X_GPIO_LAYOUT.mapSize);
+}
+BENCHMARK(BM_MmapRead);
+
+// Answer of the model to one start signal, as edge-triggered capture records it
+static int modelFrame(Periferia::EdgeEvent *edges, int jitterUs)
+{
+    Sensors::DHT22ModelConfig config;
+    config.temperature = -7.3f;
+    config.jitterUs = jitterUs;
+    Sensors::DHT22Model model(config);
+    return model.respond(0, 1000000ULL, edges, SIM_MAX_EDGES);
+}
+
+static void BM_DHT22Decode(Bench::State &state)
+{
+    Periferia::EdgeEvent edges[SIM_MAX_EDGES];
+    int count = modelFrame(edges, 8);
+    int ok = 0;
+    while (state.keepRunning())
+    {
+        Sensors::DHT22Frame frame;
+        ok += (Sensors::DHT22Decoder::decode(edges, count, frame) == Sensors::DHT22Status::Ok);
+    }
+    state.counter("ok_ratio", (double)ok / state.iterations());
+}
+BENCHMARK(BM_DHT22Decode);
+
+static void BM_DHT22Checksum(Bench::State &state)
+{
+    uint8_t bytes[DHT22_DATA_BYTE_COUNT];
+    Sensors::DHT22Model::encode(45.0f, -7.3f, bytes);
+    volatile float sink = 0;
+    while (state.keepRunning())
+    {
+        Sensors::SensorData data;
+        if (Sensors::DHT22Decoder::checksumValid(bytes))
+        {
+            Sensors::DHT22Decoder::toSensorData(bytes, data);
+            sink = sink + data.temperature;
+        }
+    }
+    (void)sink;
+}
+BENCHMARK(BM_DHT22Checksum);
+
+// Start signal, capture and decode on the simulated line; the 1 ms start pulse dominates
+static void BM_DHT22ReadSimulated(Bench::State &state)
+{
+    Sensors::DHT22Model model;
+    Periferia::SimBackend simulator(&model, true);
+    Periferia::GPIOConfig config;
+    config.customBackend = &simulator;
+    Sensors::DHT22Sensor sensor(GPIO_DHT22, config);
+    sensor.setCaptureMode(Sensors::CaptureMode::EdgeTriggered);
+    sensor.setStartPulse(std::chrono::microseconds(1000));
+
+    int ok = 0;
+    while (state.keepRunning())
+    {
+        Sensors::SensorData data;
+        ok += sensor.read(data);
+    }
+    state.counter("ok_ratio", (double)ok / state.iterations());
+}
+BENCHMARK(BM_DHT22ReadSimulated);
+
+static void BM_Delay30us(Bench::State &state)
+{
+    unsigned long long start = Bench::nowNs();
+    while (state.keepRunning())
+    {
+        Common::delay(std::chrono::microseconds(30));
+    }
+    double perIteration = (double)(Bench::nowNs() - start) / state.iterations();
+    state.counter("overshoot_ns", perIteration - 30000.0);
+}
+BENCHMARK(BM_Delay30us);
+
+static void BM_SampleBusPublish(Bench::State &state)
+{
+    Acquisition::SampleBus bus;
+    int subscriber = bus.subscribe("bench", [](const Acquisition::SampleRecord &) {});
+    bus.start();
+
+    Acquisition::SampleRecord record = {};
+    record.ok = true;
+    while (state.keepRunning())
+    {
+        record.sensorId++;
+        bus.publish(record);
+    }
+    bus.stop();
+    state.counter("dropped_ratio", (double)bus.getDropped(subscriber) / state.iterations());
+}
+BENCHMARK(BM_SampleBusPublish);
+
+static void BM_MetricsCounterAdd(Bench::State &state)
+{
+    Metrics::Counter &counter = Metrics::counter("bench_events_total");
+    while (state.keepRunning())
+    {
+        counter.add();
+    }
+}
+BENCHMARK(BM_MetricsCounterAdd);
+
+static void BM_MetricsHistogramRecord(Bench::State &state)
+{
+    Metrics::Histogram &histogram = Metrics::histogram("bench_duration_seconds");
+    uint64_t value = 1;
+    while (state.keepRunning())
+    {
+        histogram.record(value);
+        value = (value * 2862933555777941757ULL + 3037000493ULL) & 0xFFFFFF; // spread over buckets
+    }
+}
+BENCHMARK(BM_MetricsHistogramRecord);
+
+int main(int argc, char *argv[])
+{
+    FILE *out = Bench::quietStdout();
+    const int pin = GPIO_DHT22;
+    if (!sysfs.create(&pin, 1))
+    {
+        return 1;
+    }
+    Common::calibrateTiming();
+
+    int result = Bench::runBenchmarks(argc, argv, out);
+    fclose(out);
+    return result;
+}
@@ -0,0 +1,86 @@
+/*
+ * Wake-up jitter of a periodic thread with and without real-time mode.
+ *
+ * A thread sleeps to absolute 1 ms deadlines and records how late it woke
+ * up, first as a plain SCHED_OTHER thread and then after
+ * Common::enterRealtime(). Busy threads on every CPU stand in for the rest
+ * of the system. Without CAP_SYS_NICE both runs stay SCHED_OTHER and the
+ * histograms match; the reported policy says which case was measured.
+ */
+#include "BenchUtil.h"
+#include "../common/Inc/Realtime.h"
+#include <thread>
+#include <atomic>
+#include <vector>
+
+#define WAKEUPS 2000
+#define PERIOD_NS 1000000ULL
+
+static std::atomic<bool> loaded(true);
+
+static void busyLoad()
+{
+    volatile unsigned long spin = 0;
+    while (loaded.load(std::memory_order_relaxed))
+    {
+        spin++;
+    }
+}
+
+static void periodic(bool realtime, Bench::Samples &lateness, Common::RealtimeStatus &status)
+{
+    if (realtime)
+    {
+        Common::RealtimeConfig config;
+        config.cpu = REALTIME_CPU_NONE; // compete for the same CPUs as the load
+        status = Common::enterRealtime(config);
+    }
+    else
+    {
+        status = Common::currentRealtime();
+    }
+
+    unsigned long long deadline = Bench::nowNs() + PERIOD_NS;
+    for (int i = 0; i < WAKEUPS; ++i)
+    {
+        struct timespec ts;
+        ts.tv_sec = deadline / 1000000000ULL;
+        ts.tv_nsec = deadline % 1000000000ULL;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+        lateness.add(Bench::nowNs() - deadline);
+        deadline += PERIOD_NS;
+    }
+}
+
+static void run(const char *name, bool realtime)
+{
+    Bench::Samples lateness(WAKEUPS);
+    Common::RealtimeStatus status;
+    std::thread thread(periodic, realtime, std::ref(lateness), std::ref(status));
+    thread.join();
+
+    char label[64];
+    snprintf(label, sizeof(label), "%s (%s)", name, Common::policyName(status.policy));
+    Bench::report(stdout, label, lateness, "mlocked", status.memoryLocked ? 1 : 0);
+    Bench::histogram(stdout, lateness);
+}
+
+int main()
+{
+    std::vector<std::thread> load;
+    unsigned int cpus = std::thread::hardware_concurrency();
+    for (unsigned int i = 0; i < (cpus > 0 ? cpus : 1); ++i)
+    {
+        load.emplace_back(busyLoad);
+    }
+
+    run("SCHED_OTHER thread", false);
+    run("real-time mode", true);
+
+    loaded = false;
+    for (std::thread &thread : load)
+    {
+        thread.join();
+    }
+    return 0;
+}
@@ -0,0 +1,238 @@
+/*
+ * Startup of many configured sensors, and the heap after it.
+ *
+ * For each size in SIZES a configuration file is generated: three in four
+ * sensors are simulated DHT22s (every other one with a filter chain on
+ * temperature and humidity), the rest DHT22s on a fake sysfs tree whose
+ * pins setupPins() configures in one pass. SensorSet::load() runs LOADS
+ * times per size; reports the load time and its phases, the arena size
+ * and the bytes per sensor. Every metric of every sensor must have found
+ * room in the registry.
+ *
+ * Then LOOP_SENSORS simulated sensors from one configuration run in the
+ * Daemon for LOOP_MS after every sensor has been read once; heap
+ * allocations in that window must be zero.
+ *
+ * Last, the running daemon is reloaded the way SIGHUP does it: a missing
+ * file must keep the current sensors, and a file of RELOAD_SENSORS must
+ * replace them with a fresh SensorSet whose sensors are all read next.
+ */
+#include "BenchUtil.h"
+#include "../service/Inc/SensorSet.h"
+#include "../common/Inc/Log.h"
+#include "../common/Inc/AllocTracker.h"
+#include "../common/Inc/Metrics.h"
+#include <memory>
+#include <string>
+
+#define LOADS 5
+#define LOOP_SENSORS 200
+#define LOOP_PERIOD_MS 500
+#define LOOP_MS 2000
+#define FIRST_PIN 100
+#define RELOAD_SENSORS 20
+
+static const int SIZES[] = {10, 100, 500};
+
+/**
+ * @brief Writes a configuration of count sensors; the sysfs ones live under sysfsRoot.
+ */
+static bool writeConfig(const std::string &path, int count, const char *sysfsRoot, bool simulatedOnly)
+{
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    fprintf(file, "# %d generated sensors\n", count);
+    for (int i = 0; i < count; ++i)
+    {
+        fprintf(file, "\n[sensor dht%d]\ntype = dht22\npin = %d\nperiod_ms = %d\n", i, FIRST_PIN + i, LOOP_PERIOD_MS);
+        if (!simulatedOnly && i % 4 == 3)
+        {
+            fprintf(file, "backend = sysfs\nsysfs_root = %s\n", sysfsRoot);
+            continue;
+        }
+        fprintf(file, "backend = sim\ncapture = edges\ninstant_edges = 1\nstart_low_us = 1000\nsim_temperature = %.1f\n",
+                15.0f + (i % 20));
+        if (i % 2 == 0)
+        {
+            fprintf(file, "filter.temperature = range:-40:80, hampel:7:3:0.2, kalman:0.01:0.25\n"
+                          "filter.humidity = range:0:100, median:5\n");
+        }
+    }
+    return fclose(file) == 0;
+}
+
+static int loadCase(const std::string &path, int count, const char *sysfsRoot)
+{
+    if (!writeConfig(path, count, sysfsRoot, false))
+    {
+        return 1;
+    }
+    Bench::Samples total(LOADS), parse(LOADS), setup(LOADS), create(LOADS);
+    Service::SensorSet sensors;
+    int errors = 0;
+    for (int i = 0; i < LOADS; ++i)
+    {
+        if (!sensors.load(path.c_str()) || sensors.getCount() != count)
+        {
+            errors++;
+            continue;
+        }
+        const Service::SensorSetStats &stats = sensors.getStats();
+        total.add(stats.totalNs);
+        parse.add(stats.parseNs);
+        setup.add(stats.setupNs);
+        create.add(stats.createNs);
+    }
+    total.finish();
+    parse.finish();
+    setup.finish();
+    create.finish();
+    const Service::SensorSetStats &stats = sensors.getStats();
+    char name[32];
+    snprintf(name, sizeof(name), "load %d sensors", count);
+    Bench::report(stdout, name, total, "per_sensor_us", total.percentile(50) / 1e3 / count);
+    printf("%-28s parse=%.2fms setup=%.2fms create=%.2fms pins=%d pin_failures=%d filters=%d\n", "",
+           parse.percentile(50) / 1e6, setup.percentile(50) / 1e6, create.percentile(50) / 1e6, stats.pins,
+           stats.pinFailures, stats.filters);
+    printf("%-28s arena=%zuKB used=%zuKB bytes/sensor=%zu errors=%d\n", "", stats.arenaBytes / 1024,
+           stats.arenaUsed / 1024, stats.arenaUsed / count, errors);
+    return errors + stats.pinFailures + (stats.arenaUsed <= stats.arenaBytes ? 0 : 1);
+}
+
+/**
+ * @brief Reloads a running daemon from a missing file, then from a smaller one; returns the errors.
+ * @param current Receives the set that replaced initial; must outlive the daemon's use of it.
+ */
+static int reloadCase(Service::Daemon &daemon, const std::string &path, const Service::SensorSet &initial,
+                      std::unique_ptr<Service::SensorSet> &current)
+{
+    std::string file = path + ".missing";
+    daemon.setReloadHandler([&](Service::Daemon &running) {
+        std::unique_ptr<Service::SensorSet> next(new Service::SensorSet());
+        if (!next->load(file.c_str()))
+        {
+            return false;
+        }
+        running.clearSensors();
+        if (!next->addTo(running))
+        {
+            return false;
+        }
+        current.swap(next);
+        return true;
+    });
+    daemon.reload();
+    int kept = daemon.getSensorCount();
+
+    file = path + ".reload";
+    if (!writeConfig(file, RELOAD_SENSORS, nullptr, true))
+    {
+        return 1;
+    }
+    unsigned long long start = Bench::nowNs();
+    daemon.reload();
+    unsigned long long reloadNs = Bench::nowNs() - start;
+    int replaced = daemon.getSensorCount();
+    int read = 0;
+    unsigned long long end = Bench::nowNs() + 2 * LOOP_PERIOD_MS * 1000000ULL;
+    while (read < replaced && Bench::nowNs() < end)
+    {
+        daemon.runOnce(100);
+        for (read = 0; read < replaced && daemon.getSensorStats(read).cycles > 0; ++read)
+        {
+        }
+    }
+    printf("%-28s kept=%d of %d replaced=%d read=%d reload=%.2fms\n", "daemon reload", kept, initial.getCount(),
+           replaced, read, reloadNs / 1e6);
+    daemon.setReloadHandler(nullptr);
+    unlink(file.c_str());
+    return (kept == initial.getCount() && replaced == RELOAD_SENSORS && read == RELOAD_SENSORS) ? 0 : 1;
+}
+
+static int loopCase(const std::string &path)
+{
+    if (!writeConfig(path, LOOP_SENSORS, nullptr, true))
+    {
+        return 1;
+    }
+    Service::SensorSet sensors;
+    if (!sensors.load(path.c_str()))
+    {
+        return 1;
+    }
+    std::unique_ptr<Service::SensorSet> reloaded;
+    Service::DaemonConfig config;
+    config.socketPath = nullptr;
+    config.handleSignals = false;
+    Service::Daemon daemon(config);
+    if (!sensors.addTo(daemon) || !daemon.start())
+    {
+        printf("%-28s start failed\n", "daemon loop");
+        return 1;
+    }
+
+    // Warm-up: every sensor read once
+    unsigned long long warmupStart = Bench::nowNs();
+    for (int i = 0; i < LOOP_SENSORS;)
+    {
+        daemon.runOnce(-1);
+        while (i < LOOP_SENSORS && daemon.getSensorStats(i).cycles > 0)
+        {
+            i++;
+        }
+    }
+    unsigned long long warmupNs = Bench::nowNs() - warmupStart;
+    unsigned long allocationsBefore = Common::allocationCount();
+    unsigned long long end = Bench::nowNs() + LOOP_MS * 1000000ULL;
+    while (Bench::nowNs() < end)
+    {
+        daemon.runOnce(100);
+    }
+    unsigned long steadyAllocations = Common::allocationCount() - allocationsBefore;
+
+    unsigned long cycles = 0;
+    unsigned long failures = 0;
+    unsigned long long readNs = 0;
+    for (int i = 0; i < LOOP_SENSORS; ++i)
+    {
+        cycles += daemon.getSensorStats(i).cycles;
+        failures += daemon.getSensorStats(i).failures;
+        readNs += daemon.getSensorStats(i).readNsTotal;
+    }
+    printf("%-28s sensors=%d first_round=%.1fms reads=%lu failures=%lu read_mean=%.1fus steady_allocations=%lu\n",
+           "daemon loop", LOOP_SENSORS, warmupNs / 1e6, cycles, failures, readNs / 1e3 / cycles, steadyAllocations);
+    int errors = steadyAllocations == 0 ? 0 : 1;
+    errors += reloadCase(daemon, path, sensors, reloaded);
+    daemon.stop();
+    return errors;
+}
+
+int main()
+{
+    int pins[SIZES[2]];
+    for (int i = 0; i < SIZES[2]; ++i)
+    {
+        pins[i] = FIRST_PIN + i;
+    }
+    Bench::FakeSysfs sysfs;
+    if (!sysfs.create(pins, SIZES[2]))
+    {
+        return 1;
+    }
+    std::string path = std::string(sysfs.root()) + "/sensors.ini";
+    int errors = 0;
+    for (int size : SIZES)
+    {
+        errors += loadCase(path, size, sysfs.root());
+    }
+    errors += loopCase(path);
+    Metrics::Snapshot snapshot = Metrics::snapshot();
+    printf("%-28s counters=%zu histograms=%zu registration_failures=%lu\n", "metrics", snapshot.counters.size(),
+           snapshot.histograms.size(), Metrics::registrationFailures());
+    errors += Metrics::registrationFailures() == 0 ? 0 : 1;
+    Log::flush();
+    return errors == 0 ? 0 : 1;
+}
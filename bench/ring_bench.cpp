@@ -0,0 +1,109 @@
+/*
+ * Throughput and publish-to-consume latency of the sample rings.
+ *
+ * Each pushed record carries its publish time in startNs; the consumer
+ * subtracts it from the pop time. MPSC runs are repeated with more
+ * producers to show the cost of contention on the enqueue index.
+ */
+#include "BenchUtil.h"
+#include "../common/Inc/RingBuffer.h"
+#include "../acquisition/Inc/Sample.h"
+#include <thread>
+#include <atomic>
+
+#define ITEMS 1000000
+#define RING 1024
+
+typedef Acquisition::SampleRecord Record;
+
+template <typename Ring>
+static void consume(Ring &ring, long expected, Bench::Samples &latency)
+{
+    Record record;
+    long received = 0;
+    while (received < expected)
+    {
+        if (ring.tryPop(record))
+        {
+            if ((received & 63) == 0)
+            {
+                latency.add(Bench::nowNs() - record.startNs);
+            }
+            received++;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+template <typename Ring>
+static void produce(Ring &ring, long count, std::atomic<unsigned long> &fullSpins)
+{
+    Record record = Record();
+    for (long i = 0; i < count; ++i)
+    {
+        record.sensorId = (int)i;
+        record.startNs = Bench::nowNs();
+        while (!ring.tryPush(record))
+        {
+            fullSpins.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::yield();
+        }
+    }
+}
+
+static void runSpsc(FILE *out)
+{
+    static Common::SpscRing<Record, RING> ring;
+    Bench::Samples latency(ITEMS / 64 + 1);
+    std::atomic<unsigned long> fullSpins(0);
+
+    unsigned long long start = Bench::nowNs();
+    std::thread consumer([&] { consume(ring, ITEMS, latency); });
+    produce(ring, ITEMS, fullSpins);
+    consumer.join();
+    double seconds = (Bench::nowNs() - start) / 1e9;
+
+    Bench::report(out, "spsc 1p latency", latency, "Mitems/s", ITEMS / seconds / 1e6);
+}
+
+static void runMpsc(FILE *out, int producers)
+{
+    static Common::MpscRing<Record, RING> ring;
+    Bench::Samples latency(ITEMS / 64 + 1);
+    std::atomic<unsigned long> fullSpins(0);
+    long perProducer = ITEMS / producers;
+
+    unsigned long long start = Bench::nowNs();
+    std::thread consumer([&] { consume(ring, perProducer * producers, latency); });
+    std::vector<std::thread> threads;
+    for (int i = 0; i < producers; ++i)
+    {
+        threads.emplace_back([&] { produce(ring, perProducer, fullSpins); });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    consumer.join();
+    double seconds = (Bench::nowNs() - start) / 1e9;
+
+    char name[64];
+    snprintf(name, sizeof(name), "mpsc %dp latency", producers);
+    Bench::report(out, name, latency, "Mitems/s", perProducer * producers / seconds / 1e6);
+}
+
+int main()
+{
+    FILE *out = Bench::quietStdout();
+    runSpsc(out);
+    const int producers[] = {1, 2, 4, 8};
+    for (int count : producers)
+    {
+        runMpsc(out, count);
+    }
+    fclose(out);
+    return 0;
+}
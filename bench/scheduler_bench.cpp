@@ -0,0 +1,83 @@
+/*
+ * Start jitter and throughput of the acquisition scheduler as the number
+ * of sensors grows.
+ *
+ * Sensors are stand-ins that spend a fixed time in read(); one of them is
+ * timing-critical so it gets the dedicated worker, like a DHT22.
+ */
+#include "BenchUtil.h"
+#include "../acquisition/Inc/Scheduler.h"
+#include <thread>
+#include <chrono>
+
+#define RUN_MS 1000
+#define PERIOD_MS 10
+#define READ_US 200
+
+class FakeSensor : public Sensors::SensorBase
+{
+public:
+    explicit FakeSensor(bool critical) : critical(critical) {}
+    bool open() override { return true; }
+    bool read(Sensors::SensorData &data) override
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(READ_US));
+        data.temperature = 21.5f;
+        data.humidity = 40.0f;
+        data.light = 0.0f;
+        return true;
+    }
+    void close() override {}
+    bool isTimingCritical() const override { return critical; }
+
+private:
+    bool critical;
+};
+
+static void run(FILE *out, int sensorCount)
+{
+    std::vector<std::unique_ptr<FakeSensor>> sensors;
+    Acquisition::Scheduler scheduler;
+    for (int i = 0; i < sensorCount; ++i)
+    {
+        sensors.emplace_back(new FakeSensor(i == 0));
+        scheduler.addSensor(sensors.back().get(), PERIOD_MS);
+    }
+
+    scheduler.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(RUN_MS));
+    scheduler.stop();
+
+    Bench::Samples jitter(sensorCount * (RUN_MS / PERIOD_MS + 1));
+    std::vector<Acquisition::SampleRecord> records(SCHEDULER_HISTORY);
+    unsigned long runs = 0;
+    unsigned long misses = 0;
+    for (int id = 0; id < sensorCount; ++id)
+    {
+        size_t count = scheduler.getRecords(id, records.data(), records.size());
+        for (size_t i = 0; i < count; ++i)
+        {
+            jitter.add(records[i].startNs - records[i].scheduledNs);
+        }
+        Acquisition::SensorStats stats = scheduler.getStats(id);
+        runs += stats.runs;
+        misses += stats.deadlineMisses + stats.skippedPeriods;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "%d sensors jitter", sensorCount);
+    Bench::report(out, name, jitter, "samples/s", runs * 1000.0 / RUN_MS);
+    fprintf(out, "%-28s missed=%lu rt_workers=%d\n", "", misses, scheduler.getRealtimeWorkers());
+}
+
+int main()
+{
+    FILE *out = Bench::quietStdout();
+    const int counts[] = {1, 4, 16, 64, 128};
+    for (int count : counts)
+    {
+        run(out, count);
+    }
+    fclose(out);
+    return 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * Shared-memory readings: one writer, many readers, no torn copies.
+ *
+ * A writer thread publishes readings of one sensor as fast as it can for
+ * RUN_MS; every reading carries its serial in the timestamp and in all
+ * channel values, so a copy mixing two readings is detected. READERS
+ * threads and one forked reader process call latest() in a loop, and a
+ * further thread copies the whole history ring, checking that serials are
+ * strictly increasing. Reports the cost of latest() and history(), the
+ * reads per published reading, and torn or failed copies (both must be
+ * zero). The writer's publish() cost is reported with no readers and with
+ * all of them running.
+ */
+#include "BenchUtil.h"
+#include "../acquisition/Inc/SharedReadings.h"
+#include "../common/Inc/Log.h"
+#include <atomic>
+#include <thread>
+#include <sys/wait.h>
+
+#define RUN_MS 1000
+#define READERS 3
+#define SAMPLES_PER_THREAD 200000
+
+struct ReaderResult
+{
+    unsigned long reads;
+    unsigned long torn;
+    unsigned long failed;
+};
+
+static const Sensors::SensorSchema benchSchema = {3, {{"temperature", "C"}, {"humidity", "%RH"}, {"light", "lx"}}};
+
+/**
+ * @brief Values of reading number serial; checkReading() recognizes any mix of two.
+ */
+static void valuesOf(uint32_t serial, float *values)
+{
+    float base = (float)(serial % 1000000);
+    values[0] = base;
+    values[1] = base + 1.0f;
+    values[2] = base * 2.0f;
+}
+
+static bool checkReading(const Acquisition::SharedReading &reading)
+{
+    float values[3];
+    valuesOf(reading.serial, values);
+    return reading.timestampNs == reading.serial && reading.ok == 1 && reading.values[0] == values[0] &&
+           reading.values[1] == values[1] && reading.values[2] == values[2];
+}
+
+/**
+ * @brief Calls latest() until the deadline; optionally keeps latency samples.
+ */
+static ReaderResult readLatest(const char *name, unsigned long long deadlineNs, Bench::Samples *samples)
+{
+    ReaderResult result = {0, 0, 0};
+    Acquisition::SharedReader reader(name);
+    if (!reader.open())
+    {
+        result.failed = 1;
+        return result;
+    }
+    int sensor = reader.findSensor("bench");
+    Acquisition::SharedReading reading;
+    while (Bench::nowNs() < deadlineNs)
+    {
+        unsigned long long start = Bench::nowNs();
+        bool ok = reader.latest(sensor, reading);
+        if (samples != nullptr && samples->ns.size() < SAMPLES_PER_THREAD)
+        {
+            samples->add(Bench::nowNs() - start);
+        }
+        if (!ok)
+        {
+            // Only before the first reading is published
+            continue;
+        }
+        result.reads++;
+        if (!checkReading(reading))
+        {
+            result.torn++;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Publishes readings until the deadline; returns how many.
+ */
+static uint32_t writeReadings(Acquisition::SharedPublisher &publisher, int sensor, unsigned long long deadlineNs,
+                              uint32_t first, Bench::Samples &samples)
+{
+    uint32_t serial = first;
+    float values[3];
+    while (Bench::nowNs() < deadlineNs)
+    {
+        valuesOf(serial, values);
+        unsigned long long start = Bench::nowNs();
+        publisher.publish(sensor, serial, true, values);
+        if (samples.ns.size() < SAMPLES_PER_THREAD)
+        {
+            samples.add(Bench::nowNs() - start);
+        }
+        serial++;
+    }
+    return serial - first;
+}
+
+int main()
+{
+    char name[64];
+    snprintf(name, sizeof(name), "/enviromonitor-bench-%d", (int)getpid());
+    Acquisition::SharedPublisher publisher(name);
+    if (!publisher.open())
+    {
+        return 1;
+    }
+    int sensor = publisher.addSensor("bench", benchSchema);
+
+    // Writer alone
+    Bench::Samples alone(SAMPLES_PER_THREAD);
+    uint32_t published = writeReadings(publisher, sensor, Bench::nowNs() + RUN_MS * 1000000ULL / 4, 0, alone);
+    Bench::report(stdout, "publish, no readers", alone, "published_M", published / 1e6);
+
+    // Forked reader process, started before any thread
+    unsigned long long deadline = Bench::nowNs() + RUN_MS * 1000000ULL;
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0)
+    {
+        return 1;
+    }
+    pid_t child = fork();
+    if (child == 0)
+    {
+        close(pipeFds[0]);
+        ReaderResult result = readLatest(name, deadline, nullptr);
+        ssize_t written = write(pipeFds[1], &result, sizeof(result));
+        _exit(written == sizeof(result) ? 0 : 1);
+    }
+    close(pipeFds[1]);
+
+    std::vector<Bench::Samples> samples(READERS, Bench::Samples(SAMPLES_PER_THREAD));
+    std::vector<ReaderResult> results(READERS);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < READERS; ++i)
+    {
+        readers.emplace_back([&, i]() { results[i] = readLatest(name, deadline, &samples[i]); });
+    }
+    Bench::Samples historyNs(SAMPLES_PER_THREAD);
+    unsigned long historyGaps = 0;
+    unsigned long historyCopies = 0;
+    std::thread historyReader([&]() {
+        Acquisition::SharedReader reader(name);
+        if (!reader.open())
+        {
+            historyGaps++;
+            return;
+        }
+        Acquisition::SharedReading ring[SHM_HISTORY];
+        while (Bench::nowNs() < deadline)
+        {
+            unsigned long long start = Bench::nowNs();
+            size_t count = reader.history(0, ring, SHM_HISTORY);
+            if (historyNs.ns.size() < SAMPLES_PER_THREAD)
+            {
+                historyNs.add(Bench::nowNs() - start);
+            }
+            historyCopies += count;
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (!checkReading(ring[i]) || (i > 0 && ring[i].serial <= ring[i - 1].serial))
+                {
+                    historyGaps++;
+                }
+            }
+        }
+    });
+    Bench::Samples contended(SAMPLES_PER_THREAD);
+    uint32_t contendedPublished = writeReadings(publisher, sensor, deadline, published, contended);
+    for (std::thread &reader : readers)
+    {
+        reader.join();
+    }
+    historyReader.join();
+
+    ReaderResult childResult = {0, 0, 1};
+    int status = 0;
+    if (read(pipeFds[0], &childResult, sizeof(childResult)) != sizeof(childResult) ||
+        waitpid(child, &status, 0) != child)
+    {
+        childResult.failed = 1;
+    }
+    close(pipeFds[0]);
+
+    Bench::report(stdout, "publish, with readers", contended, "published_M", contendedPublished / 1e6);
+    Bench::Samples all(READERS * SAMPLES_PER_THREAD);
+    unsigned long reads = childResult.reads;
+    unsigned long torn = childResult.torn + historyGaps;
+    unsigned long failed = childResult.failed;
+    for (int i = 0; i < READERS; ++i)
+    {
+        all.ns.insert(all.ns.end(), samples[i].ns.begin(), samples[i].ns.end());
+        reads += results[i].reads;
+        torn += results[i].torn;
+        failed += results[i].failed;
+    }
+    Bench::report(stdout, "latest()", all, "reads_M", reads / 1e6);
+    Bench::report(stdout, "history(64)", historyNs, "readings_M", historyCopies / 1e6);
+    printf("%-28s readers=%d+1 process reads_per_publish=%.2f torn=%lu failed=%lu\n", "", READERS,
+           (double)reads / contendedPublished, torn, failed);
+
+    publisher.close();
+    Acquisition::SharedReader gone(name);
+    bool unlinked = !gone.open();
+    printf("%-28s %s\n", "segment removed on close", unlinked ? "yes" : "NO");
+    Log::flush();
+    return (torn == 0 && failed == 0 && unlinked) ? 0 : 1;
+}
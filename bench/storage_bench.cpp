@@ -0,0 +1,129 @@
+/*
+ * Time-series store: append throughput, write batching and range scans.
+ *
+ * A month of 1 Hz history for four sensors (about 10M records, 250 MB) is
+ * too much for a quick run, so RECORDS samples one second apart are
+ * spread over SENSORS sensors, with a few percent arriving up to
+ * LATE_MAX_S late. Appends are timed from the producer side; the write()
+ * count shows how well the writer batches. Range queries of QUERY_S
+ * seconds at random positions are timed and checked against a
+ * brute-force count over everything appended.
+ */
+#include "BenchUtil.h"
+#include "../storage/Inc/TimeSeries.h"
+#include "../common/Inc/Log.h"
+#include <thread>
+
+#define RECORDS 2000000
+#define SENSORS 4
+#define SEGMENT_RECORDS 262144
+#define LATE_PERCENT 2
+#define LATE_MAX_S 30
+#define QUERIES 2000
+#define QUERY_S 3600
+
+static unsigned long long rngState = 88172645463325252ULL;
+
+static unsigned long long randomNext()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
+int main()
+{
+    char directory[] = "/tmp/enviromonitor-tsdb-XXXXXX";
+    if (mkdtemp(directory) == nullptr)
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    const int64_t secondNs = 1000000000LL;
+    const int64_t baseNs = 1700000000LL * secondNs;
+    std::vector<Storage::StoredSample> samples(RECORDS);
+    for (int i = 0; i < RECORDS; ++i)
+    {
+        Storage::StoredSample &sample = samples[i];
+        sample.timestampNs = baseNs + (int64_t)(i / SENSORS) * secondNs;
+        if ((int)(randomNext() % 100) < LATE_PERCENT)
+        {
+            sample.timestampNs -= (int64_t)(randomNext() % LATE_MAX_S) * secondNs;
+        }
+        sample.sensorId = i % SENSORS;
+        sample.temperature = 20.0f + (i % 100) * 0.1f;
+        sample.humidity = 40.0f;
+        sample.light = 0.0f;
+    }
+
+    Storage::TimeSeriesConfig config;
+    config.directory = directory;
+    config.segmentRecords = SEGMENT_RECORDS;
+    Storage::TimeSeriesWriter writer(config);
+    if (!writer.start())
+    {
+        return 1;
+    }
+    Bench::Samples appendNs(RECORDS);
+    unsigned long long start = Bench::nowNs();
+    for (int i = 0; i < RECORDS; ++i)
+    {
+        unsigned long long before = Bench::nowNs();
+        while (!writer.append(samples[i]))
+        {
+            std::this_thread::yield(); // producer faster than the disk: wait instead of dropping
+        }
+        appendNs.add(Bench::nowNs() - before);
+    }
+    writer.flush();
+    double seconds = (Bench::nowNs() - start) / 1e9;
+    writer.stop();
+    Bench::report(stdout, "append", appendNs, "records/s", RECORDS / seconds);
+    printf("%-28s written=%lu write_calls=%lu records/write=%.1f segments=%zu bytes/record=%zu\n", "",
+           writer.getWritten(), writer.getWriteCalls(), (double)writer.getWritten() / writer.getWriteCalls(),
+           Storage::listSegments(directory).size(), sizeof(Storage::StoredSample));
+
+    Storage::TimeSeriesReader reader(directory);
+    Bench::Samples queryNs(QUERIES);
+    int mismatches = 0;
+    long returned = 0;
+    const int64_t spanNs = (int64_t)(RECORDS / SENSORS) * secondNs;
+    for (int q = 0; q < QUERIES; ++q)
+    {
+        int64_t fromNs = baseNs + (int64_t)(randomNext() % (unsigned long long)spanNs);
+        int64_t toNs = fromNs + QUERY_S * secondNs;
+        int sensor = (int)(randomNext() % (SENSORS + 1)) - 1; // -1: all sensors
+        long sum = 0;
+
+        unsigned long long before = Bench::nowNs();
+        long count = reader.scan(fromNs, toNs, sensor, [&sum](const Storage::StoredSample &record) {
+            sum += (long)record.sensorId;
+        });
+        queryNs.add(Bench::nowNs() - before);
+        returned += count;
+
+        if (q % 20 == 0) // brute force is slow; check a subset
+        {
+            long expected = 0;
+            for (const Storage::StoredSample &sample : samples)
+            {
+                expected += (sample.timestampNs >= fromNs && sample.timestampNs <= toNs &&
+                             (sensor < 0 || (int)sample.sensorId == sensor));
+            }
+            mismatches += (expected != count);
+        }
+    }
+    Bench::report(stdout, "range query 1h", queryNs, "records/query", (double)returned / QUERIES);
+    printf("%-28s mismatches=%d (of %d checked)\n", "", mismatches, QUERIES / 20);
+
+    char command[sizeof(directory) + 16];
+    snprintf(command, sizeof(command), "rm -rf %s", directory);
+    if (system(command) != 0)
+    {
+        fprintf(stderr, "Could not remove %s\n", directory);
+    }
+    Log::flush();
+    return mismatches == 0 ? 0 : 1;
+}
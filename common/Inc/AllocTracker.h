@@ -0,0 +1,65 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+/*
+ * Heap allocation accounting for the acquisition path.
+ *
+ * AllocHooks.cpp replaces malloc(), calloc(), realloc() and the aligned
+ * allocators, so every heap allocation is counted, process-wide and per
+ * thread, for the price of two increments: C++ new (which allocates
+ * through malloc) as well as libc's own, such as the FILE of an fopen().
+ * Code that must not allocate once warmed up (a sensor read, a GPIO
+ * access, publishing a reading) runs inside a NoAllocScope. An
+ * allocation inside a scope is counted as a violation; a build with
+ * ALLOC_CHECK=1 (VARIANT=debug) also prints the scope and aborts right
+ * there, so the core dump or debugger shows the allocating call.
+ *
+ * The hooks are linked only into the benchmarks and VARIANT=debug. In
+ * other builds nothing calls noteAllocation(): the counters stay at zero
+ * and a scope costs two thread-local stores. Allocations made with mmap()
+ * or by the dynamic loader are never seen.
+ */
+
+#include <cstddef>
+
+#ifndef ALLOC_CHECK
+#define ALLOC_CHECK 0
+#endif
+
+namespace Common
+{
+    // Allocations by every thread since the process started
+    unsigned long allocationCount();
+    // Allocations by the calling thread
+    unsigned long threadAllocationCount();
+    // Allocations made inside a NoAllocScope, by any thread
+    unsigned long allocationViolations();
+    // Called by the allocation hooks for each allocation; must not allocate
+    void noteAllocation(size_t size);
+
+    /**
+     * @class NoAllocScope
+     * @brief Marks the calling thread as not allocating until the scope ends.
+     *
+     * Scopes nest; an allocation is reported with the innermost name.
+     */
+    class NoAllocScope
+    {
+    public:
+        // name must outlive the scope, e.g. a string literal
+        explicit NoAllocScope(const char *name);
+        ~NoAllocScope();
+        NoAllocScope(const NoAllocScope &) = delete;
+        NoAllocScope &operator=(const NoAllocScope &) = delete;
+
+        // Allocations by this thread since the scope began
+        unsigned long getAllocations() const { return threadAllocationCount() - startCount; }
+
+    private:
+        const char *outer;
+        unsigned long startCount;
+    };
+
+} // namespace Common
+
+#endif // ALLOC_TRACKER_H
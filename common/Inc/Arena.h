@@ -0,0 +1,113 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Alignment of the arena block: a cache line
+#define ARENA_ALIGN 64
+
+namespace Common
+{
+    /**
+     * @class Arena
+     * @brief One block of memory that objects are placed into at load time.
+     *
+     * The block is allocated once by reserve(), sized beforehand by
+     * summing footprint() over everything that will be created, and its
+     * pages are touched so later use causes no page faults either. create()
+     * constructs an object in the block and, unless it is trivially
+     * destructible, records its destructor in the block as well; clear()
+     * and the destructor run them newest first. Nothing is ever freed
+     * individually. Not thread-safe: fill it from one thread, then share
+     * the objects.
+     */
+    class Arena
+    {
+    public:
+        Arena();
+        ~Arena();
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+
+        // Allocate the block; false if it cannot be allocated or objects already live in the arena
+        bool reserve(size_t bytes);
+        // Raw storage, or nullptr when the block is exhausted
+        void *allocate(size_t size, size_t alignment);
+        // Destroy every object created so far, newest first; the block is kept
+        void clear();
+
+        // Construct a T in the block; nullptr when the block is exhausted
+        template <typename T, typename... Args>
+        T *create(Args &&...args)
+        {
+            void *storage = allocate(sizeof(T), alignof(T));
+            if (storage == nullptr)
+            {
+                return nullptr;
+            }
+            if (!std::is_trivially_destructible<T>::value)
+            {
+                void *node = allocate(sizeof(Finalizer), alignof(Finalizer));
+                if (node == nullptr)
+                {
+                    return nullptr;
+                }
+                T *object = new (storage) T(std::forward<Args>(args)...);
+                last = new (node) Finalizer{&destroy<T>, object, last};
+                return object;
+            }
+            return new (storage) T(std::forward<Args>(args)...);
+        }
+
+        // Uninitialized array of count trivially destructible T; nullptr when the block is exhausted
+        template <typename T>
+        T *createArray(size_t count)
+        {
+            static_assert(std::is_trivially_destructible<T>::value, "arena arrays are never destroyed");
+            return static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        // Most bytes create<T>() takes from the block, alignment padding included
+        template <typename T>
+        static constexpr size_t footprint()
+        {
+            return sizeof(T) + alignof(T) - 1 +
+                   (std::is_trivially_destructible<T>::value ? 0 : sizeof(Finalizer) + alignof(Finalizer) - 1);
+        }
+        // Most bytes createArray<T>(count) takes from the block
+        template <typename T>
+        static constexpr size_t footprint(size_t count)
+        {
+            return sizeof(T) * count + alignof(T) - 1;
+        }
+
+        size_t getUsed() const { return used; }
+        size_t getCapacity() const { return capacity; }
+
+    private:
+        // Destructor of one object, linked newest first
+        struct Finalizer
+        {
+            void (*run)(void *);
+            void *object;
+            Finalizer *previous;
+        };
+
+        template <typename T>
+        static void destroy(void *object)
+        {
+            static_cast<T *>(object)->~T();
+        }
+
+        char *block;
+        size_t capacity;
+        size_t used;
+        Finalizer *last;
+    };
+
+} // namespace Common
+
+#endif // ARENA_H
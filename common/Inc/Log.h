@@ -0,0 +1,80 @@
+#ifndef LOG_H
+#define LOG_H
+
+/*
+ * Leveled logging with the level filter resolved at compile time.
+ *
+ * LOG_LEVEL (0 = trace ... 4 = error, 5 = off) is set by the build. A
+ * LOG_* call below that level expands to an `if constexpr (false)` block,
+ * so neither the call nor its arguments are compiled in. Trace, debug and
+ * info go straight to stdout; warnings and errors are formatted into a
+ * fixed-size record and handed to a background thread that writes them to
+ * stderr, so the caller never blocks on the terminal.
+ */
+
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_WARN 3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF 5
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Longest message kept by the async sink, including the terminator
+#define LOG_RECORD_SIZE 192
+#define LOG_QUEUE 256
+
+namespace Log
+{
+    enum class Level : int
+    {
+        Trace = LOG_LEVEL_TRACE,
+        Debug = LOG_LEVEL_DEBUG,
+        Info = LOG_LEVEL_INFO,
+        Warn = LOG_LEVEL_WARN,
+        Error = LOG_LEVEL_ERROR,
+        Off = LOG_LEVEL_OFF
+    };
+
+    constexpr Level compiledLevel = static_cast<Level>(LOG_LEVEL);
+
+    // True if messages of level L survive the given threshold
+    template <Level L, Level Threshold = compiledLevel>
+    constexpr bool enabled()
+    {
+        return L != Level::Off && static_cast<int>(L) >= static_cast<int>(Threshold);
+    }
+
+    // Runtime part of a LOG_* call; use the macros so disabled levels compile out
+    void emit(Level level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+    // Start the async sink thread now instead of on the first warning, which may come from a timing-critical path
+    void start();
+
+    // Block until the async sink has written everything queued so far
+    void flush();
+
+    // Warnings/errors lost because the async queue was full
+    unsigned long dropped();
+
+} // namespace Log
+
+#define LOG_AT(level, ...)                           \
+    do                                               \
+    {                                                \
+        if constexpr (::Log::enabled<level>())       \
+        {                                            \
+            ::Log::emit(level, __VA_ARGS__);         \
+        }                                            \
+    } while (0)
+
+#define LOG_TRACE(...) LOG_AT(::Log::Level::Trace, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(::Log::Level::Debug, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(::Log::Level::Info, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(::Log::Level::Warn, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(::Log::Level::Error, __VA_ARGS__)
+
+#endif // LOG_H
@@ -0,0 +1,131 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+/*
+ * Lock-free counters and latency histograms for the acquisition hot path.
+ *
+ * Metrics are registered once (by name and Prometheus label set) and the
+ * caller keeps the returned reference; recording is then a relaxed atomic
+ * add, so GPIO polls and DHT22 reads can be instrumented from any thread
+ * without locks or allocation. Histograms are HDR-style log-linear: every
+ * power of two is split into 2^METRICS_SUB_BUCKET_BITS linear buckets, for
+ * a relative error below 1/2^METRICS_SUB_BUCKET_BITS over the whole range.
+ * snapshot() copies the current values for local use and writePrometheus()
+ * dumps them in the text exposition format for the node exporter textfile
+ * collector. A registration past METRICS_MAX_* is an error: it is logged,
+ * counted (metrics_registration_failures_total) and gets a shared slot
+ * that is never exported.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Room for DAEMON_MAX_SENSORS filtered DHT22s in the daemon (15 counters, 7 histograms each) with margin
+#define METRICS_MAX_COUNTERS 16384
+#define METRICS_MAX_HISTOGRAMS 4096
+// Storage is allocated in blocks of this many metrics as they register, never moved or freed
+#define METRICS_BLOCK 64
+#define METRICS_NAME_SIZE 64
+#define METRICS_LABELS_SIZE 96
+#define METRICS_HELP_SIZE 96
+
+// 16 linear buckets per power of two: < 6.25% error
+#define METRICS_SUB_BUCKET_BITS 4
+// Largest recordable value is 2^METRICS_MAX_EXPONENT - 1 ns (~18 min); larger values are clamped
+#define METRICS_MAX_EXPONENT 40
+
+namespace Metrics
+{
+    /**
+     * @brief Monotonic event counter.
+     */
+    class Counter
+    {
+    public:
+        void add(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+        uint64_t get() const { return value.load(std::memory_order_relaxed); }
+        void reset() { value.store(0, std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64_t> value{0};
+    };
+
+    /**
+     * @brief Log-linear histogram of durations in nanoseconds.
+     */
+    class Histogram
+    {
+    public:
+        static constexpr int SUB_BUCKETS = 1 << METRICS_SUB_BUCKET_BITS;
+        static constexpr int BUCKETS = (METRICS_MAX_EXPONENT - METRICS_SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        void record(uint64_t ns);
+        void reset();
+
+        uint64_t getCount() const { return count.load(std::memory_order_relaxed); }
+        uint64_t getSumNs() const { return sumNs.load(std::memory_order_relaxed); }
+        uint64_t getMaxNs() const { return maxNs.load(std::memory_order_relaxed); }
+        uint64_t getBucket(int index) const { return buckets[index].load(std::memory_order_relaxed); }
+
+        static int bucketIndex(uint64_t ns);
+        // Largest value that falls into the bucket
+        static uint64_t bucketUpperNs(int index);
+
+    private:
+        std::atomic<uint64_t> buckets[BUCKETS] = {};
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sumNs{0};
+        std::atomic<uint64_t> maxNs{0};
+    };
+
+    struct CounterValue
+    {
+        std::string name;
+        std::string labels; ///< Prometheus label pairs without braces, e.g. pin="4"
+        uint64_t value;
+    };
+
+    struct HistogramValue
+    {
+        std::string name;
+        std::string labels;
+        uint64_t count;
+        uint64_t sumNs;
+        uint64_t maxNs;
+        std::vector<uint64_t> buckets; ///< Histogram::BUCKETS entries
+
+        // Upper bound of the bucket holding the p-th percentile (0..100), 0 if empty
+        uint64_t percentileNs(double p) const;
+        double meanNs() const { return count == 0 ? 0.0 : (double)sumNs / count; }
+    };
+
+    // Copy of every registered metric at one point in time
+    struct Snapshot
+    {
+        std::vector<CounterValue> counters;
+        std::vector<HistogramValue> histograms;
+
+        // nullptr if no metric has this name and label set
+        const CounterValue *findCounter(const char *name, const char *labels = "") const;
+        const HistogramValue *findHistogram(const char *name, const char *labels = "") const;
+    };
+
+    // Find or register a metric; keep the reference, registration takes a lock
+    Counter &counter(const char *name, const char *labels = "", const char *help = "");
+    Histogram &histogram(const char *name, const char *labels = "", const char *help = "");
+    // Registrations refused because a registry was full; each was logged as an error
+    unsigned long registrationFailures();
+
+    Snapshot snapshot();
+
+    // Write the Prometheus text format to path (via a temporary file and rename); false on I/O errors
+    bool writePrometheus(const char *path);
+
+    // Zero every registered metric; registrations stay valid
+    void reset();
+
+} // namespace Metrics
+
+#endif // METRICS_H
@@ -0,0 +1,86 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// acquire() result when every slot is taken
+#define POOL_NONE 0xFFFFFFFFu
+
+namespace Common
+{
+    /**
+     * @class Pool
+     * @brief Fixed number of T slots handed out and returned by index, from any thread.
+     *
+     * For objects that are filled in place and passed on by reference,
+     * e.g. a record formatted by a producer and written out by a consumer
+     * thread, where copying it through a ring would cost more than the
+     * 32-bit index. Free slots form a lock-free stack; its head carries a
+     * tag that changes on every update, so a slot taken and returned
+     * between another thread's load and CAS cannot corrupt the list.
+     * Slots are default-constructed once and reused as they are.
+     */
+    template <typename T, size_t Capacity>
+    class Pool
+    {
+        static_assert(Capacity >= 1 && Capacity < POOL_NONE, "Capacity must fit a 32-bit index");
+
+    public:
+        Pool() : head(0)
+        {
+            for (size_t i = 0; i < Capacity; ++i)
+            {
+                next[i].store((i + 1 < Capacity) ? (uint32_t)(i + 1) : POOL_NONE, std::memory_order_relaxed);
+            }
+        }
+        Pool(const Pool &) = delete;
+        Pool &operator=(const Pool &) = delete;
+
+        // Index of a slot now owned by the caller, or POOL_NONE when all are taken
+        uint32_t acquire()
+        {
+            uint64_t current = head.load(std::memory_order_acquire);
+            for (;;)
+            {
+                uint32_t index = (uint32_t)current;
+                if (index == POOL_NONE)
+                {
+                    return POOL_NONE;
+                }
+                uint64_t updated = nextTag(current) | next[index].load(std::memory_order_relaxed);
+                if (head.compare_exchange_weak(current, updated, std::memory_order_acquire,
+                                               std::memory_order_acquire))
+                {
+                    return index;
+                }
+            }
+        }
+
+        // Give back a slot returned by acquire(); its contents are kept for the next owner to overwrite
+        void release(uint32_t index)
+        {
+            uint64_t current = head.load(std::memory_order_relaxed);
+            do
+            {
+                next[index].store((uint32_t)current, std::memory_order_relaxed);
+            } while (!head.compare_exchange_weak(current, nextTag(current) | index, std::memory_order_release,
+                                                 std::memory_order_relaxed));
+        }
+
+        T &operator[](uint32_t index) { return slots[index]; }
+        const T &operator[](uint32_t index) const { return slots[index]; }
+        static constexpr size_t capacity() { return Capacity; }
+
+    private:
+        static uint64_t nextTag(uint64_t current) { return ((current >> 32) + 1) << 32; }
+
+        std::atomic<uint64_t> head; ///< update tag in the high half, first free index in the low half
+        std::atomic<uint32_t> next[Capacity];
+        T slots[Capacity];
+    };
+
+} // namespace Common
+
+#endif // POOL_H
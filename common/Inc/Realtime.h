@@ -0,0 +1,73 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <cstddef>
+#include <sched.h>
+
+#define REALTIME_PRIORITY 50
+// Stack touched up front so the timing-critical path takes no stack faults
+#define REALTIME_STACK_PREFAULT (64 * 1024)
+#define REALTIME_ISOLATED_CPUS "/sys/devices/system/cpu/isolated"
+
+// RealtimeConfig::cpu values besides a CPU number
+#define REALTIME_CPU_NONE -1     // do not pin
+#define REALTIME_CPU_ISOLATED -2 // first CPU in isolcpus=, not pinned if none
+
+namespace Common
+{
+    // What a thread asks for when it enters real-time mode
+    struct RealtimeConfig
+    {
+        int priority = REALTIME_PRIORITY; // SCHED_FIFO priority, 0 to keep the current policy
+        int cpu = REALTIME_CPU_ISOLATED;  // CPU number or REALTIME_CPU_*
+        bool lockMemory = true;           // mlockall(MCL_CURRENT | MCL_FUTURE)
+        size_t stackPrefault = REALTIME_STACK_PREFAULT; // touched once per thread
+    };
+
+    // What the thread actually got; each step degrades independently
+    struct RealtimeStatus
+    {
+        int policy = SCHED_OTHER;
+        int priority = 0;
+        int cpu = REALTIME_CPU_NONE; // CPU the thread is pinned to
+        bool memoryLocked = false;
+        bool stackPrefaulted = false;
+    };
+
+    // Switch the calling thread to real-time mode as far as privileges allow
+    RealtimeStatus enterRealtime(const RealtimeConfig &config);
+    // Policy and pinning of the calling thread right now
+    RealtimeStatus currentRealtime();
+    // Touch every page of a buffer so the first real access does not fault
+    void prefault(const void *buffer, size_t size);
+    // First CPU listed in REALTIME_ISOLATED_CPUS, or REALTIME_CPU_NONE; read once per process
+    int firstIsolatedCpu();
+    const char *policyName(int policy);
+
+    /**
+     * @class RealtimeScope
+     * @brief Runs a block in real-time mode and restores the thread's policy and affinity on exit.
+     *
+     * Memory stays locked: mlockall() is process-wide and cheap to keep.
+     */
+    class RealtimeScope
+    {
+    public:
+        explicit RealtimeScope(const RealtimeConfig &config);
+        ~RealtimeScope();
+        RealtimeScope(const RealtimeScope &) = delete;
+        RealtimeScope &operator=(const RealtimeScope &) = delete;
+
+        const RealtimeStatus &getStatus() const { return status; }
+
+    private:
+        RealtimeStatus status;
+        int savedPolicy;
+        struct sched_param savedParam;
+        cpu_set_t savedAffinity;
+        bool affinitySaved;
+    };
+
+} // namespace Common
+
+#endif // REALTIME_H
@@ -0,0 +1,166 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+
+#define CACHE_LINE_SIZE 64
+
+namespace Common
+{
+    /**
+     * @class SpscRing
+     * @brief Fixed-capacity single-producer/single-consumer queue.
+     *
+     * No locks and no allocation after construction. Head and tail live on
+     * separate cache lines, and each side caches the other side's index so
+     * the shared line is only read when the ring looks full or empty.
+     * Capacity must be a power of two; all slots are usable.
+     */
+    template <typename T, size_t Capacity>
+    class SpscRing
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        SpscRing() : head(0), cachedTail(0), tail(0), cachedHead(0) {}
+
+        // Producer side; false when full
+        bool tryPush(const T &item)
+        {
+            size_t currentHead = head.load(std::memory_order_relaxed);
+            if (currentHead - cachedTail == Capacity)
+            {
+                cachedTail = tail.load(std::memory_order_acquire);
+                if (currentHead - cachedTail == Capacity)
+                {
+                    return false;
+                }
+            }
+            slots[currentHead & (Capacity - 1)] = item;
+            head.store(currentHead + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side; false when empty
+        bool tryPop(T &item)
+        {
+            size_t currentTail = tail.load(std::memory_order_relaxed);
+            if (currentTail == cachedHead)
+            {
+                cachedHead = head.load(std::memory_order_acquire);
+                if (currentTail == cachedHead)
+                {
+                    return false;
+                }
+            }
+            item = slots[currentTail & (Capacity - 1)];
+            tail.store(currentTail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Approximate when called concurrently
+        size_t size() const
+        {
+            return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+        }
+        static constexpr size_t capacity() { return Capacity; }
+
+    private:
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> head; ///< written by the producer
+        size_t cachedTail;                                 ///< producer's copy of tail
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail; ///< written by the consumer
+        size_t cachedHead;                                 ///< consumer's copy of head
+        alignas(CACHE_LINE_SIZE) T slots[Capacity];
+    };
+
+    /**
+     * @class MpscRing
+     * @brief Fixed-capacity multi-producer/single-consumer queue (bounded Vyukov queue).
+     *
+     * Producers claim a slot with one CAS on the enqueue index; each slot has
+     * a sequence number telling whether it is free or filled, so the single
+     * consumer never needs a CAS. A full ring makes tryPush() fail instead of
+     * blocking the producer.
+     */
+    template <typename T, size_t Capacity>
+    class MpscRing
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        MpscRing() : enqueueIndex(0), dequeueIndex(0)
+        {
+            for (size_t i = 0; i < Capacity; ++i)
+            {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        // Any thread; false when full
+        bool tryPush(const T &item)
+        {
+            size_t position = enqueueIndex.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Cell &cell = cells[position & (Capacity - 1)];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                long difference = (long)sequence - (long)position;
+                if (difference == 0)
+                {
+                    if (enqueueIndex.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        cell.value = item;
+                        cell.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    return false; // full
+                }
+                else
+                {
+                    position = enqueueIndex.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Consumer thread only; false when empty
+        bool tryPop(T &item)
+        {
+            size_t position = dequeueIndex.load(std::memory_order_relaxed);
+            Cell &cell = cells[position & (Capacity - 1)];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if ((long)sequence - (long)(position + 1) < 0)
+            {
+                return false; // empty, or the producer of this slot has not finished
+            }
+            item = cell.value;
+            cell.sequence.store(position + Capacity, std::memory_order_release);
+            dequeueIndex.store(position + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Approximate when called concurrently
+        size_t size() const
+        {
+            return enqueueIndex.load(std::memory_order_acquire) - dequeueIndex.load(std::memory_order_acquire);
+        }
+        static constexpr size_t capacity() { return Capacity; }
+
+    private:
+        struct alignas(CACHE_LINE_SIZE) Cell
+        {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueueIndex; ///< shared by producers
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeueIndex; ///< consumer only
+        alignas(CACHE_LINE_SIZE) Cell cells[Capacity];
+    };
+
+} // namespace Common
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,40 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <chrono>
+
+// Overshoot calibration: this many relative sleeps of TIMING_CALIBRATION_NS
+#define TIMING_CALIBRATION_SAMPLES 100
+#define TIMING_CALIBRATION_NS 50000
+// Spin tail bounds, whatever the calibration measured
+#define TIMING_MIN_SPIN_NS 5000
+#define TIMING_MAX_SPIN_NS 200000
+
+namespace Common
+{
+    // Result of the startup overshoot measurement
+    struct TimingCalibration
+    {
+        long long sleepOvershootNs; // p90 lateness of clock_nanosleep()
+        long long spinNs;           // tail of every delay spent spinning instead of sleeping
+    };
+
+    // CLOCK_MONOTONIC in nanoseconds (vDSO, no syscall)
+    long long monotonicNowNs();
+
+    // Measure sleep overshoot once; later calls return the stored result
+    const TimingCalibration &calibrateTiming();
+
+    // Wait until a CLOCK_MONOTONIC deadline: sleep for the bulk, spin for the calibrated tail
+    void waitUntilNs(long long deadlineNs);
+
+    // Wait for at least the given duration with microsecond accuracy
+    template <typename Rep, typename Period>
+    void delay(std::chrono::duration<Rep, Period> duration)
+    {
+        waitUntilNs(monotonicNowNs() + std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+} // namespace Common
+
+#endif // TIMING_H
@@ -0,0 +1,69 @@
+#include "../Inc/AllocTracker.h"
+#include <cerrno>
+#include <cstddef>
+
+/*
+ * Counting replacements of the glibc allocation entry points.
+ *
+ * Linked only into the benchmarks and VARIANT=debug (see the Makefile);
+ * the main program keeps the plain allocator. Each entry point counts the
+ * allocation and forwards to glibc's own implementation, so free() needs
+ * no replacement. operator new reaches malloc() and is counted here too.
+ */
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *memory, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+
+    void *malloc(size_t size)
+    {
+        Common::noteAllocation(size);
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size)
+    {
+        Common::noteAllocation(count * size);
+        return __libc_calloc(count, size);
+    }
+
+    // Shrinking in place is counted as well: the caller cannot tell it will not move
+    void *realloc(void *memory, size_t size)
+    {
+        if (size > 0)
+        {
+            Common::noteAllocation(size);
+        }
+        return __libc_realloc(memory, size);
+    }
+
+    void *memalign(size_t alignment, size_t size)
+    {
+        Common::noteAllocation(size);
+        return __libc_memalign(alignment, size);
+    }
+
+    void *aligned_alloc(size_t alignment, size_t size)
+    {
+        Common::noteAllocation(size);
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void **memory, size_t alignment, size_t size)
+    {
+        if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0)
+        {
+            return EINVAL;
+        }
+        Common::noteAllocation(size);
+        void *result = __libc_memalign(alignment, size);
+        if (result == nullptr && size > 0)
+        {
+            return ENOMEM;
+        }
+        *memory = result;
+        return 0;
+    }
+}
@@ -0,0 +1,73 @@
+#include "../Inc/AllocTracker.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace Common
+{
+    namespace
+    {
+        std::atomic<unsigned long> processAllocations(0);
+        std::atomic<unsigned long> violations(0);
+        // Plain thread_locals: no constructor, so reading them from malloc() cannot allocate
+        thread_local unsigned long threadAllocations = 0;
+        thread_local const char *activeScope = nullptr;
+    } // namespace
+
+    /**
+     * @brief Counts one allocation and checks it against the thread's scope.
+     *
+     * Runs inside malloc(), so it must not allocate itself: the report is
+     * formatted on the stack and written with write(2).
+     *
+     * @param size Bytes requested.
+     */
+    void noteAllocation(size_t size)
+    {
+        threadAllocations++;
+        processAllocations.fetch_add(1, std::memory_order_relaxed);
+        if (activeScope == nullptr)
+        {
+            return;
+        }
+        violations.fetch_add(1, std::memory_order_relaxed);
+        if constexpr (ALLOC_CHECK)
+        {
+            char message[160];
+            int length = snprintf(message, sizeof(message), "Heap allocation of %zu bytes inside %s\n", size, activeScope);
+            if (length > 0 && write(STDERR_FILENO, message, (size_t)length) < 0)
+            {
+                // Aborting anyway
+            }
+            abort();
+        }
+    }
+
+    unsigned long allocationCount()
+    {
+        return processAllocations.load(std::memory_order_relaxed);
+    }
+
+    unsigned long threadAllocationCount()
+    {
+        return threadAllocations;
+    }
+
+    unsigned long allocationViolations()
+    {
+        return violations.load(std::memory_order_relaxed);
+    }
+
+    NoAllocScope::NoAllocScope(const char *name) : outer(activeScope), startCount(threadAllocations)
+    {
+        activeScope = name;
+    }
+
+    NoAllocScope::~NoAllocScope()
+    {
+        activeScope = outer;
+    }
+
+} // namespace Common
@@ -0,0 +1,81 @@
+#include "../Inc/Arena.h"
+#include "../Inc/Log.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace Common
+{
+    Arena::Arena() : block(nullptr), capacity(0), used(0), last(nullptr)
+    {
+    }
+
+    Arena::~Arena()
+    {
+        clear();
+        free(block);
+    }
+
+    /**
+     * @brief Allocates the block everything is created in.
+     *
+     * The block is zeroed, which also faults in its pages now rather than
+     * on the first access from the acquisition path.
+     *
+     * @param bytes Block size, e.g. a sum of footprint() values.
+     * @return false if the block cannot be allocated or the arena still holds objects.
+     */
+    bool Arena::reserve(size_t bytes)
+    {
+        if (used != 0)
+        {
+            LOG_ERROR("Arena: cannot resize while %zu bytes are in use.\n", used);
+            return false;
+        }
+        free(block);
+        block = nullptr;
+        capacity = 0;
+        void *storage = nullptr;
+        if (posix_memalign(&storage, ARENA_ALIGN, bytes > 0 ? bytes : ARENA_ALIGN) != 0)
+        {
+            LOG_ERROR("Arena: cannot allocate %zu bytes.\n", bytes);
+            return false;
+        }
+        memset(storage, 0, bytes);
+        block = (char *)storage;
+        capacity = bytes;
+        return true;
+    }
+
+    /**
+     * @brief Takes aligned storage from the block.
+     * @param size Bytes needed.
+     * @param alignment Power of two, at most ARENA_ALIGN.
+     * @return Storage, or nullptr when the block is exhausted.
+     */
+    void *Arena::allocate(size_t size, size_t alignment)
+    {
+        size_t offset = (used + alignment - 1) & ~(alignment - 1);
+        if (block == nullptr || alignment > ARENA_ALIGN || offset > capacity || size > capacity - offset)
+        {
+            LOG_ERROR("Arena: %zu bytes do not fit (%zu of %zu used).\n", size, used, capacity);
+            return nullptr;
+        }
+        used = offset + size;
+        return block + offset;
+    }
+
+    /**
+     * @brief Destroys the objects newest first, so each outlives the ones created after it.
+     */
+    void Arena::clear()
+    {
+        while (last != nullptr)
+        {
+            Finalizer *finalizer = last;
+            last = finalizer->previous;
+            finalizer->run(finalizer->object);
+        }
+        used = 0;
+    }
+} // namespace Common
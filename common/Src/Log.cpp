@@ -0,0 +1,206 @@
+#include "../Inc/Log.h"
+#include "../Inc/RingBuffer.h"
+#include "../Inc/Pool.h"
+#include <cstdio>
+#include <cstdarg>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// Poll interval of flush(), and of the sink thread if no eventfd could be created
+#define LOG_IDLE_US 1000
+
+namespace Log
+{
+    namespace
+    {
+        struct Record
+        {
+            Level level;
+            char text[LOG_RECORD_SIZE];
+        };
+
+        /**
+         * @brief Background writer for warnings and errors.
+         *
+         * Producers take a Record from a fixed pool, format straight into it
+         * and push its index into an MPSC ring; the sink thread writes it to
+         * stderr and returns it to the pool, so a message is never copied.
+         * An empty pool drops the message instead of blocking the producer.
+         * With nothing queued the sink thread blocks in read() on an
+         * eventfd; only the producer that makes the queue non-empty writes
+         * it, so a burst of warnings costs one wake-up.
+         */
+        class AsyncSink
+        {
+        public:
+            AsyncSink()
+                : queued(0), written(0), lost(0), running(true), wakeFd(eventfd(0, EFD_CLOEXEC)),
+                  worker(&AsyncSink::run, this)
+            {
+            }
+
+            ~AsyncSink()
+            {
+                running = false;
+                wake();
+                worker.join();
+                if (wakeFd != -1)
+                {
+                    close(wakeFd);
+                }
+            }
+
+            void push(Level level, const char *format, va_list args)
+            {
+                uint32_t index = records.acquire();
+                if (index == POOL_NONE)
+                {
+                    lost.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                Record &record = records[index];
+                record.level = level;
+                vsnprintf(record.text, sizeof(record.text), format, args);
+                // Cannot fail: the ring has room for every record of the pool
+                queue.tryPush(index);
+                // Everything before this record was written: the sink may be asleep
+                if (queued.fetch_add(1) == written.load())
+                {
+                    wake();
+                }
+            }
+
+            void flush()
+            {
+                unsigned long target = queued.load(std::memory_order_acquire);
+                while (written.load(std::memory_order_acquire) < target)
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(LOG_IDLE_US / 10));
+                }
+            }
+
+            unsigned long dropped() const { return lost.load(); }
+
+        private:
+            void wake()
+            {
+                uint64_t one = 1;
+                if (wakeFd != -1 && write(wakeFd, &one, sizeof(one)) < 0)
+                {
+                    // The counter only saturates if the sink stopped reading; it is awake anyway
+                }
+            }
+
+            void run()
+            {
+                uint32_t index;
+                for (;;)
+                {
+                    bool stopping = !running.load();
+                    while (queue.tryPop(index))
+                    {
+                        const Record &record = records[index];
+                        fprintf(stderr, "%s%s", record.level == Level::Error ? "ERROR: " : "WARN: ", record.text);
+                        records.release(index);
+                        written.fetch_add(1);
+                    }
+                    if (stopping)
+                    {
+                        break;
+                    }
+                    if (written.load() != queued.load())
+                    {
+                        // A producer holding an earlier ring slot has not published it yet
+                        std::this_thread::yield();
+                    }
+                    else if (wakeFd == -1)
+                    {
+                        std::this_thread::sleep_for(std::chrono::microseconds(LOG_IDLE_US));
+                    }
+                    else
+                    {
+                        // Seq-cst counters: either this load saw the new record or its producer sees
+                        // written == queued and writes the eventfd, so no wake-up is lost
+                        uint64_t wakeups;
+                        if (read(wakeFd, &wakeups, sizeof(wakeups)) < 0)
+                        {
+                            // EINTR: re-check the queue
+                        }
+                    }
+                }
+                fflush(stderr);
+            }
+
+            Common::Pool<Record, LOG_QUEUE> records;
+            Common::MpscRing<uint32_t, LOG_QUEUE> queue; ///< indices into records, oldest first
+            std::atomic<unsigned long> queued;
+            std::atomic<unsigned long> written;
+            std::atomic<unsigned long> lost;
+            std::atomic<bool> running;
+            int wakeFd;         ///< eventfd the sink thread blocks on while the queue is empty
+            std::thread worker; ///< started last, once the queue exists
+        };
+
+        AsyncSink &sink()
+        {
+            static AsyncSink instance;
+            return instance;
+        }
+    } // namespace
+
+    /**
+     * @brief Writes one message; called only for levels compiled in.
+     *
+     * Trace, debug and info are printed synchronously to stdout. Warnings and
+     * errors are queued to the async sink and written to stderr.
+     *
+     * @param level Message level.
+     * @param format printf-style format.
+     */
+    void emit(Level level, const char *format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        if (static_cast<int>(level) >= static_cast<int>(Level::Warn))
+        {
+            sink().push(level, format, args);
+        }
+        else
+        {
+            vprintf(format, args);
+        }
+        va_end(args);
+    }
+
+    /**
+     * @brief Creates the async sink and its thread if they do not exist yet.
+     *
+     * Creating a thread allocates; sensors and loops call this during setup
+     * so the first warning of a read only formats and enqueues. Threads
+     * started later inherit the caller's signal mask, as usual.
+     */
+    void start()
+    {
+        sink();
+    }
+
+    /**
+     * @brief Waits until every warning/error queued so far is on stderr.
+     */
+    void flush()
+    {
+        fflush(stdout);
+        sink().flush();
+    }
+
+    /**
+     * @brief Number of warnings/errors dropped because the queue was full.
+     */
+    unsigned long dropped()
+    {
+        return sink().dropped();
+    }
+} // namespace Log
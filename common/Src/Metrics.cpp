@@ -0,0 +1,466 @@
+#include "../Inc/Metrics.h"
+#include "../Inc/Log.h"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+// Prometheus buckets: le = 2^k ns, from ~1us to ~17s
+#define METRICS_EXPORT_FIRST_EXPONENT 10
+#define METRICS_EXPORT_LAST_EXPONENT 34
+
+namespace Metrics
+{
+    namespace
+    {
+        struct Description
+        {
+            char name[METRICS_NAME_SIZE];
+            char labels[METRICS_LABELS_SIZE];
+            char help[METRICS_HELP_SIZE];
+        };
+
+        std::atomic<unsigned long> failures(0);
+
+        /**
+         * @brief Table of registered metrics, grown in METRICS_BLOCK blocks up to Capacity.
+         *
+         * Registration appends under a mutex and publishes the new size with
+         * a release store; readers load the size and never see a partially
+         * written description or a block that is not there yet. Blocks are
+         * never moved or freed, so references handed out stay valid for the
+         * life of the process, and an idle registry costs only its block table.
+         * Lookups go through an open-addressing index of name and labels, so
+         * registering thousands of sensors stays linear.
+         */
+        template <typename Metric, int Capacity>
+        class Registry
+        {
+        public:
+            Registry()
+            {
+                for (int &entry : index)
+                {
+                    entry = -1;
+                }
+            }
+
+            Metric &find(const char *name, const char *labels, const char *help, const char *kind)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                int registered = size.load(std::memory_order_relaxed);
+                size_t slot = hash(name, labels) % INDEX_SIZE;
+                for (; index[slot] >= 0; slot = (slot + 1) % INDEX_SIZE)
+                {
+                    const Description &existing = description(index[slot]);
+                    if (strcmp(existing.name, name) == 0 && strcmp(existing.labels, labels) == 0)
+                    {
+                        return metric(index[slot]);
+                    }
+                }
+                if (registered == Capacity)
+                {
+                    failures.fetch_add(1, std::memory_order_relaxed);
+                    LOG_ERROR("Metrics: %d %ss registered, no room for %s{%s}; it is not exported.\n", Capacity, kind,
+                              name, labels);
+                    return overflow;
+                }
+                if (registered % METRICS_BLOCK == 0)
+                {
+                    blocks[registered / METRICS_BLOCK].reset(new Block());
+                }
+                Description &entry = blocks[registered / METRICS_BLOCK]->descriptions[registered % METRICS_BLOCK];
+                snprintf(entry.name, sizeof(entry.name), "%s", name);
+                snprintf(entry.labels, sizeof(entry.labels), "%s", labels);
+                snprintf(entry.help, sizeof(entry.help), "%s", help);
+                index[slot] = registered;
+                size.store(registered + 1, std::memory_order_release);
+                return metric(registered);
+            }
+
+            int getSize() const { return size.load(std::memory_order_acquire); }
+            const Description &description(int index) const
+            {
+                return blocks[index / METRICS_BLOCK]->descriptions[index % METRICS_BLOCK];
+            }
+            Metric &metric(int index) { return blocks[index / METRICS_BLOCK]->metrics[index % METRICS_BLOCK]; }
+
+        private:
+            // At most half full, so probe chains stay short
+            static constexpr size_t INDEX_SIZE = 2 * Capacity;
+
+            struct Block
+            {
+                Description descriptions[METRICS_BLOCK];
+                Metric metrics[METRICS_BLOCK];
+            };
+
+            std::mutex mutex;
+            std::atomic<int> size{0};
+            std::unique_ptr<Block> blocks[(Capacity + METRICS_BLOCK - 1) / METRICS_BLOCK];
+            int index[INDEX_SIZE];
+            Metric overflow;
+
+            /**
+             * @brief FNV-1a over the name, a separator and the labels (truncated like the stored copies).
+             */
+            static size_t hash(const char *name, const char *labels)
+            {
+                uint64_t value = 14695981039346656037ULL;
+                for (size_t i = 0; name[i] != '\0' && i < METRICS_NAME_SIZE - 1; ++i)
+                {
+                    value = (value ^ (unsigned char)name[i]) * 1099511628211ULL;
+                }
+                value = (value ^ 0xff) * 1099511628211ULL;
+                for (size_t i = 0; labels[i] != '\0' && i < METRICS_LABELS_SIZE - 1; ++i)
+                {
+                    value = (value ^ (unsigned char)labels[i]) * 1099511628211ULL;
+                }
+                return (size_t)value;
+            }
+        };
+
+        typedef Registry<Counter, METRICS_MAX_COUNTERS> CounterRegistry;
+        typedef Registry<Histogram, METRICS_MAX_HISTOGRAMS> HistogramRegistry;
+
+        // Function-local so metrics can be registered from other static constructors
+        CounterRegistry &counterRegistry()
+        {
+            static CounterRegistry registry;
+            return registry;
+        }
+
+        HistogramRegistry &histogramRegistry()
+        {
+            static HistogramRegistry registry;
+            return registry;
+        }
+
+        /**
+         * @brief Writes `name{labels,extra}` (braces omitted when both are empty).
+         */
+        void writeSeries(FILE *out, const char *name, const char *suffix, const char *labels, const char *extra)
+        {
+            fprintf(out, "%s%s", name, suffix);
+            if (labels[0] != '\0' || extra[0] != '\0')
+            {
+                fprintf(out, "{%s%s%s}", labels, (labels[0] != '\0' && extra[0] != '\0') ? "," : "", extra);
+            }
+        }
+
+        void writeCounter(FILE *out, const Description &description, Counter &counter)
+        {
+            writeSeries(out, description.name, "", description.labels, "");
+            fprintf(out, " %llu\n", (unsigned long long)counter.get());
+        }
+
+        /**
+         * @brief Writes cumulative buckets, sum and count of one histogram series, in seconds.
+         */
+        void writeHistogram(FILE *out, const Description &description, Histogram &histogram)
+        {
+            uint64_t cumulative = 0;
+            int bucket = 0;
+            char le[48];
+            for (int exponent = METRICS_EXPORT_FIRST_EXPONENT; exponent <= METRICS_EXPORT_LAST_EXPONENT; ++exponent)
+            {
+                int end = Histogram::bucketIndex(1ULL << exponent);
+                for (; bucket < end; ++bucket)
+                {
+                    cumulative += histogram.getBucket(bucket);
+                }
+                snprintf(le, sizeof(le), "le=\"%.9g\"", (double)(1ULL << exponent) / 1e9);
+                writeSeries(out, description.name, "_bucket", description.labels, le);
+                fprintf(out, " %llu\n", (unsigned long long)cumulative);
+            }
+            for (; bucket < Histogram::BUCKETS; ++bucket)
+            {
+                cumulative += histogram.getBucket(bucket);
+            }
+            writeSeries(out, description.name, "_bucket", description.labels, "le=\"+Inf\"");
+            fprintf(out, " %llu\n", (unsigned long long)cumulative);
+            writeSeries(out, description.name, "_sum", description.labels, "");
+            fprintf(out, " %.9f\n", histogram.getSumNs() / 1e9);
+            writeSeries(out, description.name, "_count", description.labels, "");
+            fprintf(out, " %llu\n", (unsigned long long)cumulative);
+        }
+
+        /**
+         * @brief Writes every metric of a table grouped by name, HELP/TYPE once per group.
+         *
+         * The exposition format requires the series of one metric to be
+         * contiguous, while registration order interleaves them (one sensor
+         * registers all its metrics, then the next one).
+         */
+        template <typename Table, typename Writer>
+        void writeFamilies(FILE *out, Table &table, const char *type, Writer writer)
+        {
+            int size = table.getSize();
+            for (int i = 0; i < size; ++i)
+            {
+                const char *name = table.description(i).name;
+                bool seen = false;
+                for (int j = 0; j < i && !seen; ++j)
+                {
+                    seen = (strcmp(table.description(j).name, name) == 0);
+                }
+                if (seen)
+                {
+                    continue;
+                }
+                fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", name, table.description(i).help, name, type);
+                for (int j = i; j < size; ++j)
+                {
+                    if (strcmp(table.description(j).name, name) == 0)
+                    {
+                        writer(out, table.description(j), table.metric(j));
+                    }
+                }
+            }
+        }
+    } // namespace
+
+    /**
+     * @brief Bucket of a value: exact below 2^METRICS_SUB_BUCKET_BITS, then 16 linear steps per power of two.
+     * @param ns Value in nanoseconds; clamped to the largest bucket.
+     * @return Index in [0, BUCKETS).
+     */
+    int Histogram::bucketIndex(uint64_t ns)
+    {
+        const uint64_t limit = (1ULL << METRICS_MAX_EXPONENT) - 1;
+        if (ns > limit)
+        {
+            ns = limit;
+        }
+        if (ns < (uint64_t)SUB_BUCKETS)
+        {
+            return (int)ns;
+        }
+        int exponent = 63 - __builtin_clzll(ns);
+        int shift = exponent - METRICS_SUB_BUCKET_BITS;
+        return shift * SUB_BUCKETS + (int)(ns >> shift);
+    }
+
+    /**
+     * @brief Largest value mapped to a bucket.
+     */
+    uint64_t Histogram::bucketUpperNs(int index)
+    {
+        if (index < 2 * SUB_BUCKETS)
+        {
+            return (uint64_t)index;
+        }
+        int shift = index / SUB_BUCKETS - 1;
+        uint64_t top = (uint64_t)(index - shift * SUB_BUCKETS);
+        return ((top + 1) << shift) - 1;
+    }
+
+    /**
+     * @brief Records one duration; lock-free and wait-free apart from a rare max update.
+     * @param ns Duration in nanoseconds.
+     */
+    void Histogram::record(uint64_t ns)
+    {
+        buckets[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        sumNs.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t seen = maxNs.load(std::memory_order_relaxed);
+        while (ns > seen && !maxNs.compare_exchange_weak(seen, ns, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    /**
+     * @brief Clears all buckets; concurrent records may survive partially.
+     */
+    void Histogram::reset()
+    {
+        for (std::atomic<uint64_t> &bucket : buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count.store(0, std::memory_order_relaxed);
+        sumNs.store(0, std::memory_order_relaxed);
+        maxNs.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Upper bound of the bucket that holds the p-th percentile.
+     * @param p Percentile, 0..100.
+     * @return Nanoseconds, never above the recorded maximum; 0 for an empty histogram.
+     */
+    uint64_t HistogramValue::percentileNs(double p) const
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+        uint64_t rank = (uint64_t)(p / 100.0 * (count - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets.size(); ++i)
+        {
+            seen += buckets[i];
+            if (seen >= rank)
+            {
+                uint64_t upper = Histogram::bucketUpperNs((int)i);
+                return (upper < maxNs) ? upper : maxNs;
+            }
+        }
+        return maxNs;
+    }
+
+    const CounterValue *Snapshot::findCounter(const char *name, const char *labels) const
+    {
+        for (const CounterValue &value : counters)
+        {
+            if (value.name == name && value.labels == labels)
+            {
+                return &value;
+            }
+        }
+        return nullptr;
+    }
+
+    const HistogramValue *Snapshot::findHistogram(const char *name, const char *labels) const
+    {
+        for (const HistogramValue &value : histograms)
+        {
+            if (value.name == name && value.labels == labels)
+            {
+                return &value;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Returns the counter registered under name and labels, registering it on first use.
+     * @param name Prometheus metric name, e.g. dht22_reads_total.
+     * @param labels Label pairs without braces, e.g. pin="4"; "" for none.
+     * @param help One-line description for the exposition format.
+     */
+    Counter &counter(const char *name, const char *labels, const char *help)
+    {
+        return counterRegistry().find(name, labels, help, "counter");
+    }
+
+    /**
+     * @brief Returns the histogram registered under name and labels, registering it on first use.
+     * @param name Prometheus metric name; durations are exported in seconds, so end it in _seconds.
+     * @param labels Label pairs without braces; "" for none.
+     * @param help One-line description for the exposition format.
+     */
+    Histogram &histogram(const char *name, const char *labels, const char *help)
+    {
+        return histogramRegistry().find(name, labels, help, "histogram");
+    }
+
+    /**
+     * @brief Number of registrations refused since start because a registry was full.
+     */
+    unsigned long registrationFailures()
+    {
+        return failures.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Copies every registered metric.
+     *
+     * Values are read with relaxed loads while recording goes on, so a
+     * histogram's count is taken as the sum of its copied buckets to keep
+     * the copy self-consistent.
+     */
+    Snapshot snapshot()
+    {
+        CounterRegistry &counters = counterRegistry();
+        HistogramRegistry &histograms = histogramRegistry();
+        Snapshot result;
+        int counterCount = counters.getSize();
+        result.counters.reserve(counterCount);
+        for (int i = 0; i < counterCount; ++i)
+        {
+            const Description &description = counters.description(i);
+            result.counters.push_back(CounterValue{description.name, description.labels, counters.metric(i).get()});
+        }
+
+        int histogramCount = histograms.getSize();
+        result.histograms.reserve(histogramCount);
+        for (int i = 0; i < histogramCount; ++i)
+        {
+            const Description &description = histograms.description(i);
+            Histogram &histogram = histograms.metric(i);
+            HistogramValue value;
+            value.name = description.name;
+            value.labels = description.labels;
+            value.buckets.resize(Histogram::BUCKETS);
+            value.count = 0;
+            for (int b = 0; b < Histogram::BUCKETS; ++b)
+            {
+                value.buckets[b] = histogram.getBucket(b);
+                value.count += value.buckets[b];
+            }
+            value.sumNs = histogram.getSumNs();
+            value.maxNs = histogram.getMaxNs();
+            result.histograms.push_back(value);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Dumps all metrics in the Prometheus text exposition format.
+     *
+     * Histograms are exported in seconds with cumulative buckets at powers
+     * of two nanoseconds, which coincide with internal bucket boundaries, so
+     * the exported counts are exact. The file is written next to path and
+     * renamed over it, so a scraper never reads a partial dump.
+     *
+     * @param path Destination, e.g. /var/lib/node_exporter/textfile/enviromonitor.prom.
+     * @return true on success, false if the file could not be written.
+     */
+    bool writePrometheus(const char *path)
+    {
+        CounterRegistry &counters = counterRegistry();
+        HistogramRegistry &histograms = histogramRegistry();
+        char temporary[512];
+        snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+        FILE *out = fopen(temporary, "w");
+        if (out == nullptr)
+        {
+            LOG_ERROR("Metrics: cannot write %s\n", temporary);
+            return false;
+        }
+
+        writeFamilies(out, counters, "counter", writeCounter);
+        writeFamilies(out, histograms, "histogram", writeHistogram);
+        fprintf(out, "# HELP metrics_registration_failures_total Metrics not exported because a registry was full\n"
+                     "# TYPE metrics_registration_failures_total counter\nmetrics_registration_failures_total %lu\n",
+                registrationFailures());
+
+        bool written = (fflush(out) == 0);
+        written = (fclose(out) == 0) && written;
+        if (!written || rename(temporary, path) != 0)
+        {
+            LOG_ERROR("Metrics: failed to write %s\n", path);
+            remove(temporary);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Zeroes every registered counter and histogram.
+     */
+    void reset()
+    {
+        CounterRegistry &counters = counterRegistry();
+        HistogramRegistry &histograms = histogramRegistry();
+        for (int i = 0; i < counters.getSize(); ++i)
+        {
+            counters.metric(i).reset();
+        }
+        for (int i = 0; i < histograms.getSize(); ++i)
+        {
+            histograms.metric(i).reset();
+        }
+    }
+} // namespace Metrics
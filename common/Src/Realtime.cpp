@@ -0,0 +1,234 @@
+#include "../Inc/Realtime.h"
+#include "../Inc/Log.h"
+#include <pthread.h>
+#include <sys/mman.h>
+#include <alloca.h>
+#include <cerrno>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+
+namespace Common
+{
+    namespace
+    {
+        // Each kind of failure is reported once per process, not once per read
+        std::atomic<bool> pinWarned(false);
+        std::atomic<bool> fifoWarned(false);
+        std::atomic<bool> lockWarned(false);
+        std::atomic<bool> memoryLocked(false);
+
+        // Deepest stack region this thread has already touched; the pages stay mapped
+        thread_local size_t stackPrefaulted = 0;
+
+        /**
+         * @brief Writes one byte per page of a stack region below the caller so later calls do not fault.
+         *
+         * Done once per thread and depth: a later read only pays for the
+         * extra depth it asks for, not for another 64 KB walk.
+         */
+        __attribute__((noinline)) void prefaultStack(size_t size)
+        {
+            if (size <= stackPrefaulted)
+            {
+                return;
+            }
+            static const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+            volatile unsigned char *stack = static_cast<volatile unsigned char *>(alloca(size));
+            for (size_t offset = 0; offset < size; offset += page)
+            {
+                stack[offset] = 0;
+            }
+            stack[size - 1] = 0;
+            stackPrefaulted = size;
+        }
+
+        /**
+         * @brief Parses REALTIME_ISOLATED_CPUS; see firstIsolatedCpu().
+         */
+        int readIsolatedCpu()
+        {
+            FILE *file = fopen(REALTIME_ISOLATED_CPUS, "r");
+            if (file == nullptr)
+            {
+                return REALTIME_CPU_NONE;
+            }
+            int cpu = REALTIME_CPU_NONE;
+            if (fscanf(file, "%d", &cpu) != 1)
+            {
+                cpu = REALTIME_CPU_NONE;
+            }
+            fclose(file);
+            return cpu;
+        }
+    } // namespace
+
+    /**
+     * @brief Moves the calling thread to SCHED_FIFO, pins it and locks memory.
+     *
+     * Every step is attempted independently. Without CAP_SYS_NICE the thread
+     * keeps SCHED_OTHER, without CAP_IPC_LOCK (or with a low RLIMIT_MEMLOCK)
+     * memory stays pageable; each failure is logged once as a warning and
+     * the returned status says what was actually achieved.
+     *
+     * @param config Requested priority, CPU, memory locking and stack prefault size.
+     * @return Achieved policy, priority, CPU and memory state.
+     */
+    RealtimeStatus enterRealtime(const RealtimeConfig &config)
+    {
+        int cpu = (config.cpu == REALTIME_CPU_ISOLATED) ? firstIsolatedCpu() : config.cpu;
+        if (cpu >= 0)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            if (error != 0 && !pinWarned.exchange(true))
+            {
+                LOG_WARN("Could not pin thread to CPU %d: %s\n", cpu, strerror(error));
+            }
+        }
+
+        if (config.priority > 0)
+        {
+            struct sched_param param;
+            param.sched_priority = config.priority;
+            int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+            if (error != 0 && !fifoWarned.exchange(true))
+            {
+                LOG_WARN("Thread stays SCHED_OTHER: %s\n", strerror(error));
+            }
+        }
+
+        if (config.lockMemory && !memoryLocked.load())
+        {
+            if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
+            {
+                memoryLocked = true;
+            }
+            else if (!lockWarned.exchange(true))
+            {
+                LOG_WARN("Memory not locked: %s\n", strerror(errno));
+            }
+        }
+
+        RealtimeStatus status = currentRealtime();
+        if (config.stackPrefault > 0)
+        {
+            prefaultStack(config.stackPrefault);
+            status.stackPrefaulted = true;
+        }
+        return status;
+    }
+
+    /**
+     * @brief Reports the scheduling state of the calling thread.
+     * @return Policy, priority, pinned CPU (if pinned to exactly one) and memory lock state.
+     */
+    RealtimeStatus currentRealtime()
+    {
+        RealtimeStatus status;
+        struct sched_param param;
+        if (pthread_getschedparam(pthread_self(), &status.policy, &param) == 0)
+        {
+            status.priority = param.sched_priority;
+        }
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0 && CPU_COUNT(&set) == 1)
+        {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (CPU_ISSET(cpu, &set))
+                {
+                    status.cpu = cpu;
+                    break;
+                }
+            }
+        }
+        status.memoryLocked = memoryLocked.load();
+        return status;
+    }
+
+    /**
+     * @brief Reads one byte per page so the pages are mapped before the hot path needs them.
+     * @param buffer Start of the buffer.
+     * @param size Size in bytes.
+     */
+    void prefault(const void *buffer, size_t size)
+    {
+        static const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        const volatile unsigned char *bytes = static_cast<const volatile unsigned char *>(buffer);
+        for (size_t offset = 0; offset < size; offset += page)
+        {
+            (void)bytes[offset];
+        }
+        if (size > 0)
+        {
+            (void)bytes[size - 1];
+        }
+    }
+
+    /**
+     * @brief Returns the first CPU isolated from the scheduler with isolcpus=.
+     *
+     * The file holds a cpulist such as "2-3,6" or an empty line. It only
+     * changes with the kernel command line, so it is read once per process
+     * and later real-time entries cost no file I/O.
+     *
+     * @return CPU number, or REALTIME_CPU_NONE if no CPU is isolated.
+     */
+    int firstIsolatedCpu()
+    {
+        static const int cpu = readIsolatedCpu();
+        return cpu;
+    }
+
+    /**
+     * @brief Returns a printable name for a scheduling policy.
+     */
+    const char *policyName(int policy)
+    {
+        switch (policy)
+        {
+        case SCHED_FIFO:
+            return "SCHED_FIFO";
+        case SCHED_RR:
+            return "SCHED_RR";
+        case SCHED_BATCH:
+            return "SCHED_BATCH";
+        case SCHED_IDLE:
+            return "SCHED_IDLE";
+        default:
+            return "SCHED_OTHER";
+        }
+    }
+
+    /**
+     * @brief Saves the thread's policy and affinity, then enters real-time mode.
+     * @param config Requested real-time settings.
+     */
+    RealtimeScope::RealtimeScope(const RealtimeConfig &config) : savedPolicy(SCHED_OTHER), affinitySaved(false)
+    {
+        memset(&savedParam, 0, sizeof(savedParam));
+        pthread_getschedparam(pthread_self(), &savedPolicy, &savedParam);
+        CPU_ZERO(&savedAffinity);
+        affinitySaved = pthread_getaffinity_np(pthread_self(), sizeof(savedAffinity), &savedAffinity) == 0;
+        status = enterRealtime(config);
+    }
+
+    /**
+     * @brief Restores the saved policy and affinity.
+     */
+    RealtimeScope::~RealtimeScope()
+    {
+        pthread_setschedparam(pthread_self(), savedPolicy, &savedParam);
+        if (affinitySaved)
+        {
+            pthread_setaffinity_np(pthread_self(), sizeof(savedAffinity), &savedAffinity);
+        }
+    }
+} // namespace Common
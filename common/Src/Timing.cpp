@@ -0,0 +1,97 @@
+#include "../Inc/Timing.h"
+#include "../Inc/Log.h"
+#include <time.h>
+#include <cerrno>
+#include <algorithm>
+
+namespace Common
+{
+    namespace
+    {
+        /**
+         * @brief Sleeps until an absolute CLOCK_MONOTONIC time, resuming after signals.
+         */
+        void sleepUntilNs(long long deadlineNs)
+        {
+            struct timespec ts;
+            ts.tv_sec = deadlineNs / 1000000000LL;
+            ts.tv_nsec = deadlineNs % 1000000000LL;
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+            {
+            }
+        }
+
+        /**
+         * @brief Measures how late clock_nanosleep() wakes up on this system.
+         *
+         * The p90 lateness becomes the spin tail, so nine out of ten delays
+         * wake before their deadline and finish on the spin; the rest are
+         * as late as a plain sleep would have been.
+         */
+        TimingCalibration measure()
+        {
+            long long overshoot[TIMING_CALIBRATION_SAMPLES];
+            for (int i = 0; i < TIMING_CALIBRATION_SAMPLES; ++i)
+            {
+                long long deadline = monotonicNowNs() + TIMING_CALIBRATION_NS;
+                sleepUntilNs(deadline);
+                overshoot[i] = monotonicNowNs() - deadline;
+            }
+            std::sort(overshoot, overshoot + TIMING_CALIBRATION_SAMPLES);
+
+            TimingCalibration calibration;
+            calibration.sleepOvershootNs = overshoot[TIMING_CALIBRATION_SAMPLES * 9 / 10];
+            calibration.spinNs = std::min(std::max(calibration.sleepOvershootNs, (long long)TIMING_MIN_SPIN_NS),
+                                          (long long)TIMING_MAX_SPIN_NS);
+            LOG_DEBUG("Sleep overshoot p90 %lld ns, spinning the last %lld ns of each delay\n",
+                      calibration.sleepOvershootNs, calibration.spinNs);
+            return calibration;
+        }
+    } // namespace
+
+    /**
+     * @brief Returns CLOCK_MONOTONIC in nanoseconds.
+     */
+    long long monotonicNowNs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    /**
+     * @brief Calibrates the spin tail on the first call.
+     *
+     * Takes roughly TIMING_CALIBRATION_SAMPLES x 100us; call it at startup
+     * so the first timed wait does not pay for it.
+     *
+     * @return Measured overshoot and the spin tail in use.
+     */
+    const TimingCalibration &calibrateTiming()
+    {
+        static const TimingCalibration calibration = measure();
+        return calibration;
+    }
+
+    /**
+     * @brief Waits until a deadline with microsecond accuracy.
+     *
+     * The bulk of the wait is an absolute clock_nanosleep(), which does not
+     * drift when the thread is interrupted. The last spinNs are a busy loop
+     * on CLOCK_MONOTONIC, read through the vDSO, so the wait ends within
+     * a clock read of the deadline instead of one scheduler wake-up late.
+     *
+     * @param deadlineNs CLOCK_MONOTONIC deadline in nanoseconds.
+     */
+    void waitUntilNs(long long deadlineNs)
+    {
+        long long spinFrom = deadlineNs - calibrateTiming().spinNs;
+        if (monotonicNowNs() < spinFrom)
+        {
+            sleepUntilNs(spinFrom);
+        }
+        while (monotonicNowNs() < deadlineNs)
+        {
+        }
+    }
+} // namespace Common
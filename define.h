@@ -8,8 +8,8 @@
 #include <cerrno>
 #include <cstdio>
 
-#define MAX_PATH 50
-#define MAX_DIRECTION_PATH 50
+#define MAX_PATH 128
+#define MAX_DIRECTION_PATH 128
 #define PIN_BUFF 4
 
 #define ERROR -1
@@ -1,20 +1,366 @@
 #include "sensors/Inc/DHT22.h"
 #include "sensors/Inc/SensorBase.h"
+#include "sensors/Inc/DHT22Model.h"
+#include "sensors/Inc/GL5516.h"
+#include "periferia/Inc/gpio_setup.h"
+#include "common/Inc/Log.h"
+#include "common/Inc/Metrics.h"
+#include "storage/Inc/TimeSeries.h"
+#include "service/Inc/Daemon.h"
+#include "service/Inc/SensorSet.h"
 #include <iostream>
+#include <cstdlib>
+#include <memory>
 
-int main() 
+static void usage(const char *program)
 {
-    Sensors::DHT22Sensor dht22(GPIO_DHT22);
+    printf("Usage: %s [--backend sysfs|cdev|mmap|sim] [--chip /dev/gpiochipN] [--line N] [--edges] [--rt]"
+           " [--metrics file.prom] [--store dir] [--light iio:deviceN/channel]\n"
+           "       [--daemon [--socket path] [--period ms] [--shm /name]] [--read-shm /name]\n"
+           "       [--config sensors.ini [--daemon [--socket path] [--shm /name]] [--metrics file.prom]]\n",
+           program);
+}
 
-    Sensors::SensorData data;
-    if (dht22.read(data)) 
+/**
+ * @brief Daemon mode: keeps the sensors open and reads them on timers until SIGTERM.
+ * @param daemon Daemon with its sensors added, not started.
+ * @return Process exit code.
+ */
+static int runDaemon(Service::Daemon &daemon, const char *metricsPath, const char *shmName)
+{
+    Acquisition::SharedPublisher publisher(shmName != nullptr ? shmName : SHM_READINGS_NAME);
+    if (shmName != nullptr)
+    {
+        if (!publisher.open())
+        {
+            printf("Failed to create shared memory %s\n", shmName);
+            return 1;
+        }
+        daemon.setPublisher(&publisher);
+    }
+    if (!daemon.start())
+    {
+        printf("Failed to start the daemon\n");
+        return 1;
+    }
+    daemon.run();
+    daemon.stop();
+    publisher.close();
+    if (metricsPath != nullptr && !Metrics::writePrometheus(metricsPath))
+    {
+        printf("Failed to write metrics to %s\n", metricsPath);
+    }
+    Log::flush();
+    return 0;
+}
+
+/**
+ * @brief SIGHUP in daemon mode: loads the configuration again into a fresh set and swaps it in.
+ *
+ * The daemon has closed every sensor by now. The new set is built in its
+ * own arena while the old one still exists, so a file that fails to load
+ * leaves the running sensors untouched. Once the daemon holds the new
+ * sensors, the old set (drivers, filters, arena) is destroyed.
+ *
+ * @return false if the current sensors were kept.
+ */
+static bool reloadSensors(Service::Daemon &daemon, const char *configPath, std::unique_ptr<Service::SensorSet> &current)
+{
+    std::unique_ptr<Service::SensorSet> next(new Service::SensorSet());
+    if (!next->load(configPath))
+    {
+        LOG_ERROR("Reload: %s not loaded\n", configPath);
+        return false;
+    }
+    daemon.clearSensors();
+    if (!next->addTo(daemon))
+    {
+        LOG_ERROR("Reload: too many sensors in %s\n", configPath);
+        daemon.clearSensors();
+        current->addTo(daemon);
+        return false;
+    }
+    current.swap(next);
+    LOG_INFO("Reload: %d sensors from %s\n", current->getCount(), configPath);
+    return true;
+}
+
+/**
+ * @brief Sensors from a configuration file: run them as a daemon, or read each once.
+ *
+ * In daemon mode SIGHUP reloads the file; see reloadSensors().
+ *
+ * @return Process exit code.
+ */
+static int runConfigured(const char *configPath, bool daemonMode, const Service::DaemonConfig &daemonConfig,
+                         const char *metricsPath, const char *shmName)
+{
+    std::unique_ptr<Service::SensorSet> loaded(new Service::SensorSet());
+    if (!loaded->load(configPath))
+    {
+        printf("Failed to load sensors from %s\n", configPath);
+        Log::flush();
+        return 1;
+    }
+    if (daemonMode)
+    {
+        Service::Daemon daemon(daemonConfig);
+        if (!loaded->addTo(daemon))
+        {
+            printf("Too many sensors in %s\n", configPath);
+            return 1;
+        }
+        daemon.setReloadHandler(
+            [configPath, &loaded](Service::Daemon &running) { return reloadSensors(running, configPath, loaded); });
+        return runDaemon(daemon, metricsPath, shmName);
+    }
+
+    int failures = 0;
+    for (int i = 0; i < loaded->getCount(); ++i)
+    {
+        const Service::ConfiguredSensor &entry = loaded->get(i);
+        const Sensors::SensorSchema &schema = entry.sensor->schema();
+        float values[SENSOR_MAX_CHANNELS];
+        if (!entry.sensor->open() || !entry.sensor->readChannels(values))
+        {
+            printf("Failed to read data from %s!\n", entry.config->name);
+            failures++;
+        }
+        else
+        {
+            for (size_t c = 0; c < schema.count; ++c)
+            {
+                printf("%s %s: %.2f %s\n", entry.config->name, schema.channels[c].name, values[c],
+                       schema.channels[c].unit);
+            }
+        }
+        entry.sensor->close();
+    }
+    if (metricsPath != nullptr && !Metrics::writePrometheus(metricsPath))
+    {
+        printf("Failed to write metrics to %s\n", metricsPath);
+    }
+    Log::flush();
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * @brief Prints the newest readings a daemon published to shared memory, without touching a sensor.
+ * @return Process exit code.
+ */
+static int readShared(const char *shmName)
+{
+    Acquisition::SharedReader reader(shmName);
+    if (!reader.open())
+    {
+        printf("No readings published in %s\n", shmName);
+        return 1;
+    }
+    unsigned long long now = Periferia::monotonicNs();
+    for (int i = 0; i < reader.getSensorCount(); ++i)
+    {
+        const Acquisition::SharedSensor &sensor = reader.getSensor(i);
+        Acquisition::SharedReading reading;
+        if (!reader.latest(i, reading))
+        {
+            printf("%s: no reading yet\n", sensor.name);
+            continue;
+        }
+        for (uint32_t c = 0; c < sensor.channelCount; ++c)
+        {
+            printf("%s %s: %.2f %s (%.1f s ago)\n", sensor.name, sensor.channels[c], reading.values[c], sensor.units[c],
+                   (now - reading.timestampNs) / 1e9);
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    Periferia::GPIOConfig gpioConfig = Sensors::DHT22Sensor::persistentGPIOConfig();
+    bool edgeCapture = false;
+    bool realtime = false;
+    const char *metricsPath = nullptr;
+    const char *storePath = nullptr;
+    bool readLight = false;
+    Sensors::GL5516Config lightConfig;
+    bool daemonMode = false;
+    Service::DaemonConfig daemonConfig;
+    unsigned int periodMs = 2000; // DHT22 minimum sampling interval
+    const char *shmName = nullptr;
+    const char *configPath = nullptr;
+    // Off-target runs: a simulated DHT22 on a simulated line
+    Sensors::DHT22Model model;
+    Periferia::SimBackend simulator(&model);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc && strcmp(argv[i + 1], "sim") == 0)
+        {
+            gpioConfig.customBackend = &simulator;
+            i++;
+        }
+        else if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc)
+        {
+            if (!Periferia::parseBackend(argv[++i], gpioConfig.backend))
+            {
+                printf("Unknown GPIO backend: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--chip") == 0 && i + 1 < argc)
+        {
+            gpioConfig.chipPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--line") == 0 && i + 1 < argc)
+        {
+            gpioConfig.chipLine = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--edges") == 0)
+        {
+            edgeCapture = true;
+        }
+        else if (strcmp(argv[i], "--rt") == 0)
+        {
+            realtime = true;
+        }
+        else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc)
+        {
+            metricsPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--store") == 0 && i + 1 < argc)
+        {
+            storePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--light") == 0 && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "iio:device%d/%d", &lightConfig.adc.device, &lightConfig.adc.channel) != 2)
+            {
+                printf("Expected iio:deviceN/channel, got %s\n", argv[i]);
+                return 1;
+            }
+            readLight = true;
+        }
+        else if (strcmp(argv[i], "--daemon") == 0)
+        {
+            daemonMode = true;
+        }
+        else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc)
+        {
+            daemonConfig.socketPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--period") == 0 && i + 1 < argc)
+        {
+            periodMs = (unsigned int)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc)
+        {
+            shmName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--config") == 0 && i + 1 < argc)
+        {
+            configPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--read-shm") == 0 && i + 1 < argc)
+        {
+            return readShared(argv[++i]);
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Before the log sink or any other thread exists, so they inherit the mask
+    if (daemonMode)
+    {
+        Service::Daemon::blockSignals();
+    }
+    if (configPath != nullptr)
+    {
+        return runConfigured(configPath, daemonMode, daemonConfig, metricsPath, shmName);
+    }
+
+    // Export and configure the sysfs pins in one pass; the GPIO objects take over their descriptors
+    if (gpioConfig.backend == Periferia::Backend::Sysfs && gpioConfig.customBackend == nullptr)
+    {
+        Periferia::GPIOPinSetup pins[] = {{GPIO_DHT22, OUTPUT}};
+        Periferia::GPIOSetupReport report;
+        Periferia::setupPins(pins, sizeof(pins) / sizeof(pins[0]), gpioConfig.sysfsRoot, &report);
+        LOG_DEBUG("GPIO setup: %d exported, %d already exported, %d failed in %.2f ms\n", report.exported,
+                  report.alreadyExported, report.failed, report.totalNs / 1e6);
+    }
+
+    Sensors::DHT22Sensor dht22(GPIO_DHT22, gpioConfig);
+    if (edgeCapture)
+    {
+        dht22.setCaptureMode(Sensors::CaptureMode::EdgeTriggered);
+    }
+    dht22.setRealtime(realtime);
+    if (daemonMode)
+    {
+        Service::Daemon daemon(daemonConfig);
+        daemon.addSensor("dht22", &dht22, periodMs);
+        Sensors::GL5516Sensor gl5516(lightConfig);
+        if (readLight)
+        {
+            daemon.addSensor("gl5516", &gl5516, periodMs);
+        }
+        return runDaemon(daemon, metricsPath, shmName);
+    }
+
+    Sensors::SensorData data = {};
+    Acquisition::SampleRecord record = {};
+    record.startNs = Periferia::monotonicNs();
+    record.ok = dht22.read(data);
+    record.endNs = Periferia::monotonicNs();
+    record.data = data;
+    if (record.ok)
     {
         printf("Temperature: %.2f C\n", data.temperature);
         printf("Humidity: %.2f %%\n", data.humidity);
-    } 
-    else 
+        // Append the reading to the on-disk history
+        if (storePath != nullptr)
+        {
+            Storage::TimeSeriesConfig storeConfig;
+            storeConfig.directory = storePath;
+            Storage::TimeSeriesWriter store(storeConfig);
+            if (!store.start() || !store.append(Storage::toStoredSample(record)))
+            {
+                printf("Failed to store the reading in %s\n", storePath);
+            }
+        }
+    }
+    else
     {
         printf("Failed to read data from DHT22!\n");
     }
+    if (readLight)
+    {
+        Sensors::GL5516Sensor gl5516(lightConfig);
+        Sensors::SensorData light = {};
+        if (gl5516.open() && gl5516.read(light))
+        {
+            printf("Light: %.1f lx\n", light.light);
+        }
+        else
+        {
+            printf("Failed to read data from GL5516!\n");
+        }
+        gl5516.close();
+    }
+    if (realtime)
+    {
+        const Common::RealtimeStatus &status = dht22.getRealtimeStatus();
+        printf("Read ran %s priority %d, CPU %d, memory %s\n", Common::policyName(status.policy), status.priority,
+               status.cpu, status.memoryLocked ? "locked" : "pageable");
+    }
+    // Prometheus text for the node exporter textfile collector
+    if (metricsPath != nullptr && !Metrics::writePrometheus(metricsPath))
+    {
+        printf("Failed to write metrics to %s\n", metricsPath);
+    }
+    Log::flush();
     return 0;
-}
\ No newline at end of file
+}
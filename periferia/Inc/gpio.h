@@ -2,8 +2,16 @@
 #define GPIO_H
 
 #include "../../define.h"
+#include "gpio_backend.h"
+#include "gpio_chip.h"
+#include "gpio_mmap.h"
+#include "../../common/Inc/Metrics.h"
+#include <memory>
+#include <poll.h>
 
 #define GPIO_DHT22 60
+#define GPIO_SYSFS_ROOT "/sys/class/gpio"
+
 namespace Periferia
 {
     enum class Direction
@@ -12,6 +20,41 @@ namespace Periferia
         Output
     };
 
+    /**
+     * @brief Kernel interface used to reach the pin.
+     */
+    enum class Backend
+    {
+        Sysfs,   ///< /sys/class/gpio (deprecated by the kernel, kept as the default)
+        Chardev, ///< /dev/gpiochipN line requests with kernel-timestamped edge events
+        Mmap     ///< volatile register access on the mapped GPIO bank (opt-in, needs /dev/mem)
+    };
+
+    /**
+     * @brief Construction-time options for a GPIO pin.
+     */
+    struct GPIOConfig
+    {
+        Backend backend = Backend::Sysfs;
+        // Sysfs backend
+        AccessMode mode = AccessMode::Reopen;
+        const char *sysfsRoot = GPIO_SYSFS_ROOT; ///< root of the gpio class tree (a fake tree for off-target runs)
+        short edgeWakeEvents = POLLPRI | POLLERR; ///< poll() events that count as an edge (POLLIN for a pipe stand-in)
+        // Chardev backend
+        const char *chipPath = GPIO_CHIP_PATH;
+        int chipLine = -1;         ///< line offset on the chip, -1 to use the pin number
+        GPIOChip *chip = nullptr;  ///< injected chip (e.g. MockGPIOChip), not owned
+        // Mmap backend
+        const GPIORegisterLayout *registerLayout = &AM335X_GPIO_LAYOUT;
+        const char *memPath = GPIO_MEM_PATH;
+        volatile uint32_t *registers = nullptr; ///< pre-mapped bank of the pin, not owned
+        // Any backend, e.g. SimBackend; overrides the selection above, not owned
+        GPIOBackend *customBackend = nullptr;
+    };
+
+    // Parse "sysfs", "cdev"/"chardev" or "mmap"; returns false for unknown names
+    bool parseBackend(const char *name, Backend &backend);
+
     /**
      * @class GPIO
      * @brief Class for handling GPIO operations such as initialization, reading, and closing the GPIO pin.
@@ -19,8 +62,8 @@ namespace Periferia
     class GPIO
     {
     public:
-        // Constructor: takes a pin number and direction
-        explicit GPIO(int pinNumber, int direction);
+        // Constructor: takes a pin number, direction and optional access configuration
+        explicit GPIO(int pinNumber, int direction, const GPIOConfig &config = GPIOConfig());
         // Destructor for automatic closing of the pin
         ~GPIO();
 
@@ -37,12 +80,32 @@ namespace Periferia
         int getPinNumber() const { return pin; }
         Status_t setDirection(int newDirection);
 
+        // Configure which edges produce events
+        Status_t setEdge(Edge edge);
+        // Sleep until the next configured edge; OK, 0 on timeout, ERROR on failure
+        int waitEdge(EdgeEvent &event, int timeoutMs);
+        // Wait for edges and return every queued one that fits; count, 0 on timeout, ERROR on failure
+        int readEdges(EdgeEvent *events, int maxEvents, int timeoutMs);
+
+        Backend getBackend() const { return config.backend; }
+        AccessMode getAccessMode() const { return config.mode; }
+        const GPIOStats &getStats() const { return backend->getStats(); }
+        void resetStats() { backend->getStats() = GPIOStats(); }
+
     private:
         int pin;             ///< GPIO pin number
-        int gpio_fd;         ///< File descriptor for the GPIO
         int direction; ///< Direction of the GPIO pin
+        GPIOConfig config;   ///< Backend selection and options
+        std::unique_ptr<GPIOBackend> ownedBackend; ///< Backend created from the configuration
+        GPIOBackend *backend;                      ///< Access method for the pin (owned or injected)
+        // Process-wide gpio_* metrics of this pin
+        Metrics::Counter *reads;
+        Metrics::Counter *writes;
+        Metrics::Counter *readErrors;
+        Metrics::Counter *writeErrors;
+        Metrics::Histogram *readNs;
     };
 
 } // namespace Periferia
 
-#endif // GPIO_H
\ No newline at end of file
+#endif // GPIO_H
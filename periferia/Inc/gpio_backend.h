@@ -0,0 +1,96 @@
+#ifndef GPIO_BACKEND_H
+#define GPIO_BACKEND_H
+
+#include "../../define.h"
+#include <time.h>
+
+namespace Periferia
+{
+    /**
+     * @brief How the value file of a sysfs pin is accessed.
+     */
+    enum class AccessMode
+    {
+        Reopen,     ///< open()/close() the value file on every read/write
+        Persistent  ///< keep the value fd open and use pread()/pwrite() at offset 0
+    };
+
+    /**
+     * @brief Edges that produce events (sysfs "edge" file or line request flags).
+     */
+    enum class Edge
+    {
+        None,
+        Rising,
+        Falling,
+        Both
+    };
+
+    /**
+     * @brief A level change reported by waitEdge() or readEdges().
+     */
+    struct EdgeEvent
+    {
+        unsigned long long timestampNs; ///< CLOCK_MONOTONIC time (kernel timestamp on the chardev backend)
+        int value;                      ///< level after the edge
+    };
+
+    /**
+     * @brief Per-pin counters used to compare access modes and backends.
+     */
+    struct GPIOStats
+    {
+        unsigned long syscalls = 0;         ///< syscalls issued for value access and edge waits
+        unsigned long polls = 0;            ///< number of read() calls
+        unsigned long long pollNsTotal = 0; ///< accumulated read() latency
+        unsigned long long pollNsMax = 0;   ///< worst read() latency
+    };
+
+    /**
+     * @brief Returns CLOCK_MONOTONIC in nanoseconds.
+     */
+    inline unsigned long long monotonicNs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    /**
+     * @class GPIOBackend
+     * @brief Access method behind Periferia::GPIO (sysfs, character device, ...).
+     *
+     * Methods follow the GPIO conventions: OK/ERROR for value access,
+     * SUCCESS/FAILED for configuration.
+     */
+    class GPIOBackend
+    {
+    public:
+        virtual ~GPIOBackend() = default;
+
+        // Export/request the pin and set its initial direction
+        virtual Status_t init(int direction) = 0;
+        // Open the value handle; returns a descriptor or ERROR
+        virtual int open(int flag) = 0;
+        // Drive the pin; OK or ERROR
+        virtual int write(int value) = 0;
+        // Sample the pin; 0, 1 or ERROR
+        virtual int read() = 0;
+        // Release the value handle
+        virtual void close() = 0;
+        virtual Status_t setDirection(int direction) = 0;
+        virtual Status_t setEdge(Edge edge) = 0;
+        // Wait for one edge; OK, 0 on timeout, ERROR on failure
+        virtual int waitEdge(EdgeEvent &event, int timeoutMs) = 0;
+        // Wait for edges and return as many queued ones as fit; count, 0 on timeout, ERROR on failure
+        virtual int readEdges(EdgeEvent *events, int maxEvents, int timeoutMs);
+
+        GPIOStats &getStats() { return stats; }
+
+    protected:
+        GPIOStats stats; ///< Syscall and latency counters
+    };
+
+} // namespace Periferia
+
+#endif // GPIO_BACKEND_H
@@ -0,0 +1,51 @@
+#ifndef GPIO_CDEV_H
+#define GPIO_CDEV_H
+
+#include "gpio_backend.h"
+#include "gpio_chip.h"
+#include <memory>
+
+// Kernel events pulled per read() in readEdges()
+#define CDEV_EVENT_BATCH 64
+
+namespace Periferia
+{
+    /**
+     * @class CdevBackend
+     * @brief GPIO access through a single-line request on a GPIO character device.
+     *
+     * Edge events carry kernel timestamps and are drained in batches, so a
+     * whole DHT22 frame can be collected with a handful of reads.
+     */
+    class CdevBackend : public GPIOBackend
+    {
+    public:
+        // chip may be injected (e.g. MockGPIOChip); otherwise chipPath is opened
+        CdevBackend(GPIOChip *chip, const char *chipPath, unsigned int lineOffset);
+        ~CdevBackend() override;
+
+        Status_t init(int direction) override;
+        int open(int flag) override;
+        int write(int value) override;
+        int read() override;
+        void close() override;
+        Status_t setDirection(int direction) override;
+        Status_t setEdge(Edge edge) override;
+        int waitEdge(EdgeEvent &event, int timeoutMs) override;
+        int readEdges(EdgeEvent *events, int maxEvents, int timeoutMs) override;
+
+    private:
+        Status_t applyFlags(uint64_t newFlags);
+
+        std::unique_ptr<GPIOChip> ownedChip; ///< Chip opened by this backend, if not injected
+        GPIOChip *chip;       ///< Chip serving the line request
+        unsigned int line;    ///< Line offset on the chip
+        int request;          ///< Line request handle, ERROR when released
+        uint64_t lineFlags;   ///< Current GPIO_V2_LINE_FLAG_* configuration
+        uint64_t edgeFlags;   ///< Edge flags selected by setEdge(), applied while the line is an input
+        struct gpio_v2_line_event eventBuffer[CDEV_EVENT_BATCH]; ///< Raw kernel events
+    };
+
+} // namespace Periferia
+
+#endif // GPIO_CDEV_H
@@ -0,0 +1,67 @@
+#ifndef GPIO_CHIP_H
+#define GPIO_CHIP_H
+
+#include "../../define.h"
+#include <stdint.h>
+#include <linux/gpio.h>
+
+#define GPIO_CHIP_PATH "/dev/gpiochip0"
+#define GPIO_CHIP_CONSUMER "EnviroMonitor"
+// Kernel-side edge event queue per line request
+#define GPIO_CHIP_EVENT_BUFFER 128
+
+namespace Periferia
+{
+    /**
+     * @class GPIOChip
+     * @brief Line requests on a GPIO character device (GPIO v2 uAPI).
+     *
+     * A request handle covers one or more lines; bit i of a value mask
+     * refers to the i-th offset passed to requestLines(). Flags are
+     * GPIO_V2_LINE_FLAG_* values.
+     */
+    class GPIOChip
+    {
+    public:
+        virtual ~GPIOChip() = default;
+
+        // Request lines; returns a request handle or ERROR
+        virtual int requestLines(const unsigned int *offsets, int count, uint64_t flags) = 0;
+        virtual void releaseLines(int request) = 0;
+        // Reconfigure all lines of a request
+        virtual Status_t setConfig(int request, uint64_t flags) = 0;
+        // OK or ERROR
+        virtual int getValues(int request, uint64_t mask, uint64_t &bits) = 0;
+        virtual int setValues(int request, uint64_t mask, uint64_t bits) = 0;
+        // 1 when events are queued, 0 on timeout, ERROR on failure
+        virtual int waitEvents(int request, int timeoutMs) = 0;
+        // Drain up to maxEvents queued events; count or ERROR
+        virtual int readEvents(int request, struct gpio_v2_line_event *events, int maxEvents) = 0;
+    };
+
+    /**
+     * @class LinuxGPIOChip
+     * @brief GPIOChip backed by /dev/gpiochipN ioctls; request handles are line request fds.
+     */
+    class LinuxGPIOChip : public GPIOChip
+    {
+    public:
+        explicit LinuxGPIOChip(const char *chipPath);
+        ~LinuxGPIOChip() override;
+
+        int requestLines(const unsigned int *offsets, int count, uint64_t flags) override;
+        void releaseLines(int request) override;
+        Status_t setConfig(int request, uint64_t flags) override;
+        int getValues(int request, uint64_t mask, uint64_t &bits) override;
+        int setValues(int request, uint64_t mask, uint64_t bits) override;
+        int waitEvents(int request, int timeoutMs) override;
+        int readEvents(int request, struct gpio_v2_line_event *events, int maxEvents) override;
+
+    private:
+        const char *path; ///< Character device path
+        int chip_fd;      ///< Open chip descriptor, opened on first request
+    };
+
+} // namespace Periferia
+
+#endif // GPIO_CHIP_H
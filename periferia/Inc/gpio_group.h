@@ -0,0 +1,74 @@
+#ifndef GPIO_GROUP_H
+#define GPIO_GROUP_H
+
+#include "gpio.h"
+#include <stdint.h>
+
+// One bit per pin in a 64-bit mask; also the chardev per-request line limit
+#define GPIO_GROUP_MAX_PINS 64
+
+namespace Periferia
+{
+    /**
+     * @class GPIOGroupBackend
+     * @brief Access method for a set of pins read and written as one bitmask.
+     */
+    class GPIOGroupBackend
+    {
+    public:
+        virtual ~GPIOGroupBackend() = default;
+
+        virtual Status_t init(int direction) = 0;
+        // Bit i of bits is the level of pin i; OK or ERROR
+        virtual int read(uint64_t &bits) = 0;
+        // Drive the pins selected by mask; OK or ERROR
+        virtual int write(uint64_t mask, uint64_t bits) = 0;
+        virtual Status_t setDirection(int direction) = 0;
+        virtual void close() = 0;
+
+        GPIOStats &getStats() { return stats; }
+
+    protected:
+        GPIOStats stats; ///< Syscall and latency counters
+    };
+
+    /**
+     * @class GPIOGroup
+     * @brief Several pins opened once and sampled or driven in a single call.
+     *
+     * Chardev: one line request, one ioctl per read or write (pins are line
+     * offsets on config.chipPath or the injected chip). Mmap: one data-in
+     * load per bank touched, one set and one clear store per bank on write.
+     * Sysfs: a persistent value fd per pin, read with back-to-back pread()s.
+     */
+    class GPIOGroup
+    {
+    public:
+        GPIOGroup(const int *pinNumbers, int count, int direction, const GPIOConfig &config = GPIOConfig());
+        ~GPIOGroup();
+
+        Status_t init();
+        // Sample all pins: bit i is the level of pin i; OK or ERROR
+        int read(uint64_t &bits);
+        // Drive the pins whose bit is set in mask; OK or ERROR
+        int write(uint64_t mask, uint64_t bits);
+        Status_t setDirection(int newDirection);
+        void close();
+
+        int getCount() const { return count; }
+        int getPinNumber(int index) const { return pins[index]; }
+        Backend getBackend() const { return config.backend; }
+        const GPIOStats &getStats() const { return backend->getStats(); }
+        void resetStats() { backend->getStats() = GPIOStats(); }
+
+    private:
+        int pins[GPIO_GROUP_MAX_PINS]; ///< GPIO numbers, bit order of the masks
+        int count;
+        int direction;
+        GPIOConfig config;
+        std::unique_ptr<GPIOGroupBackend> backend;
+    };
+
+} // namespace Periferia
+
+#endif // GPIO_GROUP_H
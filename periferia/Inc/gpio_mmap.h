@@ -0,0 +1,79 @@
+#ifndef GPIO_MMAP_H
+#define GPIO_MMAP_H
+
+#include "gpio_backend.h"
+#include <stdint.h>
+
+#define GPIO_MEM_PATH "/dev/mem"
+#define GPIO_MMAP_MAX_BANKS 8
+
+namespace Periferia
+{
+    /**
+     * @brief Register layout of a SoC GPIO controller with one output-enable bit per pin.
+     *
+     * Offsets are in bytes from the start of a bank. setOffset/clearOffset
+     * are write-1-to-set/clear registers; 0 means the SoC has none and
+     * dataOutOffset is updated read-modify-write instead.
+     */
+    struct GPIORegisterLayout
+    {
+        const char *name;
+        unsigned long long bankBase[GPIO_MMAP_MAX_BANKS]; ///< physical address of each bank
+        unsigned int bankCount;
+        unsigned int pinsPerBank;
+        unsigned int mapSize;       ///< bytes mapped per bank
+        unsigned int oeOffset;      ///< output-enable register
+        bool oeSetMeansInput;       ///< true if a 1 in oeOffset makes the pin an input
+        unsigned int dataInOffset;
+        unsigned int dataOutOffset;
+        unsigned int setOffset;
+        unsigned int clearOffset;
+    };
+
+    // TI AM335x (BeagleBone): GPIO0..3, 32 pins each; GPIO 60 is bank 1 bit 28
+    extern const GPIORegisterLayout AM335X_GPIO_LAYOUT;
+
+    // Map one GPIO bank from memPath; nullptr on failure. Release with munmap(bank, layout->mapSize).
+    // /dev/mem is mapped at the bank's physical address; any other device (a /dev/gpiomem-style
+    // window) must expose that bank's registers at offset 0.
+    volatile uint32_t *mapGPIOBank(const GPIORegisterLayout *layout, const char *memPath, unsigned int bankIndex);
+
+    /**
+     * @class MmapBackend
+     * @brief GPIO access by volatile loads/stores on the memory-mapped GPIO bank.
+     *
+     * read/write/setDirection issue no syscalls. Edge events are not
+     * available; use the sysfs or chardev backend for edge capture.
+     */
+    class MmapBackend : public GPIOBackend
+    {
+    public:
+        // registers may point at an already mapped bank (e.g. an anonymous page in tests)
+        MmapBackend(int pinNumber, const GPIORegisterLayout *layout, const char *memPath,
+                    volatile uint32_t *registers);
+        ~MmapBackend() override;
+
+        Status_t init(int direction) override;
+        int open(int flag) override;
+        int write(int value) override;
+        int read() override;
+        void close() override;
+        Status_t setDirection(int direction) override;
+        Status_t setEdge(Edge edge) override;
+        int waitEdge(EdgeEvent &event, int timeoutMs) override;
+
+    private:
+        volatile uint32_t &reg(unsigned int offset) { return bank[offset / sizeof(uint32_t)]; }
+
+        int pin;                          ///< GPIO pin number
+        const GPIORegisterLayout *layout; ///< Register map of the SoC
+        const char *path;                 ///< /dev/mem or /dev/gpiomem
+        volatile uint32_t *bank;          ///< Mapped bank holding the pin
+        bool ownsMapping;                 ///< true if bank was mapped by this backend
+        uint32_t mask;                    ///< Bit of the pin inside its bank
+    };
+
+} // namespace Periferia
+
+#endif // GPIO_MMAP_H
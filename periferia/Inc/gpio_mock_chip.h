@@ -0,0 +1,64 @@
+#ifndef GPIO_MOCK_CHIP_H
+#define GPIO_MOCK_CHIP_H
+
+#include "gpio_chip.h"
+
+#define MOCK_CHIP_LINES 64
+#define MOCK_CHIP_REQUESTS 16
+#define MOCK_CHIP_EVENTS 256
+
+namespace Periferia
+{
+    /**
+     * @class MockGPIOChip
+     * @brief In-memory GPIOChip for running the chardev backend without hardware.
+     *
+     * Lines keep a level and their requested flags. Edges injected with
+     * pushEdge() are queued on the request that owns the line if its edge
+     * flags match, exactly like the kernel would report them. waitEvents()
+     * never blocks: it reports a timeout when the queue is empty.
+     */
+    class MockGPIOChip : public GPIOChip
+    {
+    public:
+        MockGPIOChip();
+
+        int requestLines(const unsigned int *offsets, int count, uint64_t flags) override;
+        void releaseLines(int request) override;
+        Status_t setConfig(int request, uint64_t flags) override;
+        int getValues(int request, uint64_t mask, uint64_t &bits) override;
+        int setValues(int request, uint64_t mask, uint64_t bits) override;
+        int waitEvents(int request, int timeoutMs) override;
+        int readEvents(int request, struct gpio_v2_line_event *events, int maxEvents) override;
+
+        // Change a line level as seen by the chip and queue the matching edge event
+        void pushEdge(unsigned int offset, unsigned long long timestampNs, int value);
+        int getLevel(unsigned int offset) const { return levels[offset]; }
+        uint64_t getFlags(unsigned int offset) const { return flags[offset]; }
+        // Number of uAPI calls served, for comparing against other backends
+        unsigned long getCallCount() const { return calls; }
+
+    private:
+        struct Request
+        {
+            bool used;
+            int count;
+            unsigned int offsets[MOCK_CHIP_LINES];
+            struct gpio_v2_line_event events[MOCK_CHIP_EVENTS];
+            int head;  ///< next event to read
+            int queued; ///< events waiting
+            unsigned int seqno;
+        };
+
+        Request *lookup(int request);
+
+        Request requests[MOCK_CHIP_REQUESTS];
+        int levels[MOCK_CHIP_LINES];
+        uint64_t flags[MOCK_CHIP_LINES];
+        int owner[MOCK_CHIP_LINES]; ///< request holding the line, or ERROR
+        unsigned long calls;
+    };
+
+} // namespace Periferia
+
+#endif // GPIO_MOCK_CHIP_H
@@ -0,0 +1,54 @@
+#ifndef GPIO_SETUP_H
+#define GPIO_SETUP_H
+
+#include "gpio.h"
+
+// Longest wait for udev to make a freshly exported pin writable
+#define GPIO_SETTLE_TIMEOUT_MS 1000
+// Re-check interval while pins are settling
+#define GPIO_SETTLE_POLL_US 200
+
+namespace Periferia
+{
+    // A sysfs pin and the direction it starts in
+    struct GPIOPinSetup
+    {
+        int pin;
+        int direction; ///< INPUT or OUTPUT
+    };
+
+    // What a setupPins() pass did and where its time went
+    struct GPIOSetupReport
+    {
+        int exported = 0;                  ///< pins this pass exported
+        int alreadyExported = 0;
+        int failed = 0;                    ///< not exported, not writable in time, or direction write failed
+        unsigned long long exportNs = 0;   ///< writing the export requests
+        unsigned long long settleNs = 0;   ///< waiting for pins to become writable and configuring them
+        unsigned long long totalNs = 0;
+    };
+
+    // Descriptors of a pin configured by setupPins(), handed to the first SysfsBackend of the pin
+    struct PreparedPin
+    {
+        int directionFd; ///< direction file, O_WRONLY
+        int valueFd;     ///< value file, O_RDWR | O_NONBLOCK
+        int direction;   ///< direction written by setupPins()
+    };
+
+    // Export all pins, then configure each as soon as udev has settled it; SUCCESS if all are ready
+    Status_t setupPins(const GPIOPinSetup *pins, int count, const char *sysfsRoot = GPIO_SYSFS_ROOT,
+                       GPIOSetupReport *report = nullptr, int settleTimeoutMs = GPIO_SETTLE_TIMEOUT_MS);
+    // Take the prepared descriptors of a pin (once); false if setupPins() did not prepare it
+    bool claimPreparedPin(const char *sysfsRoot, int pin, PreparedPin &prepared);
+    // Close the descriptors no GPIO claimed
+    void releasePreparedPins();
+
+    // Write the pin number to an open export file; SUCCESS also if the pin is already exported
+    Status_t writeExport(int exportFd, int pin);
+    // Wait until the direction file of an exported pin is writable
+    bool waitForExport(const char *sysfsRoot, int pin, int timeoutMs);
+
+} // namespace Periferia
+
+#endif // GPIO_SETUP_H
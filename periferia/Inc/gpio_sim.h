@@ -0,0 +1,78 @@
+#ifndef GPIO_SIM_H
+#define GPIO_SIM_H
+
+#include "gpio_backend.h"
+
+// Longest answer a simulated device can put on the line
+#define SIM_MAX_EDGES 128
+// Host low pulse the device accepts as a start signal
+#define SIM_MIN_START_US 800
+
+namespace Periferia
+{
+    /**
+     * @class SimDevice
+     * @brief Device on the far end of a simulated single-wire line.
+     */
+    class SimDevice
+    {
+    public:
+        virtual ~SimDevice() = default;
+
+        // The host pulled the line low at lowNs and released it at releaseNs.
+        // Store the device's answer as absolute-time edges; return their count.
+        virtual int respond(unsigned long long lowNs, unsigned long long releaseNs, EdgeEvent *edges,
+                            int maxEdges) = 0;
+    };
+
+    /**
+     * @class SimBackend
+     * @brief GPIO backend that replays a SimDevice waveform on CLOCK_MONOTONIC.
+     *
+     * Writes and direction changes are recorded; when the host switches to
+     * input after a start pulse, the device's answer is scheduled from that
+     * moment. read() returns the level of the waveform at the current time,
+     * so busy-polling sees the same timing as on hardware. Edge reads either
+     * wait for each edge in real time or, with instantEdges, return the
+     * whole answer at once with its model timestamps.
+     */
+    class SimBackend : public GPIOBackend
+    {
+    public:
+        explicit SimBackend(SimDevice *device, bool instantEdges = false);
+
+        Status_t init(int direction) override;
+        int open(int flag) override;
+        int write(int value) override;
+        int read() override;
+        void close() override;
+        Status_t setDirection(int direction) override;
+        Status_t setEdge(Edge edge) override;
+        int waitEdge(EdgeEvent &event, int timeoutMs) override;
+        int readEdges(EdgeEvent *events, int maxEvents, int timeoutMs) override;
+
+        // Number of answers the device has been asked for
+        unsigned long getTransactions() const { return transactions; }
+
+    private:
+        void startAnswer(unsigned long long now);
+        bool edgeWanted(int value) const;
+
+        SimDevice *device;            ///< Not owned
+        bool instantEdges;            ///< Return pending edges without waiting for their time
+        int direction;
+        int driven;                   ///< Level driven by the host while an output
+        unsigned long long lowSinceNs; ///< When the host last drove the line low, 0 if high
+        unsigned long long lowNs;     ///< Start of the last low pulse
+        unsigned long long releaseNs; ///< End of the last low pulse
+        Edge edge;
+        EdgeEvent answer[SIM_MAX_EDGES]; ///< Scheduled device waveform
+        int answerCount;
+        int levelCursor;              ///< First answer edge not yet reached by read()
+        int edgeCursor;               ///< First answer edge not yet reported as an event
+        unsigned long transactions;
+    };
+
+} // namespace Periferia
+
+#endif // GPIO_SIM_H
@@ -0,0 +1,46 @@
+#ifndef GPIO_SYSFS_H
+#define GPIO_SYSFS_H
+
+#include "gpio_backend.h"
+
+namespace Periferia
+{
+    /**
+     * @class SysfsBackend
+     * @brief GPIO access through /sys/class/gpio (export, direction, edge, value).
+     */
+    class SysfsBackend : public GPIOBackend
+    {
+    public:
+        SysfsBackend(int pinNumber, AccessMode mode, const char *sysfsRoot, short edgeWakeEvents);
+        ~SysfsBackend() override;
+
+        Status_t init(int direction) override;
+        int open(int flag) override;
+        int write(int value) override;
+        int read() override;
+        void close() override;
+        Status_t setDirection(int direction) override;
+        Status_t setEdge(Edge edge) override;
+        int waitEdge(EdgeEvent &event, int timeoutMs) override;
+
+    private:
+        int readValue();
+        int writeValue(int value);
+        Status_t writeEdge(Edge edge);
+
+        int pin;              ///< GPIO pin number
+        int gpio_fd;          ///< File descriptor for the value file
+        int direction_fd;     ///< Direction file, opened on the first direction change and kept
+        int edge_fd;          ///< Edge file, opened on the first edge change and kept
+        int currentDirection; ///< Last direction written, ERROR if unknown
+        Edge wantedEdge;      ///< Edge selected by setEdge(), armed whenever the pin is an input
+        Edge armedEdge;       ///< Edge last written to the edge file
+        AccessMode mode;      ///< Reopen or persistent value access
+        const char *root;     ///< Root of the gpio class tree
+        short edgeWakeEvents; ///< poll() events treated as an edge
+    };
+
+} // namespace Periferia
+
+#endif // GPIO_SYSFS_H
@@ -0,0 +1,94 @@
+#ifndef IIO_H
+#define IIO_H
+
+#include "../../define.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define IIO_SYSFS_ROOT "/sys/bus/iio/devices"
+#define IIO_DEV_ROOT "/dev"
+// Scans the kernel buffer holds
+#define IIO_BUFFER_LENGTH 1024
+#define IIO_MAX_SCAN_CHANNELS 16
+
+namespace Periferia
+{
+    /**
+     * @brief Which ADC channel to read and how.
+     */
+    struct IIOConfig
+    {
+        int device = 0;                          ///< iio:deviceN
+        int channel = 0;                         ///< in_voltageN
+        const char *sysfsRoot = IIO_SYSFS_ROOT;  ///< directory of the iio:deviceN trees (a fake tree for off-target runs)
+        const char *devRoot = IIO_DEV_ROOT;      ///< directory of the iio:deviceN character devices
+        bool buffered = true;                    ///< triggered capture through the chardev; false reads in_voltageN_raw
+        const char *trigger = nullptr;           ///< written to trigger/current_trigger if set
+        size_t bufferLength = IIO_BUFFER_LENGTH; ///< written to buffer/length
+    };
+
+    // Storage of one channel inside a scan, from scan_elements/*_type, e.g. "le:u12/16>>0"
+    struct IIOScanFormat
+    {
+        bool bigEndian;
+        bool isSigned;
+        unsigned int bits;        ///< significant bits
+        unsigned int storageBits; ///< bits the value occupies in the scan
+        unsigned int shift;       ///< right shift before masking
+    };
+
+    // Parse a scan_elements type string; false if it is malformed
+    bool parseScanFormat(const char *text, IIOScanFormat &format);
+
+    /**
+     * @class IIOAdc
+     * @brief One channel of a Linux IIO ADC.
+     *
+     * In buffered mode the channel is enabled in scan_elements, the buffer
+     * is started and blocks of scans are read from /dev/iio:deviceN without
+     * blocking, one read() for as many samples as have been captured. The
+     * channel's samples are picked out of each scan according to the scan
+     * layout of all enabled channels. Without buffering, every sample is a
+     * pread() of in_voltageN_raw on a descriptor kept open.
+     */
+    class IIOAdc
+    {
+    public:
+        explicit IIOAdc(const IIOConfig &config);
+        ~IIOAdc();
+
+        Status_t init();
+        void close();
+
+        // One conversion through sysfs; the raw value or ERROR
+        int readRaw();
+        // Up to maxSamples buffered samples, waiting at most timeoutMs for the first; count or ERROR
+        int readSamples(uint16_t *samples, size_t maxSamples, int timeoutMs);
+
+        bool isBuffered() const { return config.buffered; }
+        unsigned int getBits() const { return format.bits; }
+        // Millivolts per LSB from in_voltage*_scale, 0 if the device does not report it
+        float getScale() const { return scale; }
+
+    private:
+        bool readAttribute(const char *name, char *value, size_t size);
+        bool writeAttribute(const char *name, const char *value);
+        bool setupBuffer();
+        void extract(const uint8_t *scans, size_t count, uint16_t *samples) const;
+
+        IIOConfig config;
+        char devicePath[MAX_PATH];
+        int rawFd;                  ///< in_voltageN_raw, one-shot mode
+        int bufferFd;               ///< /dev/iio:deviceN, buffered mode
+        IIOScanFormat format;
+        float scale;
+        size_t scanBytes;           ///< size of one scan of all enabled channels
+        size_t channelOffset;       ///< where the channel sits in a scan
+        std::vector<uint8_t> block; ///< read() buffer, allocated once in init()
+        size_t pending;             ///< bytes of an incomplete scan kept at the start of block
+    };
+
+} // namespace Periferia
+
+#endif // IIO_H
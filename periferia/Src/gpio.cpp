@@ -1,21 +1,82 @@
 #include "../Inc/gpio.h"
+#include "../../common/Inc/Log.h"
+#include "../../common/Inc/AllocTracker.h"
+#include "../Inc/gpio_sysfs.h"
+#include "../Inc/gpio_cdev.h"
+#include "../Inc/gpio_mmap.h"
 
 namespace Periferia
 {
+    /**
+     * @brief Creates the backend selected by the configuration.
+     */
+    static GPIOBackend *createBackend(int pin, const GPIOConfig &config)
+    {
+        if (config.backend == Backend::Chardev)
+        {
+            unsigned int line = (config.chipLine < 0) ? pin : config.chipLine;
+            return new CdevBackend(config.chip, config.chipPath, line);
+        }
+        if (config.backend == Backend::Mmap)
+        {
+            return new MmapBackend(pin, config.registerLayout, config.memPath, config.registers);
+        }
+        return new SysfsBackend(pin, config.mode, config.sysfsRoot, config.edgeWakeEvents);
+    }
+
+    /**
+     * @brief Parses a backend name given on the command line or in a config file.
+     * @param name "sysfs", "cdev", "chardev" or "mmap".
+     * @param backend Receives the parsed backend.
+     * @return true if the name is known, false otherwise.
+     */
+    bool parseBackend(const char *name, Backend &backend)
+    {
+        if (strcmp(name, "sysfs") == 0)
+        {
+            backend = Backend::Sysfs;
+            return true;
+        }
+        if (strcmp(name, "cdev") == 0 || strcmp(name, "chardev") == 0)
+        {
+            backend = Backend::Chardev;
+            return true;
+        }
+        if (strcmp(name, "mmap") == 0)
+        {
+            backend = Backend::Mmap;
+            return true;
+        }
+        return false;
+    }
+
     /**
      * @brief Constructs a GPIO object for a specific pin and direction.
      * @param pinNumber The GPIO pin number.
      * @param direction The direction of the GPIO pin ("in" or "out").
+     * @param config Backend selection and its options, or an injected backend.
      */
-    GPIO::GPIO(int pinNumber, int direction)
-        : pin(pinNumber), gpio_fd(-1), direction(direction)
+    GPIO::GPIO(int pinNumber, int direction, const GPIOConfig &config)
+        : pin(pinNumber), direction(direction), config(config),
+          ownedBackend(config.customBackend == nullptr ? createBackend(pinNumber, config) : nullptr),
+          backend(config.customBackend == nullptr ? ownedBackend.get() : config.customBackend)
     {
-        printf("Initializing GPIO pin %d with direction %s\n", pinNumber, (direction == INPUT ? "in" : "out"));
+        char labels[METRICS_LABELS_SIZE];
+        snprintf(labels, sizeof(labels), "pin=\"%d\"", pinNumber);
+        reads = &Metrics::counter("gpio_reads_total", labels, "GPIO value reads");
+        writes = &Metrics::counter("gpio_writes_total", labels, "GPIO value writes");
+        readNs = &Metrics::histogram("gpio_read_duration_seconds", labels, "GPIO read() latency");
+        snprintf(labels, sizeof(labels), "pin=\"%d\",op=\"read\"", pinNumber);
+        readErrors = &Metrics::counter("gpio_errors_total", labels, "Failed GPIO value accesses");
+        snprintf(labels, sizeof(labels), "pin=\"%d\",op=\"write\"", pinNumber);
+        writeErrors = &Metrics::counter("gpio_errors_total", labels, "Failed GPIO value accesses");
+
+        LOG_DEBUG("Initializing GPIO pin %d with direction %s\n", pinNumber, (direction == INPUT ? "in" : "out"));
 
         // Calling the init method in the constructor
         if (init() != SUCCESS)
         {
-            printf("Failed to initialize GPIO pin.\n");
+            LOG_ERROR("Failed to initialize GPIO pin.\n");
         }
     }
 
@@ -24,148 +85,79 @@ namespace Periferia
      */
     GPIO::~GPIO()
     {
-        if (gpio_fd != ERROR)
-        {
-            close();
-        }
+        close();
     }
 
     /**
-     * @brief Initializes the GPIO pin by exporting it and setting its direction.
+     * @brief Initializes the GPIO pin (export or line request) and sets its direction.
      * @return SUCCESS if initialization is successful, FAILED otherwise.
      */
     Status_t GPIO::init()
     {
-        char gpioPath[MAX_PATH];
-        char directionPath[MAX_DIRECTION_PATH];
-
-        snprintf(gpioPath, MAX_PATH, "/sys/class/gpio/gpio%d", pin);
-
-        // Check if the GPIO folder already exists
-        if (access(gpioPath, F_OK) != 0)
-        {
-            // If the folder does not exist, export the GPIO pin
-            int export_fd = ::open("/sys/class/gpio/export", O_WRONLY);
-            if (export_fd == ERROR)
-            {
-                printf("Error opening GPIO export: %s\n", strerror(errno));
-                return FAILED;
-            }
-
-            // Write the pin number to the export file
-            char pinBuffer[PIN_BUFF];
-            snprintf(pinBuffer, PIN_BUFF, "%d", pin);
-            if (::write(export_fd, pinBuffer, strlen(pinBuffer)) == ERROR)
-            {
-                printf("Error writing pin number to export: %s\n", strerror(errno));
-                ::close(export_fd);
-                return FAILED;
-            }
-            printf("Exported GPIO_%d.\n", pin);
-            ::close(export_fd);
-        }
-        else
-        {
-            printf("GPIO_%d already exported.\n", pin);
-        }
-        // Set the direction of the GPIO pin
-        snprintf(directionPath, MAX_DIRECTION_PATH, "/sys/class/gpio/gpio%d/direction", pin);
-        gpio_fd = ::open(directionPath, O_WRONLY);
-        if (gpio_fd == ERROR)
-        {
-            printf("Error opening GPIO direction: %s\n", strerror(errno));
-            return FAILED;
-        }
-        const char *dirStr = (direction == INPUT) ? "in" : "out";
-        // Write the direction to the direction file ("in" or "out")
-        if (::write(gpio_fd, dirStr, strlen(dirStr)) == ERROR)
-        {
-            printf("Error writing direction to GPIO: %s\n", strerror(errno));
-            close();
-            return FAILED;
-        }
-        printf("Set GPIO_%d direction to %s.\n", pin, dirStr);
-        close();
-
-        return SUCCESS;
+        return backend->init(direction);
     }
+
     /**
-     * @brief Opens the GPIO value file for reading or writing.
-     * @param flag Open mode (e.g., O_RDONLY or O_WRONLY).
-     * @return File descriptor for the GPIO value file, or -1 if failed.
+     * @brief Opens the value handle of the pin.
+     * @param flag Open mode (e.g., O_RDONLY or O_WRONLY), used by the sysfs reopen mode.
+     * @return Descriptor or handle of the pin, or -1 if failed.
      */
     int GPIO::open(int flag)
     {
-        char gpioPath[MAX_PATH];
-        snprintf(gpioPath, MAX_PATH, "/sys/class/gpio/gpio%d/value", pin);
-        gpio_fd = ::open(gpioPath, flag);
-        if (gpio_fd == ERROR)
-        {
-            printf("Error opening GPIO value file: %s\n", strerror(errno));
-        }
-        return gpio_fd;
+        return backend->open(flag);
     }
 
+    /**
+     * @brief Writes a value to the GPIO pin.
+     * @param value 1 to drive the pin high, 0 to drive it low.
+     * @return OK on success, ERROR otherwise.
+     */
     int GPIO::write(int value)
     {
-        if(open(O_WRONLY) == ERROR)
+        Common::NoAllocScope noAlloc("GPIO::write");
+        int result = backend->write(value);
+        writes->add();
+        if (result == ERROR)
         {
-            printf("Failed to open GPIO pin before writing.\n");
-            return ERROR;
+            writeErrors->add();
         }
-        char val_str = (value == 1) ? '1' : '0';
-        if (::write(gpio_fd, &val_str, 1) == ERROR)
-        {
-            printf("Error writing GPIO value : %s\n", strerror(errno));
-            close();
-            return ERROR;
-        }
-        close();
-        printf("Wrote value %d to GPIO pin %d.\n", value, pin);
-        return OK;
+        return result;
     }
+
     /**
-     * @brief Reads the value from the GPIO pin.
+     * @brief Reads the value from the GPIO pin and records the poll latency (stats and gpio_* metrics).
      * @return 1 if the GPIO value is high ('1'), 0 if low ('0').
      */
     int GPIO::read()
     {
-        if(open(O_RDONLY) == ERROR)
-        {
-            printf("Failed to open GPIO pin before reading\n");
-            return ERROR;
-        }
-        char value;
-        if (::read(gpio_fd, &value, sizeof(value)) == ERROR)
-        {
-            printf("Error reading GPIO value: %s\n", strerror(errno));
-            close();
-            return ERROR;
-        }
-        int readValue = (value == '1') ? 1 : (value == '0' ? 0 : -1);
-        if (readValue == -1)
+        Common::NoAllocScope noAlloc("GPIO::read");
+        unsigned long long start = monotonicNs();
+        int readValue = backend->read();
+        unsigned long long elapsed = monotonicNs() - start;
+
+        GPIOStats &stats = backend->getStats();
+        stats.polls++;
+        stats.pollNsTotal += elapsed;
+        if (elapsed > stats.pollNsMax)
         {
-            printf("Unexpected value read from GPIO_%d: %d\n", pin, value);        
+            stats.pollNsMax = elapsed;
         }
-        else
+
+        reads->add();
+        readNs->record(elapsed);
+        if (readValue == ERROR)
         {
-            printf("Read [%d] from GPIO_%d.\n", readValue, pin);
+            readErrors->add();
         }
-        close();
         return readValue;
     }
 
     /**
-     * @brief Closes the GPIO pin by closing its file descriptor.
+     * @brief Closes the value handle of the pin.
      */
     void GPIO::close()
     {
-        if (gpio_fd != -1)
-        {
-            ::close(gpio_fd);
-            //printf("Closed GPIO pin %d.\n", pin);
-            gpio_fd = -1;
-        }
+        backend->close();
     }
 
     /**
@@ -181,29 +173,52 @@ namespace Periferia
             return SUCCESS; // No need to change if the direction is already set
         }
 
-        // Set the direction in the file system
-        char directionPath[MAX_DIRECTION_PATH];
-        snprintf(directionPath, MAX_DIRECTION_PATH, "/sys/class/gpio/gpio%d/direction", pin);
-        gpio_fd = ::open(directionPath, O_WRONLY);
-        if (gpio_fd == ERROR)
+        if (backend->setDirection(newDirection) == FAILED)
         {
-            printf("Error opening GPIO direction: %s\n", strerror(errno));
             return FAILED;
         }
+        direction = newDirection; // Update the current direction
+        return SUCCESS;
+    }
 
-        const char *dirStr = (newDirection == INPUT) ? "in" : "out";
-        // Write the new direction to the direction file
-        if (::write(gpio_fd, dirStr, strlen(dirStr)) == ERROR)
-        {
-            printf("Error writing direction to GPIO: %s\n", strerror(errno));
-            close();
-            return FAILED;
-        }
+    /**
+     * @brief Selects which level changes produce edge events.
+     *
+     * On an output pin the selection is kept and takes effect when the pin
+     * becomes an input; edge events are never reported while it drives.
+     *
+     * @param edge Edge::None disables edge events.
+     * @return SUCCESS or FAILED.
+     */
+    Status_t GPIO::setEdge(Edge edge)
+    {
+        return backend->setEdge(edge);
+    }
 
-        close();
-        direction = newDirection; // Update the current direction
-        printf("Set GPIO_%d direction to %s.\n", pin, dirStr);
+    /**
+     * @brief Sleeps until the next configured edge.
+     * @param event Filled with the edge timestamp and the new level.
+     * @param timeoutMs Timeout, negative to wait forever.
+     * @return OK when an edge was seen, 0 on timeout, ERROR on failure.
+     */
+    int GPIO::waitEdge(EdgeEvent &event, int timeoutMs)
+    {
+        return backend->waitEdge(event, timeoutMs);
+    }
 
-        return SUCCESS;
+    /**
+     * @brief Waits for edges and returns all queued events that fit.
+     *
+     * The chardev backend returns kernel-buffered batches; sysfs returns at
+     * most one event per call.
+     *
+     * @param events Destination array.
+     * @param maxEvents Capacity of events.
+     * @param timeoutMs Timeout, negative to wait forever.
+     * @return Number of events, 0 on timeout, ERROR on failure.
+     */
+    int GPIO::readEdges(EdgeEvent *events, int maxEvents, int timeoutMs)
+    {
+        return backend->readEdges(events, maxEvents, timeoutMs);
     }
-} // namespace Peripheria
\ No newline at end of file
+} // namespace Peripheria
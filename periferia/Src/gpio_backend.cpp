@@ -0,0 +1,24 @@
+#include "../Inc/gpio_backend.h"
+
+namespace Periferia
+{
+    /**
+     * @brief Default batch read for backends without an event queue.
+     *
+     * Waits for a single edge, so each call returns at most one event.
+     *
+     * @param events Destination array.
+     * @param maxEvents Capacity of events.
+     * @param timeoutMs Timeout for the wait, negative to wait forever.
+     * @return 1 if an edge was stored, 0 on timeout, ERROR on failure.
+     */
+    int GPIOBackend::readEdges(EdgeEvent *events, int maxEvents, int timeoutMs)
+    {
+        if (maxEvents <= 0)
+        {
+            return 0;
+        }
+        int result = waitEdge(events[0], timeoutMs);
+        return (result == OK) ? 1 : result;
+    }
+} // namespace Periferia
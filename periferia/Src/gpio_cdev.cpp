@@ -0,0 +1,215 @@
+#include "../Inc/gpio_cdev.h"
+#include "../../common/Inc/Log.h"
+
+namespace Periferia
+{
+    /**
+     * @brief Returns the line flags for a direction; edge detection is kept on inputs only.
+     */
+    static uint64_t directionFlags(int direction, uint64_t edgeFlags)
+    {
+        return (direction == INPUT) ? (uint64_t)GPIO_V2_LINE_FLAG_INPUT | edgeFlags : (uint64_t)GPIO_V2_LINE_FLAG_OUTPUT;
+    }
+
+    /**
+     * @brief Constructs a chardev backend. The line is requested in init().
+     * @param chip Chip to use, or nullptr to open chipPath.
+     * @param chipPath Character device opened when no chip is injected.
+     * @param lineOffset Line offset on the chip.
+     */
+    CdevBackend::CdevBackend(GPIOChip *chip, const char *chipPath, unsigned int lineOffset)
+        : ownedChip(chip == nullptr ? new LinuxGPIOChip(chipPath) : nullptr),
+          chip(chip == nullptr ? ownedChip.get() : chip),
+          line(lineOffset), request(ERROR), lineFlags(0), edgeFlags(0)
+    {
+    }
+
+    /**
+     * @brief Releases the line request.
+     */
+    CdevBackend::~CdevBackend()
+    {
+        close();
+    }
+
+    /**
+     * @brief Requests the line with the initial direction.
+     * @param direction INPUT or OUTPUT.
+     * @return SUCCESS if the line was requested, FAILED otherwise.
+     */
+    Status_t CdevBackend::init(int direction)
+    {
+        lineFlags = directionFlags(direction, edgeFlags);
+        if (open(O_RDWR) == ERROR)
+        {
+            return FAILED;
+        }
+        LOG_DEBUG("Requested line %u as %s.\n", line, (direction == INPUT ? "in" : "out"));
+        return SUCCESS;
+    }
+
+    /**
+     * @brief Returns the line request handle, re-requesting it after close().
+     * @param flag Ignored: a line request is always readable and writable.
+     * @return Request handle or ERROR.
+     */
+    int CdevBackend::open(int flag)
+    {
+        (void)flag;
+        if (request == ERROR)
+        {
+            request = chip->requestLines(&line, 1, lineFlags);
+            stats.syscalls++;
+        }
+        return request;
+    }
+
+    /**
+     * @brief Drives the line with GPIO_V2_LINE_SET_VALUES_IOCTL.
+     * @return OK or ERROR.
+     */
+    int CdevBackend::write(int value)
+    {
+        if (open(O_RDWR) == ERROR)
+        {
+            return ERROR;
+        }
+        stats.syscalls++;
+        return chip->setValues(request, 1, (value == HIGH) ? 1 : 0);
+    }
+
+    /**
+     * @brief Samples the line with GPIO_V2_LINE_GET_VALUES_IOCTL.
+     * @return 0, 1 or ERROR.
+     */
+    int CdevBackend::read()
+    {
+        if (open(O_RDWR) == ERROR)
+        {
+            return ERROR;
+        }
+        uint64_t bits = 0;
+        stats.syscalls++;
+        if (chip->getValues(request, 1, bits) == ERROR)
+        {
+            return ERROR;
+        }
+        return (bits & 1) ? HIGH : LOW;
+    }
+
+    /**
+     * @brief Releases the line request.
+     */
+    void CdevBackend::close()
+    {
+        if (request != ERROR)
+        {
+            chip->releaseLines(request);
+            stats.syscalls++;
+            request = ERROR;
+        }
+    }
+
+    /**
+     * @brief Switches direction with one GPIO_V2_LINE_SET_CONFIG_IOCTL.
+     *
+     * Edge detection is dropped on an output and the edges selected by
+     * setEdge() come back with the switch to input.
+     *
+     * @return SUCCESS or FAILED.
+     */
+    Status_t CdevBackend::setDirection(int direction)
+    {
+        return applyFlags(directionFlags(direction, edgeFlags));
+    }
+
+    /**
+     * @brief Selects the kernel edge detection of the line.
+     *
+     * Applied at once on an input; on an output the edges are armed by the
+     * next switch to input, in the same ioctl.
+     *
+     * @return SUCCESS or FAILED.
+     */
+    Status_t CdevBackend::setEdge(Edge edge)
+    {
+        edgeFlags = 0;
+        if (edge == Edge::Rising || edge == Edge::Both)
+        {
+            edgeFlags |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+        }
+        if (edge == Edge::Falling || edge == Edge::Both)
+        {
+            edgeFlags |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+        }
+        if (!(lineFlags & GPIO_V2_LINE_FLAG_INPUT))
+        {
+            return SUCCESS;
+        }
+        uint64_t newFlags = directionFlags(INPUT, edgeFlags);
+        return (newFlags == lineFlags) ? SUCCESS : applyFlags(newFlags);
+    }
+
+    /**
+     * @brief Waits for a single kernel edge event.
+     * @return OK, 0 on timeout, ERROR on failure.
+     */
+    int CdevBackend::waitEdge(EdgeEvent &event, int timeoutMs)
+    {
+        int result = readEdges(&event, 1, timeoutMs);
+        return (result > 0) ? OK : result;
+    }
+
+    /**
+     * @brief Waits for edges and drains the kernel queue in one read().
+     *
+     * Timestamps come from the kernel interrupt handler, so the decoded
+     * pulse widths do not depend on when this thread got scheduled.
+     *
+     * @param events Destination array.
+     * @param maxEvents Capacity of events.
+     * @param timeoutMs Wait timeout, negative to wait forever.
+     * @return Number of events, 0 on timeout, ERROR on failure.
+     */
+    int CdevBackend::readEdges(EdgeEvent *events, int maxEvents, int timeoutMs)
+    {
+        if (open(O_RDWR) == ERROR)
+        {
+            return ERROR;
+        }
+        int ready = chip->waitEvents(request, timeoutMs);
+        stats.syscalls++;
+        if (ready <= 0)
+        {
+            return ready;
+        }
+
+        if (maxEvents > CDEV_EVENT_BATCH)
+        {
+            maxEvents = CDEV_EVENT_BATCH;
+        }
+        int count = chip->readEvents(request, eventBuffer, maxEvents);
+        stats.syscalls++;
+        for (int i = 0; i < count; ++i)
+        {
+            events[i].timestampNs = eventBuffer[i].timestamp_ns;
+            events[i].value = (eventBuffer[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE) ? HIGH : LOW;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Reconfigures the held request, or stores the flags for the next request.
+     * @return SUCCESS or FAILED.
+     */
+    Status_t CdevBackend::applyFlags(uint64_t newFlags)
+    {
+        lineFlags = newFlags;
+        if (request == ERROR)
+        {
+            return (open(O_RDWR) == ERROR) ? FAILED : SUCCESS;
+        }
+        stats.syscalls++;
+        return chip->setConfig(request, lineFlags);
+    }
+} // namespace Periferia
@@ -0,0 +1,170 @@
+#include "../Inc/gpio_chip.h"
+#include "../../common/Inc/Log.h"
+#include <sys/ioctl.h>
+#include <poll.h>
+
+namespace Periferia
+{
+    /**
+     * @brief Constructs a chip handle; the device is opened on the first request.
+     * @param chipPath Path of the character device, e.g. /dev/gpiochip1.
+     */
+    LinuxGPIOChip::LinuxGPIOChip(const char *chipPath) : path(chipPath), chip_fd(-1)
+    {
+    }
+
+    /**
+     * @brief Closes the chip descriptor. Line requests have their own fds.
+     */
+    LinuxGPIOChip::~LinuxGPIOChip()
+    {
+        if (chip_fd != ERROR)
+        {
+            ::close(chip_fd);
+        }
+    }
+
+    /**
+     * @brief Requests lines with GPIO_V2_GET_LINE_IOCTL.
+     * @param offsets Line offsets on the chip.
+     * @param count Number of offsets (at most GPIO_V2_LINES_MAX).
+     * @param flags GPIO_V2_LINE_FLAG_* applied to all lines.
+     * @return The line request fd, or ERROR.
+     */
+    int LinuxGPIOChip::requestLines(const unsigned int *offsets, int count, uint64_t flags)
+    {
+        if (chip_fd == ERROR)
+        {
+            chip_fd = ::open(path, O_RDWR | O_CLOEXEC);
+            if (chip_fd == ERROR)
+            {
+                LOG_ERROR("Error opening GPIO chip %s: %s\n", path, strerror(errno));
+                return ERROR;
+            }
+        }
+        if (count <= 0 || count > GPIO_V2_LINES_MAX)
+        {
+            LOG_ERROR("Invalid GPIO line count: %d\n", count);
+            return ERROR;
+        }
+
+        struct gpio_v2_line_request request;
+        memset(&request, 0, sizeof(request));
+        for (int i = 0; i < count; ++i)
+        {
+            request.offsets[i] = offsets[i];
+        }
+        strncpy(request.consumer, GPIO_CHIP_CONSUMER, GPIO_MAX_NAME_SIZE - 1);
+        request.config.flags = flags;
+        request.num_lines = count;
+        request.event_buffer_size = GPIO_CHIP_EVENT_BUFFER;
+
+        if (ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &request) == ERROR)
+        {
+            LOG_ERROR("Error requesting GPIO line %u on %s: %s\n", offsets[0], path, strerror(errno));
+            return ERROR;
+        }
+        return request.fd;
+    }
+
+    /**
+     * @brief Releases a line request by closing its fd.
+     */
+    void LinuxGPIOChip::releaseLines(int request)
+    {
+        if (request != ERROR)
+        {
+            ::close(request);
+        }
+    }
+
+    /**
+     * @brief Reconfigures the lines of a request (direction, edge detection).
+     * @return SUCCESS or FAILED.
+     */
+    Status_t LinuxGPIOChip::setConfig(int request, uint64_t flags)
+    {
+        struct gpio_v2_line_config config;
+        memset(&config, 0, sizeof(config));
+        config.flags = flags;
+        if (ioctl(request, GPIO_V2_LINE_SET_CONFIG_IOCTL, &config) == ERROR)
+        {
+            LOG_ERROR("Error configuring GPIO line: %s\n", strerror(errno));
+            return FAILED;
+        }
+        return SUCCESS;
+    }
+
+    /**
+     * @brief Reads the masked line values in one ioctl.
+     * @return OK or ERROR.
+     */
+    int LinuxGPIOChip::getValues(int request, uint64_t mask, uint64_t &bits)
+    {
+        struct gpio_v2_line_values values;
+        values.mask = mask;
+        values.bits = 0;
+        if (ioctl(request, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) == ERROR)
+        {
+            LOG_ERROR("Error reading GPIO line values: %s\n", strerror(errno));
+            return ERROR;
+        }
+        bits = values.bits;
+        return OK;
+    }
+
+    /**
+     * @brief Drives the masked lines in one ioctl.
+     * @return OK or ERROR.
+     */
+    int LinuxGPIOChip::setValues(int request, uint64_t mask, uint64_t bits)
+    {
+        struct gpio_v2_line_values values;
+        values.mask = mask;
+        values.bits = bits;
+        if (ioctl(request, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) == ERROR)
+        {
+            LOG_ERROR("Error writing GPIO line values: %s\n", strerror(errno));
+            return ERROR;
+        }
+        return OK;
+    }
+
+    /**
+     * @brief Waits until the request fd has edge events queued.
+     * @return 1 if readable, 0 on timeout, ERROR on failure.
+     */
+    int LinuxGPIOChip::waitEvents(int request, int timeoutMs)
+    {
+        struct pollfd pfd;
+        pfd.fd = request;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        int ready = ::poll(&pfd, 1, timeoutMs);
+        if (ready == ERROR)
+        {
+            LOG_ERROR("Error polling GPIO line request: %s\n", strerror(errno));
+        }
+        return ready;
+    }
+
+    /**
+     * @brief Drains queued edge events with a single read().
+     *
+     * The kernel copies as many whole events as fit, each carrying its own
+     * timestamp, so a burst of edges costs one syscall.
+     *
+     * @return Number of events read, or ERROR.
+     */
+    int LinuxGPIOChip::readEvents(int request, struct gpio_v2_line_event *events, int maxEvents)
+    {
+        ssize_t bytes = ::read(request, events, maxEvents * sizeof(struct gpio_v2_line_event));
+        if (bytes == ERROR)
+        {
+            LOG_ERROR("Error reading GPIO line events: %s\n", strerror(errno));
+            return ERROR;
+        }
+        return (int)(bytes / sizeof(struct gpio_v2_line_event));
+    }
+} // namespace Periferia
@@ -0,0 +1,479 @@
+#include "../Inc/gpio_group.h"
+#include "../Inc/gpio_sysfs.h"
+#include "../../common/Inc/Log.h"
+#include <sys/mman.h>
+#include <vector>
+
+namespace Periferia
+{
+    namespace
+    {
+        /**
+         * @brief Mask with the low count bits set.
+         */
+        uint64_t lowBits(int count)
+        {
+            return (count >= 64) ? ~0ULL : ((1ULL << count) - 1);
+        }
+
+        /**
+         * @class SysfsGroup
+         * @brief One persistent sysfs value fd per pin.
+         *
+         * sysfs has no multi-line read, and preadv() only scatters one fd,
+         * so a pass is one pread() per pin with no open/close in between.
+         */
+        class SysfsGroup : public GPIOGroupBackend
+        {
+        public:
+            SysfsGroup(const int *pins, int count, const GPIOConfig &config)
+            {
+                for (int i = 0; i < count; ++i)
+                {
+                    members.emplace_back(new SysfsBackend(pins[i], AccessMode::Persistent, config.sysfsRoot,
+                                                          config.edgeWakeEvents));
+                }
+            }
+
+            Status_t init(int direction) override
+            {
+                for (std::unique_ptr<SysfsBackend> &member : members)
+                {
+                    if (member->init(direction) == FAILED)
+                    {
+                        return FAILED;
+                    }
+                }
+                return SUCCESS;
+            }
+
+            int read(uint64_t &bits) override
+            {
+                bits = 0;
+                for (size_t i = 0; i < members.size(); ++i)
+                {
+                    int value = members[i]->read();
+                    if (value == ERROR)
+                    {
+                        return ERROR;
+                    }
+                    bits |= (uint64_t)(value == HIGH) << i;
+                }
+                stats.syscalls += members.size();
+                return OK;
+            }
+
+            int write(uint64_t mask, uint64_t bits) override
+            {
+                for (size_t i = 0; i < members.size(); ++i)
+                {
+                    if (mask & (1ULL << i))
+                    {
+                        if (members[i]->write((bits & (1ULL << i)) ? HIGH : LOW) == ERROR)
+                        {
+                            return ERROR;
+                        }
+                        stats.syscalls++;
+                    }
+                }
+                return OK;
+            }
+
+            Status_t setDirection(int direction) override
+            {
+                for (std::unique_ptr<SysfsBackend> &member : members)
+                {
+                    if (member->setDirection(direction) == FAILED)
+                    {
+                        return FAILED;
+                    }
+                }
+                return SUCCESS;
+            }
+
+            void close() override
+            {
+                for (std::unique_ptr<SysfsBackend> &member : members)
+                {
+                    member->close();
+                }
+            }
+
+        private:
+            std::vector<std::unique_ptr<SysfsBackend>> members;
+        };
+
+        /**
+         * @class CdevGroup
+         * @brief All pins in one chardev line request; one ioctl per pass.
+         */
+        class CdevGroup : public GPIOGroupBackend
+        {
+        public:
+            CdevGroup(const int *pins, int count, const GPIOConfig &config)
+                : ownedChip(config.chip == nullptr ? new LinuxGPIOChip(config.chipPath) : nullptr),
+                  chip(config.chip == nullptr ? ownedChip.get() : config.chip), count(count), request(ERROR)
+            {
+                for (int i = 0; i < count; ++i)
+                {
+                    offsets[i] = pins[i];
+                }
+            }
+
+            ~CdevGroup() override { close(); }
+
+            Status_t init(int direction) override
+            {
+                request = chip->requestLines(offsets, count, flagsFor(direction));
+                stats.syscalls++;
+                return (request == ERROR) ? FAILED : SUCCESS;
+            }
+
+            int read(uint64_t &bits) override
+            {
+                stats.syscalls++;
+                return chip->getValues(request, lowBits(count), bits);
+            }
+
+            int write(uint64_t mask, uint64_t bits) override
+            {
+                stats.syscalls++;
+                return chip->setValues(request, mask & lowBits(count), bits);
+            }
+
+            Status_t setDirection(int direction) override
+            {
+                stats.syscalls++;
+                return chip->setConfig(request, flagsFor(direction));
+            }
+
+            void close() override
+            {
+                if (request != ERROR)
+                {
+                    chip->releaseLines(request);
+                    stats.syscalls++;
+                    request = ERROR;
+                }
+            }
+
+        private:
+            static uint64_t flagsFor(int direction)
+            {
+                return (direction == INPUT) ? GPIO_V2_LINE_FLAG_INPUT : GPIO_V2_LINE_FLAG_OUTPUT;
+            }
+
+            std::unique_ptr<GPIOChip> ownedChip;
+            GPIOChip *chip;
+            unsigned int offsets[GPIO_GROUP_MAX_PINS];
+            int count;
+            int request;
+        };
+
+        /**
+         * @class MmapGroup
+         * @brief Pins grouped by bank; one register access per bank per pass.
+         */
+        class MmapGroup : public GPIOGroupBackend
+        {
+        public:
+            MmapGroup(const int *pins, int count, const GPIOConfig &config)
+                : layout(config.registerLayout), path(config.memPath), injected(config.registers), count(count),
+                  bankCount(0), outsideLayout(false), invalidPin(0)
+            {
+                for (int i = 0; i < count; ++i)
+                {
+                    unsigned int index = pins[i] / layout->pinsPerBank;
+                    if (pins[i] < 0 || index >= layout->bankCount)
+                    {
+                        outsideLayout = true;
+                        invalidPin = pins[i];
+                        bankSlot[i] = 0;
+                        bit[i] = 0;
+                        continue;
+                    }
+                    int slot = 0;
+                    while (slot < bankCount && banks[slot].index != index)
+                    {
+                        slot++;
+                    }
+                    if (slot == bankCount && bankCount < GPIO_MMAP_MAX_BANKS)
+                    {
+                        banks[bankCount].index = index;
+                        banks[bankCount].regs = nullptr;
+                        banks[bankCount].owned = false;
+                        banks[bankCount].pinMask = 0;
+                        bankCount++;
+                    }
+                    bankSlot[i] = slot;
+                    bit[i] = pins[i] % layout->pinsPerBank;
+                    banks[slot].pinMask |= 1u << bit[i];
+                }
+            }
+
+            ~MmapGroup() override
+            {
+                for (int b = 0; b < bankCount; ++b)
+                {
+                    if (banks[b].owned)
+                    {
+                        munmap((void *)banks[b].regs, layout->mapSize);
+                    }
+                }
+            }
+
+            Status_t init(int direction) override
+            {
+                if (outsideLayout)
+                {
+                    LOG_ERROR("GPIO_%d is outside the %s GPIO banks.\n", invalidPin, layout->name);
+                    return FAILED;
+                }
+                if (injected != nullptr && bankCount > 1)
+                {
+                    LOG_ERROR("A pre-mapped GPIO bank cannot serve pins from %d banks.\n", bankCount);
+                    return FAILED;
+                }
+                for (int b = 0; b < bankCount; ++b)
+                {
+                    if (banks[b].regs != nullptr)
+                    {
+                        continue;
+                    }
+                    if (injected != nullptr)
+                    {
+                        banks[b].regs = injected;
+                        continue;
+                    }
+                    banks[b].regs = mapGPIOBank(layout, path, banks[b].index);
+                    if (banks[b].regs == nullptr)
+                    {
+                        return FAILED;
+                    }
+                    banks[b].owned = true;
+                }
+                return setDirection(direction);
+            }
+
+            int read(uint64_t &bits) override
+            {
+                uint32_t levels[GPIO_MMAP_MAX_BANKS];
+                for (int b = 0; b < bankCount; ++b)
+                {
+                    if (banks[b].regs == nullptr)
+                    {
+                        return ERROR;
+                    }
+                    levels[b] = reg(b, layout->dataInOffset);
+                }
+                bits = 0;
+                for (int i = 0; i < count; ++i)
+                {
+                    bits |= (uint64_t)((levels[bankSlot[i]] >> bit[i]) & 1u) << i;
+                }
+                return OK;
+            }
+
+            int write(uint64_t mask, uint64_t bits) override
+            {
+                uint32_t setMask[GPIO_MMAP_MAX_BANKS] = {0};
+                uint32_t clearMask[GPIO_MMAP_MAX_BANKS] = {0};
+                for (int i = 0; i < count; ++i)
+                {
+                    if (mask & (1ULL << i))
+                    {
+                        uint32_t &target = (bits & (1ULL << i)) ? setMask[bankSlot[i]] : clearMask[bankSlot[i]];
+                        target |= 1u << bit[i];
+                    }
+                }
+                for (int b = 0; b < bankCount; ++b)
+                {
+                    if (banks[b].regs == nullptr)
+                    {
+                        return ERROR;
+                    }
+                    if (layout->setOffset != 0 && layout->clearOffset != 0)
+                    {
+                        if (setMask[b] != 0)
+                        {
+                            reg(b, layout->setOffset) = setMask[b];
+                        }
+                        if (clearMask[b] != 0)
+                        {
+                            reg(b, layout->clearOffset) = clearMask[b];
+                        }
+                    }
+                    else if ((setMask[b] | clearMask[b]) != 0)
+                    {
+                        reg(b, layout->dataOutOffset) = (reg(b, layout->dataOutOffset) & ~clearMask[b]) | setMask[b];
+                    }
+                }
+                return OK;
+            }
+
+            Status_t setDirection(int direction) override
+            {
+                bool setBit = (direction == INPUT) == layout->oeSetMeansInput;
+                for (int b = 0; b < bankCount; ++b)
+                {
+                    if (banks[b].regs == nullptr)
+                    {
+                        return FAILED;
+                    }
+                    if (setBit)
+                    {
+                        reg(b, layout->oeOffset) |= banks[b].pinMask;
+                    }
+                    else
+                    {
+                        reg(b, layout->oeOffset) &= ~banks[b].pinMask;
+                    }
+                }
+                return SUCCESS;
+            }
+
+            void close() override
+            {
+            }
+
+        private:
+            struct Bank
+            {
+                unsigned int index;     ///< bank number in the layout
+                volatile uint32_t *regs; ///< mapped registers
+                bool owned;             ///< mapped here, unmapped in the destructor
+                uint32_t pinMask;       ///< bits of group pins in this bank
+            };
+
+            volatile uint32_t &reg(int b, unsigned int offset) { return banks[b].regs[offset / sizeof(uint32_t)]; }
+
+            const GPIORegisterLayout *layout;
+            const char *path;
+            volatile uint32_t *injected;
+            int count;
+            Bank banks[GPIO_MMAP_MAX_BANKS];
+            int bankCount;
+            bool outsideLayout; ///< a pin is not in any bank of the layout
+            int invalidPin;
+            int bankSlot[GPIO_GROUP_MAX_PINS]; ///< bank of pin i
+            unsigned int bit[GPIO_GROUP_MAX_PINS]; ///< bit of pin i inside its bank
+        };
+
+        /**
+         * @brief Creates the group backend selected by the configuration.
+         */
+        GPIOGroupBackend *createGroupBackend(const int *pins, int count, const GPIOConfig &config)
+        {
+            if (config.backend == Backend::Chardev)
+            {
+                return new CdevGroup(pins, count, config);
+            }
+            if (config.backend == Backend::Mmap)
+            {
+                return new MmapGroup(pins, count, config);
+            }
+            return new SysfsGroup(pins, count, config);
+        }
+    } // namespace
+
+    /**
+     * @brief Opens a group of pins with a common direction.
+     * @param pinNumbers GPIO numbers (line offsets for the chardev backend); pin i maps to mask bit i.
+     * @param pinCount Number of pins, at most GPIO_GROUP_MAX_PINS.
+     * @param direction INPUT or OUTPUT.
+     * @param config Backend selection and options; the sysfs backend always uses persistent fds.
+     */
+    GPIOGroup::GPIOGroup(const int *pinNumbers, int pinCount, int direction, const GPIOConfig &config)
+        : count(pinCount), direction(direction), config(config)
+    {
+        if (count > GPIO_GROUP_MAX_PINS)
+        {
+            LOG_ERROR("GPIO group limited to %d pins, %d requested.\n", GPIO_GROUP_MAX_PINS, count);
+            count = GPIO_GROUP_MAX_PINS;
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            pins[i] = pinNumbers[i];
+        }
+        backend.reset(createGroupBackend(pins, count, config));
+        if (init() != SUCCESS)
+        {
+            LOG_ERROR("Failed to initialize GPIO group.\n");
+        }
+    }
+
+    /**
+     * @brief Releases the pins.
+     */
+    GPIOGroup::~GPIOGroup()
+    {
+        close();
+    }
+
+    /**
+     * @brief Exports/requests/maps the pins and sets their direction.
+     * @return SUCCESS or FAILED.
+     */
+    Status_t GPIOGroup::init()
+    {
+        return backend->init(direction);
+    }
+
+    /**
+     * @brief Samples every pin of the group and records the pass latency.
+     * @param bits Receives the levels; bit i is pin i.
+     * @return OK or ERROR.
+     */
+    int GPIOGroup::read(uint64_t &bits)
+    {
+        unsigned long long start = monotonicNs();
+        int result = backend->read(bits);
+        unsigned long long elapsed = monotonicNs() - start;
+
+        GPIOStats &stats = backend->getStats();
+        stats.polls++;
+        stats.pollNsTotal += elapsed;
+        if (elapsed > stats.pollNsMax)
+        {
+            stats.pollNsMax = elapsed;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Drives several pins at once.
+     * @param mask Pins to change; bit i is pin i.
+     * @param bits New levels for the selected pins.
+     * @return OK or ERROR.
+     */
+    int GPIOGroup::write(uint64_t mask, uint64_t bits)
+    {
+        return backend->write(mask, bits);
+    }
+
+    /**
+     * @brief Switches the direction of every pin of the group.
+     * @return SUCCESS or FAILED.
+     */
+    Status_t GPIOGroup::setDirection(int newDirection)
+    {
+        if (direction == newDirection)
+        {
+            return SUCCESS;
+        }
+        if (backend->setDirection(newDirection) == FAILED)
+        {
+            return FAILED;
+        }
+        direction = newDirection;
+        return SUCCESS;
+    }
+
+    /**
+     * @brief Closes the value fds or releases the line request.
+     */
+    void GPIOGroup::close()
+    {
+        backend->close();
+    }
+} // namespace Periferia
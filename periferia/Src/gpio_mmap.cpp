@@ -0,0 +1,200 @@
+#include "../Inc/gpio_mmap.h"
+#include "../../common/Inc/Log.h"
+#include <sys/mman.h>
+
+namespace Periferia
+{
+    const GPIORegisterLayout AM335X_GPIO_LAYOUT = {
+        "am335x",
+        {0x44E07000ULL, 0x4804C000ULL, 0x481AC000ULL, 0x481AE000ULL},
+        4,      // banks
+        32,     // pins per bank
+        0x1000, // map size
+        0x134,  // GPIO_OE
+        true,   // OE bit set = input
+        0x138,  // GPIO_DATAIN
+        0x13C,  // GPIO_DATAOUT
+        0x194,  // GPIO_SETDATAOUT
+        0x190,  // GPIO_CLEARDATAOUT
+    };
+
+    /**
+     * @brief Maps the registers of one GPIO bank.
+     *
+     * /dev/mem is addressed physically, so the bank is mapped at its base
+     * address. A restricted device such as /dev/gpiomem only exposes the
+     * GPIO registers and starts them at offset 0.
+     *
+     * @param layout Register layout of the SoC.
+     * @param memPath Device giving access to the GPIO banks.
+     * @param bankIndex Bank number.
+     * @return The mapped bank, or nullptr on failure.
+     */
+    volatile uint32_t *mapGPIOBank(const GPIORegisterLayout *layout, const char *memPath, unsigned int bankIndex)
+    {
+        if (bankIndex >= layout->bankCount)
+        {
+            LOG_ERROR("GPIO bank %u is outside the %s GPIO banks.\n", bankIndex, layout->name);
+            return nullptr;
+        }
+
+        int mem_fd = ::open(memPath, O_RDWR | O_SYNC);
+        if (mem_fd == ERROR)
+        {
+            LOG_ERROR("Error opening %s: %s\n", memPath, strerror(errno));
+            return nullptr;
+        }
+        off_t offset = strcmp(memPath, GPIO_MEM_PATH) == 0 ? (off_t)layout->bankBase[bankIndex] : 0;
+        void *mapping = mmap(nullptr, layout->mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, offset);
+        ::close(mem_fd);
+        if (mapping == MAP_FAILED)
+        {
+            LOG_ERROR("Error mapping GPIO bank %u: %s\n", bankIndex, strerror(errno));
+            return nullptr;
+        }
+        return (volatile uint32_t *)mapping;
+    }
+
+    /**
+     * @brief Constructs an mmap backend. The bank is mapped in init().
+     * @param pinNumber Global GPIO number (bank * pinsPerBank + bit).
+     * @param layout Register layout of the SoC.
+     * @param memPath Device giving access to the GPIO banks.
+     * @param registers Pre-mapped bank to use instead of mapping memPath, or nullptr.
+     */
+    MmapBackend::MmapBackend(int pinNumber, const GPIORegisterLayout *layout, const char *memPath,
+                             volatile uint32_t *registers)
+        : pin(pinNumber), layout(layout), path(memPath), bank(registers), ownsMapping(false),
+          mask(1u << (pinNumber % layout->pinsPerBank))
+    {
+    }
+
+    /**
+     * @brief Unmaps the bank if this backend mapped it.
+     */
+    MmapBackend::~MmapBackend()
+    {
+        if (ownsMapping)
+        {
+            munmap((void *)bank, layout->mapSize);
+        }
+    }
+
+    /**
+     * @brief Maps the bank holding the pin and sets its direction.
+     * @param direction INPUT or OUTPUT.
+     * @return SUCCESS or FAILED.
+     */
+    Status_t MmapBackend::init(int direction)
+    {
+        if (bank == nullptr)
+        {
+            bank = mapGPIOBank(layout, path, pin / layout->pinsPerBank);
+            if (bank == nullptr)
+            {
+                return FAILED;
+            }
+            ownsMapping = true;
+        }
+        return setDirection(direction);
+    }
+
+    /**
+     * @brief The mapping stays valid for the lifetime of the backend.
+     * @return OK once the bank is mapped, ERROR otherwise.
+     */
+    int MmapBackend::open(int flag)
+    {
+        (void)flag;
+        return (bank == nullptr) ? ERROR : OK;
+    }
+
+    /**
+     * @brief Drives the pin with a single store to the set or clear register.
+     * @return OK or ERROR.
+     */
+    int MmapBackend::write(int value)
+    {
+        if (bank == nullptr)
+        {
+            return ERROR;
+        }
+        if (layout->setOffset != 0 && layout->clearOffset != 0)
+        {
+            reg(value == HIGH ? layout->setOffset : layout->clearOffset) = mask;
+        }
+        else if (value == HIGH)
+        {
+            reg(layout->dataOutOffset) |= mask;
+        }
+        else
+        {
+            reg(layout->dataOutOffset) &= ~mask;
+        }
+        return OK;
+    }
+
+    /**
+     * @brief Samples the pin with a single load from the data-in register.
+     * @return 0, 1 or ERROR.
+     */
+    int MmapBackend::read()
+    {
+        if (bank == nullptr)
+        {
+            return ERROR;
+        }
+        return (reg(layout->dataInOffset) & mask) ? HIGH : LOW;
+    }
+
+    /**
+     * @brief Nothing to release per access; the bank is unmapped by the destructor.
+     */
+    void MmapBackend::close()
+    {
+    }
+
+    /**
+     * @brief Updates the output-enable bit of the pin.
+     * @return SUCCESS or FAILED.
+     */
+    Status_t MmapBackend::setDirection(int direction)
+    {
+        if (bank == nullptr)
+        {
+            return FAILED;
+        }
+        bool setBit = (direction == INPUT) == layout->oeSetMeansInput;
+        if (setBit)
+        {
+            reg(layout->oeOffset) |= mask;
+        }
+        else
+        {
+            reg(layout->oeOffset) &= ~mask;
+        }
+        return SUCCESS;
+    }
+
+    /**
+     * @brief Edge interrupts are not reachable through the register mapping.
+     * @return FAILED.
+     */
+    Status_t MmapBackend::setEdge(Edge edge)
+    {
+        (void)edge;
+        LOG_ERROR("Edge events need the sysfs or chardev GPIO backend.\n");
+        return FAILED;
+    }
+
+    /**
+     * @brief Edge interrupts are not reachable through the register mapping.
+     * @return ERROR.
+     */
+    int MmapBackend::waitEdge(EdgeEvent &event, int timeoutMs)
+    {
+        (void)event;
+        (void)timeoutMs;
+        return ERROR;
+    }
+} // namespace Periferia
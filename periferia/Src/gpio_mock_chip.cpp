@@ -0,0 +1,233 @@
+#include "../Inc/gpio_mock_chip.h"
+#include "../../common/Inc/Log.h"
+
+namespace Periferia
+{
+    /**
+     * @brief Constructs a chip with all lines low, unrequested and unconfigured.
+     */
+    MockGPIOChip::MockGPIOChip() : calls(0)
+    {
+        memset(requests, 0, sizeof(requests));
+        for (int i = 0; i < MOCK_CHIP_LINES; ++i)
+        {
+            levels[i] = LOW;
+            flags[i] = 0;
+            owner[i] = ERROR;
+        }
+    }
+
+    /**
+     * @brief Returns the request slot for a handle, or nullptr if it is not in use.
+     */
+    MockGPIOChip::Request *MockGPIOChip::lookup(int request)
+    {
+        if (request < 0 || request >= MOCK_CHIP_REQUESTS || !requests[request].used)
+        {
+            return nullptr;
+        }
+        return &requests[request];
+    }
+
+    /**
+     * @brief Claims free lines; fails with EBUSY semantics if one is already requested.
+     * @return Request handle (slot index) or ERROR.
+     */
+    int MockGPIOChip::requestLines(const unsigned int *offsets, int count, uint64_t lineFlags)
+    {
+        calls++;
+        if (count <= 0 || count > MOCK_CHIP_LINES)
+        {
+            return ERROR;
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            if (offsets[i] >= MOCK_CHIP_LINES || owner[offsets[i]] != ERROR)
+            {
+                LOG_ERROR("Mock GPIO line %u unavailable.\n", offsets[i]);
+                return ERROR;
+            }
+        }
+        for (int slot = 0; slot < MOCK_CHIP_REQUESTS; ++slot)
+        {
+            if (!requests[slot].used)
+            {
+                Request &req = requests[slot];
+                memset(&req, 0, sizeof(req));
+                req.used = true;
+                req.count = count;
+                for (int i = 0; i < count; ++i)
+                {
+                    req.offsets[i] = offsets[i];
+                    owner[offsets[i]] = slot;
+                    flags[offsets[i]] = lineFlags;
+                }
+                return slot;
+            }
+        }
+        return ERROR;
+    }
+
+    /**
+     * @brief Frees the lines of a request and drops its queued events.
+     */
+    void MockGPIOChip::releaseLines(int request)
+    {
+        calls++;
+        Request *req = lookup(request);
+        if (req == nullptr)
+        {
+            return;
+        }
+        for (int i = 0; i < req->count; ++i)
+        {
+            owner[req->offsets[i]] = ERROR;
+            flags[req->offsets[i]] = 0;
+        }
+        req->used = false;
+    }
+
+    /**
+     * @brief Applies new flags to every line of the request.
+     * @return SUCCESS or FAILED.
+     */
+    Status_t MockGPIOChip::setConfig(int request, uint64_t lineFlags)
+    {
+        calls++;
+        Request *req = lookup(request);
+        if (req == nullptr)
+        {
+            return FAILED;
+        }
+        for (int i = 0; i < req->count; ++i)
+        {
+            flags[req->offsets[i]] = lineFlags;
+        }
+        return SUCCESS;
+    }
+
+    /**
+     * @brief Reports the masked line levels.
+     * @return OK or ERROR.
+     */
+    int MockGPIOChip::getValues(int request, uint64_t mask, uint64_t &bits)
+    {
+        calls++;
+        Request *req = lookup(request);
+        if (req == nullptr)
+        {
+            return ERROR;
+        }
+        bits = 0;
+        for (int i = 0; i < req->count; ++i)
+        {
+            if ((mask & (1ULL << i)) && levels[req->offsets[i]] == HIGH)
+            {
+                bits |= 1ULL << i;
+            }
+        }
+        return OK;
+    }
+
+    /**
+     * @brief Drives the masked lines; only lines configured as outputs change.
+     * @return OK or ERROR.
+     */
+    int MockGPIOChip::setValues(int request, uint64_t mask, uint64_t bits)
+    {
+        calls++;
+        Request *req = lookup(request);
+        if (req == nullptr)
+        {
+            return ERROR;
+        }
+        for (int i = 0; i < req->count; ++i)
+        {
+            unsigned int offset = req->offsets[i];
+            if ((mask & (1ULL << i)) && (flags[offset] & GPIO_V2_LINE_FLAG_OUTPUT))
+            {
+                levels[offset] = (bits & (1ULL << i)) ? HIGH : LOW;
+            }
+        }
+        return OK;
+    }
+
+    /**
+     * @brief Reports whether events are queued; never sleeps.
+     * @return 1 if events are queued, 0 otherwise, ERROR for a bad handle.
+     */
+    int MockGPIOChip::waitEvents(int request, int timeoutMs)
+    {
+        (void)timeoutMs;
+        calls++;
+        Request *req = lookup(request);
+        if (req == nullptr)
+        {
+            return ERROR;
+        }
+        return (req->queued > 0) ? 1 : 0;
+    }
+
+    /**
+     * @brief Drains queued events in order.
+     * @return Number of events copied, or ERROR.
+     */
+    int MockGPIOChip::readEvents(int request, struct gpio_v2_line_event *events, int maxEvents)
+    {
+        calls++;
+        Request *req = lookup(request);
+        if (req == nullptr)
+        {
+            return ERROR;
+        }
+        int count = 0;
+        while (count < maxEvents && req->queued > 0)
+        {
+            events[count++] = req->events[req->head];
+            req->head = (req->head + 1) % MOCK_CHIP_EVENTS;
+            req->queued--;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Simulates the outside world changing a line.
+     *
+     * The event is queued only if the line is requested with the matching
+     * GPIO_V2_LINE_FLAG_EDGE_* flag. When the queue is full the oldest event
+     * is dropped, as the kernel does on overflow.
+     *
+     * @param offset Line offset on the chip.
+     * @param timestampNs Event timestamp reported to the reader.
+     * @param value New level.
+     */
+    void MockGPIOChip::pushEdge(unsigned int offset, unsigned long long timestampNs, int value)
+    {
+        if (offset >= MOCK_CHIP_LINES || levels[offset] == value)
+        {
+            return;
+        }
+        levels[offset] = value;
+
+        uint64_t edgeFlag = (value == HIGH) ? GPIO_V2_LINE_FLAG_EDGE_RISING : GPIO_V2_LINE_FLAG_EDGE_FALLING;
+        Request *req = lookup(owner[offset]);
+        if (req == nullptr || !(flags[offset] & edgeFlag))
+        {
+            return;
+        }
+
+        if (req->queued == MOCK_CHIP_EVENTS)
+        {
+            req->head = (req->head + 1) % MOCK_CHIP_EVENTS;
+            req->queued--;
+        }
+        struct gpio_v2_line_event &event = req->events[(req->head + req->queued) % MOCK_CHIP_EVENTS];
+        memset(&event, 0, sizeof(event));
+        event.timestamp_ns = timestampNs;
+        event.id = (value == HIGH) ? GPIO_V2_LINE_EVENT_RISING_EDGE : GPIO_V2_LINE_EVENT_FALLING_EDGE;
+        event.offset = offset;
+        event.seqno = ++req->seqno;
+        event.line_seqno = req->seqno;
+        req->queued++;
+    }
+} // namespace Periferia
@@ -0,0 +1,274 @@
+#include "../Inc/gpio_setup.h"
+#include "../../common/Inc/Log.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Periferia
+{
+    namespace
+    {
+        struct PreparedEntry
+        {
+            std::string root;
+            int pin;
+            PreparedPin prepared;
+        };
+
+        // Pins configured by setupPins() and not claimed yet
+        std::mutex preparedLock;
+        std::vector<PreparedEntry> preparedPins;
+
+        void closePrepared(const PreparedPin &prepared)
+        {
+            if (prepared.directionFd >= 0)
+            {
+                ::close(prepared.directionFd);
+            }
+            if (prepared.valueFd >= 0)
+            {
+                ::close(prepared.valueFd);
+            }
+        }
+
+        /**
+         * @brief Stores the descriptors of a configured pin, replacing older ones of the same pin.
+         */
+        void storePrepared(const char *sysfsRoot, int pin, const PreparedPin &prepared)
+        {
+            std::lock_guard<std::mutex> guard(preparedLock);
+            for (PreparedEntry &entry : preparedPins)
+            {
+                if (entry.pin == pin && entry.root == sysfsRoot)
+                {
+                    closePrepared(entry.prepared);
+                    entry.prepared = prepared;
+                    return;
+                }
+            }
+            preparedPins.push_back(PreparedEntry{sysfsRoot, pin, prepared});
+        }
+
+        /**
+         * @brief Opens the direction and value files of a settled pin and writes its direction.
+         */
+        bool configurePin(const char *sysfsRoot, const GPIOPinSetup &setup)
+        {
+            char path[MAX_PATH];
+            PreparedPin prepared;
+            prepared.direction = setup.direction;
+            snprintf(path, MAX_PATH, "%s/gpio%d/direction", sysfsRoot, setup.pin);
+            prepared.directionFd = ::open(path, O_WRONLY | O_CLOEXEC);
+            snprintf(path, MAX_PATH, "%s/gpio%d/value", sysfsRoot, setup.pin);
+            prepared.valueFd = ::open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+
+            const char *dirStr = (setup.direction == INPUT) ? "in" : "out";
+            if (prepared.directionFd < 0 || prepared.valueFd < 0 ||
+                ::write(prepared.directionFd, dirStr, strlen(dirStr)) == ERROR)
+            {
+                LOG_ERROR("Cannot configure GPIO_%d: %s\n", setup.pin, strerror(errno));
+                closePrepared(prepared);
+                return false;
+            }
+            storePrepared(sysfsRoot, setup.pin, prepared);
+            return true;
+        }
+
+        /**
+         * @brief True once the direction file of the pin is writable.
+         */
+        bool isSettled(const char *sysfsRoot, int pin)
+        {
+            char path[MAX_PATH];
+            snprintf(path, MAX_PATH, "%s/gpio%d/direction", sysfsRoot, pin);
+            return access(path, W_OK) == 0;
+        }
+    } // namespace
+
+    /**
+     * @brief Writes a pin number to the export file.
+     *
+     * The number is newline-terminated so back-to-back requests on one
+     * descriptor stay separate. EBUSY means another process exported the
+     * pin in the meantime, which is fine.
+     *
+     * @param exportFd Open export file.
+     * @param pin GPIO number.
+     * @return SUCCESS if the pin is exported or being exported, FAILED otherwise.
+     */
+    Status_t writeExport(int exportFd, int pin)
+    {
+        char pinBuffer[16];
+        int length = snprintf(pinBuffer, sizeof(pinBuffer), "%d\n", pin);
+        if (::write(exportFd, pinBuffer, length) == ERROR && errno != EBUSY)
+        {
+            LOG_ERROR("Error writing pin number to export: %s\n", strerror(errno));
+            return FAILED;
+        }
+        LOG_DEBUG("Exported GPIO_%d.\n", pin);
+        return SUCCESS;
+    }
+
+    /**
+     * @brief Waits for udev to finish with a freshly exported pin.
+     *
+     * The kernel creates gpioN/ during the export write, but udev rules
+     * that hand the files to the gpio group run afterwards; until then the
+     * direction file cannot be opened by an unprivileged daemon.
+     *
+     * @param sysfsRoot Root of the gpio class tree.
+     * @param pin GPIO number.
+     * @param timeoutMs Longest wait.
+     * @return true once the direction file is writable, false on timeout.
+     */
+    bool waitForExport(const char *sysfsRoot, int pin, int timeoutMs)
+    {
+        unsigned long long deadline = monotonicNs() + timeoutMs * 1000000ULL;
+        while (!isSettled(sysfsRoot, pin))
+        {
+            if (monotonicNs() >= deadline)
+            {
+                LOG_ERROR("GPIO_%d not writable %d ms after export.\n", pin, timeoutMs);
+                return false;
+            }
+            usleep(GPIO_SETTLE_POLL_US);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Exports and configures many sysfs pins in one pass.
+     *
+     * Exporting one pin at a time serializes the udev round trip of every
+     * pin. Here all export requests go out first, on one descriptor, and
+     * the pins settle concurrently; each is configured (direction written,
+     * direction and value files opened) as soon as it becomes writable.
+     * The open descriptors are kept for the GPIO objects created later for
+     * these pins, whose init() then costs no syscalls when the direction
+     * matches.
+     *
+     * @param pins Pins and their initial directions.
+     * @param count Number of pins.
+     * @param sysfsRoot Root of the gpio class tree.
+     * @param report Receives counts and timings, may be nullptr.
+     * @param settleTimeoutMs Longest wait for the pins to settle, from the last export request.
+     * @return SUCCESS if every pin was configured, FAILED otherwise.
+     */
+    Status_t setupPins(const GPIOPinSetup *pins, int count, const char *sysfsRoot, GPIOSetupReport *report,
+                       int settleTimeoutMs)
+    {
+        GPIOSetupReport local;
+        GPIOSetupReport &result = (report != nullptr) ? *report : local;
+        result = GPIOSetupReport();
+        unsigned long long start = monotonicNs();
+
+        std::vector<int> pending;
+        pending.reserve(count);
+        int exportFd = -1;
+        char path[MAX_PATH];
+        for (int i = 0; i < count; ++i)
+        {
+            snprintf(path, MAX_PATH, "%s/gpio%d", sysfsRoot, pins[i].pin);
+            if (access(path, F_OK) == 0)
+            {
+                result.alreadyExported++;
+                pending.push_back(i);
+                continue;
+            }
+            if (exportFd < 0)
+            {
+                snprintf(path, MAX_PATH, "%s/export", sysfsRoot);
+                exportFd = ::open(path, O_WRONLY | O_CLOEXEC);
+                if (exportFd < 0)
+                {
+                    LOG_ERROR("Error opening GPIO export: %s\n", strerror(errno));
+                    result.failed = count;
+                    result.totalNs = monotonicNs() - start;
+                    return FAILED;
+                }
+            }
+            if (writeExport(exportFd, pins[i].pin) == FAILED)
+            {
+                result.failed++;
+                continue;
+            }
+            result.exported++;
+            pending.push_back(i);
+        }
+        if (exportFd >= 0)
+        {
+            ::close(exportFd);
+        }
+        unsigned long long exported = monotonicNs();
+        result.exportNs = exported - start;
+
+        unsigned long long deadline = exported + settleTimeoutMs * 1000000ULL;
+        while (!pending.empty())
+        {
+            size_t kept = 0;
+            for (int index : pending)
+            {
+                if (!isSettled(sysfsRoot, pins[index].pin))
+                {
+                    pending[kept++] = index;
+                }
+                else if (!configurePin(sysfsRoot, pins[index]))
+                {
+                    result.failed++;
+                }
+            }
+            pending.resize(kept);
+            if (pending.empty())
+            {
+                break;
+            }
+            if (monotonicNs() >= deadline)
+            {
+                LOG_ERROR("%zu GPIO pins not writable %d ms after export.\n", pending.size(), settleTimeoutMs);
+                result.failed += (int)pending.size();
+                break;
+            }
+            usleep(GPIO_SETTLE_POLL_US);
+        }
+        unsigned long long end = monotonicNs();
+        result.settleNs = end - exported;
+        result.totalNs = end - start;
+        return (result.failed == 0) ? SUCCESS : FAILED;
+    }
+
+    /**
+     * @brief Hands the descriptors prepared by setupPins() to the caller, who then owns them.
+     * @param sysfsRoot Root the pin was set up under.
+     * @param pin GPIO number.
+     * @param prepared Receives the descriptors and the direction written.
+     * @return true if the pin was prepared and not claimed before.
+     */
+    bool claimPreparedPin(const char *sysfsRoot, int pin, PreparedPin &prepared)
+    {
+        std::lock_guard<std::mutex> guard(preparedLock);
+        for (size_t i = 0; i < preparedPins.size(); ++i)
+        {
+            if (preparedPins[i].pin == pin && preparedPins[i].root == sysfsRoot)
+            {
+                prepared = preparedPins[i].prepared;
+                preparedPins[i] = preparedPins.back();
+                preparedPins.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Closes the descriptors of every prepared pin that was not claimed.
+     */
+    void releasePreparedPins()
+    {
+        std::lock_guard<std::mutex> guard(preparedLock);
+        for (const PreparedEntry &entry : preparedPins)
+        {
+            closePrepared(entry.prepared);
+        }
+        preparedPins.clear();
+    }
+} // namespace Periferia
@@ -0,0 +1,231 @@
+#include "../Inc/gpio_sim.h"
+#include "../../common/Inc/Log.h"
+#include <cerrno>
+
+namespace Periferia
+{
+    /**
+     * @brief Sleeps until an absolute CLOCK_MONOTONIC time.
+     */
+    static void sleepUntil(unsigned long long deadlineNs)
+    {
+        struct timespec ts;
+        ts.tv_sec = deadlineNs / 1000000000ULL;
+        ts.tv_nsec = deadlineNs % 1000000000ULL;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+        {
+        }
+    }
+
+    /**
+     * @brief Constructs a simulated line with a device attached.
+     * @param device Model that answers start signals, not owned.
+     * @param instantEdges true to hand out edge events without waiting for their timestamps.
+     */
+    SimBackend::SimBackend(SimDevice *device, bool instantEdges)
+        : device(device), instantEdges(instantEdges), direction(INPUT), driven(HIGH), lowSinceNs(0), lowNs(0),
+          releaseNs(0), edge(Edge::None), answerCount(0), levelCursor(0), edgeCursor(0), transactions(0)
+    {
+    }
+
+    /**
+     * @brief Sets the initial direction; there is nothing to export or request.
+     * @return SUCCESS.
+     */
+    Status_t SimBackend::init(int initialDirection)
+    {
+        direction = initialDirection;
+        return SUCCESS;
+    }
+
+    /**
+     * @brief The simulated line is always open.
+     * @return OK.
+     */
+    int SimBackend::open(int flag)
+    {
+        (void)flag;
+        return OK;
+    }
+
+    /**
+     * @brief Drives the line and records the host's low pulse.
+     * @return OK, or ERROR if the line is an input.
+     */
+    int SimBackend::write(int value)
+    {
+        if (direction != OUTPUT)
+        {
+            return ERROR;
+        }
+        unsigned long long now = monotonicNs();
+        if (value == LOW && driven == HIGH)
+        {
+            lowSinceNs = now;
+        }
+        else if (value == HIGH && driven == LOW)
+        {
+            lowNs = lowSinceNs;
+            releaseNs = now;
+        }
+        driven = (value == HIGH) ? HIGH : LOW;
+        return OK;
+    }
+
+    /**
+     * @brief Returns the driven level, or the device waveform at the current time.
+     * @return 0 or 1; the idle line reads high (pull-up).
+     */
+    int SimBackend::read()
+    {
+        if (direction == OUTPUT)
+        {
+            return driven;
+        }
+        unsigned long long now = monotonicNs();
+        while (levelCursor < answerCount && answer[levelCursor].timestampNs <= now)
+        {
+            levelCursor++;
+        }
+        return (levelCursor == 0) ? HIGH : answer[levelCursor - 1].value;
+    }
+
+    /**
+     * @brief Nothing to release.
+     */
+    void SimBackend::close()
+    {
+    }
+
+    /**
+     * @brief Switches direction; releasing the line after a start pulse triggers the device.
+     * @return SUCCESS.
+     */
+    Status_t SimBackend::setDirection(int newDirection)
+    {
+        unsigned long long now = monotonicNs();
+        if (newDirection == OUTPUT)
+        {
+            answerCount = 0;
+            levelCursor = 0;
+            edgeCursor = 0;
+        }
+        else if (direction == OUTPUT)
+        {
+            if (driven == LOW)
+            {
+                lowNs = lowSinceNs;
+                releaseNs = now;
+            }
+            if (releaseNs > lowNs && releaseNs - lowNs >= SIM_MIN_START_US * 1000ULL)
+            {
+                startAnswer(now);
+            }
+            lowNs = 0;
+            releaseNs = 0;
+        }
+        direction = newDirection;
+        return SUCCESS;
+    }
+
+    /**
+     * @brief Selects reported edges; edges already on the line are not reported.
+     * @return SUCCESS.
+     */
+    Status_t SimBackend::setEdge(Edge newEdge)
+    {
+        edge = newEdge;
+        unsigned long long now = monotonicNs();
+        while (edgeCursor < answerCount && answer[edgeCursor].timestampNs < now)
+        {
+            edgeCursor++;
+        }
+        return SUCCESS;
+    }
+
+    /**
+     * @brief Waits for a single edge.
+     * @return OK, 0 on timeout, ERROR if edges are disabled.
+     */
+    int SimBackend::waitEdge(EdgeEvent &event, int timeoutMs)
+    {
+        int result = readEdges(&event, 1, timeoutMs);
+        return (result > 0) ? OK : result;
+    }
+
+    /**
+     * @brief Returns the next selected edges of the device waveform.
+     *
+     * In real-time mode the call sleeps until the first pending edge is due
+     * and returns every edge due by then; in instant mode pending edges are
+     * returned at once.
+     *
+     * @return Number of events, 0 on timeout or when the answer is over, ERROR if edges are disabled.
+     */
+    int SimBackend::readEdges(EdgeEvent *events, int maxEvents, int timeoutMs)
+    {
+        if (edge == Edge::None)
+        {
+            LOG_ERROR("Simulated GPIO: edge events are not enabled.\n");
+            return ERROR;
+        }
+
+        int count = 0;
+        while (count < maxEvents)
+        {
+            while (edgeCursor < answerCount && !edgeWanted(answer[edgeCursor].value))
+            {
+                edgeCursor++;
+            }
+            if (edgeCursor == answerCount)
+            {
+                break;
+            }
+
+            unsigned long long due = answer[edgeCursor].timestampNs;
+            if (!instantEdges)
+            {
+                unsigned long long now = monotonicNs();
+                if (due > now)
+                {
+                    if (count > 0)
+                    {
+                        break;
+                    }
+                    if (timeoutMs >= 0 && due > now + timeoutMs * 1000000ULL)
+                    {
+                        sleepUntil(now + timeoutMs * 1000000ULL);
+                        return 0;
+                    }
+                    sleepUntil(due);
+                }
+            }
+            events[count++] = answer[edgeCursor++];
+        }
+        if (count == 0 && !instantEdges && timeoutMs > 0)
+        {
+            sleepUntil(monotonicNs() + timeoutMs * 1000000ULL); // line stays idle
+        }
+        return count;
+    }
+
+    /**
+     * @brief Asks the device for its answer to the start pulse just released.
+     */
+    void SimBackend::startAnswer(unsigned long long now)
+    {
+        answerCount = device->respond(lowNs, now, answer, SIM_MAX_EDGES);
+        levelCursor = 0;
+        edgeCursor = 0;
+        transactions++;
+    }
+
+    /**
+     * @brief True if an edge to this level is selected by setEdge().
+     */
+    bool SimBackend::edgeWanted(int value) const
+    {
+        return edge == Edge::Both || (edge == Edge::Rising && value == HIGH) ||
+               (edge == Edge::Falling && value == LOW);
+    }
+} // namespace Periferia
@@ -0,0 +1,429 @@
+#include "../Inc/gpio_sysfs.h"
+#include "../Inc/gpio_setup.h"
+#include "../../common/Inc/Log.h"
+#include <poll.h>
+
+namespace Periferia
+{
+    /**
+     * @brief Constructs a sysfs backend for a pin. No file is touched until init().
+     * @param pinNumber The GPIO pin number.
+     * @param mode Reopen or persistent value access.
+     * @param sysfsRoot Root of the gpio class tree.
+     * @param edgeWakeEvents poll() events that count as an edge.
+     */
+    SysfsBackend::SysfsBackend(int pinNumber, AccessMode mode, const char *sysfsRoot, short edgeWakeEvents)
+        : pin(pinNumber), gpio_fd(-1), direction_fd(-1), edge_fd(-1), currentDirection(ERROR), wantedEdge(Edge::None),
+          armedEdge(Edge::None), mode(mode), root(sysfsRoot), edgeWakeEvents(edgeWakeEvents)
+    {
+    }
+
+    /**
+     * @brief Closes the value, direction and edge files if they are open.
+     */
+    SysfsBackend::~SysfsBackend()
+    {
+        if (gpio_fd != ERROR)
+        {
+            close();
+        }
+        if (direction_fd != ERROR)
+        {
+            ::close(direction_fd);
+        }
+        if (edge_fd != ERROR)
+        {
+            ::close(edge_fd);
+        }
+    }
+
+    /**
+     * @brief Initializes the GPIO pin by exporting it and setting its direction.
+     *
+     * A pin prepared by setupPins() takes over its open descriptors and
+     * direction, so nothing is exported or written when the direction
+     * matches. Otherwise the pin is exported if needed and, once udev has
+     * settled it, its direction is written. In persistent mode the value
+     * file is opened here and kept for the lifetime of the object.
+     *
+     * @param direction INPUT or OUTPUT.
+     * @return SUCCESS if initialization is successful, FAILED otherwise.
+     */
+    Status_t SysfsBackend::init(int direction)
+    {
+        PreparedPin prepared;
+        if (claimPreparedPin(root, pin, prepared))
+        {
+            direction_fd = prepared.directionFd;
+            currentDirection = prepared.direction;
+            if (mode == AccessMode::Persistent && gpio_fd == ERROR)
+            {
+                gpio_fd = prepared.valueFd;
+            }
+            else
+            {
+                ::close(prepared.valueFd);
+            }
+            LOG_DEBUG("GPIO_%d set up in bulk.\n", pin);
+        }
+        else
+        {
+            char gpioPath[MAX_PATH];
+            snprintf(gpioPath, MAX_PATH, "%s/gpio%d", root, pin);
+
+            // Check if the GPIO folder already exists
+            if (access(gpioPath, F_OK) != 0)
+            {
+                // If the folder does not exist, export the GPIO pin
+                char exportPath[MAX_PATH];
+                snprintf(exportPath, MAX_PATH, "%s/export", root);
+                int export_fd = ::open(exportPath, O_WRONLY);
+                if (export_fd == ERROR)
+                {
+                    LOG_ERROR("Error opening GPIO export: %s\n", strerror(errno));
+                    return FAILED;
+                }
+                Status_t exported = writeExport(export_fd, pin);
+                ::close(export_fd);
+                if (exported == FAILED || !waitForExport(root, pin, GPIO_SETTLE_TIMEOUT_MS))
+                {
+                    return FAILED;
+                }
+            }
+            else
+            {
+                LOG_DEBUG("GPIO_%d already exported.\n", pin);
+            }
+        }
+        // Set the direction of the GPIO pin
+        if (setDirection(direction) == FAILED)
+        {
+            return FAILED;
+        }
+
+        if (mode == AccessMode::Persistent && open(O_RDWR) == ERROR)
+        {
+            return FAILED;
+        }
+        return SUCCESS;
+    }
+    /**
+     * @brief Opens the GPIO value file for reading or writing.
+     *
+     * In persistent mode the file is always opened O_RDWR | O_NONBLOCK and
+     * an already open descriptor is returned as is.
+     *
+     * @param flag Open mode (e.g., O_RDONLY or O_WRONLY).
+     * @return File descriptor for the GPIO value file, or -1 if failed.
+     */
+    int SysfsBackend::open(int flag)
+    {
+        if (mode == AccessMode::Persistent)
+        {
+            if (gpio_fd != ERROR)
+            {
+                return gpio_fd;
+            }
+            flag = O_RDWR | O_NONBLOCK;
+        }
+
+        char gpioPath[MAX_PATH];
+        snprintf(gpioPath, MAX_PATH, "%s/gpio%d/value", root, pin);
+        gpio_fd = ::open(gpioPath, flag);
+        stats.syscalls++;
+        if (gpio_fd == ERROR)
+        {
+            LOG_ERROR("Error opening GPIO value file: %s\n", strerror(errno));
+        }
+        return gpio_fd;
+    }
+
+    /**
+     * @brief Writes a value to the GPIO pin.
+     * @param value 1 to drive the pin high, 0 to drive it low.
+     * @return OK on success, ERROR otherwise.
+     */
+    int SysfsBackend::write(int value)
+    {
+        if (mode == AccessMode::Persistent)
+        {
+            if (open(O_RDWR) == ERROR)
+            {
+                LOG_ERROR("Failed to open GPIO pin before writing.\n");
+                return ERROR;
+            }
+            return writeValue(value);
+        }
+
+        if(open(O_WRONLY) == ERROR)
+        {
+            LOG_ERROR("Failed to open GPIO pin before writing.\n");
+            return ERROR;
+        }
+        int result = writeValue(value);
+        close();
+        return result;
+    }
+    /**
+     * @brief Reads the value from the GPIO pin.
+     * @return 1 if the GPIO value is high ('1'), 0 if low ('0').
+     */
+    int SysfsBackend::read()
+    {
+        if (mode == AccessMode::Persistent)
+        {
+            if (open(O_RDWR) == ERROR)
+            {
+                LOG_ERROR("Failed to open GPIO pin before reading\n");
+                return ERROR;
+            }
+            return readValue();
+        }
+
+        if(open(O_RDONLY) == ERROR)
+        {
+            LOG_ERROR("Failed to open GPIO pin before reading\n");
+            return ERROR;
+        }
+        int readValue = this->readValue();
+        close();
+        return readValue;
+    }
+
+    /**
+     * @brief Closes the GPIO pin by closing its file descriptor.
+     */
+    void SysfsBackend::close()
+    {
+        if (gpio_fd != -1)
+        {
+            ::close(gpio_fd);
+            stats.syscalls++;
+            //printf("Closed GPIO pin %d.\n", pin);
+            gpio_fd = -1;
+        }
+    }
+
+    /**
+     * @brief Writes "in" or "out" to the direction file of the pin.
+     *
+     * The direction file is opened once and kept, separate from the value
+     * fd, so a change is a single pwrite(); setting the direction the pin
+     * already has costs nothing. The kernel refuses to drive a line that has
+     * an edge interrupt, so an armed edge is written back to "none" before
+     * the switch to output and the edge selected by setEdge() is re-armed
+     * right after the switch to input.
+     *
+     * @param newDirection INPUT or OUTPUT.
+     * @return SUCCESS if the direction was written, FAILED otherwise.
+     */
+    Status_t SysfsBackend::setDirection(int newDirection)
+    {
+        if (newDirection == currentDirection)
+        {
+            return SUCCESS;
+        }
+        if (direction_fd == ERROR)
+        {
+            char directionPath[MAX_DIRECTION_PATH];
+            snprintf(directionPath, MAX_DIRECTION_PATH, "%s/gpio%d/direction", root, pin);
+            direction_fd = ::open(directionPath, O_WRONLY | O_CLOEXEC);
+            if (direction_fd == ERROR)
+            {
+                LOG_ERROR("Error opening GPIO direction: %s\n", strerror(errno));
+                return FAILED;
+            }
+        }
+        if (newDirection == OUTPUT && armedEdge != Edge::None && writeEdge(Edge::None) == FAILED)
+        {
+            return FAILED;
+        }
+
+        const char *dirStr = (newDirection == INPUT) ? "in" : "out";
+        // Write the direction to the direction file ("in" or "out")
+        if (::pwrite(direction_fd, dirStr, strlen(dirStr), 0) == ERROR)
+        {
+            LOG_ERROR("Error writing direction to GPIO: %s\n", strerror(errno));
+            currentDirection = ERROR;
+            return FAILED;
+        }
+        currentDirection = newDirection;
+        LOG_DEBUG("Set GPIO_%d direction to %s.\n", pin, dirStr);
+        if (newDirection == INPUT && wantedEdge != Edge::None)
+        {
+            return writeEdge(wantedEdge);
+        }
+        return SUCCESS;
+    }
+
+    /**
+     * @brief Selects which level changes make the value file pollable.
+     *
+     * On an input the edge file is written straight away. On an output the
+     * edge is only remembered and armed by the next setDirection(INPUT), so
+     * a caller can select it before releasing the line and pay for a single
+     * pwrite() after the release.
+     *
+     * @param edge Edge::None disables edge notification.
+     * @return SUCCESS if the edge was stored or written, FAILED otherwise.
+     */
+    Status_t SysfsBackend::setEdge(Edge edge)
+    {
+        wantedEdge = edge;
+        if (currentDirection != INPUT || edge == armedEdge)
+        {
+            return SUCCESS;
+        }
+        return writeEdge(edge);
+    }
+
+    /**
+     * @brief Writes the edge file and consumes the pending notification.
+     *
+     * The edge file is opened on first use and kept. After arming, the value
+     * file is read once so the first waitEdge() only returns on a real edge.
+     *
+     * @param edge Edge to arm, Edge::None to disarm.
+     * @return SUCCESS if the edge file was written, FAILED otherwise.
+     */
+    Status_t SysfsBackend::writeEdge(Edge edge)
+    {
+        static const char *const edgeNames[] = {"none", "rising", "falling", "both"};
+        const char *edgeStr = edgeNames[static_cast<int>(edge)];
+
+        if (edge_fd == ERROR)
+        {
+            char edgePath[MAX_PATH];
+            snprintf(edgePath, MAX_PATH, "%s/gpio%d/edge", root, pin);
+            edge_fd = ::open(edgePath, O_WRONLY | O_CLOEXEC);
+            if (edge_fd == ERROR)
+            {
+                LOG_ERROR("Error opening GPIO edge: %s\n", strerror(errno));
+                return FAILED;
+            }
+        }
+        stats.syscalls++;
+        if (::pwrite(edge_fd, edgeStr, strlen(edgeStr), 0) == ERROR)
+        {
+            LOG_ERROR("Error writing edge to GPIO: %s\n", strerror(errno));
+            return FAILED;
+        }
+        armedEdge = edge;
+
+        if (edge != Edge::None && mode == AccessMode::Persistent && open(O_RDWR) != ERROR)
+        {
+            // Clear the pending notification; a pipe stand-in has nothing to clear
+            char discard;
+            ::pread(gpio_fd, &discard, sizeof(discard), 0);
+            stats.syscalls++;
+        }
+        return SUCCESS;
+    }
+
+    /**
+     * @brief Blocks in poll() until the value file reports an edge.
+     *
+     * Requires the persistent access mode: sysfs only delivers POLLPRI on a
+     * descriptor that stays open and is re-read after every wake-up. The
+     * timestamp is taken before the value is read so it stays as close to
+     * the interrupt as userspace allows.
+     *
+     * @param event Filled with the wake-up time and the new level.
+     * @param timeoutMs poll() timeout, negative to wait forever.
+     * @return OK when an edge was seen, 0 on timeout, ERROR on failure.
+     */
+    int SysfsBackend::waitEdge(EdgeEvent &event, int timeoutMs)
+    {
+        if (mode != AccessMode::Persistent || open(O_RDWR) == ERROR)
+        {
+            LOG_ERROR("Edge wait needs a persistent GPIO value fd.\n");
+            return ERROR;
+        }
+
+        struct pollfd pfd;
+        pfd.fd = gpio_fd;
+        pfd.events = edgeWakeEvents;
+        pfd.revents = 0;
+
+        int ready = ::poll(&pfd, 1, timeoutMs);
+        stats.syscalls++;
+        if (ready == ERROR)
+        {
+            LOG_ERROR("Error polling GPIO_%d: %s\n", pin, strerror(errno));
+            return ERROR;
+        }
+        if (ready == 0)
+        {
+            return 0;
+        }
+
+        event.timestampNs = monotonicNs();
+        event.value = readValue();
+        return (event.value == ERROR) ? ERROR : OK;
+    }
+
+    /**
+     * @brief Reads one character from the open value file.
+     *
+     * Persistent descriptors are read with pread() at offset 0 so sysfs
+     * refreshes the value without a reopen or lseek().
+     *
+     * @return 1 for '1', 0 for '0', ERROR otherwise.
+     */
+    int SysfsBackend::readValue()
+    {
+        char value;
+        ssize_t result = (mode == AccessMode::Persistent)
+                             ? ::pread(gpio_fd, &value, sizeof(value), 0)
+                             : ::read(gpio_fd, &value, sizeof(value));
+        stats.syscalls++;
+        if (result == ERROR && errno == ESPIPE)
+        {
+            // Not seekable (pipe standing in for the value file)
+            result = ::read(gpio_fd, &value, sizeof(value));
+            stats.syscalls++;
+        }
+        if (result == ERROR)
+        {
+            LOG_ERROR("Error reading GPIO value: %s\n", strerror(errno));
+            return ERROR;
+        }
+        if (result == 0)
+        {
+            // EOF: nothing was read into value
+            LOG_ERROR("Error reading GPIO value: end of file on GPIO_%d\n", pin);
+            return ERROR;
+        }
+        int readValue = (value == '1') ? 1 : (value == '0' ? 0 : -1);
+        if (readValue == -1)
+        {
+            LOG_WARN("Unexpected value read from GPIO_%d: %d\n", pin, value);
+        }
+        else
+        {
+            LOG_TRACE("Read [%d] from GPIO_%d.\n", readValue, pin);
+        }
+        return readValue;
+    }
+
+    /**
+     * @brief Writes one character to the open value file.
+     * @param value 1 for '1', anything else for '0'.
+     * @return OK on success, ERROR otherwise.
+     */
+    int SysfsBackend::writeValue(int value)
+    {
+        char val_str = (value == 1) ? '1' : '0';
+        ssize_t result = (mode == AccessMode::Persistent)
+                             ? ::pwrite(gpio_fd, &val_str, 1, 0)
+                             : ::write(gpio_fd, &val_str, 1);
+        stats.syscalls++;
+        if (result == ERROR)
+        {
+            LOG_ERROR("Error writing GPIO value : %s\n", strerror(errno));
+            return ERROR;
+        }
+        LOG_TRACE("Wrote value %d to GPIO pin %d.\n", value, pin);
+        return OK;
+    }
+} // namespace Peripheria
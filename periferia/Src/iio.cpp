@@ -0,0 +1,395 @@
+#include "../Inc/iio.h"
+#include "../../common/Inc/Log.h"
+#include <algorithm>
+#include <cstdlib>
+#include <dirent.h>
+#include <poll.h>
+
+// Resolution assumed when the device does not describe the channel in scan_elements
+#define IIO_DEFAULT_BITS 12
+
+namespace Periferia
+{
+    /**
+     * @brief Parses a scan_elements type such as "le:u12/16>>0" or "be:s14/16X2>>2".
+     * @param text Attribute contents.
+     * @param format Parsed format.
+     * @return true on success.
+     */
+    bool parseScanFormat(const char *text, IIOScanFormat &format)
+    {
+        char endian;
+        char sign;
+        unsigned int repeat;
+        if (sscanf(text, "%ce:%c%u/%u>>%u", &endian, &sign, &format.bits, &format.storageBits, &format.shift) != 5 &&
+            sscanf(text, "%ce:%c%u/%uX%u>>%u", &endian, &sign, &format.bits, &format.storageBits, &repeat,
+                   &format.shift) != 6)
+        {
+            return false;
+        }
+        format.bigEndian = (endian == 'b');
+        format.isSigned = (sign == 's');
+        return (endian == 'b' || endian == 'l') && (sign == 's' || sign == 'u') && format.storageBits % 8 == 0 &&
+               format.storageBits > 0 && format.storageBits <= 64 && format.bits <= format.storageBits;
+    }
+
+    /**
+     * @brief Constructs a closed ADC channel. No file is touched until init().
+     * @param config Device, channel, paths and capture mode.
+     */
+    IIOAdc::IIOAdc(const IIOConfig &config)
+        : config(config), rawFd(-1), bufferFd(-1), format(), scale(0.0f), scanBytes(0), channelOffset(0), pending(0)
+    {
+        snprintf(devicePath, sizeof(devicePath), "%s/iio:device%d", config.sysfsRoot, config.device);
+        format.bits = IIO_DEFAULT_BITS;
+        format.storageBits = 16;
+    }
+
+    /**
+     * @brief Stops the buffer and closes the descriptors.
+     */
+    IIOAdc::~IIOAdc()
+    {
+        close();
+    }
+
+    /**
+     * @brief Reads a sysfs attribute of the device.
+     * @param name Path relative to the device directory.
+     * @return true if something was read; value is NUL-terminated without the trailing newline.
+     */
+    bool IIOAdc::readAttribute(const char *name, char *value, size_t size)
+    {
+        char path[MAX_PATH * 2];
+        snprintf(path, sizeof(path), "%s/%s", devicePath, name);
+        int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        ssize_t length = ::read(fd, value, size - 1);
+        ::close(fd);
+        if (length <= 0)
+        {
+            return false;
+        }
+        value[length] = '\0';
+        value[strcspn(value, "\n")] = '\0';
+        return true;
+    }
+
+    /**
+     * @brief Writes a sysfs attribute of the device.
+     * @param name Path relative to the device directory.
+     * @return true on success.
+     */
+    bool IIOAdc::writeAttribute(const char *name, const char *value)
+    {
+        char path[MAX_PATH * 2];
+        snprintf(path, sizeof(path), "%s/%s", devicePath, name);
+        int fd = ::open(path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+        if (fd < 0)
+        {
+            LOG_ERROR("IIO: cannot open %s: %s\n", path, strerror(errno));
+            return false;
+        }
+        bool ok = ::write(fd, value, strlen(value)) == (ssize_t)strlen(value);
+        if (!ok)
+        {
+            LOG_ERROR("IIO: cannot write %s to %s: %s\n", value, path, strerror(errno));
+        }
+        ::close(fd);
+        return ok;
+    }
+
+    /**
+     * @brief Opens the channel: one-shot raw attribute, or buffered capture.
+     *
+     * The scale is taken from in_voltageN_scale or the shared
+     * in_voltage_scale; the resolution from scan_elements if the device
+     * describes it, otherwise IIO_DEFAULT_BITS.
+     *
+     * @return SUCCESS or FAILED.
+     */
+    Status_t IIOAdc::init()
+    {
+        close();
+        char name[MAX_PATH];
+        char value[64];
+        snprintf(name, sizeof(name), "in_voltage%d_scale", config.channel);
+        if (readAttribute(name, value, sizeof(value)) || readAttribute("in_voltage_scale", value, sizeof(value)))
+        {
+            scale = (float)atof(value);
+        }
+        snprintf(name, sizeof(name), "scan_elements/in_voltage%d_type", config.channel);
+        if (readAttribute(name, value, sizeof(value)) && !parseScanFormat(value, format))
+        {
+            LOG_ERROR("IIO: %s/%s has an unknown format: %s\n", devicePath, name, value);
+            return FAILED;
+        }
+        if (format.bits > 16)
+        {
+            LOG_ERROR("IIO: %u-bit samples are not supported.\n", format.bits);
+            return FAILED;
+        }
+
+        if (config.buffered)
+        {
+            return setupBuffer() ? SUCCESS : FAILED;
+        }
+        char path[MAX_PATH * 2];
+        snprintf(path, sizeof(path), "%s/in_voltage%d_raw", devicePath, config.channel);
+        rawFd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (rawFd < 0)
+        {
+            LOG_ERROR("IIO: cannot open %s: %s\n", path, strerror(errno));
+            return FAILED;
+        }
+        return SUCCESS;
+    }
+
+    /**
+     * @brief Enables the channel, works out the scan layout, starts the buffer and opens the chardev.
+     *
+     * A scan holds every enabled channel (the timestamp too, if enabled)
+     * in scan_elements index order, each aligned to its own storage size.
+     *
+     * @return true on success.
+     */
+    bool IIOAdc::setupBuffer()
+    {
+        char name[MAX_PATH * 2];
+        char value[64];
+        snprintf(name, sizeof(name), "scan_elements/in_voltage%d_en", config.channel);
+        snprintf(value, sizeof(value), "%zu", config.bufferLength);
+        if (!writeAttribute("buffer/enable", "0") || !writeAttribute(name, "1") ||
+            (config.trigger != nullptr && !writeAttribute("trigger/current_trigger", config.trigger)) ||
+            !writeAttribute("buffer/length", value))
+        {
+            return false;
+        }
+
+        struct Element
+        {
+            unsigned int index;
+            size_t bytes;
+            bool ours;
+        };
+        Element elements[IIO_MAX_SCAN_CHANNELS];
+        size_t count = 0;
+        char scanDir[MAX_PATH * 2];
+        snprintf(scanDir, sizeof(scanDir), "%s/scan_elements", devicePath);
+        DIR *dir = opendir(scanDir);
+        if (dir == nullptr)
+        {
+            LOG_ERROR("IIO: cannot list %s: %s\n", scanDir, strerror(errno));
+            return false;
+        }
+        char ours[MAX_PATH];
+        snprintf(ours, sizeof(ours), "in_voltage%d", config.channel);
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != nullptr && count < IIO_MAX_SCAN_CHANNELS)
+        {
+            size_t length = strlen(entry->d_name);
+            if (length < 4 || length >= MAX_PATH - 8 || strcmp(entry->d_name + length - 3, "_en") != 0)
+            {
+                continue;
+            }
+            char base[MAX_PATH];
+            snprintf(base, sizeof(base), "%.*s", (int)(length - 3), entry->d_name);
+            snprintf(name, sizeof(name), "scan_elements/%s", entry->d_name);
+            if (!readAttribute(name, value, sizeof(value)) || atoi(value) != 1)
+            {
+                continue;
+            }
+            IIOScanFormat elementFormat;
+            snprintf(name, sizeof(name), "scan_elements/%s_type", base);
+            bool typed = readAttribute(name, value, sizeof(value)) && parseScanFormat(value, elementFormat);
+            snprintf(name, sizeof(name), "scan_elements/%s_index", base);
+            if (!typed || !readAttribute(name, value, sizeof(value)))
+            {
+                LOG_ERROR("IIO: cannot describe scan element %s.\n", base);
+                closedir(dir);
+                return false;
+            }
+            elements[count++] = Element{(unsigned int)atoi(value), elementFormat.storageBits / 8,
+                                        strcmp(base, ours) == 0};
+        }
+        closedir(dir);
+
+        std::sort(elements, elements + count, [](const Element &a, const Element &b) { return a.index < b.index; });
+        size_t offset = 0;
+        size_t alignment = 1;
+        bool found = false;
+        for (size_t i = 0; i < count; ++i)
+        {
+            offset = (offset + elements[i].bytes - 1) / elements[i].bytes * elements[i].bytes;
+            if (elements[i].ours)
+            {
+                channelOffset = offset;
+                found = true;
+            }
+            offset += elements[i].bytes;
+            alignment = std::max(alignment, elements[i].bytes);
+        }
+        if (!found)
+        {
+            LOG_ERROR("IIO: %s is not enabled in %s.\n", ours, scanDir);
+            return false;
+        }
+        scanBytes = (offset + alignment - 1) / alignment * alignment;
+
+        if (!writeAttribute("buffer/enable", "1"))
+        {
+            return false;
+        }
+        char path[MAX_PATH * 2];
+        snprintf(path, sizeof(path), "%s/iio:device%d", config.devRoot, config.device);
+        bufferFd = ::open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (bufferFd < 0)
+        {
+            LOG_ERROR("IIO: cannot open %s: %s\n", path, strerror(errno));
+            writeAttribute("buffer/enable", "0");
+            return false;
+        }
+        block.resize(config.bufferLength * scanBytes);
+        pending = 0;
+        return true;
+    }
+
+    /**
+     * @brief Stops the buffer and closes the descriptors.
+     */
+    void IIOAdc::close()
+    {
+        if (bufferFd >= 0)
+        {
+            ::close(bufferFd);
+            bufferFd = -1;
+            writeAttribute("buffer/enable", "0");
+        }
+        if (rawFd >= 0)
+        {
+            ::close(rawFd);
+            rawFd = -1;
+        }
+    }
+
+    /**
+     * @brief Triggers one conversion by reading in_voltageN_raw.
+     * @return The raw value, or ERROR.
+     */
+    int IIOAdc::readRaw()
+    {
+        char value[32];
+        ssize_t length = (rawFd >= 0) ? pread(rawFd, value, sizeof(value) - 1, 0) : -1;
+        if (length <= 0)
+        {
+            return ERROR;
+        }
+        value[length] = '\0';
+        return atoi(value);
+    }
+
+    /**
+     * @brief Reads captured samples of the channel from the buffer.
+     *
+     * Reads as many scans as are available, up to maxSamples, in one read()
+     * where possible. If none are available, waits up to timeoutMs for the
+     * first. An incomplete trailing scan is kept for the next call.
+     *
+     * @param samples Destination, maxSamples entries.
+     * @param maxSamples At most this many; capped at the buffer length.
+     * @param timeoutMs Longest wait for the first sample, 0 to not wait.
+     * @return Number of samples stored (0 if none arrived in time), or ERROR.
+     */
+    int IIOAdc::readSamples(uint16_t *samples, size_t maxSamples, int timeoutMs)
+    {
+        if (bufferFd < 0)
+        {
+            return ERROR;
+        }
+        size_t wanted = std::min(maxSamples, config.bufferLength) * scanBytes;
+        size_t have = pending;
+        bool waited = false;
+        while (have < wanted)
+        {
+            ssize_t result = ::read(bufferFd, block.data() + have, wanted - have);
+            if (result > 0)
+            {
+                have += (size_t)result;
+                continue;
+            }
+            if (result == 0)
+            {
+                break; // end of a regular file standing in for the chardev
+            }
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno != EAGAIN)
+            {
+                LOG_ERROR("IIO: buffer read failed: %s\n", strerror(errno));
+                return ERROR;
+            }
+            if (have >= scanBytes || waited || timeoutMs <= 0)
+            {
+                break;
+            }
+            struct pollfd request = {bufferFd, POLLIN, 0};
+            waited = true;
+            if (poll(&request, 1, timeoutMs) <= 0)
+            {
+                break;
+            }
+        }
+
+        size_t count = have / scanBytes;
+        extract(block.data(), count, samples);
+        pending = have - count * scanBytes;
+        memmove(block.data(), block.data() + count * scanBytes, pending);
+        return (int)count;
+    }
+
+    /**
+     * @brief Picks the channel's value out of each scan.
+     *
+     * The common layout, a single little-endian 16-bit channel, is a plain
+     * shift-and-mask over a contiguous array (on the little-endian hosts
+     * this runs on), which the compiler vectorizes; other layouts are
+     * decoded byte by byte.
+     */
+    void IIOAdc::extract(const uint8_t *scans, size_t count, uint16_t *samples) const
+    {
+        uint64_t mask = (format.bits >= 64) ? ~0ULL : ((1ULL << format.bits) - 1);
+        if (scanBytes == 2 && format.storageBits == 16 && !format.bigEndian && !format.isSigned)
+        {
+            memcpy(samples, scans, count * sizeof(uint16_t));
+            uint16_t shift = (uint16_t)format.shift;
+            uint16_t valueMask = (uint16_t)mask;
+            for (size_t i = 0; i < count; ++i)
+            {
+                samples[i] = (uint16_t)((samples[i] >> shift) & valueMask);
+            }
+            return;
+        }
+
+        size_t bytes = format.storageBits / 8;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint8_t *field = scans + i * scanBytes + channelOffset;
+            uint64_t raw = 0;
+            for (size_t b = 0; b < bytes; ++b)
+            {
+                raw |= (uint64_t)field[format.bigEndian ? b : bytes - 1 - b] << (8 * (bytes - 1 - b));
+            }
+            raw = (raw >> format.shift) & mask;
+            if (format.isSigned && (raw >> (format.bits - 1)) & 1)
+            {
+                raw = 0; // negative readings do not occur on a divider; clamp
+            }
+            samples[i] = (uint16_t)raw;
+        }
+    }
+} // namespace Periferia
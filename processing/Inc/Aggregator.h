@@ -0,0 +1,140 @@
+#ifndef AGGREGATOR_H
+#define AGGREGATOR_H
+
+/*
+ * Windowed summaries of sensor samples.
+ *
+ * Downstream consumers only need per-minute (or similar) summaries, so
+ * instead of shipping every reading the aggregator keeps, per sensor and
+ * channel, a window with a running mean/variance, min/max and a quantile
+ * sketch, and publishes one WindowResult per window. Every sample costs
+ * O(1) amortized and memory is fixed once a sensor has been seen.
+ */
+
+#include "../../define.h"
+#include "../../acquisition/Inc/Sample.h"
+#include "../../acquisition/Inc/SampleBatch.h"
+#include "WindowStats.h"
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#define AGG_WINDOW_MS 60000
+// Samples a sliding window can hold per sensor; the oldest are dropped beyond it
+#define AGG_WINDOW_CAPACITY 4096
+
+// Channel bits of WindowConfig::channels and WindowResult::channels
+#define AGG_TEMPERATURE 0x1
+#define AGG_HUMIDITY 0x2
+#define AGG_LIGHT 0x4
+#define AGG_ALL_CHANNELS (AGG_TEMPERATURE | AGG_HUMIDITY | AGG_LIGHT)
+#define AGG_CHANNELS 3
+
+namespace Processing
+{
+    enum class WindowKind
+    {
+        Tumbling, ///< back-to-back windows of `length`, each published once when it ends
+        Sliding   ///< the last `length` of samples, published every `cadence`
+    };
+
+    // Values a channel is expected to take, for the quantile sketch
+    struct ChannelRange
+    {
+        float low;
+        float high;
+        float resolution;
+    };
+
+    struct WindowConfig
+    {
+        WindowKind kind = WindowKind::Tumbling;
+        std::chrono::milliseconds length{AGG_WINDOW_MS};
+        std::chrono::milliseconds cadence{AGG_WINDOW_MS}; ///< sliding only; tumbling windows publish every `length`
+        size_t capacity = AGG_WINDOW_CAPACITY;            ///< sliding only
+        unsigned int channels = AGG_ALL_CHANNELS;         ///< default for sensors without setChannels()
+        ChannelRange temperature{-40.0f, 80.0f, 0.1f};    ///< DHT22 range and resolution, degrees C
+        ChannelRange humidity{0.0f, 100.0f, 0.1f};        ///< %RH
+        ChannelRange light{0.0f, 20000.0f, 5.0f};         ///< GL5516, lux
+    };
+
+    struct ChannelSummary
+    {
+        size_t count;
+        float min;
+        float max;
+        double mean;
+        double stddev;
+        float p50;
+        float p90;
+        float p99;
+    };
+
+    struct WindowResult
+    {
+        int sensorId;
+        unsigned long long startNs; ///< CLOCK_MONOTONIC, inclusive
+        unsigned long long endNs;   ///< exclusive
+        unsigned long samples;      ///< successful reads in the window
+        unsigned long failures;     ///< failed reads since the previous result
+        unsigned int channels;      ///< AGG_* bits of the summaries that are filled in
+        ChannelSummary temperature;
+        ChannelSummary humidity;
+        ChannelSummary light;
+    };
+
+    /**
+     * @class Aggregator
+     * @brief Turns a stream of sample records into per-sensor window summaries.
+     *
+     * Not thread-safe: meant to run on one consumer thread, typically a
+     * SampleBus subscriber whose handler calls add(). Records are windowed
+     * by their endNs. A record a little older than the current window (from
+     * another acquisition thread) is counted in the current one.
+     */
+    class Aggregator
+    {
+    public:
+        using Publisher = std::function<void(const WindowResult &)>;
+
+        Aggregator(const WindowConfig &config, Publisher publish);
+        ~Aggregator();
+
+        // Channels to aggregate for one sensor (AGG_* bits), e.g. no light for a DHT22
+        void setChannels(int sensorId, unsigned int channels);
+
+        // Publish the windows that ended before the record, then add it
+        void add(const Acquisition::SampleRecord &record);
+        // Same as add() for every row and failure of a batch, summarizing column-wise where it can
+        void addBatch(const Acquisition::SampleBatch &batch);
+        // Publish every window that ended by nowNs (CLOCK_MONOTONIC), e.g. when samples stop
+        void advance(unsigned long long nowNs);
+        // Publish the unfinished tumbling windows, e.g. at shutdown
+        void flush();
+
+        unsigned long getPublished() const { return published; }
+
+    private:
+        struct SensorWindow;
+
+        SensorWindow &window(int sensorId);
+        void begin(SensorWindow &sensor, unsigned long long timeNs);
+        void addRow(SensorWindow &sensor, unsigned long long timeNs, bool ok, const float *values);
+        void addRun(SensorWindow &sensor, const float *const *columns, const unsigned long long *timestamps,
+                    size_t from, size_t to);
+        void publishDue(SensorWindow &sensor, unsigned long long nowNs);
+        void publish(SensorWindow &sensor, unsigned long long startNs, unsigned long long endNs);
+
+        WindowConfig config;
+        Publisher publisher;
+        unsigned long long lengthNs;
+        unsigned long long cadenceNs;
+        std::vector<std::unique_ptr<SensorWindow>> sensors; ///< indexed by sensor id
+        std::vector<unsigned int> channelMasks;              ///< setChannels() before the sensor is seen
+        unsigned long published;
+    };
+
+} // namespace Processing
+
+#endif // AGGREGATOR_H
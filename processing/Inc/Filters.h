@@ -0,0 +1,236 @@
+#ifndef FILTERS_H
+#define FILTERS_H
+
+/*
+ * Per-channel filters for sensor readings.
+ *
+ * A checksum only catches some corrupted frames: a multi-bit error can
+ * leave it valid and turn 21.5 C into 47.1 C. Instead of reading the
+ * sensor again, readings go through a short chain of filters per channel
+ * (range check, Hampel outlier rejection, median, Kalman). Filters hold
+ * fixed-size state and never allocate after construction, so they can
+ * sit on the acquisition path. Each one also has a batch form over a
+ * contiguous column of values for replaying recorded history.
+ */
+
+#include "../../define.h"
+#include "../../sensors/Inc/SensorBase.h"
+#include "../../common/Inc/Metrics.h"
+#include <cstddef>
+
+// Largest median/Hampel window
+#define FILTER_MAX_WINDOW 31
+// Stages per channel in a FilterPipeline
+#define FILTER_MAX_STAGES 4
+#define FILTER_CHANNELS 3
+// MAD to standard deviation for normally distributed noise
+#define FILTER_MAD_SCALE 1.4826f
+
+namespace Processing
+{
+    enum class Channel
+    {
+        Temperature,
+        Humidity,
+        Light
+    };
+
+    // Field of a reading that holds a channel
+    float &channelOf(Sensors::SensorData &data, Channel channel);
+
+    /**
+     * @class Filter
+     * @brief One stage of a channel's filter chain.
+     */
+    class Filter
+    {
+    public:
+        virtual ~Filter() = default;
+
+        // Filter one value in place; false if it was rejected and replaced
+        virtual bool process(float &value) = 0;
+        // Filter a column in place, continuing from the current state; returns the number rejected
+        virtual size_t processBatch(float *values, size_t count) = 0;
+        // Forget the history
+        virtual void reset() = 0;
+    };
+
+    /**
+     * @class SortedWindow
+     * @brief The last N values, both in arrival order and sorted, in fixed memory.
+     *
+     * Insertion and eviction shift the sorted array, O(N) with plain
+     * contiguous moves, which for N up to FILTER_MAX_WINDOW is faster than
+     * any tree or heap.
+     */
+    class SortedWindow
+    {
+    public:
+        explicit SortedWindow(size_t length);
+
+        // Add a value, evicting the oldest once the window is full
+        void push(float value);
+        void reset();
+
+        size_t size() const { return count; }
+        float median() const;
+        // Median absolute deviation from the median
+        float mad() const;
+
+    private:
+        size_t length;
+        size_t count;
+        size_t head;                      ///< oldest value in ring
+        float ring[FILTER_MAX_WINDOW];    ///< arrival order
+        float sorted[FILTER_MAX_WINDOW];  ///< ascending
+    };
+
+    /**
+     * @class RangeFilter
+     * @brief Rejects values outside what the sensor can physically report.
+     *
+     * A rejected value is replaced by the last accepted one, or clamped to
+     * the range if there is none yet. NaN is rejected too.
+     */
+    class RangeFilter final : public Filter
+    {
+    public:
+        RangeFilter(float low, float high);
+
+        bool process(float &value) override;
+        size_t processBatch(float *values, size_t count) override;
+        void reset() override { hasLast = false; }
+
+    private:
+        float low;
+        float high;
+        float last;
+        bool hasLast;
+    };
+
+    /**
+     * @class MedianFilter
+     * @brief Replaces each value with the median of the last N (N odd); never rejects.
+     */
+    class MedianFilter final : public Filter
+    {
+    public:
+        explicit MedianFilter(size_t length);
+
+        bool process(float &value) override;
+        size_t processBatch(float *values, size_t count) override;
+        void reset() override { window.reset(); }
+
+    private:
+        SortedWindow window;
+    };
+
+    /**
+     * @class HampelFilter
+     * @brief Rejects values more than k robust standard deviations from the recent median.
+     *
+     * The spread is estimated as FILTER_MAD_SCALE * MAD of the last N raw
+     * values, including the new one, but never below minSigma: quantized
+     * sensors often repeat the same value and would otherwise reject the
+     * next single step. A rejected value is replaced by the median. A real
+     * step in the signal is accepted once it fills half the window. Nothing
+     * is rejected until the window holds minSamples values.
+     */
+    class HampelFilter final : public Filter
+    {
+    public:
+        HampelFilter(size_t length, float k, float minSigma, size_t minSamples = 3);
+
+        bool process(float &value) override;
+        size_t processBatch(float *values, size_t count) override;
+        void reset() override { window.reset(); }
+
+    private:
+        SortedWindow window;
+        float k;
+        float minSigma;
+        size_t minSamples;
+    };
+
+    /**
+     * @class KalmanFilter
+     * @brief Scalar Kalman filter for a slowly drifting value (random-walk model).
+     *
+     * processNoise is the variance the true value drifts by per sample,
+     * measurementNoise the variance of a reading. Their ratio sets how
+     * much a new reading moves the estimate. Never rejects.
+     */
+    class KalmanFilter final : public Filter
+    {
+    public:
+        KalmanFilter(float processNoise, float measurementNoise);
+
+        bool process(float &value) override;
+        size_t processBatch(float *values, size_t count) override;
+        void reset() override { initialized = false; }
+
+    private:
+        float processNoise;
+        float measurementNoise;
+        float estimate;
+        float variance;
+        bool initialized;
+    };
+
+    /**
+     * @class FilterPipeline
+     * @brief Ordered filter stages per channel, applied to whole readings.
+     *
+     * Stages are not owned and run in the order they were added; a value
+     * replaced by one stage is what the next stage sees. Not thread-safe:
+     * one pipeline per sensor, driven by the thread that reads it.
+     */
+    class FilterPipeline
+    {
+    public:
+        // name labels the filter_rejected_total metric
+        explicit FilterPipeline(const char *name);
+
+        // Append a stage to a channel; false if the channel already has FILTER_MAX_STAGES
+        bool add(Channel channel, Filter *filter);
+        // Filter every channel that has stages; false if any value was rejected (and replaced)
+        bool process(Sensors::SensorData &data);
+        // Filter a recorded column of one channel in place; returns the number of rejections
+        size_t processBatch(Channel channel, float *values, size_t count);
+        void reset();
+
+        unsigned long long getRejected(Channel channel) const { return rejected[(int)channel]->get(); }
+
+    private:
+        Filter *stages[FILTER_CHANNELS][FILTER_MAX_STAGES];
+        size_t stageCount[FILTER_CHANNELS];
+        Metrics::Counter *rejected[FILTER_CHANNELS];
+    };
+
+    /**
+     * @class FilteredSensor
+     * @brief Sensor front that passes every successful reading through a FilterPipeline.
+     *
+     * A reading with a rejected value still succeeds, carrying the
+     * replacement, so the caller does not have to read the bus again.
+     */
+    class FilteredSensor : public Sensors::SensorBase
+    {
+    public:
+        // Neither sensor nor pipeline is owned
+        FilteredSensor(Sensors::SensorBase &sensor, FilterPipeline &pipeline);
+
+        bool open() override { return sensor.open(); }
+        bool read(Sensors::SensorData &data) override;
+        void close() override { sensor.close(); }
+        bool isTimingCritical() const override { return sensor.isTimingCritical(); }
+        const Sensors::SensorSchema &schema() const override { return sensor.schema(); }
+
+    private:
+        Sensors::SensorBase &sensor;
+        FilterPipeline &pipeline;
+    };
+
+} // namespace Processing
+
+#endif // FILTERS_H
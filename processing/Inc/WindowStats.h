@@ -0,0 +1,213 @@
+#ifndef WINDOW_STATS_H
+#define WINDOW_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Upper bound on quantile sketch bins; coarser resolution is used beyond it
+#define SKETCH_MAX_BINS 4096
+// Independent accumulators in the column kernels, so the compiler can vectorize them
+#define COLUMN_LANES 8
+
+namespace Processing
+{
+    /**
+     * @class RunningStats
+     * @brief Welford's online mean and variance, with removal for sliding windows.
+     */
+    class RunningStats
+    {
+    public:
+        RunningStats() : count(0), mean(0.0), m2(0.0) {}
+
+        void add(double x)
+        {
+            count++;
+            double delta = x - mean;
+            mean += delta / count;
+            m2 += delta * (x - mean);
+        }
+
+        // Undo add(x) of a value still in the window
+        void remove(double x)
+        {
+            if (count <= 1)
+            {
+                reset();
+                return;
+            }
+            double delta = x - mean;
+            mean -= delta / (count - 1);
+            m2 -= delta * (x - mean);
+            count--;
+            if (m2 < 0.0)
+            {
+                m2 = 0.0; // rounding after many removals
+            }
+        }
+
+        // Add a block of n values summarized by its mean and sum of squared deviations (Chan et al.)
+        void merge(size_t n, double blockMean, double blockM2)
+        {
+            if (n == 0)
+            {
+                return;
+            }
+            size_t total = count + n;
+            double delta = blockMean - mean;
+            mean += delta * n / total;
+            m2 += blockM2 + delta * delta * count * n / total;
+            count = total;
+        }
+
+        void reset()
+        {
+            count = 0;
+            mean = 0.0;
+            m2 = 0.0;
+        }
+
+        size_t getCount() const { return count; }
+        double getMean() const { return mean; }
+        // Sample variance, 0 below two values
+        double getVariance() const { return count > 1 ? m2 / (count - 1) : 0.0; }
+
+    private:
+        size_t count;
+        double mean;
+        double m2;
+    };
+
+    // Statistics of a contiguous column of values
+    struct ColumnSummary
+    {
+        float min;
+        float max;
+        double mean;
+        double m2;   ///< sum of squared deviations from the mean
+        bool finite; ///< false if any value is NaN or infinite; the other fields are then undefined
+    };
+
+    // One pass for min/max/sum, one for the squared deviations; count must be positive
+    ColumnSummary summarizeColumn(const float *values, size_t count);
+
+    /**
+     * @class MonotonicDeque
+     * @brief Sliding-window minimum (Less) or maximum (Greater) in O(1) amortized per sample.
+     *
+     * Keeps the candidates in a fixed ring: a value is dropped as soon as a
+     * newer one is at least as extreme, so the front is always the extreme
+     * of the window. Capacity must cover the largest window.
+     */
+    template <typename Better>
+    class MonotonicDeque
+    {
+    public:
+        explicit MonotonicDeque(size_t capacity) : entries(capacity), head(0), size(0) {}
+
+        // Append the value with sequence number seq (increasing)
+        void push(uint64_t seq, float value)
+        {
+            Better better;
+            while (size > 0 && !better(back().value, value))
+            {
+                size--;
+            }
+            if (size == entries.size())
+            {
+                popFront(); // window larger than the capacity: forget the oldest candidate
+            }
+            entries[(head + size) % entries.size()] = Entry{seq, value};
+            size++;
+        }
+
+        // Drop candidates with a sequence number below seq
+        void expire(uint64_t seq)
+        {
+            while (size > 0 && entries[head].seq < seq)
+            {
+                popFront();
+            }
+        }
+
+        void reset()
+        {
+            head = 0;
+            size = 0;
+        }
+
+        bool empty() const { return size == 0; }
+        float front() const { return entries[head].value; }
+
+    private:
+        struct Entry
+        {
+            uint64_t seq;
+            float value;
+        };
+
+        const Entry &back() const { return entries[(head + size - 1) % entries.size()]; }
+        void popFront()
+        {
+            head = (head + 1) % entries.size();
+            size--;
+        }
+
+        std::vector<Entry> entries;
+        size_t head;
+        size_t size;
+    };
+
+    struct Less
+    {
+        bool operator()(float a, float b) const { return a < b; }
+    };
+    struct Greater
+    {
+        bool operator()(float a, float b) const { return a > b; }
+    };
+
+    /**
+     * @class QuantileSketch
+     * @brief Fixed-bin histogram over a known value range, with removal.
+     *
+     * Bins are centred on multiples of the resolution, so readings that are
+     * already quantized (the DHT22 reports 0.1 steps) are counted exactly.
+     * Values outside the range go to the edge bins. Memory is fixed at
+     * construction; add/remove are O(1), quantile() is O(bins).
+     */
+    class QuantileSketch
+    {
+    public:
+        QuantileSketch(float low, float high, float resolution);
+
+        void add(float value) { bins[binOf(value)]++; total++; }
+        void remove(float value)
+        {
+            uint32_t &bin = bins[binOf(value)];
+            if (bin > 0)
+            {
+                bin--;
+                total--;
+            }
+        }
+        void reset();
+
+        // Value at quantile q (0..1), to within one resolution step; 0 when empty
+        float quantile(double q) const;
+        size_t getCount() const { return total; }
+        float getResolution() const { return resolution; }
+
+    private:
+        size_t binOf(float value) const;
+
+        float low;
+        float resolution;
+        std::vector<uint32_t> bins;
+        size_t total;
+    };
+
+} // namespace Processing
+
+#endif // WINDOW_STATS_H
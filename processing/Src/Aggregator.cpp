@@ -0,0 +1,537 @@
+#include "../Inc/Aggregator.h"
+#include "../../common/Inc/Log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Processing
+{
+    /**
+     * @brief Window state of one channel of one sensor.
+     *
+     * Tumbling windows never remove values, so they track min/max directly;
+     * sliding windows need the monotonic deques to stay O(1) on removal.
+     */
+    struct ChannelWindow
+    {
+        ChannelWindow(const ChannelRange &range, size_t capacity)
+            : minimum(capacity), maximum(capacity), sketch(range.low, range.high, range.resolution), low(0.0f),
+              high(0.0f)
+        {
+        }
+
+        void reset()
+        {
+            stats.reset();
+            minimum.reset();
+            maximum.reset();
+            sketch.reset();
+        }
+
+        RunningStats stats;
+        MonotonicDeque<Less> minimum;
+        MonotonicDeque<Greater> maximum;
+        QuantileSketch sketch;
+        float low;  ///< tumbling minimum
+        float high; ///< tumbling maximum
+    };
+
+    /**
+     * @brief Window of one sensor: per-channel state plus, for sliding windows, the samples in it.
+     */
+    struct Aggregator::SensorWindow
+    {
+        struct Entry
+        {
+            uint64_t seq;
+            unsigned long long timeNs;
+            float values[AGG_CHANNELS];
+        };
+
+        SensorWindow(const WindowConfig &config, int id, unsigned int channels)
+            : id(id), channels(channels), entries(config.kind == WindowKind::Sliding ? std::max<size_t>(1, config.capacity) : 0),
+              head(0), size(0), nextSeq(0), boundaryNs(0), started(false), samples(0), failures(0)
+        {
+            size_t dequeCapacity = std::max<size_t>(1, entries.size());
+            channel.reserve(AGG_CHANNELS);
+            channel.emplace_back(config.temperature, dequeCapacity);
+            channel.emplace_back(config.humidity, dequeCapacity);
+            channel.emplace_back(config.light, dequeCapacity);
+        }
+
+        int id;
+        unsigned int channels;
+        std::vector<ChannelWindow> channel; ///< temperature, humidity, light
+        std::vector<Entry> entries;         ///< sliding only: ring of the samples in the window
+        size_t head;
+        size_t size;
+        uint64_t nextSeq;
+        unsigned long long boundaryNs; ///< tumbling: start of the window; sliding: next publish time
+        bool started;
+        unsigned long samples;  ///< tumbling: successful reads in the window
+        unsigned long failures; ///< since the previous result
+    };
+
+    // Schema channel names of the aggregated channels, in AGG_* bit order
+    static const char *const channelNames[AGG_CHANNELS] = {"temperature", "humidity", "light"};
+
+    static float channelValue(const Sensors::SensorData &data, int channel)
+    {
+        switch (channel)
+        {
+        case 0:
+            return data.temperature;
+        case 1:
+            return data.humidity;
+        default:
+            return data.light;
+        }
+    }
+
+    /**
+     * @brief Constructs an aggregator.
+     * @param config Window kind, length, publish cadence and channel ranges.
+     * @param publish Called with every finished window, on the thread calling add()/advance()/flush().
+     */
+    Aggregator::Aggregator(const WindowConfig &config, Publisher publish)
+        : config(config), publisher(std::move(publish)), published(0)
+    {
+        lengthNs = (unsigned long long)std::max<long long>(1, config.length.count()) * 1000000ULL;
+        cadenceNs = (config.kind == WindowKind::Tumbling)
+                        ? lengthNs
+                        : (unsigned long long)std::max<long long>(1, config.cadence.count()) * 1000000ULL;
+    }
+
+    Aggregator::~Aggregator() = default;
+
+    /**
+     * @brief Selects the channels aggregated for a sensor.
+     *
+     * Takes effect when the sensor's first record arrives, so call it
+     * before feeding records. A DHT22, for example, does not fill in light.
+     *
+     * @param sensorId Sensor id as in SampleRecord::sensorId.
+     * @param channels AGG_TEMPERATURE, AGG_HUMIDITY and/or AGG_LIGHT.
+     */
+    void Aggregator::setChannels(int sensorId, unsigned int channels)
+    {
+        if (sensorId < 0)
+        {
+            return;
+        }
+        if ((size_t)sensorId < sensors.size() && sensors[sensorId])
+        {
+            LOG_WARN("Aggregator: channels of sensor %d set after its first sample, ignored.\n", sensorId);
+            return;
+        }
+        if ((size_t)sensorId >= channelMasks.size())
+        {
+            channelMasks.resize(sensorId + 1, config.channels);
+        }
+        channelMasks[sensorId] = channels & AGG_ALL_CHANNELS;
+    }
+
+    /**
+     * @brief State of a sensor, created on its first record.
+     */
+    Aggregator::SensorWindow &Aggregator::window(int sensorId)
+    {
+        if ((size_t)sensorId >= sensors.size())
+        {
+            sensors.resize(sensorId + 1);
+        }
+        if (!sensors[sensorId])
+        {
+            unsigned int channels = ((size_t)sensorId < channelMasks.size()) ? channelMasks[sensorId] : config.channels;
+            sensors[sensorId].reset(new SensorWindow(config, sensorId, channels));
+        }
+        return *sensors[sensorId];
+    }
+
+    /**
+     * @brief Adds one cycle record to its sensor's window.
+     *
+     * Windows that ended at or before the record's endNs are published
+     * first. Failed reads, and reads with a non-finite value in an
+     * aggregated channel, are only counted.
+     *
+     * @param record Record from the scheduler or the sample bus.
+     */
+    void Aggregator::add(const Acquisition::SampleRecord &record)
+    {
+        if (record.sensorId < 0)
+        {
+            return;
+        }
+        SensorWindow &sensor = window(record.sensorId);
+        begin(sensor, record.endNs);
+        float values[AGG_CHANNELS];
+        for (int c = 0; c < AGG_CHANNELS; ++c)
+        {
+            values[c] = channelValue(record.data, c);
+        }
+        addRow(sensor, record.endNs, record.ok, values);
+    }
+
+    /**
+     * @brief Adds a column batch of one sensor's readings.
+     *
+     * Channels are matched to temperature/humidity/light by name in the
+     * batch's schema; channels the schema lacks are dropped from the
+     * sensor's aggregation. For tumbling windows, the rows that fall into
+     * the same window are summarized column-wise and merged into the
+     * window in one step. Sliding windows need every row in their ring,
+     * so they take the rows one by one. Failures are counted in time order
+     * with the rows, as add() would.
+     *
+     * @param batch Readings of one sensor, in timestamp order.
+     */
+    void Aggregator::addBatch(const Acquisition::SampleBatch &batch)
+    {
+        if (batch.getSensorId() < 0)
+        {
+            return;
+        }
+        SensorWindow &sensor = window(batch.getSensorId());
+        const float *columns[AGG_CHANNELS];
+        for (int c = 0; c < AGG_CHANNELS; ++c)
+        {
+            int index = batch.getSchema().find(channelNames[c]);
+            columns[c] = (index >= 0) ? batch.column(index) : nullptr;
+            if (index < 0)
+            {
+                sensor.channels &= ~(1u << c);
+            }
+        }
+
+        const unsigned long long *timestamps = batch.timestamps();
+        const unsigned long long *failed = batch.failureTimestamps();
+        size_t rows = batch.size();
+        size_t failures = batch.getFailureCount();
+        size_t row = 0;
+        size_t failure = 0;
+        float values[AGG_CHANNELS];
+        while (row < rows || failure < failures)
+        {
+            if (failure < failures && (row == rows || failed[failure] < timestamps[row]))
+            {
+                begin(sensor, failed[failure]);
+                sensor.failures++;
+                failure++;
+                continue;
+            }
+            begin(sensor, timestamps[row]);
+            if (config.kind == WindowKind::Sliding)
+            {
+                for (int c = 0; c < AGG_CHANNELS; ++c)
+                {
+                    values[c] = columns[c] ? columns[c][row] : NAN;
+                }
+                addRow(sensor, timestamps[row], true, values);
+                row++;
+                continue;
+            }
+
+            size_t end = row + 1;
+            while (end < rows && timestamps[end] < sensor.boundaryNs + lengthNs)
+            {
+                end++;
+            }
+            addRun(sensor, columns, timestamps, row, end);
+            row = end;
+        }
+    }
+
+    /**
+     * @brief Publishes the windows that ended by timeNs and starts the first window of a new sensor.
+     */
+    void Aggregator::begin(SensorWindow &sensor, unsigned long long timeNs)
+    {
+        publishDue(sensor, timeNs);
+        if (!sensor.started)
+        {
+            // Windows are aligned to multiples of the cadence so all sensors publish together
+            sensor.boundaryNs = timeNs - timeNs % cadenceNs;
+            if (config.kind == WindowKind::Sliding)
+            {
+                sensor.boundaryNs += cadenceNs;
+            }
+            sensor.started = true;
+        }
+    }
+
+    /**
+     * @brief Adds one reading to the current window.
+     * @param values Temperature, humidity and light.
+     */
+    void Aggregator::addRow(SensorWindow &sensor, unsigned long long timeNs, bool ok, const float *values)
+    {
+        for (int c = 0; c < AGG_CHANNELS && ok; ++c)
+        {
+            ok = !(sensor.channels & (1u << c)) || std::isfinite(values[c]);
+        }
+        if (!ok)
+        {
+            sensor.failures++;
+            return;
+        }
+
+        if (config.kind == WindowKind::Tumbling)
+        {
+            sensor.samples++;
+            for (int c = 0; c < AGG_CHANNELS; ++c)
+            {
+                if (sensor.channels & (1u << c))
+                {
+                    ChannelWindow &state = sensor.channel[c];
+                    float value = values[c];
+                    bool first = state.stats.getCount() == 0;
+                    state.low = (first || value < state.low) ? value : state.low;
+                    state.high = (first || value > state.high) ? value : state.high;
+                    state.stats.add(value);
+                    state.sketch.add(value);
+                }
+            }
+            return;
+        }
+
+        if (sensor.size == sensor.entries.size())
+        {
+            // More samples than the capacity: drop the oldest as if it had expired
+            const SensorWindow::Entry &oldest = sensor.entries[sensor.head];
+            for (int c = 0; c < AGG_CHANNELS; ++c)
+            {
+                if (sensor.channels & (1u << c))
+                {
+                    sensor.channel[c].stats.remove(oldest.values[c]);
+                    sensor.channel[c].sketch.remove(oldest.values[c]);
+                    sensor.channel[c].minimum.expire(oldest.seq + 1);
+                    sensor.channel[c].maximum.expire(oldest.seq + 1);
+                }
+            }
+            sensor.head = (sensor.head + 1) % sensor.entries.size();
+            sensor.size--;
+        }
+        SensorWindow::Entry &entry = sensor.entries[(sensor.head + sensor.size) % sensor.entries.size()];
+        entry.seq = sensor.nextSeq++;
+        entry.timeNs = timeNs;
+        for (int c = 0; c < AGG_CHANNELS; ++c)
+        {
+            entry.values[c] = values[c];
+            if (sensor.channels & (1u << c))
+            {
+                sensor.channel[c].stats.add(entry.values[c]);
+                sensor.channel[c].sketch.add(entry.values[c]);
+                sensor.channel[c].minimum.push(entry.seq, entry.values[c]);
+                sensor.channel[c].maximum.push(entry.seq, entry.values[c]);
+            }
+        }
+        sensor.size++;
+    }
+
+    /**
+     * @brief Adds rows [from, to) of a batch, all inside the current tumbling window.
+     *
+     * Each aggregated column is summarized by summarizeColumn() and merged
+     * into the running statistics. If a column holds a non-finite value the
+     * rows are added one by one instead, so the affected rows count as
+     * failures exactly as in add().
+     */
+    void Aggregator::addRun(SensorWindow &sensor, const float *const *columns, const unsigned long long *timestamps,
+                            size_t from, size_t to)
+    {
+        size_t count = to - from;
+        ColumnSummary summaries[AGG_CHANNELS];
+        bool finite = true;
+        for (int c = 0; c < AGG_CHANNELS; ++c)
+        {
+            if (sensor.channels & (1u << c))
+            {
+                summaries[c] = summarizeColumn(columns[c] + from, count);
+                finite = finite && summaries[c].finite;
+            }
+        }
+        if (!finite)
+        {
+            float values[AGG_CHANNELS];
+            for (size_t row = from; row < to; ++row)
+            {
+                for (int c = 0; c < AGG_CHANNELS; ++c)
+                {
+                    values[c] = columns[c] ? columns[c][row] : NAN;
+                }
+                addRow(sensor, timestamps[row], true, values);
+            }
+            return;
+        }
+
+        sensor.samples += count;
+        for (int c = 0; c < AGG_CHANNELS; ++c)
+        {
+            if (!(sensor.channels & (1u << c)))
+            {
+                continue;
+            }
+            ChannelWindow &state = sensor.channel[c];
+            const ColumnSummary &summary = summaries[c];
+            bool first = state.stats.getCount() == 0;
+            state.low = (first || summary.min < state.low) ? summary.min : state.low;
+            state.high = (first || summary.max > state.high) ? summary.max : state.high;
+            state.stats.merge(count, summary.mean, summary.m2);
+            const float *column = columns[c];
+            for (size_t row = from; row < to; ++row)
+            {
+                state.sketch.add(column[row]);
+            }
+        }
+    }
+
+    /**
+     * @brief Publishes the windows of every sensor that ended by nowNs.
+     *
+     * Records drive publishing on their own; this is for when a sensor
+     * stops producing them, e.g. from a periodic timer on the same thread.
+     */
+    void Aggregator::advance(unsigned long long nowNs)
+    {
+        for (std::unique_ptr<SensorWindow> &sensor : sensors)
+        {
+            if (sensor)
+            {
+                publishDue(*sensor, nowNs);
+            }
+        }
+    }
+
+    /**
+     * @brief Publishes the unfinished tumbling windows and starts over.
+     *
+     * Sliding windows have nothing pending: they are published every
+     * cadence anyway.
+     */
+    void Aggregator::flush()
+    {
+        if (config.kind != WindowKind::Tumbling)
+        {
+            return;
+        }
+        for (std::unique_ptr<SensorWindow> &sensor : sensors)
+        {
+            if (sensor && sensor->started)
+            {
+                publish(*sensor, sensor->boundaryNs, sensor->boundaryNs + lengthNs);
+                sensor->started = false;
+            }
+        }
+    }
+
+    /**
+     * @brief Publishes the sensor's windows that ended by nowNs.
+     *
+     * A tumbling window is published once and reset; the next one starts
+     * at the boundary nowNs falls in, skipping empty windows. A sliding
+     * window first drops the samples older than its start, then is
+     * published; it is skipped while it holds nothing to report.
+     */
+    void Aggregator::publishDue(SensorWindow &sensor, unsigned long long nowNs)
+    {
+        if (!sensor.started)
+        {
+            return;
+        }
+        if (config.kind == WindowKind::Tumbling)
+        {
+            if (nowNs >= sensor.boundaryNs + lengthNs)
+            {
+                publish(sensor, sensor.boundaryNs, sensor.boundaryNs + lengthNs);
+                sensor.boundaryNs = nowNs - nowNs % lengthNs;
+            }
+            return;
+        }
+
+        while (nowNs >= sensor.boundaryNs)
+        {
+            unsigned long long startNs = (sensor.boundaryNs > lengthNs) ? sensor.boundaryNs - lengthNs : 0;
+            while (sensor.size > 0 && sensor.entries[sensor.head].timeNs < startNs)
+            {
+                const SensorWindow::Entry &oldest = sensor.entries[sensor.head];
+                for (int c = 0; c < AGG_CHANNELS; ++c)
+                {
+                    if (sensor.channels & (1u << c))
+                    {
+                        sensor.channel[c].stats.remove(oldest.values[c]);
+                        sensor.channel[c].sketch.remove(oldest.values[c]);
+                    }
+                }
+                sensor.head = (sensor.head + 1) % sensor.entries.size();
+                sensor.size--;
+            }
+            uint64_t firstSeq = (sensor.size > 0) ? sensor.entries[sensor.head].seq : sensor.nextSeq;
+            for (int c = 0; c < AGG_CHANNELS; ++c)
+            {
+                sensor.channel[c].minimum.expire(firstSeq);
+                sensor.channel[c].maximum.expire(firstSeq);
+            }
+            if (sensor.size > 0 || sensor.failures > 0)
+            {
+                publish(sensor, startNs, sensor.boundaryNs);
+            }
+            sensor.boundaryNs += cadenceNs;
+            if (sensor.size == 0 && nowNs >= sensor.boundaryNs)
+            {
+                // Idle sensor: jump to the first boundary after nowNs instead of stepping through empty windows
+                sensor.boundaryNs = nowNs - nowNs % cadenceNs + cadenceNs;
+            }
+        }
+    }
+
+    /**
+     * @brief Summarizes the sensor's window and hands it to the publisher.
+     *
+     * Tumbling state is reset afterwards; sliding state stays as it is.
+     */
+    void Aggregator::publish(SensorWindow &sensor, unsigned long long startNs, unsigned long long endNs)
+    {
+        bool tumbling = config.kind == WindowKind::Tumbling;
+        WindowResult result = {};
+        result.sensorId = sensor.id;
+        result.startNs = startNs;
+        result.endNs = endNs;
+        result.samples = tumbling ? sensor.samples : (unsigned long)sensor.size;
+        result.failures = sensor.failures;
+
+        ChannelSummary *summaries[AGG_CHANNELS] = {&result.temperature, &result.humidity, &result.light};
+        for (int c = 0; c < AGG_CHANNELS; ++c)
+        {
+            ChannelWindow &state = sensor.channel[c];
+            if (!(sensor.channels & (1u << c)) || state.stats.getCount() == 0)
+            {
+                continue;
+            }
+            ChannelSummary &summary = *summaries[c];
+            summary.count = state.stats.getCount();
+            summary.min = tumbling ? state.low : state.minimum.front();
+            summary.max = tumbling ? state.high : state.maximum.front();
+            summary.mean = state.stats.getMean();
+            summary.stddev = std::sqrt(state.stats.getVariance());
+            summary.p50 = state.sketch.quantile(0.50);
+            summary.p90 = state.sketch.quantile(0.90);
+            summary.p99 = state.sketch.quantile(0.99);
+            result.channels |= 1u << c;
+        }
+
+        if (result.samples > 0 || result.failures > 0)
+        {
+            publisher(result);
+            published++;
+        }
+        sensor.failures = 0;
+        if (tumbling)
+        {
+            sensor.samples = 0;
+            for (ChannelWindow &state : sensor.channel)
+            {
+                state.reset();
+            }
+        }
+    }
+} // namespace Processing
@@ -0,0 +1,454 @@
+#include "../Inc/Filters.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Processing
+{
+    static const char *const channelNames[FILTER_CHANNELS] = {"temperature", "humidity", "light"};
+
+    /**
+     * @brief Field of a reading that holds a channel.
+     */
+    float &channelOf(Sensors::SensorData &data, Channel channel)
+    {
+        switch (channel)
+        {
+        case Channel::Temperature:
+            return data.temperature;
+        case Channel::Humidity:
+            return data.humidity;
+        default:
+            return data.light;
+        }
+    }
+
+    /**
+     * @brief Constructs an empty window.
+     * @param length Number of values kept, at most FILTER_MAX_WINDOW.
+     */
+    SortedWindow::SortedWindow(size_t length)
+        : length(std::min<size_t>(std::max<size_t>(1, length), FILTER_MAX_WINDOW)), count(0), head(0)
+    {
+    }
+
+    /**
+     * @brief Adds a finite value, evicting the oldest once the window is full.
+     */
+    void SortedWindow::push(float value)
+    {
+        size_t slot;
+        if (count == length)
+        {
+            float oldest = ring[head];
+            size_t index = std::lower_bound(sorted, sorted + count, oldest) - sorted;
+            memmove(&sorted[index], &sorted[index + 1], (count - index - 1) * sizeof(float));
+            count--;
+            slot = head;
+            head = (head + 1) % length;
+        }
+        else
+        {
+            slot = (head + count) % length;
+        }
+        ring[slot] = value;
+        size_t index = std::upper_bound(sorted, sorted + count, value) - sorted;
+        memmove(&sorted[index + 1], &sorted[index], (count - index) * sizeof(float));
+        sorted[index] = value;
+        count++;
+    }
+
+    void SortedWindow::reset()
+    {
+        count = 0;
+        head = 0;
+    }
+
+    /**
+     * @brief Median of the window; the mean of the middle two for an even count, 0 when empty.
+     */
+    float SortedWindow::median() const
+    {
+        if (count == 0)
+        {
+            return 0.0f;
+        }
+        return (count & 1) ? sorted[count / 2] : 0.5f * (sorted[count / 2 - 1] + sorted[count / 2]);
+    }
+
+    /**
+     * @brief Median absolute deviation from the median.
+     *
+     * The deviations of the values below the median, walking down, and of
+     * those above it, walking up, are both ascending; merging the two
+     * sequences up to the middle rank finds the MAD without a sort.
+     */
+    float SortedWindow::mad() const
+    {
+        if (count == 0)
+        {
+            return 0.0f;
+        }
+        float center = median();
+        long below = (long)((count - 1) / 2); // walks down
+        size_t above = count / 2 + ((count & 1) ? 1 : 0); // walks up
+        if (count & 1)
+        {
+            below--; // the median itself has deviation 0 and is rank 0
+        }
+        size_t rank = (count & 1) ? 1 : 0;
+        float previous = 0.0f;
+        float current = 0.0f;
+        while (rank <= count / 2)
+        {
+            float down = (below >= 0) ? center - sorted[below] : INFINITY;
+            float up = (above < count) ? sorted[above] - center : INFINITY;
+            previous = current;
+            if (down <= up)
+            {
+                current = down;
+                below--;
+            }
+            else
+            {
+                current = up;
+                above++;
+            }
+            rank++;
+        }
+        return (count & 1) ? current : 0.5f * (previous + current);
+    }
+
+    /**
+     * @brief Constructs a range check.
+     * @param low Lowest plausible value.
+     * @param high Highest plausible value.
+     */
+    RangeFilter::RangeFilter(float low, float high) : low(low), high(high), last(0.0f), hasLast(false)
+    {
+    }
+
+    /**
+     * @brief Replaces an implausible value with the last accepted one.
+     * @return false if the value was rejected.
+     */
+    bool RangeFilter::process(float &value)
+    {
+        if (value >= low && value <= high) // false for NaN
+        {
+            last = value;
+            hasLast = true;
+            return true;
+        }
+        value = hasLast ? last : (value < low ? low : high);
+        return false;
+    }
+
+    /**
+     * @brief Range-checks a column in place.
+     * @return Number of rejected values.
+     */
+    size_t RangeFilter::processBatch(float *values, size_t count)
+    {
+        size_t rejections = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            rejections += !RangeFilter::process(values[i]);
+        }
+        return rejections;
+    }
+
+    /**
+     * @brief Constructs a median filter.
+     * @param length Window, odd so the median is one of the values; at most FILTER_MAX_WINDOW.
+     */
+    MedianFilter::MedianFilter(size_t length) : window(length)
+    {
+    }
+
+    /**
+     * @brief Replaces the value with the median of the window including it.
+     * @return true, unless the value was not finite (then it is replaced by the median so far).
+     */
+    bool MedianFilter::process(float &value)
+    {
+        if (!std::isfinite(value))
+        {
+            if (window.size() > 0)
+            {
+                value = window.median();
+            }
+            return false;
+        }
+        window.push(value);
+        value = window.median();
+        return true;
+    }
+
+    /**
+     * @brief Median-filters a column in place.
+     * @return Number of non-finite values replaced.
+     */
+    size_t MedianFilter::processBatch(float *values, size_t count)
+    {
+        size_t rejections = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            rejections += !MedianFilter::process(values[i]);
+        }
+        return rejections;
+    }
+
+    /**
+     * @brief Constructs a Hampel filter.
+     * @param length Window of recent values, at most FILTER_MAX_WINDOW.
+     * @param k Rejection threshold in robust standard deviations, typically 3.
+     * @param minSigma Smallest spread assumed, e.g. the sensor's resolution.
+     * @param minSamples Values needed in the window before anything is rejected.
+     */
+    HampelFilter::HampelFilter(size_t length, float k, float minSigma, size_t minSamples)
+        : window(length), k(k), minSigma(minSigma), minSamples(std::max<size_t>(1, minSamples))
+    {
+    }
+
+    /**
+     * @brief Replaces the value with the window median if it is an outlier.
+     * @return false if the value was rejected.
+     */
+    bool HampelFilter::process(float &value)
+    {
+        if (!std::isfinite(value))
+        {
+            if (window.size() > 0)
+            {
+                value = window.median();
+            }
+            return false;
+        }
+        window.push(value);
+        if (window.size() < minSamples)
+        {
+            return true;
+        }
+        float center = window.median();
+        float sigma = std::max(minSigma, FILTER_MAD_SCALE * window.mad());
+        if (std::fabs(value - center) > k * sigma)
+        {
+            value = center;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Hampel-filters a column in place.
+     * @return Number of rejected values.
+     */
+    size_t HampelFilter::processBatch(float *values, size_t count)
+    {
+        size_t rejections = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            rejections += !HampelFilter::process(values[i]);
+        }
+        return rejections;
+    }
+
+    /**
+     * @brief Constructs a Kalman filter; the first value initializes the estimate.
+     * @param processNoise Variance of the change of the true value per sample.
+     * @param measurementNoise Variance of one reading.
+     */
+    KalmanFilter::KalmanFilter(float processNoise, float measurementNoise)
+        : processNoise(processNoise), measurementNoise(measurementNoise), estimate(0.0f), variance(0.0f),
+          initialized(false)
+    {
+    }
+
+    /**
+     * @brief Updates the estimate with a reading and replaces the reading with it.
+     * @return true, unless the value was not finite (then it is replaced by the estimate so far).
+     */
+    bool KalmanFilter::process(float &value)
+    {
+        if (!std::isfinite(value))
+        {
+            if (initialized)
+            {
+                value = estimate;
+            }
+            return false;
+        }
+        if (!initialized)
+        {
+            estimate = value;
+            variance = measurementNoise;
+            initialized = true;
+            return true;
+        }
+        variance += processNoise;
+        float gain = variance / (variance + measurementNoise);
+        estimate += gain * (value - estimate);
+        variance *= 1.0f - gain;
+        value = estimate;
+        return true;
+    }
+
+    /**
+     * @brief Kalman-filters a column in place.
+     *
+     * The variance recurrence does not depend on the values and reaches a
+     * fixed point after a few dozen samples; from then on the update is a
+     * first-order IIR with a constant gain, so the loop switches to that
+     * and skips the variance arithmetic. The results are identical.
+     *
+     * @return Number of non-finite values replaced.
+     */
+    size_t KalmanFilter::processBatch(float *values, size_t count)
+    {
+        size_t rejections = 0;
+        size_t i = 0;
+        bool converged = false;
+        while (i < count && !converged)
+        {
+            float before = variance;
+            bool update = initialized && std::isfinite(values[i]);
+            rejections += !KalmanFilter::process(values[i]);
+            converged = update && variance == before;
+            ++i;
+        }
+        if (i >= count)
+        {
+            return rejections;
+        }
+
+        // Steady state: the variance is a fixed point, so only the estimate changes
+        float gain = (variance + processNoise) / (variance + processNoise + measurementNoise);
+        float current = estimate;
+        for (; i < count; ++i)
+        {
+            float value = values[i];
+            if (!std::isfinite(value))
+            {
+                rejections++;
+            }
+            else
+            {
+                current += gain * (value - current);
+            }
+            values[i] = current;
+        }
+        estimate = current;
+        return rejections;
+    }
+
+    /**
+     * @brief Constructs an empty pipeline.
+     * @param name Sensor name for the filter_rejected_total{sensor,channel} metric.
+     */
+    FilterPipeline::FilterPipeline(const char *name) : stages(), stageCount()
+    {
+        for (int c = 0; c < FILTER_CHANNELS; ++c)
+        {
+            char labels[METRICS_LABELS_SIZE];
+            snprintf(labels, sizeof(labels), "sensor=\"%s\",channel=\"%s\"", name, channelNames[c]);
+            rejected[c] = &Metrics::counter("filter_rejected_total", labels, "Values rejected and replaced by a filter");
+        }
+    }
+
+    /**
+     * @brief Appends a stage to a channel's chain.
+     * @param channel Channel to filter.
+     * @param filter Stage, not owned; must outlive the pipeline.
+     * @return false if the channel already has FILTER_MAX_STAGES stages.
+     */
+    bool FilterPipeline::add(Channel channel, Filter *filter)
+    {
+        size_t &count = stageCount[(int)channel];
+        if (filter == nullptr || count >= FILTER_MAX_STAGES)
+        {
+            return false;
+        }
+        stages[(int)channel][count++] = filter;
+        return true;
+    }
+
+    /**
+     * @brief Runs every channel of a reading through its stages.
+     * @param data Reading, filtered in place.
+     * @return false if any stage rejected a value; the reading then holds the replacement.
+     */
+    bool FilterPipeline::process(Sensors::SensorData &data)
+    {
+        bool accepted = true;
+        for (int c = 0; c < FILTER_CHANNELS; ++c)
+        {
+            float &value = channelOf(data, (Channel)c);
+            bool channelAccepted = true;
+            for (size_t s = 0; s < stageCount[c]; ++s)
+            {
+                channelAccepted &= stages[c][s]->process(value);
+            }
+            if (!channelAccepted)
+            {
+                rejected[c]->add();
+                accepted = false;
+            }
+        }
+        return accepted;
+    }
+
+    /**
+     * @brief Runs a recorded column through a channel's stages, one stage over the whole column at a time.
+     *
+     * The result equals calling process() value by value, since every stage
+     * only sees the output of the one before it.
+     *
+     * @return Number of rejections summed over the stages.
+     */
+    size_t FilterPipeline::processBatch(Channel channel, float *values, size_t count)
+    {
+        size_t rejections = 0;
+        for (size_t s = 0; s < stageCount[(int)channel]; ++s)
+        {
+            rejections += stages[(int)channel][s]->processBatch(values, count);
+        }
+        return rejections;
+    }
+
+    /**
+     * @brief Resets every stage.
+     */
+    void FilterPipeline::reset()
+    {
+        for (int c = 0; c < FILTER_CHANNELS; ++c)
+        {
+            for (size_t s = 0; s < stageCount[c]; ++s)
+            {
+                stages[c][s]->reset();
+            }
+        }
+    }
+
+    /**
+     * @brief Constructs a filtering front for a sensor.
+     */
+    FilteredSensor::FilteredSensor(Sensors::SensorBase &sensor, FilterPipeline &pipeline)
+        : sensor(sensor), pipeline(pipeline)
+    {
+    }
+
+    /**
+     * @brief Reads the sensor and filters the reading.
+     * @return false only if the sensor read failed.
+     */
+    bool FilteredSensor::read(Sensors::SensorData &data)
+    {
+        if (!sensor.read(data))
+        {
+            return false;
+        }
+        pipeline.process(data);
+        return true;
+    }
+} // namespace Processing
@@ -0,0 +1,168 @@
+#include "../Inc/WindowStats.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Processing
+{
+    /**
+     * @brief Summarizes a column of values.
+     *
+     * Each loop keeps COLUMN_LANES independent accumulators, which lets the
+     * compiler turn them into vector registers without reassociating a
+     * single floating-point sum. Sums are kept in double so long columns
+     * lose no precision.
+     *
+     * @param values Contiguous values.
+     * @param count Number of values, at least 1.
+     */
+    ColumnSummary summarizeColumn(const float *values, size_t count)
+    {
+        ColumnSummary summary;
+        double sum[COLUMN_LANES] = {0.0};
+        float low[COLUMN_LANES];
+        float high[COLUMN_LANES];
+        int invalid[COLUMN_LANES] = {0};
+        for (int j = 0; j < COLUMN_LANES; ++j)
+        {
+            low[j] = values[0];
+            high[j] = values[0];
+        }
+
+        size_t i = 0;
+        for (; i + COLUMN_LANES <= count; i += COLUMN_LANES)
+        {
+            for (int j = 0; j < COLUMN_LANES; ++j)
+            {
+                float x = values[i + j];
+                sum[j] += x;
+                low[j] = x < low[j] ? x : low[j];
+                high[j] = x > high[j] ? x : high[j];
+                invalid[j] |= !(x - x == 0.0f); // NaN for NaN and infinities
+            }
+        }
+        for (; i < count; ++i)
+        {
+            float x = values[i];
+            sum[0] += x;
+            low[0] = x < low[0] ? x : low[0];
+            high[0] = x > high[0] ? x : high[0];
+            invalid[0] |= !(x - x == 0.0f);
+        }
+
+        double total = 0.0;
+        int anyInvalid = 0;
+        summary.min = low[0];
+        summary.max = high[0];
+        for (int j = 0; j < COLUMN_LANES; ++j)
+        {
+            total += sum[j];
+            summary.min = std::min(summary.min, low[j]);
+            summary.max = std::max(summary.max, high[j]);
+            anyInvalid |= invalid[j];
+        }
+        summary.finite = !anyInvalid;
+        summary.mean = total / count;
+        summary.m2 = 0.0;
+        if (!summary.finite)
+        {
+            return summary;
+        }
+
+        double squares[COLUMN_LANES] = {0.0};
+        for (i = 0; i + COLUMN_LANES <= count; i += COLUMN_LANES)
+        {
+            for (int j = 0; j < COLUMN_LANES; ++j)
+            {
+                double delta = values[i + j] - summary.mean;
+                squares[j] += delta * delta;
+            }
+        }
+        for (; i < count; ++i)
+        {
+            double delta = values[i] - summary.mean;
+            squares[0] += delta * delta;
+        }
+        for (int j = 0; j < COLUMN_LANES; ++j)
+        {
+            summary.m2 += squares[j];
+        }
+        return summary;
+    }
+
+    /**
+     * @brief Constructs an empty sketch.
+     *
+     * If the range would need more than SKETCH_MAX_BINS bins at the given
+     * resolution, the resolution is coarsened to fit.
+     *
+     * @param low Lowest value counted exactly.
+     * @param high Highest value counted exactly.
+     * @param resolution Width of a bin.
+     */
+    QuantileSketch::QuantileSketch(float low, float high, float resolution) : low(low), resolution(resolution), total(0)
+    {
+        if (!(this->resolution > 0.0f))
+        {
+            this->resolution = 1.0f;
+        }
+        double span = std::max(0.0, (double)high - low);
+        size_t count = (size_t)std::lround(span / this->resolution) + 1;
+        if (count > SKETCH_MAX_BINS)
+        {
+            this->resolution = (float)(span / (SKETCH_MAX_BINS - 1));
+            count = SKETCH_MAX_BINS;
+        }
+        bins.assign(count, 0);
+    }
+
+    /**
+     * @brief Index of the bin whose centre is nearest to value, clamped to the range.
+     */
+    size_t QuantileSketch::binOf(float value) const
+    {
+        double position = std::round(((double)value - low) / resolution);
+        if (!(position > 0.0)) // also NaN
+        {
+            return 0;
+        }
+        return std::min((size_t)position, bins.size() - 1);
+    }
+
+    /**
+     * @brief Empties the sketch.
+     */
+    void QuantileSketch::reset()
+    {
+        std::fill(bins.begin(), bins.end(), 0);
+        total = 0;
+    }
+
+    /**
+     * @brief Estimates a quantile.
+     *
+     * Uses the nearest-rank definition: the smallest value with at least
+     * ceil(q * count) values at or below it.
+     *
+     * @param q Quantile between 0 and 1.
+     * @return Centre of the bin holding that rank, or 0 if the sketch is empty.
+     */
+    float QuantileSketch::quantile(double q) const
+    {
+        if (total == 0)
+        {
+            return 0.0f;
+        }
+        q = std::min(1.0, std::max(0.0, q));
+        size_t rank = std::max<size_t>(1, (size_t)std::ceil(q * total));
+        size_t seen = 0;
+        for (size_t i = 0; i < bins.size(); ++i)
+        {
+            seen += bins[i];
+            if (seen >= rank)
+            {
+                return low + (float)i * resolution;
+            }
+        }
+        return low + (float)(bins.size() - 1) * resolution;
+    }
+} // namespace Processing
@@ -0,0 +1,87 @@
+#ifndef CACHED_SENSOR_H
+#define CACHED_SENSOR_H
+
+#include "SensorBase.h"
+#include "../../common/Inc/Metrics.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+// Defaults of CachePolicy; the interval is the DHT22 minimum between reads
+#define CACHED_MIN_INTERVAL_MS 2000
+#define CACHED_RETRIES 2
+#define CACHED_BACKOFF_MS 2000
+#define CACHED_MAX_BACKOFF_MS 8000
+#define CACHED_MAX_AGE_MS 60000
+
+namespace Sensors
+{
+    // Rate limit, retry and staleness rules of a CachedSensor
+    struct CachePolicy
+    {
+        std::chrono::milliseconds minInterval{CACHED_MIN_INTERVAL_MS}; ///< rest between bus transactions
+        int retries = CACHED_RETRIES;                                  ///< extra attempts after a failed frame
+        std::chrono::milliseconds backoff{CACHED_BACKOFF_MS};          ///< rest before the first retry, doubled after each; at least minInterval
+        std::chrono::milliseconds maxBackoff{CACHED_MAX_BACKOFF_MS};
+        std::chrono::milliseconds maxAge{CACHED_MAX_AGE_MS};           ///< older values are not served; 0 = no limit
+    };
+
+    /**
+     * @class CachedSensor
+     * @brief Rate-limiting, retrying, single-flight front for a slow sensor.
+     *
+     * A read() inside the rest period after the last bus transaction is
+     * served from the last good value. A read() after it runs one
+     * transaction; callers that arrive meanwhile get the cached value, or
+     * wait for the transaction's result if there is none yet, so any number
+     * of consumers cause at most one transaction per minInterval. A failed
+     * transaction falls back to the last good value while it is younger
+     * than maxAge and lengthens the rest before the next one: a retry is
+     * the next read() after the backoff, which grows exponentially but
+     * never drops below minInterval. No call sleeps on the bus's behalf.
+     */
+    class CachedSensor : public SensorBase
+    {
+    public:
+        // sensor is not owned; name labels the cached_sensor_* metrics
+        CachedSensor(SensorBase &sensor, const char *name, const CachePolicy &policy = CachePolicy());
+
+        bool open() override;
+        // Fresh or cached value; false if there is no value younger than maxAge
+        bool read(SensorData &data) override;
+        // Same as read(), also returning how old the value is (0 for a value read by this call)
+        bool read(SensorData &data, std::chrono::nanoseconds &age);
+        void close() override;
+        bool isTimingCritical() const override { return sensor.isTimingCritical(); }
+        const SensorSchema &schema() const override { return sensor.schema(); }
+
+        unsigned long long getTransactions() const { return transactions->get(); }
+        unsigned long long getRetries() const { return retries->get(); }
+        unsigned long long getHits() const { return hits->get(); }
+        unsigned long long getFallbacks() const { return fallbacks->get(); }
+
+    private:
+        bool transact(SensorData &data);
+        long long restNs(bool ok);
+        bool serveCached(SensorData &data, std::chrono::nanoseconds &age, long long now);
+
+        SensorBase &sensor;
+        CachePolicy policy;
+        std::mutex lock;               ///< guards everything below
+        std::condition_variable done;  ///< signalled when a transaction finishes
+        bool inFlight;
+        bool hasValue;
+        SensorData lastGood;
+        long long lastGoodNs;          ///< when lastGood was read
+        long long lastTransactionNs;   ///< end of the last transaction, 0 before the first
+        long long nextTransactionNs;   ///< earliest start of the next one: rest or retry backoff
+        int failedTransactions;        ///< consecutive failures, reset by a success or after the last retry
+        Metrics::Counter *transactions;
+        Metrics::Counter *retries;
+        Metrics::Counter *hits;
+        Metrics::Counter *fallbacks;
+    };
+
+} // namespace Sensors
+
+#endif // CACHED_SENSOR_H
@@ -2,48 +2,99 @@
 #define DHT22_SENSOR_H
 
 #include "SensorBase.h"
+#include "DHT22Decoder.h"
 #include "../../periferia/Inc/gpio.h"
+#include "../../common/Inc/Realtime.h"
+#include "../../common/Inc/Timing.h"
+#include "../../common/Inc/Metrics.h"
+#include "../../common/Inc/AllocTracker.h"
 #include <iostream>
 #include <cstring>
-#include <thread>
 #include <chrono>
-#include <time.h>
 
-#define DHT22_DATA_BIT_COUNT 40
-#define DHT22_DATA_BYTE_COUNT 5
 #define TIMEOUT_US 100000
 
+// Host start signal: low for DHT22_START_LOW_US (datasheet minimum 1ms), then high
+#define DHT22_START_LOW_US 18000
+#define DHT22_START_HIGH_US 30
 
-#define HIGH_THRESHOLD_US 70
-#define LOW_THRESHOLD_US_MIN 26
-#define LOW_THRESHOLD_US_MAX 28
-
-#define DELAY_BETWEEN_BITS 50
-
-#define MS "ms"
-#define US "us"
+// Captured frame: idle level + ACK (3 edges) + 2 edges per bit + release, with margin
+#define DHT22_MAX_EDGES 96
+#define EDGE_TIMEOUT_MS 2
+// Polling capture stops once the line holds its level this long
+#define DHT22_IDLE_US 200
 
 namespace Sensors
 {
+    // How the response frame is sampled
+    enum class CaptureMode
+    {
+        Polling,      // busy-wait on gpio.read()
+        EdgeTriggered // sleep until the GPIO backend reports edges
+    };
+
+    // Lock-free instruments of one sensor, registered at construction
+    struct DHT22Metrics
+    {
+        Metrics::Counter *reads;
+        Metrics::Counter *gpioErrors;   // start signal or capture failed on the GPIO
+        Metrics::Counter *noResponse;
+        Metrics::Counter *truncated;
+        Metrics::Counter *timing;       // frame rejected for inconsistent bit timing (lost or moved edges)
+        Metrics::Counter *checksum;
+        Metrics::Histogram *readNs;     // whole read(), successful or not
+        Metrics::Histogram *startNs;    // host start pulse
+        Metrics::Histogram *ackNs;      // line release to the sensor pulling it low
+        Metrics::Histogram *captureNs;  // line release to the end of capture (ACK and bit loop)
+        Metrics::Histogram *decodeNs;   // pulse classification and checksum
+    };
 
     //// Define a DHT22Sensor class that inherits from SensorBase
     class DHT22Sensor : public SensorBase
     {
     public:
-        // DHT22Sensor class constructor, accepts GPIO pin number
-        explicit DHT22Sensor(int gpioPin);
-        
-        void delay(int time, const std::string& unit);
+        // DHT22Sensor class constructor, accepts GPIO pin number and GPIO access options
+        explicit DHT22Sensor(int gpioPin, const Periferia::GPIOConfig &gpioConfig = persistentGPIOConfig());
+
+        // Default GPIO options: keep the value fd open so edge polling costs one pread()
+        static Periferia::GPIOConfig persistentGPIOConfig();
+
         // Initialize the sensor, overrides the virtual method from SensorBase
         bool open() override;
         // Reading data from the sensor: temperature and humidity
         bool read(SensorData& data) override; 
         // Close the sensor
         void close() override;
+        // The 40-bit frame is decoded from microsecond pulse widths
+        bool isTimingCritical() const override { return true; }
+        // Temperature and humidity; the DHT22 has no light channel
+        const SensorSchema &schema() const override;
+        // Select polling or edge-triggered capture of the response frame
+        void setCaptureMode(CaptureMode mode) { captureMode = mode; }
+        // Length of the host's low start pulse; shorter pulses allow faster polling
+        void setStartPulse(std::chrono::microseconds low) { startPulse = low; }
+        // Run each read() in real-time mode (SCHED_FIFO, pinned, memory locked), restoring the thread afterwards
+        void setRealtime(bool enable, const Common::RealtimeConfig &config = Common::RealtimeConfig());
+        // Policy, CPU and memory state achieved by the last real-time read
+        const Common::RealtimeStatus &getRealtimeStatus() const { return realtimeStatus; }
+        // Longest time between two samples of the last polling capture
+        unsigned long long getPollGapNs() const { return pollGapNs; }
     private:
         Periferia::GPIO gpio; // Object for working with GPIO
+        CaptureMode captureMode;
+        std::chrono::microseconds startPulse;
+        bool realtime;
+        Common::RealtimeConfig realtimeConfig;
+        Common::RealtimeStatus realtimeStatus;
+        Periferia::EdgeEvent edges[DHT22_MAX_EDGES]; // Transitions of the last frame, preallocated
+        unsigned long long releaseNs; // When startSignal() released the line
+        unsigned long long pollGapNs; // Longest sampling gap of the last polling capture
+        DHT22Metrics metrics;
+        void registerMetrics(int gpioPin);
+        bool readFrame(SensorData &data);
         int startSignal();
-        int measure_signal_duration();
+        int capturePolling();
+        int captureEdges();
     };
 
 } // namespace Sensors
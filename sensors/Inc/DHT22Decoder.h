@@ -0,0 +1,61 @@
+#ifndef DHT22_DECODER_H
+#define DHT22_DECODER_H
+
+#include "SensorBase.h"
+#include "../../periferia/Inc/gpio_backend.h"
+#include <cstdint>
+
+#define DHT22_DATA_BIT_COUNT 40
+#define DHT22_DATA_BYTE_COUNT 5
+
+// Nominal high pulse widths: ~26-28us for a 0, ~70us for a 1
+#define HIGH_THRESHOLD_US 70
+#define LOW_THRESHOLD_US_MAX 28
+// Used when the frame holds a single bit value and no split can be learned
+#define BIT_SPLIT_US ((LOW_THRESHOLD_US_MAX + HIGH_THRESHOLD_US) / 2)
+// Narrowest 0/1 width spread that is treated as two clusters
+#define BIT_SEPARATION_US 20
+// Iterations of the 2-means threshold search
+#define BIT_SPLIT_ROUNDS 8
+// Largest distance of a bit's ~50us start low from the frame's median low
+#define BIT_LOW_TOLERANCE_US 25
+
+namespace Sensors
+{
+    // Outcome of decoding one frame
+    enum class DHT22Status
+    {
+        Ok,
+        NoResponse, // no complete high pulse: the sensor never answered
+        Truncated,  // fewer than 40 data pulses captured
+        Timing,     // a bit's start low strays from the others: an edge was lost or moved
+        Checksum    // bytes decoded but the checksum does not match
+    };
+
+    // Decoded frame plus the measurements the decision was based on
+    struct DHT22Frame
+    {
+        uint8_t bytes[DHT22_DATA_BYTE_COUNT];
+        unsigned long long pulseNs[DHT22_DATA_BIT_COUNT]; // high pulse width of each data bit
+        unsigned long long lowNs[DHT22_DATA_BIT_COUNT];   // low before each data bit, 0 if not captured
+        unsigned long long splitNs;                       // pulses at or above this are 1s
+    };
+
+    // Pure DHT22 frame decoder: works on recorded edges, never touches hardware
+    class DHT22Decoder
+    {
+    public:
+        // Classify the last 40 high pulses of an edge stream and verify the checksum
+        static DHT22Status decode(const Periferia::EdgeEvent *edges, int edgeCount, DHT22Frame &frame);
+        // Threshold separating short (0) and long (1) pulses of one frame
+        static unsigned long long adaptiveSplit(const unsigned long long *widthsNs, int count);
+        // True if every captured start low is within BIT_LOW_TOLERANCE_US of their median
+        static bool lowsConsistent(const unsigned long long *lowsNs, int count);
+        static bool checksumValid(const uint8_t *bytes);
+        // Convert frame bytes to humidity (%) and temperature (°C)
+        static void toSensorData(const uint8_t *bytes, SensorData &data);
+    };
+
+} // namespace Sensors
+
+#endif // DHT22_DECODER_H
@@ -0,0 +1,63 @@
+#ifndef DHT22_MODEL_H
+#define DHT22_MODEL_H
+
+#include "DHT22Decoder.h"
+#include "../../periferia/Inc/gpio_sim.h"
+
+// Nominal DHT22 answer timing
+#define DHT22_MODEL_RESPONSE_US 30
+#define DHT22_MODEL_ACK_US 80
+#define DHT22_MODEL_BIT_LOW_US 50
+#define DHT22_MODEL_ZERO_US 26
+#define DHT22_MODEL_ONE_US 70
+
+namespace Sensors
+{
+    // Reading and fault injection of the simulated sensor
+    struct DHT22ModelConfig
+    {
+        float humidity = 45.0f;
+        float temperature = 21.5f;
+        int jitterUs = 0;              // uniform +-jitter added to every low/high segment
+        double missingAckRate = 0.0;   // probability of not answering a start signal
+        double badChecksumRate = 0.0;  // probability of a frame with a corrupted checksum
+        unsigned int seed = 1;
+    };
+
+    /**
+     * @class DHT22Model
+     * @brief Timing model of a DHT22 answering on a simulated GPIO line.
+     *
+     * Attach it to a Periferia::SimBackend and inject the backend through
+     * GPIOConfig::customBackend to run DHT22Sensor::read() without hardware.
+     */
+    class DHT22Model : public Periferia::SimDevice
+    {
+    public:
+        explicit DHT22Model(const DHT22ModelConfig &config = DHT22ModelConfig());
+
+        int respond(unsigned long long lowNs, unsigned long long releaseNs, Periferia::EdgeEvent *edges,
+                    int maxEdges) override;
+
+        void setReading(float humidity, float temperature);
+        // Encode a reading the way the sensor sends it
+        static void encode(float humidity, float temperature, uint8_t *bytes);
+
+        unsigned long getAnswered() const { return answered; }
+        unsigned long getSilent() const { return silent; }
+        unsigned long getCorrupted() const { return corrupted; }
+
+    private:
+        double uniform();
+        long long segmentNs(int us);
+
+        DHT22ModelConfig config;
+        unsigned long long rngState;
+        unsigned long answered;
+        unsigned long silent;
+        unsigned long corrupted;
+    };
+
+} // namespace Sensors
+
+#endif // DHT22_MODEL_H
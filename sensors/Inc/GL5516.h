@@ -1,26 +1,78 @@
-// #ifndef GL5516_SENSOR_H
-// #define GL5516_SENSOR_H
+#ifndef GL5516_SENSOR_H
+#define GL5516_SENSOR_H
 
-// #include "SensorBase.h"
-// #include <iostream>
-// #include "../../periferia/Inc/gpio.h"
+#include "SensorBase.h"
+#include "../../periferia/Inc/iio.h"
+#include "../../common/Inc/Metrics.h"
+#include <vector>
 
-// namespace Sensors
-// {
+// ADC samples averaged per reading
+#define GL5516_OVERSAMPLE 64
+// Divider: the LDR and a fixed resistor between the supply and ground, ADC on the midpoint
+#define GL5516_SUPPLY_MV 3300.0f
+#define GL5516_FIXED_OHMS 10000.0f
+// Datasheet: 5-10 kOhm at 10 lux, gamma (log R10/R100) 0.5
+#define GL5516_R10_OHMS 7500.0f
+#define GL5516_GAMMA 0.5f
+#define GL5516_MAX_LUX 100000.0f
+// Longest wait for the first buffered sample
+#define GL5516_TIMEOUT_MS 100
 
-//     class GL5516Sensor : public SensorBase
-//     {
-//     public:
-//         explicit GL5516Sensor(int gpioPin);
-//         bool open() override;
-//         bool read(SensorData &data) override;
-//         void close() override;
+namespace Sensors
+{
+    // ADC channel, oversampling and divider of a GL5516
+    struct GL5516Config
+    {
+        Periferia::IIOConfig adc;
+        size_t oversample = GL5516_OVERSAMPLE;
+        float supplyMv = GL5516_SUPPLY_MV;     ///< also the ADC full scale when the device reports no scale
+        float fixedOhms = GL5516_FIXED_OHMS;
+        bool ldrToGround = true;               ///< LDR between the ADC input and ground (darker reads higher)
+        float r10Ohms = GL5516_R10_OHMS;
+        float gamma = GL5516_GAMMA;
+        int timeoutMs = GL5516_TIMEOUT_MS;
+    };
 
-//     private:
-//         int gpioPin;
-//         Periferia::GPIO gpio;
-//     };
+    /**
+     * @class GL5516Sensor
+     * @brief GL5516 photoresistor in a voltage divider, read through an IIO ADC.
+     *
+     * Each reading averages up to `oversample` ADC samples, taken in one
+     * block from the IIO buffer (or one by one from sysfs without
+     * buffering), and converts the average to lux through a table built
+     * in open() for every raw code of the ADC.
+     */
+    class GL5516Sensor : public SensorBase
+    {
+    public:
+        explicit GL5516Sensor(const GL5516Config &config = GL5516Config());
 
-// } // namespace Sensors
+        bool open() override;
+        // Illuminance in data.light, lux
+        bool read(SensorData &data) override;
+        void close() override;
+        const SensorSchema &schema() const override;
 
-// #endif // GL5516_SENSOR_H
+        // Lux for an averaged raw ADC value, interpolated in the table
+        float toLux(float raw) const;
+        // Average of the samples taken by the last read()
+        float getLastRaw() const { return lastRaw; }
+
+    private:
+        void buildTable();
+
+        GL5516Config config;
+        Periferia::IIOAdc adc;
+        std::vector<float> luxTable;   ///< lux per raw code, built in open()
+        std::vector<uint16_t> samples; ///< oversampling buffer, allocated once
+        float lastRaw;
+        Metrics::Counter *reads;
+        Metrics::Counter *failures;
+    };
+
+    // Mean of count samples; multi-accumulator loop so it vectorizes
+    float averageSamples(const uint16_t *samples, size_t count);
+
+} // namespace Sensors
+
+#endif // GL5516_SENSOR_H
@@ -1,6 +1,10 @@
 #ifndef SENSOR_BASE_H
 #define SENSOR_BASE_H
 
+#include <cstddef>
+
+// Most channels a sensor can declare
+#define SENSOR_MAX_CHANNELS 8
 
 namespace Sensors {
 
@@ -9,8 +13,29 @@ struct SensorData {
     float humidity;
     float light;
 };
+
+// One value a sensor reports, e.g. {"temperature", "C"}
+struct ChannelInfo {
+    const char *name;
+    const char *unit;
+};
+
+// Channels of a sensor, in the order readChannels() fills them
+struct SensorSchema {
+    size_t count;
+    ChannelInfo channels[SENSOR_MAX_CHANNELS];
+
+    // Index of the channel with this name, or -1
+    int find(const char *name) const;
+};
+
+// Schema of the SensorData fields: temperature, humidity, light
+const SensorSchema &legacySchema();
+// Fill values[] for each schema channel named like a SensorData field; NaN for other channels
+void fromSensorData(const SensorSchema &schema, const SensorData &data, float *values);
+
 // Base class for sensor interface
-class SensorBase 
+class SensorBase
 {
 public:
 // Virtual destructor to ensure proper cleanup of derived classes
@@ -21,9 +46,15 @@ public:
     virtual bool read(SensorData& data) = 0;
     // Close the sensor and release resources
     virtual void close() = 0;
+    // True for bit-banged protocols that need a dedicated real-time worker
+    virtual bool isTimingCritical() const { return false; }
+    // Channels and units this sensor reports; by default the three SensorData fields
+    virtual const SensorSchema &schema() const { return legacySchema(); }
+    // Read one value per schema channel; by default read() mapped through fromSensorData()
+    virtual bool readChannels(float *values);
 };
 
 } // namespace Sensors
 
 
-#endif // SENSOR_BASE_H
\ No newline at end of file
+#endif // SENSOR_BASE_H
@@ -0,0 +1,91 @@
+#ifndef SENSOR_REGISTRY_H
+#define SENSOR_REGISTRY_H
+
+/*
+ * Sensor drivers by type name.
+ *
+ * Every driver registers a SensorType from its own translation unit: how
+ * many arena bytes an instance needs, how to construct one from its
+ * configuration, and which sysfs pin it will claim. A configuration
+ * loader can then size one arena for all instances, export their pins in
+ * one pass and construct every driver in place, without knowing any
+ * driver by name.
+ */
+
+#include "SensorBase.h"
+#include "../../common/Inc/Arena.h"
+#include "../../periferia/Inc/gpio_setup.h"
+
+#define REGISTRY_MAX_TYPES 16
+#define REGISTRY_MAX_KEYS 16
+#define REGISTRY_NAME_SIZE 32
+#define REGISTRY_KEY_SIZE 24
+#define REGISTRY_VALUE_SIZE 72
+// Reading period of a sensor whose configuration sets none; the DHT22 minimum
+#define REGISTRY_DEFAULT_PERIOD_MS 2000
+
+namespace Sensors
+{
+    // One configured sensor instance: its name, driver type, period and driver keys
+    struct SensorConfig
+    {
+        char name[REGISTRY_NAME_SIZE];
+        char type[REGISTRY_NAME_SIZE];
+        unsigned int periodMs;
+        int line;                                    ///< line of the configuration file, for messages
+        int keyCount;
+        char keys[REGISTRY_MAX_KEYS][REGISTRY_KEY_SIZE];
+        char values[REGISTRY_MAX_KEYS][REGISTRY_VALUE_SIZE];
+
+        // Value of a key, or fallback if it is not set
+        const char *get(const char *key, const char *fallback = nullptr) const;
+        int getInt(const char *key, int fallback) const;
+        float getFloat(const char *key, float fallback) const;
+        // Add or replace a key; false if the value is too long or there are too many keys
+        bool set(const char *key, const char *value);
+    };
+
+    // A driver the registry can instantiate
+    struct SensorType
+    {
+        const char *name;
+        // Arena bytes create() takes for this configuration, at most
+        size_t (*footprint)(const SensorConfig &config);
+        // Construct the driver in the arena; nullptr (with an error logged) if the configuration is invalid
+        SensorBase *(*create)(const SensorConfig &config, Common::Arena &arena);
+        // Sysfs pin the driver will claim, for a bulk setupPins() pass; nullptr or false if none
+        bool (*sysfsPin)(const SensorConfig &config, Periferia::GPIOPinSetup &pin, const char *&sysfsRoot);
+    };
+
+    /**
+     * @class SensorRegistry
+     * @brief Table of sensor types, filled by static registrations before main().
+     */
+    class SensorRegistry
+    {
+    public:
+        static SensorRegistry &instance();
+
+        // false if the table is full or the name is taken
+        bool registerType(const SensorType &type);
+        // nullptr for unknown names
+        const SensorType *findType(const char *name) const;
+        int getTypeCount() const { return typeCount; }
+        const SensorType &getType(int index) const { return types[index]; }
+
+    private:
+        SensorRegistry();
+
+        SensorType types[REGISTRY_MAX_TYPES];
+        int typeCount;
+    };
+
+    // Registers a type when its translation unit is initialized
+    struct SensorTypeRegistration
+    {
+        explicit SensorTypeRegistration(const SensorType &type);
+    };
+
+} // namespace Sensors
+
+#endif // SENSOR_REGISTRY_H
@@ -0,0 +1,186 @@
+#include "../Inc/CachedSensor.h"
+#include "../../common/Inc/Log.h"
+#include "../../common/Inc/Timing.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace Sensors
+{
+    /**
+     * @brief Wraps a sensor with a cache, rate limit and retries.
+     * @param sensor Sensor that performs the bus transactions, not owned.
+     * @param name Value of the sensor label of the cached_sensor_* metrics.
+     * @param policy Minimum interval, retry backoff and maximum value age.
+     */
+    CachedSensor::CachedSensor(SensorBase &sensor, const char *name, const CachePolicy &policy)
+        : sensor(sensor), policy(policy), inFlight(false), hasValue(false), lastGood(), lastGoodNs(0),
+          lastTransactionNs(0), nextTransactionNs(0), failedTransactions(0)
+    {
+        char labels[METRICS_LABELS_SIZE];
+        snprintf(labels, sizeof(labels), "sensor=\"%s\"", name);
+        transactions = &Metrics::counter("cached_sensor_transactions_total", labels, "Bus transactions incl. retries");
+        retries = &Metrics::counter("cached_sensor_retries_total", labels, "Retried failed frames");
+        hits = &Metrics::counter("cached_sensor_hits_total", labels, "Reads served without a bus transaction");
+        fallbacks = &Metrics::counter("cached_sensor_fallbacks_total", labels,
+                                      "Failed transactions answered with the last good value");
+    }
+
+    /**
+     * @brief Opens the wrapped sensor.
+     */
+    bool CachedSensor::open()
+    {
+        return sensor.open();
+    }
+
+    /**
+     * @brief Returns a fresh or cached value.
+     * @param data Receives the value.
+     * @return true if a value younger than maxAge was returned.
+     */
+    bool CachedSensor::read(SensorData &data)
+    {
+        std::chrono::nanoseconds age;
+        return read(data, age);
+    }
+
+    /**
+     * @brief Returns a fresh or cached value and its age.
+     *
+     * Only one caller at a time runs a transaction, and only once the rest
+     * after the previous one (restNs()) has passed. The lock is not
+     * held during the transaction, so other callers are answered from the
+     * cache meanwhile; without a cached value they wait for its result.
+     *
+     * @param data Receives the value.
+     * @param age Receives the time since the value was read from the bus.
+     * @return true if a value younger than maxAge was returned.
+     */
+    bool CachedSensor::read(SensorData &data, std::chrono::nanoseconds &age)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        for (;;)
+        {
+            long long now = Common::monotonicNowNs();
+            bool rested = now >= nextTransactionNs;
+
+            if (inFlight || !rested)
+            {
+                if (serveCached(data, age, now))
+                {
+                    hits->add();
+                    return true;
+                }
+                if (!inFlight)
+                {
+                    return false; // the last transaction failed and the sensor still needs rest
+                }
+                done.wait(guard, [this]() { return !inFlight; });
+                continue;
+            }
+
+            inFlight = true;
+            if (failedTransactions > 0)
+            {
+                retries->add();
+            }
+            guard.unlock();
+            SensorData fresh;
+            bool ok = transact(fresh);
+            guard.lock();
+            inFlight = false;
+            lastTransactionNs = Common::monotonicNowNs();
+            nextTransactionNs = lastTransactionNs + restNs(ok);
+            if (ok)
+            {
+                lastGood = fresh;
+                lastGoodNs = lastTransactionNs;
+                hasValue = true;
+            }
+            done.notify_all();
+
+            if (ok)
+            {
+                data = fresh;
+                age = std::chrono::nanoseconds(0);
+                return true;
+            }
+            if (serveCached(data, age, lastTransactionNs))
+            {
+                fallbacks->add();
+                return true;
+            }
+            return false;
+        }
+    }
+
+    /**
+     * @brief Runs one bus transaction.
+     * @param data Receives the value on success.
+     * @return true if the sensor returned a valid frame.
+     */
+    bool CachedSensor::transact(SensorData &data)
+    {
+        transactions->add();
+        return sensor.read(data);
+    }
+
+    /**
+     * @brief Rest the bus needs after a transaction, counting its failures. Call with the lock held.
+     *
+     * A success rests minInterval. The n-th consecutive failure waits
+     * backoff * 2^(n-1), capped at maxBackoff and never below minInterval,
+     * so a retry can not hit the sensor sooner than a normal read would.
+     * After the last retry the count starts over at the normal rest.
+     *
+     * @param ok Whether the transaction succeeded.
+     * @return Nanoseconds until the next transaction may start.
+     */
+    long long CachedSensor::restNs(bool ok)
+    {
+        std::chrono::milliseconds rest = policy.minInterval;
+        if (ok)
+        {
+            failedTransactions = 0;
+        }
+        else if (failedTransactions++ < policy.retries)
+        {
+            std::chrono::milliseconds backoff = policy.backoff;
+            for (int i = 1; i < failedTransactions && backoff < policy.maxBackoff; ++i)
+            {
+                backoff *= 2;
+            }
+            rest = std::max(std::min(backoff, policy.maxBackoff), policy.minInterval);
+        }
+        else
+        {
+            LOG_WARN("Sensor read failed after %d attempts.\n", failedTransactions);
+            failedTransactions = 0;
+        }
+        return (long long)rest.count() * 1000000LL;
+    }
+
+    /**
+     * @brief Copies the last good value if it is not older than maxAge. Call with the lock held.
+     * @return true if a value was copied.
+     */
+    bool CachedSensor::serveCached(SensorData &data, std::chrono::nanoseconds &age, long long now)
+    {
+        long long ageNs = now - lastGoodNs;
+        if (!hasValue || (policy.maxAge.count() > 0 && ageNs > policy.maxAge.count() * 1000000LL))
+        {
+            return false;
+        }
+        data = lastGood;
+        age = std::chrono::nanoseconds(ageNs);
+        return true;
+    }
+
+    /**
+     * @brief Closes the wrapped sensor; the cached value is kept.
+     */
+    void CachedSensor::close()
+    {
+        sensor.close();
+    }
+} // namespace Sensors
@@ -1,22 +1,9 @@
 #include "../Inc/DHT22.h"
+#include "../Inc/DHT22Model.h"
+#include "../Inc/SensorRegistry.h"
+#include "../../common/Inc/Log.h"
+#include <algorithm>
 
-/*
- * DHT22 data protocol:
- *
- * The first 5 bytes contain humidity, temperature and checksum information:
- *
- * 1st byte (byte 0): high byte for humidity.
- * 2nd byte (byte 1): low byte for humidity.
- * 3rd byte (byte 2): high byte for temperature.
- * 4th byte (byte 3): low byte for temperature.
- * 5th byte (byte 4): checksum, to check data integrity.
- *
- * Data format:
- * - Humidity (two bytes) - 0.1% in whole percent
- * - Temperature (two bytes) - 0.1°C in whole degrees
- * - Checksum - the sum of the first four bytes (humidity and temperature)
- *
- */
 namespace Sensors
 {
     /**
@@ -25,9 +12,90 @@ namespace Sensors
      * Initializes the DHT22 sensor with the specified GPIO pin.
      *
      * @param gpioPin The GPIO pin number to which the sensor is connected.
+     * @param gpioConfig Access mode and sysfs root used for the pin.
      */
-    DHT22Sensor::DHT22Sensor(int gpioPin) : SensorBase(), gpio(gpioPin, OUTPUT)
+    DHT22Sensor::DHT22Sensor(int gpioPin, const Periferia::GPIOConfig &gpioConfig)
+        : SensorBase(), gpio(gpioPin, OUTPUT, gpioConfig), captureMode(CaptureMode::Polling),
+          startPulse(DHT22_START_LOW_US),
+          realtime(false), releaseNs(0), pollGapNs(0)
     {
+        // Measure sleep overshoot and start the log sink now rather than inside the first read
+        Common::calibrateTiming();
+        Log::start();
+        registerMetrics(gpioPin);
+    }
+
+    /**
+     * @brief Registers the read, failure and phase metrics of this sensor, labelled with its pin.
+     * @param gpioPin The GPIO pin number of the sensor.
+     */
+    void DHT22Sensor::registerMetrics(int gpioPin)
+    {
+        char labels[METRICS_LABELS_SIZE];
+        const char *failureHelp = "Failed DHT22 reads by cause";
+        const char *phaseHelp = "Duration of the DHT22 protocol phases";
+
+        snprintf(labels, sizeof(labels), "pin=\"%d\"", gpioPin);
+        metrics.reads = &Metrics::counter("dht22_reads_total", labels, "DHT22 read attempts");
+        metrics.readNs = &Metrics::histogram("dht22_read_duration_seconds", labels, "DHT22 read() latency");
+
+        snprintf(labels, sizeof(labels), "pin=\"%d\",cause=\"gpio\"", gpioPin);
+        metrics.gpioErrors = &Metrics::counter("dht22_read_failures_total", labels, failureHelp);
+        snprintf(labels, sizeof(labels), "pin=\"%d\",cause=\"no_response\"", gpioPin);
+        metrics.noResponse = &Metrics::counter("dht22_read_failures_total", labels, failureHelp);
+        snprintf(labels, sizeof(labels), "pin=\"%d\",cause=\"truncated\"", gpioPin);
+        metrics.truncated = &Metrics::counter("dht22_read_failures_total", labels, failureHelp);
+        snprintf(labels, sizeof(labels), "pin=\"%d\",cause=\"timing\"", gpioPin);
+        metrics.timing = &Metrics::counter("dht22_read_failures_total", labels, failureHelp);
+        snprintf(labels, sizeof(labels), "pin=\"%d\",cause=\"checksum\"", gpioPin);
+        metrics.checksum = &Metrics::counter("dht22_read_failures_total", labels, failureHelp);
+
+        snprintf(labels, sizeof(labels), "pin=\"%d\",phase=\"start\"", gpioPin);
+        metrics.startNs = &Metrics::histogram("dht22_phase_duration_seconds", labels, phaseHelp);
+        snprintf(labels, sizeof(labels), "pin=\"%d\",phase=\"ack\"", gpioPin);
+        metrics.ackNs = &Metrics::histogram("dht22_phase_duration_seconds", labels, phaseHelp);
+        snprintf(labels, sizeof(labels), "pin=\"%d\",phase=\"capture\"", gpioPin);
+        metrics.captureNs = &Metrics::histogram("dht22_phase_duration_seconds", labels, phaseHelp);
+        snprintf(labels, sizeof(labels), "pin=\"%d\",phase=\"decode\"", gpioPin);
+        metrics.decodeNs = &Metrics::histogram("dht22_phase_duration_seconds", labels, phaseHelp);
+    }
+
+    /**
+     * @brief Returns the GPIO configuration used by default for the DHT22.
+     *
+     * The value file stays open for the lifetime of the sensor, so every poll
+     * in capturePolling() is a single pread() instead of open/read/close.
+     */
+    Periferia::GPIOConfig DHT22Sensor::persistentGPIOConfig()
+    {
+        Periferia::GPIOConfig config;
+        config.mode = Periferia::AccessMode::Persistent;
+        return config;
+    }
+
+    /**
+     * @brief Enables or disables real-time mode for read().
+     *
+     * When enabled, every read() switches the calling thread to SCHED_FIFO,
+     * pins it, locks memory and prefaults the stack and capture buffer
+     * before the start signal, then restores the thread's policy and
+     * affinity. Only the first real-time read of a thread locks memory and
+     * walks the stack; later ones pay for the policy and affinity switch.
+     * Missing privileges only downgrade the mode; see getRealtimeStatus()
+     * for what was achieved.
+     *
+     * @param enable true to run reads in real-time mode.
+     * @param config Priority, CPU and memory options.
+     */
+    void DHT22Sensor::setRealtime(bool enable, const Common::RealtimeConfig &config)
+    {
+        realtime = enable;
+        realtimeConfig = config;
+        if (enable && config.cpu == REALTIME_CPU_ISOLATED)
+        {
+            // The first lookup reads sysfs through stdio, which allocates; keep it out of read()
+            Common::firstIsolatedCpu();
+        }
     }
 
     /**
@@ -40,213 +108,364 @@ namespace Sensors
      */
     bool DHT22Sensor::open()
     {
-        if (!gpio.open(O_WRONLY))
+        if (gpio.open(O_WRONLY) == ERROR)
         {
-            printf("Failed to open GPIO for writing\n");
+            LOG_ERROR("Failed to open GPIO for writing\n");
             return false;
         }
         return true;
     }
 
 
-    void DHT22Sensor::delay(int time, const std::string &unit)
-    {
-        if (unit == MS)
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds(time));
-        }
-        else if (unit == US)
-        {
-            std::this_thread::sleep_for(std::chrono::microseconds(time));
-        }
-        else
-        {
-            printf("Error: Unsupported time unit code.\n");
-        }
-    }
     /**
      * @brief Resets the DHT22 signal.
      *
-     * This method sends a start signal to the DHT22 sensor, waits for its response,
-     * and checks if the sensor is ready to communicate.
+     * This method sends a start signal to the DHT22 sensor and releases the
+     * line; the acknowledge is checked by the decoder as part of the frame.
+     * In edge mode the edges are selected before the release, so the switch
+     * to input arms them in the same step (one pwrite() on sysfs, the same
+     * ioctl on the chardev) instead of costing an extra call in the window
+     * where the sensor starts answering.
      *
      * @return ERROR if there is an issue with the communication, OK otherwise.
      */
     int DHT22Sensor::startSignal()
     {
-        // Set low level (0) for 18ms to start communication
-        if (gpio.write(LOW) == ERROR) 
+        // The previous transaction left the pin as an input
+        if (gpio.setDirection(OUTPUT) == FAILED)
         {
-            printf("Failed to set GPIO low.\n");
+            LOG_ERROR("Failed to set GPIO direction.\n");
             return ERROR;
         }
-        delay(18,MS);
 
-        // Set high level (1) for 20-40us for DHT22 to detect the start signal
-        if (gpio.write(HIGH) == ERROR)
+        // In edge mode the backend records the transitions for us
+        if (captureMode == CaptureMode::EdgeTriggered && gpio.setEdge(Periferia::Edge::Both) == FAILED)
         {
-            printf("Failed to set GPIO high.\n");
+            LOG_ERROR("Failed to enable GPIO edge events.\n");
             return ERROR;
         }
-        delay(30,US);
-        
-        
-        // Step 2: Set direction to input for reading response
-        if(gpio.setDirection(INPUT) == FAILED)
+
+        // Set low level (0) for 18ms (startPulse) to start communication
+        if (gpio.write(LOW) == ERROR) 
         {
-            printf("Failed to set GPIO direction.\n");
+            LOG_ERROR("Failed to set GPIO low.\n");
             return ERROR;
         }
-        usleep(10);
+        Common::delay(startPulse);
 
-        
-        // Step 3: Wait for DHT22 response signal
-        delay(80,US);
-
-        // Check if the bus is high, indicating DHT22 is responding
-        if (gpio.read() != LOW)
+        // Set high level (1) for 20-40us for DHT22 to detect the start signal
+        if (gpio.write(HIGH) == ERROR)
         {
-            printf("DHT22 not responding!\n");
-            return ERROR; 
+            LOG_ERROR("Failed to set GPIO high.\n");
+            return ERROR;
         }
-
-        // Step 4: Wait for the next signal from DHT22
-        delay(80 , US);
+        Common::delay(std::chrono::microseconds(DHT22_START_HIGH_US));
         
-        if (gpio.read() == HIGH)
-        {
-            printf("DHT22 started to send data!\n");
-        }
-        else
+        
+        // Step 2: Release the line; the response is captured straight away
+        if(gpio.setDirection(INPUT) == FAILED)
         {
-            printf("Incorrect response from DHT22!\n");
-            return ERROR; 
+            LOG_ERROR("Failed to set GPIO direction.\n");
+            return ERROR;
         }
+        releaseNs = Periferia::monotonicNs();
         return OK;
     }
+    /**
+     * @brief Channels of the DHT22: temperature in degrees C and relative humidity, 0.1 resolution.
+     */
+    const SensorSchema &DHT22Sensor::schema() const
+    {
+        static const SensorSchema dht22Schema = {2, {{"temperature", "C"}, {"humidity", "%RH"}}};
+        return dht22Schema;
+    }
+
     /**
      * @brief Reads data from the DHT22 sensor.
      *
-     * This method reads 5 bytes of data from the sensor, calculates the humidity
-     * and temperature values, and verifies the checksum.
+     * The read has two stages: the response is first captured as a list of
+     * timestamped level transitions, with no decoding or sleeping inside the
+     * capture loop, and then handed to DHT22Decoder, which classifies the
+     * pulse widths and verifies the checksum. With setRealtime() the whole
+     * read runs in real-time mode. Every read is counted and timed in the
+     * dht22_* metrics.
      *
      * @param data A reference to the SensorData object to store the read values.
      * @return true if data is read successfully, false otherwise.
      */
     bool DHT22Sensor::read(SensorData &data)
+    {
+        Common::NoAllocScope noAlloc("DHT22Sensor::read");
+        unsigned long long start = Periferia::monotonicNs();
+        metrics.reads->add();
+        bool success;
+        if (!realtime)
+        {
+            success = readFrame(data);
+        }
+        else
+        {
+            Common::RealtimeScope scope(realtimeConfig);
+            realtimeStatus = scope.getStatus();
+            Common::prefault(edges, sizeof(edges));
+            success = readFrame(data);
+        }
+        metrics.readNs->record(Periferia::monotonicNs() - start);
+        return success;
+    }
+
+    /**
+     * @brief Start signal, capture and decode of one frame.
+     * @param data Receives the decoded values.
+     * @return true if a valid frame was read.
+     */
+    bool DHT22Sensor::readFrame(SensorData &data)
     {
         // Reset the signal before reading data
+        unsigned long long phaseStart = Periferia::monotonicNs();
         if (startSignal() == ERROR)
         {
-            printf("Failed to start signal.\n");
+            LOG_ERROR("Failed to start signal.\n");
+            metrics.gpioErrors->add();
             return false;
         }
-        uint8_t buffer[DHT22_DATA_BYTE_COUNT] = {0};
+        metrics.startNs->record(releaseNs - phaseStart);
 
-        // Read 5 bytes (40 bits) of data from the sensor
-        for (size_t i = 0; i < DHT22_DATA_BIT_COUNT; ++i)
+        int edgeCount;
+        if (captureMode == CaptureMode::EdgeTriggered)
         {
-            // Measure signal duration to determine bit value
-            int bit = measure_signal_duration(); // Wait for HIGH signal
-            if (bit == ERROR)
-            {
-                printf("Error: Failed to read bit!\n");
-                return false; // Error reading bit
-            }
-            // Store the bit in the buffer
-            buffer[i / 8] <<= 1; // Shift left for the new bit
-            if (bit == HIGH)
-            {
-                buffer[i / 8] |= 1; // Set bit to 1
-            }
-
-            // Wait for 50us before reading the next bit
-            //std::this_thread::sleep_for(std::chrono::microseconds(50));
-            delay(DELAY_BETWEEN_BITS,US);
+            edgeCount = captureEdges();
         }
-
-        // Checksum verification
-        uint8_t checksum = (buffer[0] + buffer[1] + buffer[2] + buffer[3]) & 0xFF;
-        if (checksum != buffer[4])
+        else
         {
-            printf("Checksum error!\n");
-            return false; // Checksum validation failed
+            edgeCount = capturePolling();
+        }
+        unsigned long long captureEnd = Periferia::monotonicNs();
+        if (edgeCount == ERROR)
+        {
+            LOG_ERROR("Failed to capture DHT22 response!\n");
+            metrics.gpioErrors->add();
+            return false;
+        }
+        metrics.captureNs->record(captureEnd - releaseNs);
+        for (int i = 0; i < edgeCount; ++i)
+        {
+            // The sensor's answer starts with it pulling the line low
+            if (edges[i].value == LOW && edges[i].timestampNs >= releaseNs)
+            {
+                metrics.ackNs->record(edges[i].timestampNs - releaseNs);
+                break;
+            }
         }
-        // Humidity calculation
-        data.humidity = ((buffer[0] << 8) | buffer[1]) * 0.1f;
-        // Temperature calculation
-
-        int16_t rawTemperature = ((buffer[2] & 0x7F) << 8) | buffer[3];
 
-        // if the high bit is set, the temperature is negative
-        if (buffer[2] & 0x80)
+        DHT22Frame frame;
+        DHT22Status status = DHT22Decoder::decode(edges, edgeCount, frame);
+        metrics.decodeNs->record(Periferia::monotonicNs() - captureEnd);
+        switch (status)
         {
-            rawTemperature = -rawTemperature;
+        case DHT22Status::Ok:
+            break;
+        case DHT22Status::NoResponse:
+            LOG_WARN("DHT22 not responding!\n");
+            metrics.noResponse->add();
+            return false;
+        case DHT22Status::Truncated:
+            LOG_WARN("Incomplete frame from DHT22 (%d edges)!\n", edgeCount);
+            metrics.truncated->add();
+            return false;
+        case DHT22Status::Timing:
+            LOG_WARN("Inconsistent DHT22 bit timing, edges lost during capture!\n");
+            metrics.timing->add();
+            return false;
+        case DHT22Status::Checksum:
+            LOG_WARN("Checksum error!\n");
+            metrics.checksum->add();
+            return false;
         }
-        // result in degrees Celsius
-        data.temperature = rawTemperature * 0.1f;
-        printf("Temperature: %.2f C, Humidity: %.2f %%\n", data.temperature, data.humidity);
+        DHT22Decoder::toSensorData(frame.bytes, data);
         return true;
     }
+
     /**
-     * @brief Measures the duration of a signal from the DHT22 sensor.
+     * @brief Records the response frame by busy-polling the line.
      *
-     * This method waits for the LOW signal to start measuring,
-     * then waits for the HIGH signal and calculates its duration.
+     * The loop only samples the level and stores a timestamp when it changes;
+     * classification happens afterwards, so a bit no longer loses time to
+     * the work done for the previous one. The first entry is the level seen
+     * when capture starts. Capture ends when the buffer is full, when the
+     * line has not changed for DHT22_IDLE_US (the sensor released the bus or
+     * never answered) or after TIMEOUT_US. The longest time between two
+     * samples is kept for getPollGapNs(): a gap near a pulse width means
+     * the thread was descheduled and edges may be lost.
      *
-     * @return LOW if the measured signal corresponds to bit 0,
-     *         HIGH if the measured signal corresponds to bit 1,
-     *         ERROR if there is a timeout or measurement issue.
+     * @return Number of entries stored in edges[], or ERROR.
      */
-    int DHT22Sensor::measure_signal_duration()
+    int DHT22Sensor::capturePolling()
     {
-        struct timespec start, end;
-        int value = -1;
-
-        // Record the initial time
-        clock_gettime(CLOCK_MONOTONIC, &start);
-
-        // Wait for the LOW signal (start of bit transmission)
-        while (gpio.read() != LOW)
+        int level = gpio.read();
+        if (level == ERROR)
         {
-            clock_gettime(CLOCK_MONOTONIC, &end);
-            long elapsed_time = (end.tv_sec - start.tv_sec) * 1000000 +
-                                (end.tv_nsec - start.tv_nsec) / 1000;
+            return ERROR;
+        }
+        unsigned long long start = Periferia::monotonicNs();
+        unsigned long long lastChange = start;
+        unsigned long long lastSample = start;
+        pollGapNs = 0;
+        edges[0].timestampNs = start;
+        edges[0].value = level;
+        int count = 1;
 
-            if (elapsed_time > TIMEOUT_US)
+        while (count < DHT22_MAX_EDGES)
+        {
+            int value = gpio.read();
+            unsigned long long now = Periferia::monotonicNs();
+            if (value == ERROR)
+            {
+                return ERROR;
+            }
+            pollGapNs = std::max(pollGapNs, now - lastSample);
+            lastSample = now;
+            if (value != level)
             {
-                return ERROR; // Timeout occurred
+                edges[count].timestampNs = now;
+                edges[count].value = value;
+                count++;
+                level = value;
+                lastChange = now;
+            }
+            else if (now - lastChange > DHT22_IDLE_US * 1000ULL || now - start > TIMEOUT_US * 1000ULL)
+            {
+                break;
             }
         }
+        return count;
+    }
 
-        // Wait for high level and measure its duration
-        clock_gettime(CLOCK_MONOTONIC, &start);
-        // Wait until the signal becomes HIGH
-        while (gpio.read() == LOW)
-            ;
-
-        clock_gettime(CLOCK_MONOTONIC, &end);
-        long elapsed_time = (end.tv_sec - start.tv_sec) * 1000000 +
-                            (end.tv_nsec - start.tv_nsec) / 1000;
-
-        // Check the duration of the HIGH signal to determine bit value
-        if (elapsed_time >= LOW_THRESHOLD_US_MIN && elapsed_time <= LOW_THRESHOLD_US_MAX)
-        {
-            return LOW; // Bit 0
-        }
-        else if (elapsed_time >= HIGH_THRESHOLD_US && elapsed_time <= TIMEOUT_US)
+    /**
+     * @brief Records the level transitions of one response frame.
+     *
+     * Sleeps between edges instead of spinning on gpio.read(). The sysfs
+     * backend delivers one edge per wake-up; the chardev backend returns
+     * kernel-timestamped batches, usually the whole frame in a few reads.
+     * Capture ends when the buffer is full or the line stays idle for
+     * EDGE_TIMEOUT_MS, which happens once the sensor releases the bus.
+     *
+     * @return Number of edges stored in edges[], or ERROR.
+     */
+    int DHT22Sensor::captureEdges()
+    {
+        int count = 0;
+        while (count < DHT22_MAX_EDGES)
         {
-            return HIGH; // Bit 1
+            int result = gpio.readEdges(&edges[count], DHT22_MAX_EDGES - count, EDGE_TIMEOUT_MS);
+            if (result == ERROR)
+            {
+                return ERROR;
+            }
+            if (result == 0)
+            {
+                break; // Line idle: frame complete or sensor silent
+            }
+            count += result;
         }
-
-        return ERROR; // Measurement issue
+        return count;
     }
+
     /**
      * @brief Closes the GPIO associated with the DHT22 sensor.
      */
     void DHT22Sensor::close()
     {
         gpio.close();
-        printf("Closing DHT22\n");
+        LOG_DEBUG("Closing DHT22\n");
     }
+
+    namespace
+    {
+        bool isSimulated(const SensorConfig &config)
+        {
+            return strcmp(config.get("backend", "sysfs"), "sim") == 0;
+        }
+
+        size_t dht22Footprint(const SensorConfig &config)
+        {
+            size_t bytes = Common::Arena::footprint<DHT22Sensor>();
+            if (isSimulated(config))
+            {
+                bytes += Common::Arena::footprint<DHT22Model>() + Common::Arena::footprint<Periferia::SimBackend>();
+            }
+            return bytes;
+        }
+
+        /**
+         * @brief Builds a DHT22 from its keys.
+         *
+         * Keys: pin, backend (sysfs|cdev|mmap|sim), sysfs_root, chip, line,
+         * capture (polling|edges), start_low_us, realtime (0|1). The sim
+         * backend places a DHT22Model (sim_temperature, sim_humidity) and
+         * its SimBackend (instant_edges) in the arena next to the sensor.
+         */
+        SensorBase *createDHT22(const SensorConfig &config, Common::Arena &arena)
+        {
+            Periferia::GPIOConfig gpioConfig = DHT22Sensor::persistentGPIOConfig();
+            const char *backend = config.get("backend", "sysfs");
+            if (!isSimulated(config) && !Periferia::parseBackend(backend, gpioConfig.backend))
+            {
+                LOG_ERROR("Sensor %s: unknown GPIO backend %s\n", config.name, backend);
+                return nullptr;
+            }
+            const char *capture = config.get("capture", "polling");
+            if (strcmp(capture, "polling") != 0 && strcmp(capture, "edges") != 0)
+            {
+                LOG_ERROR("Sensor %s: capture must be polling or edges, got %s\n", config.name, capture);
+                return nullptr;
+            }
+            gpioConfig.sysfsRoot = config.get("sysfs_root", GPIO_SYSFS_ROOT);
+            gpioConfig.chipPath = config.get("chip", GPIO_CHIP_PATH);
+            gpioConfig.chipLine = config.getInt("line", -1);
+            if (isSimulated(config))
+            {
+                DHT22ModelConfig modelConfig;
+                modelConfig.temperature = config.getFloat("sim_temperature", modelConfig.temperature);
+                modelConfig.humidity = config.getFloat("sim_humidity", modelConfig.humidity);
+                DHT22Model *model = arena.create<DHT22Model>(modelConfig);
+                if (model == nullptr)
+                {
+                    return nullptr;
+                }
+                gpioConfig.customBackend =
+                    arena.create<Periferia::SimBackend>(model, config.getInt("instant_edges", 0) != 0);
+                if (gpioConfig.customBackend == nullptr)
+                {
+                    return nullptr;
+                }
+            }
+
+            DHT22Sensor *sensor = arena.create<DHT22Sensor>(config.getInt("pin", GPIO_DHT22), gpioConfig);
+            if (sensor == nullptr)
+            {
+                return nullptr;
+            }
+            if (strcmp(capture, "edges") == 0)
+            {
+                sensor->setCaptureMode(CaptureMode::EdgeTriggered);
+            }
+            sensor->setStartPulse(std::chrono::microseconds(config.getInt("start_low_us", DHT22_START_LOW_US)));
+            sensor->setRealtime(config.getInt("realtime", 0) != 0);
+            return sensor;
+        }
+
+        bool dht22SysfsPin(const SensorConfig &config, Periferia::GPIOPinSetup &pin, const char *&sysfsRoot)
+        {
+            if (strcmp(config.get("backend", "sysfs"), "sysfs") != 0)
+            {
+                return false;
+            }
+            pin = Periferia::GPIOPinSetup{config.getInt("pin", GPIO_DHT22), OUTPUT};
+            sysfsRoot = config.get("sysfs_root", GPIO_SYSFS_ROOT);
+            return true;
+        }
+
+        const SensorTypeRegistration dht22Type({"dht22", dht22Footprint, createDHT22, dht22SysfsPin});
+    } // namespace
 } // namespace Sensors
@@ -0,0 +1,220 @@
+#include "../Inc/DHT22Decoder.h"
+#include <algorithm>
+
+/*
+ * DHT22 data protocol:
+ *
+ * The first 5 bytes contain humidity, temperature and checksum information:
+ *
+ * 1st byte (byte 0): high byte for humidity.
+ * 2nd byte (byte 1): low byte for humidity.
+ * 3rd byte (byte 2): high byte for temperature.
+ * 4th byte (byte 3): low byte for temperature.
+ * 5th byte (byte 4): checksum, to check data integrity.
+ *
+ * Data format:
+ * - Humidity (two bytes) - 0.1% in whole percent
+ * - Temperature (two bytes) - 0.1°C in whole degrees
+ * - Checksum - the sum of the first four bytes (humidity and temperature)
+ *
+ * On the wire every bit is a ~50us low followed by a high pulse whose
+ * width carries the value. The frame is preceded by an 80us low / 80us
+ * high acknowledge and followed by the sensor releasing the line.
+ */
+namespace Sensors
+{
+    /**
+     * @brief Decodes one frame from a stream of level transitions.
+     *
+     * Every rising edge followed by a falling edge is a high pulse; the last
+     * 40 of them are the data bits, so a missed or extra leading edge (line
+     * idle level, ACK) does not shift the frame. Bits are classified against
+     * a threshold learned from the frame itself.
+     *
+     * A capture that stalled (a polling thread descheduled for longer than
+     * a pulse) loses or moves edges, and about one such frame in 256 still
+     * passes the checksum with the wrong reading. The sensor starts every
+     * bit with the same ~50us low, so a frame whose lows disagree is
+     * rejected as Timing before the checksum is looked at.
+     *
+     * @param edges Transitions in time order.
+     * @param edgeCount Number of entries in edges.
+     * @param frame Receives the bytes, the pulse widths and the threshold used.
+     * @return Ok, or the reason the frame was rejected.
+     */
+    DHT22Status DHT22Decoder::decode(const Periferia::EdgeEvent *edges, int edgeCount, DHT22Frame &frame)
+    {
+        unsigned long long widthsNs[DHT22_DATA_BIT_COUNT];
+        unsigned long long lowsNs[DHT22_DATA_BIT_COUNT];
+        int pulses = 0;
+
+        // Keep only the last 40 pulses in a circular window
+        for (int i = 0; i + 1 < edgeCount; ++i)
+        {
+            if (edges[i].value == HIGH && edges[i + 1].value == LOW)
+            {
+                widthsNs[pulses % DHT22_DATA_BIT_COUNT] = edges[i + 1].timestampNs - edges[i].timestampNs;
+                lowsNs[pulses % DHT22_DATA_BIT_COUNT] =
+                    (i > 0 && edges[i - 1].value == LOW) ? edges[i].timestampNs - edges[i - 1].timestampNs : 0;
+                pulses++;
+            }
+        }
+        if (pulses == 0)
+        {
+            return DHT22Status::NoResponse;
+        }
+        if (pulses < DHT22_DATA_BIT_COUNT)
+        {
+            return DHT22Status::Truncated;
+        }
+
+        int first = pulses % DHT22_DATA_BIT_COUNT;
+        for (int i = 0; i < DHT22_DATA_BIT_COUNT; ++i)
+        {
+            frame.pulseNs[i] = widthsNs[(first + i) % DHT22_DATA_BIT_COUNT];
+            frame.lowNs[i] = lowsNs[(first + i) % DHT22_DATA_BIT_COUNT];
+        }
+        frame.splitNs = adaptiveSplit(frame.pulseNs, DHT22_DATA_BIT_COUNT);
+
+        for (int i = 0; i < DHT22_DATA_BYTE_COUNT; ++i)
+        {
+            frame.bytes[i] = 0;
+        }
+        for (int i = 0; i < DHT22_DATA_BIT_COUNT; ++i)
+        {
+            frame.bytes[i / 8] <<= 1;
+            if (frame.pulseNs[i] >= frame.splitNs)
+            {
+                frame.bytes[i / 8] |= 1;
+            }
+        }
+        if (!lowsConsistent(frame.lowNs, DHT22_DATA_BIT_COUNT))
+        {
+            return DHT22Status::Timing;
+        }
+        return checksumValid(frame.bytes) ? DHT22Status::Ok : DHT22Status::Checksum;
+    }
+
+    /**
+     * @brief Checks that the start lows of one frame agree with each other.
+     *
+     * Compared with their median rather than the nominal 50us, so a capture
+     * path that delays rising and falling edges by different amounts (which
+     * shortens every low by the same constant) still passes. Lows that were
+     * not captured (0) are skipped.
+     *
+     * @param lowsNs Low widths.
+     * @param count Number of widths, at most DHT22_DATA_BIT_COUNT.
+     * @return false if any low is further than BIT_LOW_TOLERANCE_US from the median.
+     */
+    bool DHT22Decoder::lowsConsistent(const unsigned long long *lowsNs, int count)
+    {
+        unsigned long long sorted[DHT22_DATA_BIT_COUNT];
+        int captured = 0;
+        for (int i = 0; i < count && captured < DHT22_DATA_BIT_COUNT; ++i)
+        {
+            if (lowsNs[i] != 0)
+            {
+                sorted[captured++] = lowsNs[i];
+            }
+        }
+        if (captured == 0)
+        {
+            return true;
+        }
+        std::nth_element(sorted, sorted + captured / 2, sorted + captured);
+        unsigned long long median = sorted[captured / 2];
+        for (int i = 0; i < captured; ++i)
+        {
+            unsigned long long distance = (sorted[i] > median) ? sorted[i] - median : median - sorted[i];
+            if (distance > BIT_LOW_TOLERANCE_US * 1000ULL)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Finds the threshold between 0 and 1 pulses of one frame.
+     *
+     * Two-means clustering: start at the midpoint of the shortest and longest
+     * pulse, then move to the midpoint of the two cluster means until it
+     * settles. This follows a sensor whose timing drifts with temperature or
+     * supply voltage, and a capture path that adds a constant latency to
+     * every pulse. If the spread is too small for two clusters (all bits
+     * equal) the nominal BIT_SPLIT_US is used.
+     *
+     * @param widthsNs Pulse widths.
+     * @param count Number of widths.
+     * @return Threshold in nanoseconds.
+     */
+    unsigned long long DHT22Decoder::adaptiveSplit(const unsigned long long *widthsNs, int count)
+    {
+        unsigned long long shortest = widthsNs[0];
+        unsigned long long longest = widthsNs[0];
+        for (int i = 1; i < count; ++i)
+        {
+            shortest = (widthsNs[i] < shortest) ? widthsNs[i] : shortest;
+            longest = (widthsNs[i] > longest) ? widthsNs[i] : longest;
+        }
+        if (longest - shortest < BIT_SEPARATION_US * 1000ULL)
+        {
+            return BIT_SPLIT_US * 1000ULL;
+        }
+
+        unsigned long long split = (shortest + longest) / 2;
+        for (int round = 0; round < BIT_SPLIT_ROUNDS; ++round)
+        {
+            unsigned long long sums[2] = {0, 0};
+            int counts[2] = {0, 0};
+            for (int i = 0; i < count; ++i)
+            {
+                int cluster = (widthsNs[i] >= split) ? 1 : 0;
+                sums[cluster] += widthsNs[i];
+                counts[cluster]++;
+            }
+            if (counts[0] == 0 || counts[1] == 0)
+            {
+                break;
+            }
+            unsigned long long next = (sums[0] / counts[0] + sums[1] / counts[1]) / 2;
+            if (next == split)
+            {
+                break;
+            }
+            split = next;
+        }
+        return split;
+    }
+
+    /**
+     * @brief Checks that byte 4 is the low byte of the sum of bytes 0-3.
+     */
+    bool DHT22Decoder::checksumValid(const uint8_t *bytes)
+    {
+        uint8_t checksum = (bytes[0] + bytes[1] + bytes[2] + bytes[3]) & 0xFF;
+        return checksum == bytes[4];
+    }
+
+    /**
+     * @brief Converts frame bytes to physical values.
+     * @param bytes Frame bytes (checksum already verified).
+     * @param data Receives humidity and temperature.
+     */
+    void DHT22Decoder::toSensorData(const uint8_t *bytes, SensorData &data)
+    {
+        // Humidity calculation
+        data.humidity = ((bytes[0] << 8) | bytes[1]) * 0.1f;
+
+        // Temperature calculation
+        int16_t rawTemperature = ((bytes[2] & 0x7F) << 8) | bytes[3];
+        // if the high bit is set, the temperature is negative
+        if (bytes[2] & 0x80)
+        {
+            rawTemperature = -rawTemperature;
+        }
+        // result in degrees Celsius
+        data.temperature = rawTemperature * 0.1f;
+    }
+} // namespace Sensors
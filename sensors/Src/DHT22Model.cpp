@@ -0,0 +1,119 @@
+#include "../Inc/DHT22Model.h"
+#include <cmath>
+
+namespace Sensors
+{
+    /**
+     * @brief Constructs a sensor model with a fixed reading and fault rates.
+     * @param config Reading, jitter, fault probabilities and random seed.
+     */
+    DHT22Model::DHT22Model(const DHT22ModelConfig &config)
+        : config(config), rngState(config.seed == 0 ? 1 : config.seed), answered(0), silent(0), corrupted(0)
+    {
+    }
+
+    /**
+     * @brief Changes the reading sent in the following frames.
+     */
+    void DHT22Model::setReading(float humidity, float temperature)
+    {
+        config.humidity = humidity;
+        config.temperature = temperature;
+    }
+
+    /**
+     * @brief Encodes humidity and temperature into the 5 frame bytes.
+     * @param humidity Relative humidity in %.
+     * @param temperature Temperature in °C; negative values set the sign bit.
+     * @param bytes Receives humidity, temperature and checksum.
+     */
+    void DHT22Model::encode(float humidity, float temperature, uint8_t *bytes)
+    {
+        unsigned int rawHumidity = (unsigned int)lroundf(humidity * 10.0f);
+        unsigned int rawTemperature = (unsigned int)lroundf(fabsf(temperature) * 10.0f);
+        bytes[0] = (rawHumidity >> 8) & 0xFF;
+        bytes[1] = rawHumidity & 0xFF;
+        bytes[2] = ((rawTemperature >> 8) & 0x7F) | (temperature < 0 ? 0x80 : 0);
+        bytes[3] = rawTemperature & 0xFF;
+        bytes[4] = (bytes[0] + bytes[1] + bytes[2] + bytes[3]) & 0xFF;
+    }
+
+    /**
+     * @brief Produces the answer to a start signal.
+     *
+     * Starting DHT22_MODEL_RESPONSE_US after the release: 80us low, 80us high
+     * (ACK), then per bit 50us low and a 26us (0) or 70us (1) high, then a
+     * final 50us low before the line is released. Every segment gets its own
+     * jitter.
+     *
+     * @param lowNs Start of the host's low pulse (unused: any pulse accepted by the backend counts).
+     * @param releaseNs Time the host released the line.
+     * @param edges Receives the waveform.
+     * @param maxEdges Capacity of edges.
+     * @return Number of edges, 0 when the model decides not to answer.
+     */
+    int DHT22Model::respond(unsigned long long lowNs, unsigned long long releaseNs, Periferia::EdgeEvent *edges,
+                            int maxEdges)
+    {
+        (void)lowNs;
+        if (uniform() < config.missingAckRate)
+        {
+            silent++;
+            return 0;
+        }
+
+        uint8_t bytes[DHT22_DATA_BYTE_COUNT];
+        encode(config.humidity, config.temperature, bytes);
+        if (uniform() < config.badChecksumRate)
+        {
+            bytes[4] ^= 0x01;
+            corrupted++;
+        }
+
+        int count = 0;
+        unsigned long long t = releaseNs;
+        auto add = [&](int us, int value) {
+            if (count < maxEdges)
+            {
+                t += segmentNs(us);
+                edges[count].timestampNs = t;
+                edges[count].value = value;
+                count++;
+            }
+        };
+
+        add(DHT22_MODEL_RESPONSE_US, LOW);
+        add(DHT22_MODEL_ACK_US, HIGH);
+        add(DHT22_MODEL_ACK_US, LOW);
+        for (int i = 0; i < DHT22_DATA_BIT_COUNT; ++i)
+        {
+            bool one = bytes[i / 8] & (0x80 >> (i % 8));
+            add(DHT22_MODEL_BIT_LOW_US, HIGH);
+            add(one ? DHT22_MODEL_ONE_US : DHT22_MODEL_ZERO_US, LOW);
+        }
+        add(DHT22_MODEL_BIT_LOW_US, HIGH);
+        answered++;
+        return count;
+    }
+
+    /**
+     * @brief Uniform random number in [0, 1) (xorshift64).
+     */
+    double DHT22Model::uniform()
+    {
+        rngState ^= rngState << 13;
+        rngState ^= rngState >> 7;
+        rngState ^= rngState << 17;
+        return (rngState >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    /**
+     * @brief Length of one waveform segment with jitter applied, never below 1us.
+     */
+    long long DHT22Model::segmentNs(int us)
+    {
+        double jitter = (config.jitterUs > 0) ? (uniform() * 2.0 - 1.0) * config.jitterUs : 0.0;
+        double length = us + jitter;
+        return (long long)((length < 1.0 ? 1.0 : length) * 1000.0);
+    }
+} // namespace Sensors
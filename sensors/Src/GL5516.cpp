@@ -1,57 +1,238 @@
-// #include "../Inc/GL5516.h"
-// #include <iostream> 
-
-// namespace Sensors {
-
-// /**
-//  * @brief Constructor for the GL5516 sensor.
-//  * 
-//  * @param gpioPin The GPIO pin number the sensor is connected to.
-//  */
-// GL5516Sensor::GL5516Sensor(int gpioPin) : gpioPin(gpioPin) {}
-
-// /**
-//  * @brief Initializes the GL5516 sensor.
-//  * 
-//  * This function sets up the necessary configurations for the sensor 
-//  * and prepares it for operation.
-//  * 
-//  * @return true if initialization is successful, false otherwise.
-//  */
-// bool GL5516Sensor::open() {
-//     std::cout << "Initializing GL5516 sensor on GPIO pin " << gpioPin << std::endl;
-//     // Add GPIO initialization code here if required
-//     return true;
-// }
-
-// /**
-//  * @brief Reads light intensity from the GL5516 sensor.
-//  * 
-//  * This function reads the current light intensity value from the sensor 
-//  * and stores it in the provided SensorData structure.
-//  * 
-//  * @param data A reference to a SensorData structure where the light 
-//  *             intensity value will be stored.
-//  * @return true if reading is successful, false otherwise.
-//  */
-// bool GL5516Sensor::read(SensorData& data) {
-//     std::cout << "Reading light intensity from GL5516 sensor on GPIO pin " << gpioPin << std::endl;
-//     int lightValue = gpio.read();
-//     data.light = static_cast<float>(lightValue);
-//     std::cout << "Light Level: " << data.light << std::endl;
-//     return true;
-// }
-
-// /**
-//  * @brief Closes the GL5516 sensor and releases resources.
-//  * 
-//  * This function performs necessary cleanup operations for the sensor, 
-//  * such as releasing GPIO pins or other resources used during its 
-//  * operation.
-//  */
-// void GL5516Sensor::close() {
-//     std::cout << "Closing GL5516 sensor on GPIO pin " << gpioPin << std::endl;
-//     // Add code for closing/releasing GPIO if required
-// }
-
-// } // namespace Sensors
\ No newline at end of file
+#include "../Inc/GL5516.h"
+#include "../Inc/SensorRegistry.h"
+#include "../../common/Inc/Log.h"
+#include <cmath>
+
+// Independent accumulators in averageSamples()
+#define GL5516_LANES 16
+
+namespace Sensors
+{
+    /**
+     * @brief Mean of ADC samples.
+     *
+     * 16-bit samples are summed into GL5516_LANES 32-bit lanes, which the
+     * compiler maps onto vector registers; no lane can overflow for fewer
+     * than 65537 samples per lane.
+     *
+     * @param samples Raw ADC codes.
+     * @param count Number of samples, at least 1.
+     */
+    float averageSamples(const uint16_t *samples, size_t count)
+    {
+        uint32_t lanes[GL5516_LANES] = {0};
+        size_t i = 0;
+        for (; i + GL5516_LANES <= count; i += GL5516_LANES)
+        {
+            for (int j = 0; j < GL5516_LANES; ++j)
+            {
+                lanes[j] += samples[i + j];
+            }
+        }
+        uint64_t total = 0;
+        for (; i < count; ++i)
+        {
+            total += samples[i];
+        }
+        for (int j = 0; j < GL5516_LANES; ++j)
+        {
+            total += lanes[j];
+        }
+        return (float)((double)total / count);
+    }
+
+    /**
+     * @brief Constructor for the GL5516 sensor. The ADC is not touched until open().
+     * @param config ADC channel, oversampling, divider and photoresistor parameters.
+     */
+    GL5516Sensor::GL5516Sensor(const GL5516Config &config)
+        : config(config), adc(config.adc), samples(std::max<size_t>(1, config.oversample)), lastRaw(0.0f)
+    {
+        char labels[METRICS_LABELS_SIZE];
+        snprintf(labels, sizeof(labels), "device=\"iio:device%d\",channel=\"%d\"", config.adc.device,
+                 config.adc.channel);
+        reads = &Metrics::counter("gl5516_reads_total", labels, "GL5516 read() calls");
+        failures = &Metrics::counter("gl5516_read_failures_total", labels, "GL5516 reads without a sample");
+    }
+
+    /**
+     * @brief Opens the ADC channel and builds the lux table for its resolution.
+     * @return true if the ADC could be opened.
+     */
+    bool GL5516Sensor::open()
+    {
+        if (adc.init() != SUCCESS)
+        {
+            LOG_ERROR("GL5516: cannot open iio:device%d channel %d.\n", config.adc.device, config.adc.channel);
+            return false;
+        }
+        buildTable();
+        return true;
+    }
+
+    /**
+     * @brief Builds the raw code to lux table.
+     *
+     * The divider voltage gives the LDR resistance; the GL5516 follows
+     * R = R10 * (lux / 10)^-gamma, so lux = 10 * (R10 / R)^(1 / gamma).
+     * Codes at the rails, where the resistance is zero or infinite, are
+     * clamped to GL5516_MAX_LUX and 0.
+     */
+    void GL5516Sensor::buildTable()
+    {
+        size_t codes = (size_t)1 << adc.getBits();
+        float mvPerCode = (adc.getScale() > 0.0f) ? adc.getScale() : config.supplyMv / (float)(codes - 1);
+        luxTable.resize(codes);
+        for (size_t code = 0; code < codes; ++code)
+        {
+            double volts = code * (double)mvPerCode;
+            double supply = config.supplyMv;
+            double resistance;
+            if (config.ldrToGround)
+            {
+                resistance = (volts >= supply) ? INFINITY : config.fixedOhms * volts / (supply - volts);
+            }
+            else
+            {
+                resistance = (volts <= 0.0) ? INFINITY : config.fixedOhms * (supply - volts) / volts;
+            }
+            double lux;
+            if (resistance <= 0.0)
+            {
+                lux = GL5516_MAX_LUX;
+            }
+            else if (std::isinf(resistance))
+            {
+                lux = 0.0;
+            }
+            else
+            {
+                lux = std::min<double>(GL5516_MAX_LUX, 10.0 * std::pow(config.r10Ohms / resistance, 1.0 / config.gamma));
+            }
+            luxTable[code] = (float)lux;
+        }
+    }
+
+    /**
+     * @brief Converts an averaged raw value to lux.
+     *
+     * The average falls between two codes; the table entries of both are
+     * interpolated linearly.
+     */
+    float GL5516Sensor::toLux(float raw) const
+    {
+        if (luxTable.empty())
+        {
+            return 0.0f;
+        }
+        float last = (float)(luxTable.size() - 1);
+        raw = std::min(std::max(raw, 0.0f), last);
+        size_t low = (size_t)raw;
+        if (low >= luxTable.size() - 1)
+        {
+            return luxTable.back();
+        }
+        float fraction = raw - (float)low;
+        return luxTable[low] + fraction * (luxTable[low + 1] - luxTable[low]);
+    }
+
+    /**
+     * @brief Reads the light intensity.
+     *
+     * Buffered: takes what the buffer holds, up to `oversample` samples,
+     * in one read, waiting at most timeoutMs if it is empty. Otherwise
+     * `oversample` one-shot conversions through sysfs.
+     *
+     * @param data data.light receives lux; the other fields are left alone.
+     * @return true if at least one sample was read.
+     */
+    bool GL5516Sensor::read(SensorData &data)
+    {
+        reads->add();
+        int count;
+        if (adc.isBuffered())
+        {
+            count = adc.readSamples(samples.data(), samples.size(), config.timeoutMs);
+        }
+        else
+        {
+            count = 0;
+            for (size_t i = 0; i < samples.size(); ++i)
+            {
+                int raw = adc.readRaw();
+                if (raw == ERROR)
+                {
+                    break;
+                }
+                samples[count++] = (uint16_t)raw;
+            }
+        }
+        if (count <= 0)
+        {
+            failures->add();
+            return false;
+        }
+        lastRaw = averageSamples(samples.data(), (size_t)count);
+        data.light = toLux(lastRaw);
+        return true;
+    }
+
+    /**
+     * @brief Closes the GL5516 sensor, stopping the ADC buffer.
+     */
+    void GL5516Sensor::close()
+    {
+        adc.close();
+    }
+
+    /**
+     * @brief The GL5516 reports illuminance only.
+     */
+    const SensorSchema &GL5516Sensor::schema() const
+    {
+        static const SensorSchema gl5516Schema = {1, {{"light", "lx"}}};
+        return gl5516Schema;
+    }
+
+    namespace
+    {
+        size_t gl5516Footprint(const SensorConfig &)
+        {
+            return Common::Arena::footprint<GL5516Sensor>();
+        }
+
+        /**
+         * @brief Builds a GL5516 from its keys.
+         *
+         * Keys: device, channel, buffered (0|1), trigger, sysfs_root,
+         * dev_root, oversample, supply_mv, fixed_ohms, ldr_to_ground (0|1),
+         * r10_ohms, gamma. The oversampling buffer is allocated by the
+         * constructor, here at load time.
+         */
+        SensorBase *createGL5516(const SensorConfig &config, Common::Arena &arena)
+        {
+            GL5516Config lightConfig;
+            lightConfig.adc.device = config.getInt("device", lightConfig.adc.device);
+            lightConfig.adc.channel = config.getInt("channel", lightConfig.adc.channel);
+            lightConfig.adc.buffered = config.getInt("buffered", 1) != 0;
+            lightConfig.adc.trigger = config.get("trigger");
+            lightConfig.adc.sysfsRoot = config.get("sysfs_root", IIO_SYSFS_ROOT);
+            lightConfig.adc.devRoot = config.get("dev_root", IIO_DEV_ROOT);
+            int oversample = config.getInt("oversample", GL5516_OVERSAMPLE);
+            if (oversample < 1)
+            {
+                LOG_ERROR("Sensor %s: oversample must be at least 1\n", config.name);
+                return nullptr;
+            }
+            lightConfig.oversample = (size_t)oversample;
+            lightConfig.supplyMv = config.getFloat("supply_mv", lightConfig.supplyMv);
+            lightConfig.fixedOhms = config.getFloat("fixed_ohms", lightConfig.fixedOhms);
+            lightConfig.ldrToGround = config.getInt("ldr_to_ground", 1) != 0;
+            lightConfig.r10Ohms = config.getFloat("r10_ohms", lightConfig.r10Ohms);
+            lightConfig.gamma = config.getFloat("gamma", lightConfig.gamma);
+            return arena.create<GL5516Sensor>(lightConfig);
+        }
+
+        const SensorTypeRegistration gl5516Type({"gl5516", gl5516Footprint, createGL5516, nullptr});
+    } // namespace
+} // namespace Sensors
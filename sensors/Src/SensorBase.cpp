@@ -0,0 +1,81 @@
+#include "../Inc/SensorBase.h"
+#include <cmath>
+#include <cstring>
+
+namespace Sensors
+{
+    /**
+     * @brief Looks up a channel by name.
+     * @return Index into channels[], or -1 if the sensor has no such channel.
+     */
+    int SensorSchema::find(const char *name) const
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (strcmp(channels[i].name, name) == 0)
+            {
+                return (int)i;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Schema of sensors that only fill in SensorData.
+     */
+    const SensorSchema &legacySchema()
+    {
+        static const SensorSchema schema = {3, {{"temperature", "C"}, {"humidity", "%RH"}, {"light", "lx"}}};
+        return schema;
+    }
+
+    /**
+     * @brief Maps a SensorData reading onto a schema's channels by name.
+     * @param schema Channels to fill.
+     * @param data Reading.
+     * @param values One value per schema channel; channels SensorData has no field for get NaN.
+     */
+    void fromSensorData(const SensorSchema &schema, const SensorData &data, float *values)
+    {
+        for (size_t i = 0; i < schema.count; ++i)
+        {
+            const char *name = schema.channels[i].name;
+            if (strcmp(name, "temperature") == 0)
+            {
+                values[i] = data.temperature;
+            }
+            else if (strcmp(name, "humidity") == 0)
+            {
+                values[i] = data.humidity;
+            }
+            else if (strcmp(name, "light") == 0)
+            {
+                values[i] = data.light;
+            }
+            else
+            {
+                values[i] = NAN;
+            }
+        }
+    }
+
+    /**
+     * @brief Reads one value per schema channel.
+     *
+     * Sensors with channels that SensorData has no field for (pressure,
+     * CO2, ...) override this; the others get it from read().
+     *
+     * @param values At least schema().count floats.
+     * @return read() result.
+     */
+    bool SensorBase::readChannels(float *values)
+    {
+        SensorData data = {};
+        if (!read(data))
+        {
+            return false;
+        }
+        fromSensorData(schema(), data, values);
+        return true;
+    }
+} // namespace Sensors
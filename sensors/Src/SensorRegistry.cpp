@@ -0,0 +1,118 @@
+#include "../Inc/SensorRegistry.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace Sensors
+{
+    /**
+     * @brief Looks up a driver key.
+     * @param key Key name.
+     * @param fallback Returned when the key is not set.
+     * @return The value as written in the configuration.
+     */
+    const char *SensorConfig::get(const char *key, const char *fallback) const
+    {
+        for (int i = 0; i < keyCount; ++i)
+        {
+            if (strcmp(keys[i], key) == 0)
+            {
+                return values[i];
+            }
+        }
+        return fallback;
+    }
+
+    int SensorConfig::getInt(const char *key, int fallback) const
+    {
+        const char *value = get(key);
+        return (value != nullptr) ? atoi(value) : fallback;
+    }
+
+    float SensorConfig::getFloat(const char *key, float fallback) const
+    {
+        const char *value = get(key);
+        return (value != nullptr) ? strtof(value, nullptr) : fallback;
+    }
+
+    /**
+     * @brief Sets a driver key, replacing an earlier value of the same key.
+     * @return false if the key or value does not fit or all REGISTRY_MAX_KEYS are used.
+     */
+    bool SensorConfig::set(const char *key, const char *value)
+    {
+        if (strlen(key) >= REGISTRY_KEY_SIZE || strlen(value) >= REGISTRY_VALUE_SIZE)
+        {
+            return false;
+        }
+        int index = 0;
+        while (index < keyCount && strcmp(keys[index], key) != 0)
+        {
+            index++;
+        }
+        if (index == REGISTRY_MAX_KEYS)
+        {
+            return false;
+        }
+        if (index == keyCount)
+        {
+            snprintf(keys[index], REGISTRY_KEY_SIZE, "%s", key);
+            keyCount++;
+        }
+        snprintf(values[index], REGISTRY_VALUE_SIZE, "%s", value);
+        return true;
+    }
+
+    SensorRegistry::SensorRegistry() : types(), typeCount(0)
+    {
+    }
+
+    /**
+     * @brief The process-wide registry; built on first use, so registrations may run in any order.
+     */
+    SensorRegistry &SensorRegistry::instance()
+    {
+        static SensorRegistry registry;
+        return registry;
+    }
+
+    /**
+     * @brief Adds a driver type.
+     *
+     * Runs during static initialization, before the log sink exists, so
+     * it reports nothing itself.
+     *
+     * @param type Name and callbacks; the name must be a string literal or otherwise outlive the registry.
+     * @return false if the table is full or a type of that name is registered already.
+     */
+    bool SensorRegistry::registerType(const SensorType &type)
+    {
+        if (typeCount == REGISTRY_MAX_TYPES || type.create == nullptr || type.footprint == nullptr ||
+            findType(type.name) != nullptr)
+        {
+            return false;
+        }
+        types[typeCount++] = type;
+        return true;
+    }
+
+    const SensorType *SensorRegistry::findType(const char *name) const
+    {
+        for (int i = 0; i < typeCount; ++i)
+        {
+            if (strcmp(types[i].name, name) == 0)
+            {
+                return &types[i];
+            }
+        }
+        return nullptr;
+    }
+
+    SensorTypeRegistration::SensorTypeRegistration(const SensorType &type)
+    {
+        if (!SensorRegistry::instance().registerType(type))
+        {
+            fprintf(stderr, "Sensor type %s could not be registered\n", type.name);
+        }
+    }
+} // namespace Sensors
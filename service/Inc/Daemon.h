@@ -0,0 +1,150 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "../../define.h"
+#include "../../sensors/Inc/SensorBase.h"
+#include "../../common/Inc/Metrics.h"
+#include "../../acquisition/Inc/SharedReadings.h"
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <signal.h>
+#include <sys/epoll.h>
+
+#define DAEMON_SOCKET_PATH "/run/enviromonitor.sock"
+#define DAEMON_MAX_SENSORS 512
+// epoll events taken per wakeup
+#define DAEMON_MAX_EVENTS 16
+// Status reply sent to each socket client; later lines are cut off
+#define DAEMON_REPLY_SIZE 8192
+#define DAEMON_BACKLOG 8
+#define DAEMON_NAME_SIZE 32
+
+namespace Service
+{
+    // Where the daemon listens and which signals it takes over
+    struct DaemonConfig
+    {
+        const char *socketPath = DAEMON_SOCKET_PATH; ///< UNIX stream socket for status, nullptr for none
+        bool handleSignals = true;                   ///< SIGTERM/SIGINT stop, SIGHUP reloads
+    };
+
+    // Counters of one sensor, updated by the event loop
+    struct DaemonSensorStats
+    {
+        unsigned long cycles = 0;
+        unsigned long failures = 0;
+        unsigned long overruns = 0;        ///< timer expirations lost because the loop was late
+        unsigned long reopens = 0;         ///< open() calls after the first, following a failed read
+        unsigned long long readNsTotal = 0; ///< time spent in open/readChannels
+        unsigned long long readNsMax = 0;
+    };
+
+    // Counters of the loop itself
+    struct DaemonStats
+    {
+        unsigned long wakeups = 0;
+        unsigned long clients = 0;
+        unsigned long reloads = 0;
+        unsigned long long overheadNsTotal = 0; ///< time awake outside sensor reads
+        unsigned long long overheadNsMax = 0;
+    };
+
+    /**
+     * @class Daemon
+     * @brief Long-running acquisition on one epoll loop.
+     *
+     * Every sensor is opened once and read on its own periodic timerfd;
+     * SIGTERM/SIGINT and SIGHUP arrive through a signalfd, and the latest
+     * reading of every channel is served as text to each client of a
+     * UNIX-domain socket and, with a publisher, to shared memory. All buffers are sized in start(), so the loop
+     * itself does not allocate. SIGHUP closes every sensor, lets the reload
+     * handler replace them (clearSensors(), then addSensor()) and reopens
+     * whatever is registered afterwards.
+     */
+    class Daemon
+    {
+    public:
+        explicit Daemon(const DaemonConfig &config = DaemonConfig());
+        ~Daemon();
+
+        // Block the daemon's signals in the calling thread; call before any thread is started
+        static void blockSignals();
+
+        // Register a sensor, armed at once if the daemon runs; not owned. Returns its id or ERROR
+        int addSensor(const char *name, Sensors::SensorBase *sensor, unsigned int periodMs);
+        // Close every sensor and forget it; ids restart at 0
+        void clearSensors();
+        // Called on SIGHUP with every sensor closed; may replace them. false keeps the current ones
+        void setReloadHandler(std::function<bool(Daemon &)> handler) { reloadHandler = handler; }
+        // Also publish every reading to shared memory (opened, not owned); set before start()
+        void setPublisher(Acquisition::SharedPublisher *sharedPublisher) { publisher = sharedPublisher; }
+
+        // Open sensors, arm timers, create the socket; false if any descriptor could not be set up
+        bool start();
+        // Handle the events ready within timeoutMs (-1 waits); returns the number handled or ERROR
+        int runOnce(int timeoutMs);
+        // runOnce() until a stop signal or requestStop()
+        void run();
+        // Safe from other threads and signal handlers
+        void requestStop();
+        // Close sensors, descriptors and the socket
+        void stop();
+        // Close every sensor, call the reload handler, then open the sensors registered afterwards
+        void reload();
+
+        bool isStopRequested() const { return stopRequested.load(); }
+        int getSensorCount() const { return (int)slots.size(); }
+        const DaemonSensorStats &getSensorStats(int sensorId) const { return slots[sensorId].stats; }
+        const DaemonStats &getStats() const { return stats; }
+        // The text socket clients receive; returns its length
+        size_t formatStatus(char *out, size_t size) const;
+
+    private:
+        struct Slot
+        {
+            char name[DAEMON_NAME_SIZE];
+            Sensors::SensorBase *sensor;
+            Sensors::SensorSchema schema;
+            unsigned long long periodNs;
+            int timerFd;
+            bool opened;
+            bool valid;                          ///< values hold a reading
+            float values[SENSOR_MAX_CHANNELS];
+            unsigned long long readAtNs;         ///< end of the last successful read
+            int sharedIndex;                     ///< sensor index in the publisher's segment, or ERROR
+            DaemonSensorStats stats;
+            Metrics::Counter *cycles;
+            Metrics::Counter *failures;
+            Metrics::Histogram *readNs;
+        };
+
+        void onTimer(Slot &slot);
+        void onSignal();
+        void onClients();
+        bool openSensor(Slot &slot);
+        bool armSensor(size_t index);
+        void closeFds();
+
+        DaemonConfig config;
+        std::vector<Slot> slots;
+        std::function<bool(Daemon &)> reloadHandler;
+        Acquisition::SharedPublisher *publisher;
+        int epollFd;
+        int signalFd;
+        int listenFd;
+        int stopFd;               ///< eventfd written by requestStop()
+        bool started;
+        std::atomic<bool> stopRequested;
+        bool signalsBlocked;
+        sigset_t savedMask;
+        unsigned long long startNs;
+        DaemonStats stats;
+        Metrics::Histogram *overheadNs;
+        struct epoll_event events[DAEMON_MAX_EVENTS];
+        char reply[DAEMON_REPLY_SIZE];
+    };
+
+} // namespace Service
+
+#endif // DAEMON_H
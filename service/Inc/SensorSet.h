@@ -0,0 +1,87 @@
+#ifndef SENSOR_SET_H
+#define SENSOR_SET_H
+
+#include "../../define.h"
+#include "../../sensors/Inc/SensorRegistry.h"
+#include "../../common/Inc/Arena.h"
+#include "../../processing/Inc/Filters.h"
+#include "Daemon.h"
+#include <cstdio>
+#include <vector>
+
+#define SENSOR_SET_MAX_SENSORS DAEMON_MAX_SENSORS
+#define SENSOR_SET_LINE_SIZE 256
+
+namespace Service
+{
+    // A sensor built from the configuration file
+    struct ConfiguredSensor
+    {
+        const Sensors::SensorConfig *config;
+        Sensors::SensorBase *sensor; ///< the filtering front when the configuration sets filters
+    };
+
+    // What load() did and how long each phase took
+    struct SensorSetStats
+    {
+        int sensors = 0;
+        int filters = 0;                 ///< filter stages over all channels
+        int pins = 0;                    ///< sysfs pins exported in the bulk pass
+        int pinFailures = 0;
+        size_t arenaBytes = 0;           ///< block reserved from the footprints
+        size_t arenaUsed = 0;
+        unsigned long long parseNs = 0;
+        unsigned long long setupNs = 0;  ///< bulk GPIO export and configuration
+        unsigned long long createNs = 0; ///< driver and filter construction
+        unsigned long long totalNs = 0;
+    };
+
+    /**
+     * @class SensorSet
+     * @brief Sensors declared in an INI file, built through the SensorRegistry into one arena.
+     *
+     * Each `[sensor NAME]` section names a driver `type`, a `period_ms` and
+     * the driver's own keys; `filter.temperature`, `filter.humidity` and
+     * `filter.light` list filter stages, e.g.
+     * `range:-40:80, hampel:7:3:0.2, median:5, kalman:0.01:0.25`.
+     * load() parses the whole file, sizes the arena from the footprints of
+     * every driver and filter, exports all sysfs pins in one setupPins()
+     * pass and then constructs everything in place. Drivers, their
+     * simulated backends, filters and the configurations themselves live in
+     * the arena until the set is destroyed or reloaded.
+     */
+    class SensorSet
+    {
+    public:
+        SensorSet();
+        ~SensorSet();
+        SensorSet(const SensorSet &) = delete;
+        SensorSet &operator=(const SensorSet &) = delete;
+
+        // Replace the current sensors with those of the file; false (nothing loaded) on the first error
+        bool load(const char *path);
+        // Destroy every sensor; they must be closed
+        void clear();
+        // Register every sensor with its period; false if the daemon refused one
+        bool addTo(Daemon &daemon) const;
+
+        int getCount() const { return count; }
+        const ConfiguredSensor &get(int index) const { return sensors[index]; }
+        const SensorSetStats &getStats() const { return stats; }
+
+    private:
+        bool parse(FILE *file, const char *path, std::vector<Sensors::SensorConfig> &configs);
+        bool addFootprint(const Sensors::SensorConfig &config, const Sensors::SensorType &type, size_t &bytes);
+        void setupSysfsPins(const std::vector<Sensors::SensorConfig> &configs,
+                            const std::vector<const Sensors::SensorType *> &types);
+        Sensors::SensorBase *createFiltered(const Sensors::SensorConfig &config, Sensors::SensorBase *sensor);
+
+        Common::Arena arena;
+        ConfiguredSensor *sensors;
+        int count;
+        SensorSetStats stats;
+    };
+
+} // namespace Service
+
+#endif // SENSOR_SET_H
@@ -0,0 +1,614 @@
+#include "../Inc/Daemon.h"
+#include "../../common/Inc/Log.h"
+#include "../../periferia/Inc/gpio_backend.h"
+#include <algorithm>
+#include <cmath>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <time.h>
+
+// epoll_event.data.u64: descriptor kind in the high half, sensor index in the low half
+#define TAG_TIMER 1ULL
+#define TAG_SIGNAL 2ULL
+#define TAG_LISTEN 3ULL
+#define TAG_STOP 4ULL
+#define TAG(kind, index) (((kind) << 32) | (unsigned long long)(index))
+
+namespace Service
+{
+    /**
+     * @brief Signals taken over by the daemon.
+     */
+    static sigset_t daemonSignals()
+    {
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, SIGTERM);
+        sigaddset(&mask, SIGINT);
+        sigaddset(&mask, SIGHUP);
+        return mask;
+    }
+
+    /**
+     * @brief Resident set size of this process from /proc/self/statm, without allocating.
+     * @return Kilobytes, or -1 if unavailable.
+     */
+    static long residentKb()
+    {
+        char buffer[128];
+        int fd = ::open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return -1;
+        }
+        ssize_t length = ::read(fd, buffer, sizeof(buffer) - 1);
+        ::close(fd);
+        if (length <= 0)
+        {
+            return -1;
+        }
+        buffer[length] = '\0';
+        long size;
+        long resident;
+        if (sscanf(buffer, "%ld %ld", &size, &resident) != 2)
+        {
+            return -1;
+        }
+        return resident * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+
+    /**
+     * @brief Constructs a stopped daemon.
+     * @param config Socket path and signal handling.
+     */
+    Daemon::Daemon(const DaemonConfig &config)
+        : config(config), publisher(nullptr), epollFd(-1), signalFd(-1), listenFd(-1), stopFd(-1), started(false),
+          stopRequested(false), signalsBlocked(false), startNs(0)
+    {
+        // Slots are never reallocated, so their metric pointers stay valid
+        slots.reserve(DAEMON_MAX_SENSORS);
+        sigemptyset(&savedMask);
+        overheadNs = &Metrics::histogram("daemon_overhead_duration_seconds", "",
+                                         "Event loop time per wakeup outside sensor reads");
+    }
+
+    /**
+     * @brief Stops the daemon if it is still running.
+     */
+    Daemon::~Daemon()
+    {
+        stop();
+    }
+
+    /**
+     * @brief Blocks SIGTERM, SIGINT and SIGHUP in the calling thread.
+     *
+     * signalfd only sees signals that no thread accepts, and threads
+     * inherit the mask they are created with, so the main thread calls this
+     * before starting any (the log sink, scheduler workers, ...).
+     */
+    void Daemon::blockSignals()
+    {
+        sigset_t mask = daemonSignals();
+        pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+    }
+
+    /**
+     * @brief Registers a sensor to be read every periodMs.
+     *
+     * Before start() the sensor is only recorded. On a running daemon (from
+     * the reload handler) its timer is armed at once and the sensor is
+     * opened when reload() finishes, or by its first cycle.
+     *
+     * @param name Label in the status reply and metrics, truncated to DAEMON_NAME_SIZE - 1.
+     * @param sensor Sensor driver, opened in start() and kept open; must outlive the daemon or clearSensors().
+     * @param periodMs Time between reads.
+     * @return Sensor id for getSensorStats(), or ERROR.
+     */
+    int Daemon::addSensor(const char *name, Sensors::SensorBase *sensor, unsigned int periodMs)
+    {
+        if (sensor == nullptr || periodMs == 0 || slots.size() >= DAEMON_MAX_SENSORS)
+        {
+            LOG_ERROR("Cannot add sensor %s to the daemon.\n", name);
+            return ERROR;
+        }
+        slots.emplace_back();
+        Slot &slot = slots.back();
+        snprintf(slot.name, sizeof(slot.name), "%s", name);
+        slot.sensor = sensor;
+        slot.schema = sensor->schema();
+        slot.periodNs = periodMs * 1000000ULL;
+        slot.timerFd = -1;
+        slot.opened = false;
+        slot.valid = false;
+        slot.readAtNs = 0;
+        slot.sharedIndex = ERROR;
+
+        char labels[METRICS_LABELS_SIZE];
+        snprintf(labels, sizeof(labels), "sensor=\"%s\"", slot.name);
+        slot.cycles = &Metrics::counter("daemon_reads_total", labels, "Daemon sensor reads");
+        slot.failures = &Metrics::counter("daemon_read_failures_total", labels, "Daemon sensor reads that failed");
+        slot.readNs = &Metrics::histogram("daemon_read_duration_seconds", labels, "Daemon sensor open and read time");
+        if (started && !armSensor(slots.size() - 1))
+        {
+            slots.pop_back();
+            return ERROR;
+        }
+        return (int)slots.size() - 1;
+    }
+
+    /**
+     * @brief Closes every sensor and its timer and drops the slots.
+     *
+     * The drivers are not destroyed; their owner may do so afterwards.
+     * Called by the reload handler before it registers the new sensors.
+     */
+    void Daemon::clearSensors()
+    {
+        for (Slot &slot : slots)
+        {
+            if (slot.opened)
+            {
+                slot.sensor->close();
+                slot.opened = false;
+            }
+            if (slot.timerFd >= 0)
+            {
+                ::close(slot.timerFd); // also leaves the epoll set
+                slot.timerFd = -1;
+            }
+        }
+        slots.clear();
+    }
+
+    /**
+     * @brief Creates the periodic timer of a slot, adds it to epoll and gives it a shared memory index.
+     * @return false if a descriptor could not be set up.
+     */
+    bool Daemon::armSensor(size_t index)
+    {
+        Slot &slot = slots[index];
+        slot.timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        struct itimerspec period;
+        period.it_interval.tv_sec = slot.periodNs / 1000000000ULL;
+        period.it_interval.tv_nsec = slot.periodNs % 1000000000ULL;
+        period.it_value.tv_sec = 0;
+        period.it_value.tv_nsec = 1; // first read right away
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = TAG(TAG_TIMER, index);
+        if (slot.timerFd < 0 || timerfd_settime(slot.timerFd, 0, &period, nullptr) < 0 ||
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, slot.timerFd, &event) < 0)
+        {
+            LOG_ERROR("Daemon: cannot arm the timer of %s: %s\n", slot.name, strerror(errno));
+            if (slot.timerFd >= 0)
+            {
+                ::close(slot.timerFd);
+                slot.timerFd = -1;
+            }
+            return false;
+        }
+        if (publisher != nullptr && slot.sharedIndex == ERROR)
+        {
+            slot.sharedIndex = publisher->addSensor(slot.name, slot.schema);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Opens a sensor, counting it as a reopen if it was open before.
+     */
+    bool Daemon::openSensor(Slot &slot)
+    {
+        if (slot.stats.cycles > 0)
+        {
+            slot.stats.reopens++;
+        }
+        slot.opened = slot.sensor->open();
+        if (!slot.opened)
+        {
+            LOG_WARN("Daemon: cannot open %s, retrying next cycle.\n", slot.name);
+        }
+        return slot.opened;
+    }
+
+    /**
+     * @brief Creates the epoll set, timers, signalfd and socket, and opens the sensors.
+     *
+     * A sensor that fails to open is retried on each of its cycles; only
+     * descriptor errors fail start().
+     *
+     * @return true if the loop can run.
+     */
+    bool Daemon::start()
+    {
+        if (started || slots.empty())
+        {
+            return false;
+        }
+        Log::start();
+        stopRequested = false;
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd < 0 || stopFd < 0)
+        {
+            LOG_ERROR("Daemon: cannot create epoll/eventfd: %s\n", strerror(errno));
+            closeFds();
+            return false;
+        }
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = TAG(TAG_STOP, 0);
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, stopFd, &event);
+
+        if (config.handleSignals)
+        {
+            sigset_t mask = daemonSignals();
+            pthread_sigmask(SIG_BLOCK, &mask, &savedMask);
+            signalsBlocked = true;
+            signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+            event.data.u64 = TAG(TAG_SIGNAL, 0);
+            if (signalFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, signalFd, &event) < 0)
+            {
+                LOG_ERROR("Daemon: cannot create signalfd: %s\n", strerror(errno));
+                closeFds();
+                return false;
+            }
+        }
+
+        if (config.socketPath != nullptr)
+        {
+            struct sockaddr_un address;
+            memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            if (strlen(config.socketPath) >= sizeof(address.sun_path))
+            {
+                LOG_ERROR("Daemon: socket path too long: %s\n", config.socketPath);
+                closeFds();
+                return false;
+            }
+            strcpy(address.sun_path, config.socketPath);
+            unlink(config.socketPath); // left behind by a daemon that was killed
+            listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            event.data.u64 = TAG(TAG_LISTEN, 0);
+            if (listenFd < 0 || bind(listenFd, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+                listen(listenFd, DAEMON_BACKLOG) < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) < 0)
+            {
+                LOG_ERROR("Daemon: cannot listen on %s: %s\n", config.socketPath, strerror(errno));
+                closeFds();
+                return false;
+            }
+        }
+
+        startNs = Periferia::monotonicNs();
+        for (size_t i = 0; i < slots.size(); ++i)
+        {
+            if (!armSensor(i))
+            {
+                closeFds();
+                return false;
+            }
+            openSensor(slots[i]);
+        }
+        started = true;
+        return true;
+    }
+
+    /**
+     * @brief Waits for and handles one batch of events.
+     *
+     * Time awake outside sensor reads is recorded as loop overhead.
+     *
+     * @param timeoutMs Longest wait, -1 for no limit.
+     * @return Number of events handled, 0 on timeout, ERROR if not started or epoll failed.
+     */
+    int Daemon::runOnce(int timeoutMs)
+    {
+        if (!started)
+        {
+            return ERROR;
+        }
+        int count = epoll_wait(epollFd, events, DAEMON_MAX_EVENTS, timeoutMs);
+        if (count < 0)
+        {
+            return (errno == EINTR) ? 0 : ERROR;
+        }
+        unsigned long long awake = Periferia::monotonicNs();
+        unsigned long long readNs = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            unsigned long long tag = events[i].data.u64;
+            switch (tag >> 32)
+            {
+            case TAG_TIMER:
+            {
+                // A reload earlier in this batch may have replaced the slots
+                size_t index = tag & 0xffffffffULL;
+                if (index >= slots.size())
+                {
+                    break;
+                }
+                Slot &slot = slots[index];
+                unsigned long long before = slot.stats.readNsTotal;
+                onTimer(slot);
+                readNs += slot.stats.readNsTotal - before;
+                break;
+            }
+            case TAG_SIGNAL:
+                onSignal();
+                break;
+            case TAG_LISTEN:
+                onClients();
+                break;
+            case TAG_STOP:
+            {
+                uint64_t value;
+                if (::read(stopFd, &value, sizeof(value)) == sizeof(value))
+                {
+                    stopRequested = true;
+                }
+                break;
+            }
+            }
+        }
+        unsigned long long overhead = Periferia::monotonicNs() - awake - readNs;
+        stats.wakeups++;
+        stats.overheadNsTotal += overhead;
+        if (overhead > stats.overheadNsMax)
+        {
+            stats.overheadNsMax = overhead;
+        }
+        overheadNs->record(overhead);
+        return count;
+    }
+
+    /**
+     * @brief Runs the loop until SIGTERM/SIGINT or requestStop().
+     */
+    void Daemon::run()
+    {
+        while (!stopRequested.load() && runOnce(-1) != ERROR)
+        {
+        }
+    }
+
+    /**
+     * @brief Makes run() return after the current wakeup.
+     */
+    void Daemon::requestStop()
+    {
+        stopRequested = true;
+        if (stopFd >= 0)
+        {
+            uint64_t one = 1;
+            ssize_t written = ::write(stopFd, &one, sizeof(one));
+            (void)written;
+        }
+    }
+
+    /**
+     * @brief Reads a sensor whose timer expired.
+     *
+     * A failed read closes the sensor so the next cycle reopens it, which
+     * recovers drivers whose descriptors went bad (unexported GPIO, removed
+     * device) without restarting the daemon.
+     */
+    void Daemon::onTimer(Slot &slot)
+    {
+        uint64_t expirations = 0;
+        if (::read(slot.timerFd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        {
+            return;
+        }
+        if (expirations > 1)
+        {
+            slot.stats.overruns += expirations - 1;
+        }
+
+        unsigned long long begin = Periferia::monotonicNs();
+        bool ok = slot.opened || openSensor(slot);
+        if (ok)
+        {
+            ok = slot.sensor->readChannels(slot.values);
+        }
+        unsigned long long end = Periferia::monotonicNs();
+        slot.stats.cycles++;
+        slot.cycles->add();
+        slot.stats.readNsTotal += end - begin;
+        if (end - begin > slot.stats.readNsMax)
+        {
+            slot.stats.readNsMax = end - begin;
+        }
+        slot.readNs->record(end - begin);
+        if (publisher != nullptr)
+        {
+            publisher->publish(slot.sharedIndex, end, ok, slot.values);
+        }
+        if (ok)
+        {
+            slot.valid = true;
+            slot.readAtNs = end;
+            return;
+        }
+        slot.stats.failures++;
+        slot.failures->add();
+        if (slot.opened)
+        {
+            slot.sensor->close();
+            slot.opened = false;
+        }
+    }
+
+    /**
+     * @brief Drains the signalfd: SIGTERM/SIGINT request a stop, SIGHUP a reload.
+     */
+    void Daemon::onSignal()
+    {
+        struct signalfd_siginfo info;
+        while (::read(signalFd, &info, sizeof(info)) == sizeof(info))
+        {
+            if (info.ssi_signo == SIGHUP)
+            {
+                LOG_INFO("Daemon: SIGHUP, reloading.\n");
+                reload();
+            }
+            else
+            {
+                LOG_INFO("Daemon: signal %u, stopping.\n", info.ssi_signo);
+                stopRequested = true;
+            }
+        }
+    }
+
+    /**
+     * @brief Accepts every pending client, sends it the status and closes it.
+     *
+     * The reply is formatted once per wakeup into a fixed buffer. It is far
+     * below the socket buffer size, so the non-blocking send completes; a
+     * client that is gone just gets closed.
+     */
+    void Daemon::onClients()
+    {
+        size_t length = 0;
+        int client;
+        while ((client = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+        {
+            if (length == 0)
+            {
+                length = formatStatus(reply, sizeof(reply));
+            }
+            ssize_t sent = send(client, reply, length, MSG_NOSIGNAL | MSG_DONTWAIT);
+            (void)sent;
+            ::close(client);
+            stats.clients++;
+        }
+    }
+
+    /**
+     * @brief Closes every sensor, runs the reload handler and reopens what is registered then.
+     *
+     * The handler sees every sensor closed, so it may reuse their pins for
+     * the replacements. Without a handler, or when it returns false, the
+     * current sensors are just reopened.
+     */
+    void Daemon::reload()
+    {
+        for (Slot &slot : slots)
+        {
+            if (slot.opened)
+            {
+                slot.sensor->close();
+                slot.opened = false;
+            }
+        }
+        stats.reloads++;
+        if (reloadHandler && !reloadHandler(*this))
+        {
+            LOG_WARN("Daemon: reload failed, keeping the current sensors.\n");
+        }
+        if (started)
+        {
+            for (Slot &slot : slots)
+            {
+                openSensor(slot);
+            }
+        }
+    }
+
+    /**
+     * @brief Formats the latest readings.
+     *
+     * A header line with uptime, wakeups and resident memory, then one line
+     * per channel: sensor, channel, value, unit and age of the reading in
+     * milliseconds. Channels without a reading yet show nan and age -1.
+     *
+     * @param out Destination.
+     * @param size Capacity of out; lines that do not fit are left out.
+     * @return Length written, without the terminator.
+     */
+    size_t Daemon::formatStatus(char *out, size_t size) const
+    {
+        if (size == 0)
+        {
+            return 0;
+        }
+        unsigned long long now = Periferia::monotonicNs();
+        int length = snprintf(out, size, "# uptime_ms=%llu wakeups=%lu rss_kb=%ld\n",
+                              started ? (now - startNs) / 1000000ULL : 0ULL, stats.wakeups, residentKb());
+        size_t used = (length < 0) ? 0 : std::min((size_t)length, size - 1);
+        for (const Slot &slot : slots)
+        {
+            for (size_t i = 0; i < slot.schema.count; ++i)
+            {
+                float value = slot.valid ? slot.values[i] : NAN;
+                long long age = slot.valid ? (long long)((now - slot.readAtNs) / 1000000ULL) : -1;
+                length = snprintf(out + used, size - used, "%s %s %.2f %s %lld\n", slot.name,
+                                  slot.schema.channels[i].name, value, slot.schema.channels[i].unit, age);
+                if (length < 0 || (size_t)length >= size - used)
+                {
+                    out[used] = '\0';
+                    return used;
+                }
+                used += length;
+            }
+        }
+        return used;
+    }
+
+    /**
+     * @brief Closes every descriptor the daemon created and restores the signal mask.
+     */
+    void Daemon::closeFds()
+    {
+        for (Slot &slot : slots)
+        {
+            if (slot.timerFd >= 0)
+            {
+                ::close(slot.timerFd);
+                slot.timerFd = -1;
+            }
+        }
+        if (listenFd >= 0)
+        {
+            unlink(config.socketPath);
+        }
+        int *fds[] = {&epollFd, &signalFd, &listenFd, &stopFd};
+        for (int *fd : fds)
+        {
+            if (*fd >= 0)
+            {
+                ::close(*fd);
+                *fd = -1;
+            }
+        }
+        if (signalsBlocked)
+        {
+            pthread_sigmask(SIG_SETMASK, &savedMask, nullptr);
+            signalsBlocked = false;
+        }
+    }
+
+    /**
+     * @brief Closes the sensors and every descriptor; start() can be called again.
+     */
+    void Daemon::stop()
+    {
+        if (!started)
+        {
+            return;
+        }
+        for (Slot &slot : slots)
+        {
+            if (slot.opened)
+            {
+                slot.sensor->close();
+                slot.opened = false;
+            }
+        }
+        closeFds();
+        started = false;
+    }
+} // namespace Service
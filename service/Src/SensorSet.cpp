@@ -0,0 +1,539 @@
+#include "../Inc/SensorSet.h"
+#include "../../common/Inc/Log.h"
+#include "../../periferia/Inc/gpio_setup.h"
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+namespace Service
+{
+    namespace
+    {
+        enum class FilterKind
+        {
+            Range,
+            Median,
+            Hampel,
+            Kalman
+        };
+
+        struct FilterSpec
+        {
+            FilterKind kind;
+            float params[3];
+        };
+
+        // Filter keys, in Processing::Channel order
+        const char *const filterKeys[FILTER_CHANNELS] = {"filter.temperature", "filter.humidity", "filter.light"};
+
+        char *trim(char *text)
+        {
+            while (isspace((unsigned char)*text))
+            {
+                text++;
+            }
+            size_t length = strlen(text);
+            while (length > 0 && isspace((unsigned char)text[length - 1]))
+            {
+                text[--length] = '\0';
+            }
+            return text;
+        }
+
+        /**
+         * @brief Parses one stage such as "hampel:7:3:0.2"; false if the kind or its parameters are invalid.
+         */
+        bool parseStage(char *stage, FilterSpec &spec)
+        {
+            char *save = nullptr;
+            const char *kind = strtok_r(stage, ": \t", &save);
+            float params[4];
+            int paramCount = 0;
+            for (char *field = strtok_r(nullptr, ": \t", &save); field != nullptr; field = strtok_r(nullptr, ": \t", &save))
+            {
+                char *end = nullptr;
+                if (paramCount == 4)
+                {
+                    return false;
+                }
+                params[paramCount++] = strtof(field, &end);
+                if (*end != '\0')
+                {
+                    return false;
+                }
+            }
+            if (kind == nullptr)
+            {
+                return false;
+            }
+            if (strcmp(kind, "range") == 0 && paramCount == 2 && params[0] < params[1])
+            {
+                spec = FilterSpec{FilterKind::Range, {params[0], params[1], 0.0f}};
+                return true;
+            }
+            int length = (paramCount > 0) ? (int)params[0] : 0;
+            if (strcmp(kind, "median") == 0 && paramCount == 1 && length >= 1 && length <= FILTER_MAX_WINDOW &&
+                length % 2 == 1)
+            {
+                spec = FilterSpec{FilterKind::Median, {params[0], 0.0f, 0.0f}};
+                return true;
+            }
+            if (strcmp(kind, "hampel") == 0 && (paramCount == 2 || paramCount == 3) && length >= 3 &&
+                length <= FILTER_MAX_WINDOW && params[1] > 0.0f)
+            {
+                spec = FilterSpec{FilterKind::Hampel, {params[0], params[1], (paramCount == 3) ? params[2] : 0.0f}};
+                return true;
+            }
+            if (strcmp(kind, "kalman") == 0 && paramCount == 2 && params[0] > 0.0f && params[1] > 0.0f)
+            {
+                spec = FilterSpec{FilterKind::Kalman, {params[0], params[1], 0.0f}};
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * @brief Parses a comma-separated stage list; false if a stage is invalid or there are too many.
+         */
+        bool parseFilters(const char *text, FilterSpec *specs, int &count)
+        {
+            char buffer[REGISTRY_VALUE_SIZE];
+            snprintf(buffer, sizeof(buffer), "%s", text);
+            count = 0;
+            char *save = nullptr;
+            for (char *stage = strtok_r(buffer, ",", &save); stage != nullptr; stage = strtok_r(nullptr, ",", &save))
+            {
+                if (count == FILTER_MAX_STAGES || !parseStage(stage, specs[count]))
+                {
+                    return false;
+                }
+                count++;
+            }
+            return count > 0;
+        }
+
+        size_t filterFootprint(const FilterSpec &spec)
+        {
+            switch (spec.kind)
+            {
+            case FilterKind::Range:
+                return Common::Arena::footprint<Processing::RangeFilter>();
+            case FilterKind::Median:
+                return Common::Arena::footprint<Processing::MedianFilter>();
+            case FilterKind::Hampel:
+                return Common::Arena::footprint<Processing::HampelFilter>();
+            case FilterKind::Kalman:
+                return Common::Arena::footprint<Processing::KalmanFilter>();
+            }
+            return 0;
+        }
+
+        Processing::Filter *createFilter(const FilterSpec &spec, Common::Arena &arena)
+        {
+            switch (spec.kind)
+            {
+            case FilterKind::Range:
+                return arena.create<Processing::RangeFilter>(spec.params[0], spec.params[1]);
+            case FilterKind::Median:
+                return arena.create<Processing::MedianFilter>((size_t)spec.params[0]);
+            case FilterKind::Hampel:
+                return arena.create<Processing::HampelFilter>((size_t)spec.params[0], spec.params[1], spec.params[2]);
+            case FilterKind::Kalman:
+                return arena.create<Processing::KalmanFilter>(spec.params[0], spec.params[1]);
+            }
+            return nullptr;
+        }
+
+        bool hasFilters(const Sensors::SensorConfig &config)
+        {
+            for (const char *key : filterKeys)
+            {
+                if (config.get(key) != nullptr)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    } // namespace
+
+    SensorSet::SensorSet() : sensors(nullptr), count(0)
+    {
+    }
+
+    SensorSet::~SensorSet()
+    {
+        clear();
+    }
+
+    /**
+     * @brief Loads the sensors of a configuration file.
+     *
+     * Every allocation happens here: the file is parsed completely, then
+     * one arena block is reserved for all configurations, drivers and
+     * filters, the sysfs pins are exported together, and the objects are
+     * constructed in the block. Nothing is opened yet; the owner opens the
+     * sensors (the Daemon does in start()).
+     *
+     * @param path INI file of [sensor NAME] sections.
+     * A configuration whose sensors do not all get their metrics (the
+     * registry is full; see METRICS_MAX_COUNTERS) is refused rather than
+     * run with readings that are never exported.
+     *
+     * @return false, with the set left empty, if the file cannot be read, any sensor is invalid or its metrics do not fit.
+     */
+    bool SensorSet::load(const char *path)
+    {
+        clear();
+        stats = SensorSetStats();
+        unsigned long long start = Periferia::monotonicNs();
+
+        FILE *file = fopen(path, "r");
+        if (file == nullptr)
+        {
+            LOG_ERROR("Cannot open sensor configuration %s: %s\n", path, strerror(errno));
+            return false;
+        }
+        std::vector<Sensors::SensorConfig> configs;
+        bool parsed = parse(file, path, configs);
+        fclose(file);
+        if (!parsed)
+        {
+            return false;
+        }
+        if (configs.empty())
+        {
+            LOG_ERROR("%s: no [sensor NAME] sections\n", path);
+            return false;
+        }
+
+        // One block for the configurations, the sensor table, every driver and every filter
+        size_t bytes = Common::Arena::footprint<Sensors::SensorConfig>(configs.size()) +
+                       Common::Arena::footprint<ConfiguredSensor>(configs.size());
+        std::vector<const Sensors::SensorType *> types(configs.size());
+        for (size_t i = 0; i < configs.size(); ++i)
+        {
+            types[i] = Sensors::SensorRegistry::instance().findType(configs[i].type);
+            if (types[i] == nullptr)
+            {
+                LOG_ERROR("%s:%d: unknown sensor type %s\n", path, configs[i].line, configs[i].type);
+                return false;
+            }
+            if (!addFootprint(configs[i], *types[i], bytes))
+            {
+                return false;
+            }
+        }
+        stats.parseNs = Periferia::monotonicNs() - start;
+        if (!arena.reserve(bytes))
+        {
+            return false;
+        }
+        stats.arenaBytes = bytes;
+
+        setupSysfsPins(configs, types);
+
+        unsigned long long createStart = Periferia::monotonicNs();
+        unsigned long metricFailures = Metrics::registrationFailures();
+        Sensors::SensorConfig *stored = arena.createArray<Sensors::SensorConfig>(configs.size());
+        sensors = arena.createArray<ConfiguredSensor>(configs.size());
+        memcpy(stored, configs.data(), configs.size() * sizeof(Sensors::SensorConfig));
+        for (size_t i = 0; i < configs.size(); ++i)
+        {
+            Sensors::SensorBase *sensor = types[i]->create(stored[i], arena);
+            if (sensor != nullptr && hasFilters(stored[i]))
+            {
+                sensor = createFiltered(stored[i], sensor);
+            }
+            if (sensor == nullptr)
+            {
+                LOG_ERROR("%s:%d: cannot create sensor %s\n", path, stored[i].line, stored[i].name);
+                clear();
+                Periferia::releasePreparedPins();
+                return false;
+            }
+            sensors[count++] = ConfiguredSensor{&stored[i], sensor};
+        }
+        // Descriptors of pins whose driver turned out to use another backend
+        Periferia::releasePreparedPins();
+        if (Metrics::registrationFailures() != metricFailures)
+        {
+            LOG_ERROR("%s: the metrics registry has no room for the metrics of %d sensors, not loaded\n", path, count);
+            clear();
+            return false;
+        }
+
+        unsigned long long end = Periferia::monotonicNs();
+        stats.sensors = count;
+        stats.arenaUsed = arena.getUsed();
+        stats.createNs = end - createStart;
+        stats.totalNs = end - start;
+        LOG_INFO("Loaded %d sensors from %s in %.2f ms, %zu arena bytes\n", count, path, stats.totalNs / 1e6,
+                 stats.arenaUsed);
+        return true;
+    }
+
+    /**
+     * @brief Destroys every sensor, filter and configuration, newest first.
+     */
+    void SensorSet::clear()
+    {
+        arena.clear();
+        sensors = nullptr;
+        count = 0;
+    }
+
+    /**
+     * @brief Hands every sensor to a daemon, before start() or from its reload handler.
+     * @return false if the daemon refused a sensor (too many, or already started).
+     */
+    bool SensorSet::addTo(Daemon &daemon) const
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            if (daemon.addSensor(sensors[i].config->name, sensors[i].sensor, sensors[i].config->periodMs) == ERROR)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Reads the [sensor NAME] sections.
+     *
+     * `type` and `period_ms` are interpreted here; every other key is
+     * kept for the driver or the filters. Blank lines and lines starting
+     * with '#' or ';' are skipped.
+     *
+     * @return false, with the file and line logged, on the first malformed line.
+     */
+    bool SensorSet::parse(FILE *file, const char *path, std::vector<Sensors::SensorConfig> &configs)
+    {
+        char buffer[SENSOR_SET_LINE_SIZE];
+        int line = 0;
+        while (fgets(buffer, sizeof(buffer), file) != nullptr)
+        {
+            line++;
+            if (strchr(buffer, '\n') == nullptr && !feof(file))
+            {
+                LOG_ERROR("%s:%d: line longer than %d characters\n", path, line, SENSOR_SET_LINE_SIZE - 2);
+                return false;
+            }
+            char *text = trim(buffer);
+            if (*text == '\0' || *text == '#' || *text == ';')
+            {
+                continue;
+            }
+
+            if (*text == '[')
+            {
+                size_t length = strlen(text);
+                if (length < 2 || text[length - 1] != ']' || strncmp(text + 1, "sensor", 6) != 0 ||
+                    !isspace((unsigned char)text[7]))
+                {
+                    LOG_ERROR("%s:%d: expected [sensor NAME]\n", path, line);
+                    return false;
+                }
+                text[length - 1] = '\0';
+                const char *name = trim(text + 7);
+                if (*name == '\0' || strlen(name) >= REGISTRY_NAME_SIZE)
+                {
+                    LOG_ERROR("%s:%d: sensor name must have 1 to %d characters\n", path, line, REGISTRY_NAME_SIZE - 1);
+                    return false;
+                }
+                for (const Sensors::SensorConfig &other : configs)
+                {
+                    if (strcmp(other.name, name) == 0)
+                    {
+                        LOG_ERROR("%s:%d: sensor %s already defined on line %d\n", path, line, name, other.line);
+                        return false;
+                    }
+                }
+                if (configs.size() == SENSOR_SET_MAX_SENSORS)
+                {
+                    LOG_ERROR("%s:%d: more than %d sensors\n", path, line, SENSOR_SET_MAX_SENSORS);
+                    return false;
+                }
+                Sensors::SensorConfig config = {};
+                snprintf(config.name, sizeof(config.name), "%s", name);
+                config.periodMs = REGISTRY_DEFAULT_PERIOD_MS;
+                config.line = line;
+                configs.push_back(config);
+                continue;
+            }
+
+            char *equals = strchr(text, '=');
+            if (equals == nullptr || configs.empty())
+            {
+                LOG_ERROR("%s:%d: expected key = value inside a [sensor NAME] section\n", path, line);
+                return false;
+            }
+            *equals = '\0';
+            const char *key = trim(text);
+            const char *value = trim(equals + 1);
+            Sensors::SensorConfig &config = configs.back();
+            if (strcmp(key, "type") == 0)
+            {
+                if (strlen(value) >= REGISTRY_NAME_SIZE)
+                {
+                    LOG_ERROR("%s:%d: unknown sensor type %s\n", path, line, value);
+                    return false;
+                }
+                snprintf(config.type, sizeof(config.type), "%s", value);
+            }
+            else if (strcmp(key, "period_ms") == 0)
+            {
+                char *end = nullptr;
+                unsigned long period = strtoul(value, &end, 10);
+                if (*value == '\0' || *end != '\0' || period == 0 || period > 86400000UL)
+                {
+                    LOG_ERROR("%s:%d: period_ms must be a positive number of milliseconds\n", path, line);
+                    return false;
+                }
+                config.periodMs = (unsigned int)period;
+            }
+            else if (strncmp(key, "filter.", 7) == 0 && strcmp(key, filterKeys[0]) != 0 &&
+                     strcmp(key, filterKeys[1]) != 0 && strcmp(key, filterKeys[2]) != 0)
+            {
+                LOG_ERROR("%s:%d: no channel %s to filter\n", path, line, key + 7);
+                return false;
+            }
+            else if (!config.set(key, value))
+            {
+                LOG_ERROR("%s:%d: key or value too long, or more than %d keys\n", path, line, REGISTRY_MAX_KEYS);
+                return false;
+            }
+        }
+        for (const Sensors::SensorConfig &config : configs)
+        {
+            if (config.type[0] == '\0')
+            {
+                LOG_ERROR("%s:%d: sensor %s has no type\n", path, config.line, config.name);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Adds the arena bytes of a sensor, its filters and their pipeline.
+     * @return false if a filter list is invalid.
+     */
+    bool SensorSet::addFootprint(const Sensors::SensorConfig &config, const Sensors::SensorType &type, size_t &bytes)
+    {
+        bytes += type.footprint(config);
+        if (!hasFilters(config))
+        {
+            return true;
+        }
+        bytes += Common::Arena::footprint<Processing::FilterPipeline>() +
+                 Common::Arena::footprint<Processing::FilteredSensor>();
+        for (const char *key : filterKeys)
+        {
+            const char *text = config.get(key);
+            FilterSpec specs[FILTER_MAX_STAGES];
+            int stages = 0;
+            if (text == nullptr)
+            {
+                continue;
+            }
+            if (!parseFilters(text, specs, stages))
+            {
+                LOG_ERROR("Sensor %s (line %d): invalid %s: %s\n", config.name, config.line, key, text);
+                return false;
+            }
+            for (int i = 0; i < stages; ++i)
+            {
+                bytes += filterFootprint(specs[i]);
+            }
+            stats.filters += stages;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Exports and configures the sysfs pins of all sensors, one setupPins() pass per gpio tree.
+     *
+     * Failures are only counted: the drivers retry the export when they
+     * are opened and report the pin themselves.
+     */
+    void SensorSet::setupSysfsPins(const std::vector<Sensors::SensorConfig> &configs,
+                                   const std::vector<const Sensors::SensorType *> &types)
+    {
+        unsigned long long start = Periferia::monotonicNs();
+        std::vector<Periferia::GPIOPinSetup> pins;
+        std::vector<const char *> roots;
+        for (size_t i = 0; i < configs.size(); ++i)
+        {
+            Periferia::GPIOPinSetup pin;
+            const char *root = nullptr;
+            if (types[i]->sysfsPin != nullptr && types[i]->sysfsPin(configs[i], pin, root))
+            {
+                pins.push_back(pin);
+                roots.push_back(root);
+            }
+        }
+        std::vector<Periferia::GPIOPinSetup> batch;
+        for (size_t i = 0; i < pins.size(); ++i)
+        {
+            if (roots[i] == nullptr)
+            {
+                continue; // set up with an earlier tree
+            }
+            const char *root = roots[i];
+            batch.clear();
+            for (size_t j = i; j < pins.size(); ++j)
+            {
+                if (roots[j] != nullptr && strcmp(roots[j], root) == 0)
+                {
+                    batch.push_back(pins[j]);
+                    roots[j] = nullptr;
+                }
+            }
+            Periferia::GPIOSetupReport report;
+            Periferia::setupPins(batch.data(), (int)batch.size(), root, &report);
+            stats.pins += (int)batch.size();
+            stats.pinFailures += report.failed;
+        }
+        if (stats.pinFailures > 0)
+        {
+            LOG_WARN("%d of %d sysfs pins could not be set up\n", stats.pinFailures, stats.pins);
+        }
+        stats.setupNs = Periferia::monotonicNs() - start;
+    }
+
+    /**
+     * @brief Places the configured filter stages, their pipeline and the filtering front in the arena.
+     * @return The front to read instead of the driver, or nullptr if the arena ran out.
+     */
+    Sensors::SensorBase *SensorSet::createFiltered(const Sensors::SensorConfig &config, Sensors::SensorBase *sensor)
+    {
+        Processing::FilterPipeline *pipeline = arena.create<Processing::FilterPipeline>(config.name);
+        if (pipeline == nullptr)
+        {
+            return nullptr;
+        }
+        for (int c = 0; c < FILTER_CHANNELS; ++c)
+        {
+            const char *text = config.get(filterKeys[c]);
+            FilterSpec specs[FILTER_MAX_STAGES];
+            int stages = 0;
+            if (text == nullptr || !parseFilters(text, specs, stages))
+            {
+                continue; // validated by addFootprint()
+            }
+            for (int i = 0; i < stages; ++i)
+            {
+                Processing::Filter *filter = createFilter(specs[i], arena);
+                if (filter == nullptr)
+                {
+                    return nullptr;
+                }
+                pipeline->add((Processing::Channel)c, filter);
+            }
+        }
+        return arena.create<Processing::FilteredSensor>(*sensor, *pipeline);
+    }
+} // namespace Service
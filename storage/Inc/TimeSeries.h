@@ -0,0 +1,163 @@
+#ifndef TIME_SERIES_H
+#define TIME_SERIES_H
+
+/*
+ * Append-only on-disk history of sensor samples.
+ *
+ * A store is a directory of segment files, segment-NNNNNNNN.emts, each a
+ * 64-byte header followed by fixed-size 24-byte records. Records are only
+ * ever appended, in batches, by one writer thread; a full segment is
+ * synced and a new one started. Records are kept in time order except for
+ * samples that arrive late: the header stores the largest such lateness,
+ * which lets readers binary-search an mmap of the file and still return
+ * every record in a range.
+ */
+
+#include "../../define.h"
+#include "../../common/Inc/RingBuffer.h"
+#include "../../acquisition/Inc/Sample.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TSDB_MAGIC "EMTSDB1"
+#define TSDB_VERSION 1
+#define TSDB_HEADER_SIZE 64
+// ~24 MB per segment, about 12 days of one sensor at 1 Hz
+#define TSDB_SEGMENT_RECORDS (1u << 20)
+#define TSDB_BATCH_RECORDS 256
+#define TSDB_FLUSH_INTERVAL_MS 5000
+#define TSDB_QUEUE 4096
+// Writer thread sleep when its queue is empty and no eventfd could be created
+#define TSDB_IDLE_US 2000
+
+namespace Storage
+{
+    // One sample as stored on disk
+    struct StoredSample
+    {
+        int64_t timestampNs; ///< CLOCK_REALTIME
+        uint32_t sensorId;
+        float temperature;
+        float humidity;
+        float light;
+    };
+    static_assert(sizeof(StoredSample) == 24, "on-disk record layout");
+
+    struct SegmentHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        int64_t createdNs;     ///< CLOCK_REALTIME when the segment was started
+        int64_t maxLatenessNs; ///< largest amount a record is older than one written before it
+        uint8_t reserved[TSDB_HEADER_SIZE - 32];
+    };
+    static_assert(sizeof(SegmentHeader) == TSDB_HEADER_SIZE, "on-disk header layout");
+
+    // Convert a cycle record (CLOCK_MONOTONIC) to a stored sample (CLOCK_REALTIME)
+    StoredSample toStoredSample(const Acquisition::SampleRecord &record);
+
+    struct TimeSeriesConfig
+    {
+        std::string directory;
+        size_t segmentRecords = TSDB_SEGMENT_RECORDS;
+        size_t batchRecords = TSDB_BATCH_RECORDS;                             ///< write() once this many are queued
+        std::chrono::milliseconds flushInterval{TSDB_FLUSH_INTERVAL_MS};      ///< or once the oldest waits this long
+        bool syncOnFlush = false;  ///< fdatasync() every batch, not only when a segment is sealed
+        size_t maxSegments = 0;    ///< delete the oldest segments beyond this many; 0 keeps all
+    };
+
+    /**
+     * @class TimeSeriesWriter
+     * @brief Batches samples from any thread into segment files on a writer thread.
+     */
+    class TimeSeriesWriter
+    {
+    public:
+        explicit TimeSeriesWriter(const TimeSeriesConfig &config);
+        ~TimeSeriesWriter();
+
+        // Create the directory, recover the last segment and start the writer thread
+        bool start();
+        // Write everything queued, seal the segment and join the thread
+        void stop();
+
+        // Lock-free, never blocks; false if the queue was full and the sample dropped
+        bool append(const StoredSample &sample);
+        // Block until everything appended so far has been written to the file
+        void flush();
+
+        // Samples lost to a full queue or a failed write
+        unsigned long getDropped() const { return dropped.load() + lost.load(); }
+        unsigned long getWritten() const { return written.load(); }
+        unsigned long getWriteCalls() const { return writeCalls.load(); }
+
+    private:
+        void run();
+        void wake();
+        bool writeBatch();
+        bool openSegment(unsigned int sequence, bool recover);
+        void sealSegment();
+        void enforceRetention();
+        unsigned long processed() const { return written.load() + lost.load(); }
+
+        TimeSeriesConfig config;
+        Common::MpscRing<StoredSample, TSDB_QUEUE> queue;
+        std::vector<StoredSample> batch;
+        std::thread worker;
+        std::atomic<bool> running;
+        std::atomic<unsigned long> flushTarget; ///< write the batch until processed() reaches it
+        std::atomic<unsigned long> queued;
+        std::atomic<unsigned long> taken;    ///< popped by the writer thread
+        std::atomic<unsigned long> written;
+        std::atomic<unsigned long> dropped;  ///< queue full
+        std::atomic<unsigned long> lost;     ///< write failed
+        std::atomic<unsigned long> writeCalls;
+        int wakeFd;                  ///< eventfd the writer thread blocks on while the queue is empty
+        std::mutex flushMutex;
+        std::condition_variable flushed; ///< signalled after each batch and when the thread exits
+        // Writer thread only
+        int fd;
+        unsigned int sequence;
+        size_t segmentCount;     ///< records in the current segment
+        SegmentHeader header;
+        int64_t newestNs;        ///< newest timestamp written so far, carried across segments
+    };
+
+    /**
+     * @class TimeSeriesReader
+     * @brief Range queries over a store by memory-mapping its segments.
+     *
+     * Safe to use while a writer appends: each query maps the segments as
+     * they are at that moment.
+     */
+    class TimeSeriesReader
+    {
+    public:
+        explicit TimeSeriesReader(const char *directory);
+
+        // Call visit for each record with fromNs <= timestamp <= toNs (sensorId < 0: any sensor).
+        // Returns the number of records visited, or ERROR if the store cannot be read.
+        long scan(int64_t fromNs, int64_t toNs, int sensorId, const std::function<void(const StoredSample &)> &visit);
+        // Same as scan(), appending to out
+        long query(int64_t fromNs, int64_t toNs, int sensorId, std::vector<StoredSample> &out);
+
+    private:
+        std::string directory;
+    };
+
+    // Segment file name for a sequence number, inside directory
+    std::string segmentPath(const std::string &directory, unsigned int sequence);
+    // Sequence numbers of the segments in directory, ascending
+    std::vector<unsigned int> listSegments(const std::string &directory);
+
+} // namespace Storage
+
+#endif // TIME_SERIES_H
@@ -0,0 +1,168 @@
+#include "../Inc/TimeSeries.h"
+#include "../../common/Inc/Log.h"
+#include <algorithm>
+#include <climits>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace Storage
+{
+    /**
+     * @brief Adds without wrapping past the int64_t limits.
+     */
+    static int64_t saturatingAdd(int64_t value, int64_t delta)
+    {
+        int64_t result;
+        if (__builtin_add_overflow(value, delta, &result))
+        {
+            return (delta > 0) ? LLONG_MAX : LLONG_MIN;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Path of a segment file.
+     */
+    std::string segmentPath(const std::string &directory, unsigned int sequence)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "/segment-%08u.emts", sequence);
+        return directory + name;
+    }
+
+    /**
+     * @brief Lists the segment files of a store.
+     * @return Sequence numbers in ascending order; empty if the directory cannot be read.
+     */
+    std::vector<unsigned int> listSegments(const std::string &directory)
+    {
+        std::vector<unsigned int> segments;
+        DIR *dir = opendir(directory.c_str());
+        if (dir == nullptr)
+        {
+            return segments;
+        }
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != nullptr)
+        {
+            unsigned int sequence;
+            char suffix[8];
+            if (sscanf(entry->d_name, "segment-%u.%7s", &sequence, suffix) == 2 && strcmp(suffix, "emts") == 0)
+            {
+                segments.push_back(sequence);
+            }
+        }
+        closedir(dir);
+        std::sort(segments.begin(), segments.end());
+        return segments;
+    }
+
+    /**
+     * @brief Constructs a reader for a store directory.
+     */
+    TimeSeriesReader::TimeSeriesReader(const char *directory) : directory(directory)
+    {
+    }
+
+    /**
+     * @brief Visits the records of a time range.
+     *
+     * Each segment is mapped read-only. Its records are in time order
+     * except that one may be older than an earlier one by at most the
+     * header's maxLatenessNs (L). Bisection therefore looks for a record
+     * older than fromNs - L: every record before it is older than fromNs.
+     * The scan stops at a record newer than toNs + L, after which no record
+     * can be inside the range. A record being written while the query runs
+     * may be missed.
+     *
+     * @param fromNs Start of the range, CLOCK_REALTIME, inclusive.
+     * @param toNs End of the range, inclusive.
+     * @param sensorId Sensor to return, or a negative value for all.
+     * @param visit Called for every matching record, in file order.
+     * @return Number of records visited, or ERROR if the directory cannot be read.
+     */
+    long TimeSeriesReader::scan(int64_t fromNs, int64_t toNs, int sensorId,
+                                const std::function<void(const StoredSample &)> &visit)
+    {
+        DIR *dir = opendir(directory.c_str());
+        if (dir == nullptr)
+        {
+            LOG_ERROR("Time series: cannot open %s: %s\n", directory.c_str(), strerror(errno));
+            return ERROR;
+        }
+        closedir(dir);
+
+        long visited = 0;
+        for (unsigned int sequence : listSegments(directory))
+        {
+            std::string path = segmentPath(directory, sequence);
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                continue; // removed by retention in the meantime
+            }
+            struct stat info;
+            if (fstat(fd, &info) != 0 || info.st_size < (off_t)(TSDB_HEADER_SIZE + sizeof(StoredSample)))
+            {
+                ::close(fd);
+                continue;
+            }
+            size_t size = (size_t)info.st_size;
+            void *map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (map == MAP_FAILED)
+            {
+                LOG_WARN("Time series: cannot map %s: %s\n", path.c_str(), strerror(errno));
+                continue;
+            }
+
+            const SegmentHeader *header = (const SegmentHeader *)map;
+            if (memcmp(header->magic, TSDB_MAGIC, sizeof(TSDB_MAGIC)) != 0 || header->recordSize != sizeof(StoredSample))
+            {
+                munmap(map, size);
+                continue;
+            }
+            const StoredSample *records = (const StoredSample *)((const char *)map + TSDB_HEADER_SIZE);
+            long count = (long)((size - TSDB_HEADER_SIZE) / sizeof(StoredSample));
+            int64_t lowBound = saturatingAdd(fromNs, -header->maxLatenessNs);
+            int64_t highBound = saturatingAdd(toNs, header->maxLatenessNs);
+
+            long low = -1;
+            long high = count;
+            while (high - low > 1)
+            {
+                long middle = low + (high - low) / 2;
+                if (records[middle].timestampNs < lowBound)
+                {
+                    low = middle;
+                }
+                else
+                {
+                    high = middle;
+                }
+            }
+            for (long i = low + 1; i < count && records[i].timestampNs <= highBound; ++i)
+            {
+                const StoredSample &record = records[i];
+                if (record.timestampNs >= fromNs && record.timestampNs <= toNs &&
+                    (sensorId < 0 || record.sensorId == (uint32_t)sensorId))
+                {
+                    visit(record);
+                    visited++;
+                }
+            }
+            munmap(map, size);
+        }
+        return visited;
+    }
+
+    /**
+     * @brief Collects the records of a time range.
+     * @return Number of records appended to out, or ERROR.
+     */
+    long TimeSeriesReader::query(int64_t fromNs, int64_t toNs, int sensorId, std::vector<StoredSample> &out)
+    {
+        return scan(fromNs, toNs, sensorId, [&out](const StoredSample &record) { out.push_back(record); });
+    }
+} // namespace Storage
@@ -0,0 +1,464 @@
+#include "../Inc/TimeSeries.h"
+#include "../../common/Inc/Log.h"
+#include <algorithm>
+#include <climits>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <time.h>
+
+// Records read per pread() when recovering a segment's newest timestamp
+#define TSDB_RECOVER_CHUNK 256
+
+namespace Storage
+{
+    static long long clockNs(clockid_t clock)
+    {
+        struct timespec ts;
+        clock_gettime(clock, &ts);
+        return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    /**
+     * @brief Converts a scheduler cycle record into a stored sample.
+     *
+     * Cycle records are stamped with CLOCK_MONOTONIC, which restarts at boot;
+     * the store keeps CLOCK_REALTIME so history stays comparable across
+     * reboots. The end of the cycle is used, when the value was obtained.
+     */
+    StoredSample toStoredSample(const Acquisition::SampleRecord &record)
+    {
+        long long offsetNs = clockNs(CLOCK_REALTIME) - clockNs(CLOCK_MONOTONIC);
+        StoredSample sample;
+        sample.timestampNs = (int64_t)record.endNs + offsetNs;
+        sample.sensorId = (uint32_t)record.sensorId;
+        sample.temperature = record.data.temperature;
+        sample.humidity = record.data.humidity;
+        sample.light = record.data.light;
+        return sample;
+    }
+
+    /**
+     * @brief Writes the whole buffer at offset, retrying short writes and EINTR.
+     * @return true if everything was written.
+     */
+    static bool writeAll(int fd, const void *buffer, size_t size, off_t offset)
+    {
+        const char *data = (const char *)buffer;
+        while (size > 0)
+        {
+            ssize_t result = pwrite(fd, data, size, offset);
+            if (result < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            data += result;
+            size -= (size_t)result;
+            offset += result;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Constructs a stopped writer.
+     * @param config Directory, segment size, batching and retention.
+     */
+    TimeSeriesWriter::TimeSeriesWriter(const TimeSeriesConfig &config)
+        : config(config), running(false), flushTarget(0), queued(0), taken(0), written(0), dropped(0), lost(0),
+          writeCalls(0), wakeFd(eventfd(0, EFD_CLOEXEC)), fd(-1), sequence(0), segmentCount(0), header(), newestNs(LLONG_MIN)
+    {
+    }
+
+    /**
+     * @brief Stops the writer, writing everything that was queued.
+     */
+    TimeSeriesWriter::~TimeSeriesWriter()
+    {
+        stop();
+        if (wakeFd != -1)
+        {
+            close(wakeFd);
+        }
+    }
+
+    /**
+     * @brief Opens the store and starts the writer thread.
+     *
+     * The newest segment is reopened and appended to; a torn record left
+     * by a crash is cut off. A segment with an unreadable header is left
+     * alone and a new one started after it.
+     *
+     * @return true if started, false if already running or the directory cannot be used.
+     */
+    bool TimeSeriesWriter::start()
+    {
+        if (running.load())
+        {
+            return false;
+        }
+        if (mkdir(config.directory.c_str(), 0755) != 0 && errno != EEXIST)
+        {
+            LOG_ERROR("Time series: cannot create %s: %s\n", config.directory.c_str(), strerror(errno));
+            return false;
+        }
+        if (config.segmentRecords == 0 || config.batchRecords == 0)
+        {
+            LOG_ERROR("Time series: segment and batch sizes must be positive.\n");
+            return false;
+        }
+
+        std::vector<unsigned int> segments = listSegments(config.directory);
+        bool opened = !segments.empty() && openSegment(segments.back(), true);
+        if (!opened && !openSegment(segments.empty() ? 1 : segments.back() + 1, false))
+        {
+            return false;
+        }
+
+        batch.reserve(config.batchRecords);
+        running = true;
+        worker = std::thread(&TimeSeriesWriter::run, this);
+        return true;
+    }
+
+    /**
+     * @brief Writes what is queued, syncs and closes the segment, joins the thread.
+     */
+    void TimeSeriesWriter::stop()
+    {
+        if (!running.exchange(false))
+        {
+            return;
+        }
+        wake();
+        worker.join();
+        sealSegment();
+    }
+
+    /**
+     * @brief Queues a sample for the writer thread.
+     *
+     * Only the producer that finds everything before its sample already
+     * taken writes the eventfd, so a burst of samples costs one wake-up.
+     *
+     * @param sample Sample to store.
+     * @return true if queued, false if the queue was full (the sample is dropped and counted).
+     */
+    bool TimeSeriesWriter::append(const StoredSample &sample)
+    {
+        if (!queue.tryPush(sample))
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (queued.fetch_add(1) == taken.load())
+        {
+            wake();
+        }
+        return true;
+    }
+
+    /**
+     * @brief Waits until every sample appended before the call has been written (or lost to an I/O error).
+     */
+    void TimeSeriesWriter::flush()
+    {
+        unsigned long target = queued.load();
+        unsigned long current = flushTarget.load();
+        while (current < target && !flushTarget.compare_exchange_weak(current, target))
+        {
+        }
+        wake();
+        std::unique_lock<std::mutex> lock(flushMutex);
+        flushed.wait(lock, [this, target] { return !running.load() || processed() >= target; });
+    }
+
+    /**
+     * @brief Wakes the writer thread if it is blocked on the eventfd.
+     */
+    void TimeSeriesWriter::wake()
+    {
+        uint64_t one = 1;
+        if (wakeFd != -1 && write(wakeFd, &one, sizeof(one)) < 0)
+        {
+            // The counter only saturates if the writer stopped reading; it is awake anyway
+        }
+    }
+
+    /**
+     * @brief Writer thread: fills the batch from the queue and writes it when full, old or requested.
+     *
+     * With nothing to take it blocks on the eventfd, for at most the time
+     * left before a pending batch is due.
+     */
+    void TimeSeriesWriter::run()
+    {
+        long long batchStartNs = 0;
+        long long flushIntervalNs = config.flushInterval.count() * 1000000LL;
+        StoredSample sample;
+        for (;;)
+        {
+            bool stopping = !running.load();
+            bool popped = false;
+            while (batch.size() < config.batchRecords && queue.tryPop(sample))
+            {
+                if (batch.empty())
+                {
+                    batchStartNs = clockNs(CLOCK_MONOTONIC);
+                }
+                batch.push_back(sample);
+                taken.fetch_add(1);
+                popped = true;
+            }
+
+            bool requested = processed() < flushTarget.load();
+            if (!batch.empty() && (batch.size() >= config.batchRecords || requested || stopping ||
+                                   clockNs(CLOCK_MONOTONIC) - batchStartNs >= flushIntervalNs))
+            {
+                writeBatch();
+                {
+                    std::lock_guard<std::mutex> lock(flushMutex);
+                }
+                flushed.notify_all();
+                continue; // the queue may hold more
+            }
+            if (stopping)
+            {
+                break;
+            }
+            if (popped)
+            {
+                continue;
+            }
+            if (taken.load() != queued.load())
+            {
+                // A producer holding an earlier ring slot has not published it yet
+                std::this_thread::yield();
+            }
+            else if (wakeFd == -1)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(TSDB_IDLE_US));
+            }
+            else
+            {
+                // Seq-cst counters: either this load saw the new sample or its producer sees
+                // taken == queued and writes the eventfd, so no wake-up is lost
+                int timeoutMs = -1;
+                if (!batch.empty())
+                {
+                    long long leftNs = batchStartNs + flushIntervalNs - clockNs(CLOCK_MONOTONIC);
+                    timeoutMs = (int)(std::max(leftNs, 0LL) / 1000000 + 1);
+                }
+                struct pollfd wakeup = {wakeFd, POLLIN, 0};
+                uint64_t wakeups;
+                if (poll(&wakeup, 1, timeoutMs) > 0 && read(wakeFd, &wakeups, sizeof(wakeups)) < 0)
+                {
+                    // Already drained: re-check the queue
+                }
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(flushMutex);
+        }
+        flushed.notify_all();
+    }
+
+    /**
+     * @brief Appends the batch in time order, rotating segments as they fill up.
+     *
+     * The batch is sorted first, so only samples older than an earlier
+     * batch count as late; the segment header is updated before such
+     * records are written, so a reader never underestimates the lateness.
+     *
+     * @return true if every record was written.
+     */
+    bool TimeSeriesWriter::writeBatch()
+    {
+        std::stable_sort(batch.begin(), batch.end(),
+                         [](const StoredSample &a, const StoredSample &b) { return a.timestampNs < b.timestampNs; });
+
+        bool ok = true;
+        size_t done = 0;
+        while (done < batch.size() && ok)
+        {
+            if (segmentCount >= config.segmentRecords)
+            {
+                sealSegment();
+                if (!openSegment(sequence + 1, false))
+                {
+                    ok = false;
+                    break;
+                }
+                enforceRetention();
+            }
+            size_t count = std::min(batch.size() - done, config.segmentRecords - segmentCount);
+
+            int64_t lateness = header.maxLatenessNs;
+            for (size_t i = done; i < done + count; ++i)
+            {
+                if (batch[i].timestampNs < newestNs)
+                {
+                    lateness = std::max<int64_t>(lateness, newestNs - batch[i].timestampNs);
+                }
+                else
+                {
+                    newestNs = batch[i].timestampNs;
+                }
+            }
+            if (lateness > header.maxLatenessNs)
+            {
+                header.maxLatenessNs = lateness;
+                ok = writeAll(fd, &header, sizeof(header), 0);
+            }
+
+            off_t offset = (off_t)(TSDB_HEADER_SIZE + segmentCount * sizeof(StoredSample));
+            ok = ok && writeAll(fd, &batch[done], count * sizeof(StoredSample), offset);
+            writeCalls.fetch_add(1, std::memory_order_relaxed);
+            if (ok)
+            {
+                segmentCount += count;
+                written.fetch_add(count, std::memory_order_release);
+                done += count;
+            }
+        }
+
+        if (ok && config.syncOnFlush)
+        {
+            fdatasync(fd);
+        }
+        if (!ok)
+        {
+            LOG_ERROR("Time series: write to segment %u failed: %s\n", sequence, strerror(errno));
+            lost.fetch_add(batch.size() - done, std::memory_order_release);
+        }
+        batch.clear();
+        return ok;
+    }
+
+    /**
+     * @brief Opens a segment for appending.
+     * @param number Sequence number of the segment.
+     * @param recover true to reopen an existing segment, false to create a new one.
+     * @return true on success.
+     */
+    bool TimeSeriesWriter::openSegment(unsigned int number, bool recover)
+    {
+        std::string path = segmentPath(config.directory, number);
+        if (!recover)
+        {
+            fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+            if (fd < 0)
+            {
+                LOG_ERROR("Time series: cannot create %s: %s\n", path.c_str(), strerror(errno));
+                return false;
+            }
+            header = SegmentHeader();
+            memcpy(header.magic, TSDB_MAGIC, sizeof(TSDB_MAGIC));
+            header.version = TSDB_VERSION;
+            header.recordSize = sizeof(StoredSample);
+            header.createdNs = clockNs(CLOCK_REALTIME);
+            if (!writeAll(fd, &header, sizeof(header), 0))
+            {
+                LOG_ERROR("Time series: cannot write %s: %s\n", path.c_str(), strerror(errno));
+                ::close(fd);
+                fd = -1;
+                return false;
+            }
+            sequence = number;
+            segmentCount = 0;
+            return true; // newestNs carries over, so lateness is also measured across segments
+        }
+
+        fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+        struct stat info;
+        if (fd < 0 || pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) || fstat(fd, &info) != 0 ||
+            memcmp(header.magic, TSDB_MAGIC, sizeof(TSDB_MAGIC)) != 0 || header.version != TSDB_VERSION ||
+            header.recordSize != sizeof(StoredSample))
+        {
+            LOG_WARN("Time series: %s is not a usable segment, starting a new one.\n", path.c_str());
+            if (fd >= 0)
+            {
+                ::close(fd);
+                fd = -1;
+            }
+            return false;
+        }
+
+        size_t records = (size_t)(info.st_size - TSDB_HEADER_SIZE) / sizeof(StoredSample);
+        off_t end = (off_t)(TSDB_HEADER_SIZE + records * sizeof(StoredSample));
+        if (info.st_size != end)
+        {
+            LOG_WARN("Time series: cutting a torn record off %s.\n", path.c_str());
+            if (ftruncate(fd, end) != 0)
+            {
+                ::close(fd);
+                fd = -1;
+                return false;
+            }
+        }
+
+        // Newest timestamp: scan back until a record is older than the maximum by more than any lateness
+        newestNs = LLONG_MIN;
+        StoredSample chunk[TSDB_RECOVER_CHUNK];
+        size_t remaining = records;
+        bool more = true;
+        while (remaining > 0 && more)
+        {
+            size_t count = std::min(remaining, (size_t)TSDB_RECOVER_CHUNK);
+            remaining -= count;
+            off_t offset = (off_t)(TSDB_HEADER_SIZE + remaining * sizeof(StoredSample));
+            if (pread(fd, chunk, count * sizeof(StoredSample), offset) != (ssize_t)(count * sizeof(StoredSample)))
+            {
+                break;
+            }
+            for (size_t i = count; i-- > 0;)
+            {
+                newestNs = std::max<long long>(newestNs, chunk[i].timestampNs);
+                if (chunk[i].timestampNs + header.maxLatenessNs < newestNs)
+                {
+                    more = false;
+                    break;
+                }
+            }
+        }
+        sequence = number;
+        segmentCount = records;
+        return true;
+    }
+
+    /**
+     * @brief Syncs and closes the current segment.
+     */
+    void TimeSeriesWriter::sealSegment()
+    {
+        if (fd >= 0)
+        {
+            fdatasync(fd);
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    /**
+     * @brief Deletes the oldest segments beyond config.maxSegments.
+     */
+    void TimeSeriesWriter::enforceRetention()
+    {
+        if (config.maxSegments == 0)
+        {
+            return;
+        }
+        std::vector<unsigned int> segments = listSegments(config.directory);
+        for (size_t i = 0; i + config.maxSegments < segments.size() && segments[i] != sequence; ++i)
+        {
+            std::string path = segmentPath(config.directory, segments[i]);
+            if (unlink(path.c_str()) != 0)
+            {
+                LOG_WARN("Time series: cannot remove %s: %s\n", path.c_str(), strerror(errno));
+            }
+        }
+    }
+} // namespace Storage